@@ -0,0 +1,140 @@
+#include <cube.h>
+
+#define BENCH_VOICE_COUNT 64
+#define BENCH_VOICE_FRAMES 48000
+#define BENCH_BLOCK_FRAMES 512
+#define BENCH_ITERATIONS 32
+#define BENCH_SOURCE_RATE 44100
+#define BENCH_TARGET_RATE 48000
+
+typedef void (*bench_mix_function)(
+    float *stream,
+    const float *source,
+    uint32_t frame_count,
+    const float gain[2]);
+
+static double bench_seconds(Uint64 begin, Uint64 end);
+static void bench_fill(float *samples, uint32_t sample_count);
+static double bench_mix(bench_mix_function mix, const float *voices, float *stream);
+static double bench_resample(const float *source, float *target);
+
+int main(void)
+{
+    float *voices;
+    float *stream;
+    float *target;
+    double scalar_rate;
+    double vector_rate;
+
+    voices = SDL_SIMDAlloc((size_t)BENCH_VOICE_COUNT * BENCH_VOICE_FRAMES * 2 * sizeof(float));
+    stream = SDL_SIMDAlloc(BENCH_BLOCK_FRAMES * 2 * sizeof(float));
+    target = SDL_SIMDAlloc((size_t)BENCH_VOICE_FRAMES * 2 * 2 * sizeof(float));
+    if (voices == NULL || stream == NULL || target == NULL)
+    {
+        puts("failed to allocate samples");
+        return 1;
+    }
+    bench_fill(voices, BENCH_VOICE_COUNT * BENCH_VOICE_FRAMES * 2);
+
+    printf(
+        "%u voices, %u frame blocks, best of %u runs\n",
+        BENCH_VOICE_COUNT,
+        BENCH_BLOCK_FRAMES,
+        BENCH_ITERATIONS);
+
+    scalar_rate = bench_mix(audio_mix_stereo_scalar, voices, stream);
+    vector_rate = bench_mix(audio_mix_stereo, voices, stream);
+    printf(
+        "mix       scalar %10.1f  simd %10.1f voices per ms  (%.2fx)\n",
+        scalar_rate,
+        vector_rate,
+        vector_rate / scalar_rate);
+    printf(
+        "resample  %u -> %u  %10.1f frames per ms\n",
+        BENCH_SOURCE_RATE,
+        BENCH_TARGET_RATE,
+        bench_resample(voices, target));
+
+    SDL_SIMDFree(voices);
+    SDL_SIMDFree(stream);
+    SDL_SIMDFree(target);
+    return 0;
+}
+
+double bench_seconds(Uint64 begin, Uint64 end)
+{
+    return (double)(end - begin) / (double)SDL_GetPerformanceFrequency();
+}
+
+void bench_fill(float *samples, uint32_t sample_count)
+{
+    uint32_t index;
+    Uint32 state;
+
+    state = 22695477;
+    for (index = 0; index < sample_count; index++)
+    {
+        state = state * 1664525 + 1013904223;
+        *(samples + index) = (float)(state >> 8) / 16777216.0f - 0.5f;
+    }
+}
+
+// one voice mixed is one block of that voice added into the output stream
+double bench_mix(bench_mix_function mix, const float *voices, float *stream)
+{
+    const float gain[2] = {0.5f, 0.25f};
+    double best;
+    double elapsed;
+    Uint64 begin;
+    uint32_t iteration;
+    uint32_t block;
+    uint32_t voice;
+
+    best = HUGE_VAL;
+    for (iteration = 0; iteration < BENCH_ITERATIONS; iteration++)
+    {
+        begin = SDL_GetPerformanceCounter();
+        for (block = 0; block + BENCH_BLOCK_FRAMES <= BENCH_VOICE_FRAMES; block += BENCH_BLOCK_FRAMES)
+        {
+            SDL_memset(stream, 0, BENCH_BLOCK_FRAMES * 2 * sizeof(float));
+            for (voice = 0; voice < BENCH_VOICE_COUNT; voice++)
+            {
+                mix(
+                    stream,
+                    voices + ((size_t)voice * BENCH_VOICE_FRAMES + block) * 2,
+                    BENCH_BLOCK_FRAMES,
+                    gain);
+            }
+            audio_clamp(stream, BENCH_BLOCK_FRAMES * 2);
+        }
+        elapsed = bench_seconds(begin, SDL_GetPerformanceCounter());
+        best = (elapsed < best) ? elapsed : best;
+    }
+    return (double)(BENCH_VOICE_FRAMES / BENCH_BLOCK_FRAMES) * BENCH_VOICE_COUNT / (best * 1e3);
+}
+
+double bench_resample(const float *source, float *target)
+{
+    cube_resampler resampler;
+    double best;
+    double elapsed;
+    Uint64 begin;
+    uint32_t iteration;
+    uint32_t target_frame_count;
+
+    if (audio_create_resampler(&resampler, BENCH_SOURCE_RATE, BENCH_TARGET_RATE) != CUBE_SUCCESS)
+    {
+        return 0.0;
+    }
+    target_frame_count = audio_resample_length(&resampler, BENCH_VOICE_FRAMES);
+    best = HUGE_VAL;
+    for (iteration = 0; iteration < BENCH_ITERATIONS; iteration++)
+    {
+        begin = SDL_GetPerformanceCounter();
+        audio_resample(&resampler, source, BENCH_VOICE_FRAMES, target, target_frame_count);
+        elapsed = bench_seconds(begin, SDL_GetPerformanceCounter());
+        best = (elapsed < best) ? elapsed : best;
+    }
+    audio_destroy_resampler(&resampler);
+    return (double)target_frame_count / (best * 1e3);
+}
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include <cube.h>
+
+#define BENCH_INSTANCE_COUNT 1000000
+#define BENCH_TRANSFORM_GRAIN 1024
+#define BENCH_SPIN_COUNT 262144
+#define BENCH_SPIN_STEPS 256
+#define BENCH_ITERATIONS 16
+
+typedef struct
+{
+    cube_transforms transforms;
+    float rotation[4];
+    float (*matrices)[4][4];
+    float *results;
+} bench_data;
+
+static double bench_seconds(Uint64 begin, Uint64 end);
+static int bench_create(bench_data *data);
+static void bench_destroy(bench_data *data);
+static void bench_transform_job(void *data, uint32_t begin, uint32_t end);
+static void bench_spin_job(void *data, uint32_t begin, uint32_t end);
+static double bench_run(cube_jobs *jobs, cube_job_function function, bench_data *data, uint32_t count, uint32_t grain);
+
+int main(void)
+{
+    bench_data data;
+    cube_jobs *jobs;
+    uint32_t core_count;
+    uint32_t worker_count;
+    double transform_time;
+    double spin_time;
+    double transform_base;
+    double spin_base;
+
+    if (bench_create(&data) != CUBE_SUCCESS)
+    {
+        puts("failed to allocate transforms");
+        return 1;
+    }
+
+    // the calling thread helps, so n cores is n - 1 workers
+    core_count = (uint32_t)SDL_clamp(SDL_GetCPUCount(), 1, CUBE_JOB_MAX_WORKERS + 1);
+    printf(
+        "%u instances in ranges of %u, %u spin items, best of %u runs\n",
+        BENCH_INSTANCE_COUNT,
+        BENCH_TRANSFORM_GRAIN,
+        BENCH_SPIN_COUNT,
+        BENCH_ITERATIONS);
+    printf("cores   transforms ms  speedup   spin ms  speedup\n");
+    transform_base = 0.0;
+    spin_base = 0.0;
+    for (worker_count = 0; worker_count < core_count; worker_count++)
+    {
+        if (application_create_jobs(&jobs, worker_count) != CUBE_SUCCESS)
+        {
+            puts("failed to create jobs");
+            bench_destroy(&data);
+            return 1;
+        }
+        transform_time = bench_run(jobs, bench_transform_job, &data, BENCH_INSTANCE_COUNT, BENCH_TRANSFORM_GRAIN);
+        spin_time = bench_run(jobs, bench_spin_job, &data, BENCH_SPIN_COUNT, 0);
+        application_destroy_jobs(jobs);
+        if (worker_count == 0)
+        {
+            transform_base = transform_time;
+            spin_base = spin_time;
+        }
+        printf(
+            "%5u   %13.3f  %6.2fx  %8.3f  %6.2fx\n",
+            worker_count + 1,
+            transform_time * 1e3,
+            transform_base / transform_time,
+            spin_time * 1e3,
+            spin_base / spin_time);
+    }
+    bench_destroy(&data);
+    return 0;
+}
+
+double bench_seconds(Uint64 begin, Uint64 end)
+{
+    return (double)(end - begin) / (double)SDL_GetPerformanceFrequency();
+}
+
+int bench_create(bench_data *data)
+{
+    float **arrays[] = {
+        &data->transforms.position_x,
+        &data->transforms.position_y,
+        &data->transforms.position_z,
+        &data->transforms.rotation_x,
+        &data->transforms.rotation_y,
+        &data->transforms.rotation_z,
+        &data->transforms.rotation_w,
+        &data->transforms.scale_x,
+        &data->transforms.scale_y,
+        &data->transforms.scale_z,
+    };
+    uint32_t array_index;
+    uint32_t index;
+
+    SDL_memset(data, 0, sizeof(bench_data));
+    data->transforms.count = BENCH_INSTANCE_COUNT;
+    data->transforms.capacity = BENCH_INSTANCE_COUNT;
+    for (array_index = 0; array_index < sizeof(arrays) / sizeof(arrays[0]); array_index++)
+    {
+        *arrays[array_index] = SDL_SIMDAlloc(BENCH_INSTANCE_COUNT * sizeof(float));
+        if (*arrays[array_index] == NULL)
+        {
+            return CUBE_FAILURE;
+        }
+    }
+    data->matrices = SDL_SIMDAlloc((size_t)BENCH_INSTANCE_COUNT * sizeof(float[4][4]));
+    data->results = SDL_SIMDAlloc(BENCH_SPIN_COUNT * sizeof(float));
+    if (data->matrices == NULL || data->results == NULL)
+    {
+        return CUBE_FAILURE;
+    }
+
+    for (index = 0; index < BENCH_INSTANCE_COUNT; index++)
+    {
+        *(data->transforms.position_x + index) = (float)(index % 1000);
+        *(data->transforms.position_y + index) = (float)(index / 1000);
+        *(data->transforms.position_z + index) = 0.0f;
+        *(data->transforms.rotation_x + index) = 0.0f;
+        *(data->transforms.rotation_y + index) = 0.0f;
+        *(data->transforms.rotation_z + index) = 0.0f;
+        *(data->transforms.rotation_w + index) = 1.0f;
+        *(data->transforms.scale_x + index) = 1.0f;
+        *(data->transforms.scale_y + index) = 1.0f;
+        *(data->transforms.scale_z + index) = 1.0f;
+    }
+    data->rotation[0] = 0.0f;
+    data->rotation[1] = 0.0f;
+    data->rotation[2] = sinf(0.005f);
+    data->rotation[3] = cosf(0.005f);
+    return CUBE_SUCCESS;
+}
+
+void bench_destroy(bench_data *data)
+{
+    SDL_SIMDFree(data->transforms.position_x);
+    SDL_SIMDFree(data->transforms.position_y);
+    SDL_SIMDFree(data->transforms.position_z);
+    SDL_SIMDFree(data->transforms.rotation_x);
+    SDL_SIMDFree(data->transforms.rotation_y);
+    SDL_SIMDFree(data->transforms.rotation_z);
+    SDL_SIMDFree(data->transforms.rotation_w);
+    SDL_SIMDFree(data->transforms.scale_x);
+    SDL_SIMDFree(data->transforms.scale_y);
+    SDL_SIMDFree(data->transforms.scale_z);
+    SDL_SIMDFree(data->matrices);
+    SDL_SIMDFree(data->results);
+}
+
+// the per frame instance update, bound by memory bandwidth at high core counts
+void bench_transform_job(void *data, uint32_t begin, uint32_t end)
+{
+    bench_data *bench;
+
+    bench = data;
+    graphics_transforms_rotate(&bench->transforms, begin, end - begin, bench->rotation);
+    graphics_transforms_compute(&bench->transforms, begin, end - begin, bench->matrices);
+}
+
+// pure arithmetic, shows what the scheduler itself scales to
+void bench_spin_job(void *data, uint32_t begin, uint32_t end)
+{
+    bench_data *bench;
+    uint32_t index;
+    uint32_t step;
+    float value;
+
+    bench = data;
+    for (index = begin; index < end; index++)
+    {
+        value = (float)index;
+        for (step = 0; step < BENCH_SPIN_STEPS; step++)
+        {
+            value = value * 0.999f + 0.5f;
+        }
+        *(bench->results + index) = value;
+    }
+}
+
+double bench_run(cube_jobs *jobs, cube_job_function function, bench_data *data, uint32_t count, uint32_t grain)
+{
+    double best;
+    double elapsed;
+    Uint64 begin;
+    uint32_t iteration;
+
+    best = HUGE_VAL;
+    for (iteration = 0; iteration < BENCH_ITERATIONS; iteration++)
+    {
+        begin = SDL_GetPerformanceCounter();
+        application_jobs_parallel_for(jobs, function, data, count, grain);
+        elapsed = bench_seconds(begin, SDL_GetPerformanceCounter());
+        best = (elapsed < best) ? elapsed : best;
+    }
+    return best;
+}
\ No newline at end of file
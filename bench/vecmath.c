@@ -0,0 +1,177 @@
+#include <cube.h>
+
+#define BENCH_MATRIX_COUNT 65536
+#define BENCH_ITERATIONS 64
+
+typedef void (*bench_multiply_function)(const cube_mat4 *a, const cube_mat4 *b, cube_mat4 *out);
+typedef int (*bench_inverse_function)(const cube_mat4 *matrix, cube_mat4 *out);
+
+static double bench_seconds(Uint64 begin, Uint64 end);
+static void bench_fill(cube_mat4 *matrices, uint32_t count);
+static double bench_multiply(
+    bench_multiply_function multiply,
+    const cube_mat4 *left,
+    const cube_mat4 *matrices,
+    cube_mat4 *out);
+static double bench_multiply_batch(
+    const cube_mat4 *left,
+    const cube_mat4 *matrices,
+    cube_mat4 *out);
+static double bench_inverse(
+    bench_inverse_function inverse,
+    const cube_mat4 *matrices,
+    cube_mat4 *out);
+static double bench_inverse_batch(const cube_mat4 *matrices, cube_mat4 *out);
+
+int main(void)
+{
+    cube_mat4 left;
+    cube_mat4 *matrices;
+    cube_mat4 *out;
+    double scalar_time;
+    double vector_time;
+
+    matrices = SDL_SIMDAlloc(BENCH_MATRIX_COUNT * sizeof(cube_mat4));
+    out = SDL_SIMDAlloc(BENCH_MATRIX_COUNT * sizeof(cube_mat4));
+    if (matrices == NULL || out == NULL)
+    {
+        puts("failed to allocate matrices");
+        return 1;
+    }
+    bench_fill(&left, 1);
+    bench_fill(matrices, BENCH_MATRIX_COUNT);
+
+    printf("%u matrices, best of %u runs, ns per matrix\n", BENCH_MATRIX_COUNT, BENCH_ITERATIONS);
+
+    scalar_time = bench_multiply(graphics_mat4_multiply_scalar, &left, matrices, out);
+    vector_time = bench_multiply(graphics_mat4_multiply, &left, matrices, out);
+    printf("multiply        scalar %8.2f  simd %8.2f  (%.2fx)\n", scalar_time, vector_time, scalar_time / vector_time);
+    vector_time = bench_multiply_batch(&left, matrices, out);
+    printf("multiply batch  scalar %8.2f  simd %8.2f  (%.2fx)\n", scalar_time, vector_time, scalar_time / vector_time);
+
+    scalar_time = bench_inverse(graphics_mat4_inverse_scalar, matrices, out);
+    vector_time = bench_inverse(graphics_mat4_inverse, matrices, out);
+    printf("inverse         scalar %8.2f  simd %8.2f  (%.2fx)\n", scalar_time, vector_time, scalar_time / vector_time);
+    vector_time = bench_inverse_batch(matrices, out);
+    printf("inverse batch   scalar %8.2f  simd %8.2f  (%.2fx)\n", scalar_time, vector_time, scalar_time / vector_time);
+
+    SDL_SIMDFree(matrices);
+    SDL_SIMDFree(out);
+    return 0;
+}
+
+double bench_seconds(Uint64 begin, Uint64 end)
+{
+    return (double)(end - begin) / (double)SDL_GetPerformanceFrequency();
+}
+
+void bench_fill(cube_mat4 *matrices, uint32_t count)
+{
+    const cube_vec3 axis = {
+        .x = 0.267f,
+        .y = 0.535f,
+        .z = 0.802f,
+    };
+    cube_mat4 identity;
+    uint32_t index;
+
+    // well conditioned rigid transforms so every inverse exists
+    graphics_mat4_identity(&identity);
+    for (index = 0; index < count; index++)
+    {
+        graphics_mat4_rotate(&identity, (float)index * 0.001f, &axis, matrices + index);
+        (matrices + index)->m[3][0] = (float)(index % 17);
+        (matrices + index)->m[3][1] = (float)(index % 13);
+        (matrices + index)->m[3][2] = (float)(index % 11);
+    }
+}
+
+double bench_multiply(
+    bench_multiply_function multiply,
+    const cube_mat4 *left,
+    const cube_mat4 *matrices,
+    cube_mat4 *out)
+{
+    double best;
+    double elapsed;
+    Uint64 begin;
+    uint32_t iteration;
+    uint32_t index;
+
+    best = HUGE_VAL;
+    for (iteration = 0; iteration < BENCH_ITERATIONS; iteration++)
+    {
+        begin = SDL_GetPerformanceCounter();
+        for (index = 0; index < BENCH_MATRIX_COUNT; index++)
+        {
+            multiply(left, matrices + index, out + index);
+        }
+        elapsed = bench_seconds(begin, SDL_GetPerformanceCounter());
+        best = (elapsed < best) ? elapsed : best;
+    }
+    return best * 1e9 / BENCH_MATRIX_COUNT;
+}
+
+double bench_multiply_batch(
+    const cube_mat4 *left,
+    const cube_mat4 *matrices,
+    cube_mat4 *out)
+{
+    double best;
+    double elapsed;
+    Uint64 begin;
+    uint32_t iteration;
+
+    best = HUGE_VAL;
+    for (iteration = 0; iteration < BENCH_ITERATIONS; iteration++)
+    {
+        begin = SDL_GetPerformanceCounter();
+        graphics_mat4_multiply_batch(left, matrices, BENCH_MATRIX_COUNT, out);
+        elapsed = bench_seconds(begin, SDL_GetPerformanceCounter());
+        best = (elapsed < best) ? elapsed : best;
+    }
+    return best * 1e9 / BENCH_MATRIX_COUNT;
+}
+
+double bench_inverse(
+    bench_inverse_function inverse,
+    const cube_mat4 *matrices,
+    cube_mat4 *out)
+{
+    double best;
+    double elapsed;
+    Uint64 begin;
+    uint32_t iteration;
+    uint32_t index;
+
+    best = HUGE_VAL;
+    for (iteration = 0; iteration < BENCH_ITERATIONS; iteration++)
+    {
+        begin = SDL_GetPerformanceCounter();
+        for (index = 0; index < BENCH_MATRIX_COUNT; index++)
+        {
+            inverse(matrices + index, out + index);
+        }
+        elapsed = bench_seconds(begin, SDL_GetPerformanceCounter());
+        best = (elapsed < best) ? elapsed : best;
+    }
+    return best * 1e9 / BENCH_MATRIX_COUNT;
+}
+
+double bench_inverse_batch(const cube_mat4 *matrices, cube_mat4 *out)
+{
+    double best;
+    double elapsed;
+    Uint64 begin;
+    uint32_t iteration;
+
+    best = HUGE_VAL;
+    for (iteration = 0; iteration < BENCH_ITERATIONS; iteration++)
+    {
+        begin = SDL_GetPerformanceCounter();
+        graphics_mat4_inverse_batch(matrices, BENCH_MATRIX_COUNT, out);
+        elapsed = bench_seconds(begin, SDL_GetPerformanceCounter());
+        best = (elapsed < best) ? elapsed : best;
+    }
+    return best * 1e9 / BENCH_MATRIX_COUNT;
+}
\ No newline at end of file
@@ -1,5 +1,10 @@
 #include "cube.h"
 
+#define CUBE_SIMULATION_INTERVAL 8
+#define CUBE_SIMULATION_DEGREES_PER_SECOND 100.0f
+#define CUBE_SIMULATION_TIME_VARIABLE "CUBE_SIMULATION_TIME"
+
+static void application_simulate(cube_application *application);
 static void application_handle_keyboard_event(
     cube_application *application,
     const SDL_KeyboardEvent *const keyboard_event);
@@ -7,34 +12,92 @@ static void application_handle_keyboard_event(
 int application_create(cube_application **application, const char *resource_directory)
 {
     CUBE_BEGIN_FUNCTION
+    Uint64 start_counter;
+    const char *simulation_time_variable;
+
+    start_counter = SDL_GetPerformanceCounter();
     CUBE_ASSERT(application != NULL, "invalid application handle")
 
     CUBE_ASSERT(SDL_Init(SDL_INIT_EVERYTHING) >= 0, SDL_GetError())
+#ifdef CUBE_PROFILE
+    CUBE_ASSERT(application_create_profile() == CUBE_SUCCESS, "failed to create profile")
+#endif
+    CUBE_PROFILE_THREAD("main")
 
     *application = calloc(1, sizeof(cube_application));
     CUBE_ASSERT(*application != NULL, "failed to allocate application")
+    (*application)->start_counter = start_counter;
+
+    // one scheduler for loading, culling, transforms and recording
+    CUBE_ASSERT(
+        application_create_jobs(
+            &(*application)->jobs, CUBE_JOB_DEFAULT_WORKERS) == CUBE_SUCCESS,
+        "failed to create jobs")
+
+    CUBE_ASSERT(
+        application_create_resources(
+            &(*application)->resources,
+            (*application)->jobs,
+            resource_directory) == CUBE_SUCCESS,
+        "failed to create resources")
 
     CUBE_ASSERT(
         graphics_create(
-            &(*application)->graphics, resource_directory) == CUBE_SUCCESS,
+            &(*application)->graphics,
+            (*application)->jobs,
+            (*application)->resources) == CUBE_SUCCESS,
         "failed to create graphics subsystem")
+
+    CUBE_ASSERT(
+        audio_create(
+            &(*application)->audio, (*application)->resources) == CUBE_SUCCESS,
+        "failed to create audio subsystem")
+
+    CUBE_ASSERT(
+        application_create_input(
+            &(*application)->input) == CUBE_SUCCESS,
+        "failed to create input subsystem")
+
+    (*application)->simulation_counter = SDL_GetPerformanceCounter();
+    // a fixed time holds the scene still, so every frame of a run renders the same image
+    simulation_time_variable = SDL_getenv(CUBE_SIMULATION_TIME_VARIABLE);
+    if (simulation_time_variable != NULL)
+    {
+        (*application)->simulation_fixed = SDL_TRUE;
+        (*application)->scene.angle = fmodf(
+            (float)SDL_atof(simulation_time_variable) * CUBE_SIMULATION_DEGREES_PER_SECOND * 3.14159265f / 180.0f,
+            2.0f * 3.14159265f);
+    }
+    CUBE_ASSERT(
+        application_create_render(
+            &(*application)->render,
+            (*application)->graphics,
+            (*application)->input,
+            &(*application)->scene,
+            (*application)->start_counter) == CUBE_SUCCESS,
+        "failed to create render thread")
     CUBE_END_FUNCTION
 }
 
+// the render thread owns the frame loop, this thread only pumps events and simulates
 int application_loop(cube_application *application)
 {
     CUBE_BEGIN_FUNCTION
-    SDL_Event event;
+    const cube_input_event *input_event;
+    uint32_t event_count;
+    uint32_t event_index;
     application->loop = SDL_TRUE;
     while (application->loop == SDL_TRUE)
     {
         CUBE_ASSERT(
-            graphics_render(
-                application->graphics) == CUBE_SUCCESS,
+            application_render_failed(
+                application->render) == SDL_FALSE,
             "render error")
-        if (SDL_PollEvent(&event) > 0)
+        event_count = application_input_poll(application->input, CUBE_SIMULATION_INTERVAL);
+        for (event_index = 0; event_index < event_count; event_index++)
         {
-            switch (event.type)
+            input_event = application->input->events + event_index;
+            switch (input_event->event.type)
             {
             case SDL_QUIT:
                 application->loop = SDL_FALSE;
@@ -42,21 +105,63 @@ int application_loop(cube_application *application)
             case SDL_KEYDOWN:
                 application_handle_keyboard_event(
                     application,
-                    (SDL_KeyboardEvent *)&event);
+                    (SDL_KeyboardEvent *)&input_event->event);
                 break;
             }
+            // the next published scene reflects this event
+            application->scene.input_id = input_event->id;
         }
+        CUBE_PROFILE_BEGIN(simulate_zone)
+        application_simulate(application);
+        CUBE_PROFILE_END(simulate_zone, "application_simulate")
+        application_render_publish(application->render, &application->scene);
     }
     CUBE_END_FUNCTION
 }
 
 void application_destroy(cube_application *application)
 {
+    application_destroy_render(application->render);
+    if (application->input != NULL)
+    {
+        application_input_report(application->input);
+        application_destroy_input(application->input);
+    }
+    // graphics may still be reloading shaders through the workers,
+    // and the workers may still be decoding into audio
     graphics_destroy(application->graphics);
+    application_destroy_resources(application->resources);
+    audio_destroy(application->audio);
+    application_destroy_jobs(application->jobs);
     free(application);
+#ifdef CUBE_PROFILE
+    // every thread that recorded has been joined
+    application_destroy_profile();
+#endif
     SDL_Quit();
 }
 
+void application_simulate(cube_application *application)
+{
+    Uint64 now;
+    float elapsed;
+
+    if (application->simulation_fixed == SDL_TRUE)
+    {
+        application->scene.tick++;
+        return;
+    }
+    now = SDL_GetPerformanceCounter();
+    elapsed = (float)(now - application->simulation_counter) / (float)SDL_GetPerformanceFrequency();
+    application->simulation_counter = now;
+
+    // wrapped so the angle keeps its precision over long runs
+    application->scene.angle = fmodf(
+        application->scene.angle + elapsed * CUBE_SIMULATION_DEGREES_PER_SECOND * 3.14159265f / 180.0f,
+        2.0f * 3.14159265f);
+    application->scene.tick++;
+}
+
 void application_handle_keyboard_event(
     cube_application *application,
     const SDL_KeyboardEvent *const keyboard_event)
@@ -67,6 +172,9 @@ void application_handle_keyboard_event(
         {
             application->loop = SDL_FALSE;
         }
-        // TODO: handle else
+        else
+        {
+            audio_play_random(application->audio);
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "cube.h"
+
+#define CUBE_INPUT_MICROSECONDS 1000000
+
+static void application_input_stamp(cube_input *input, cube_input_event *input_event);
+static double application_input_milliseconds(const cube_input *input, Uint64 counter);
+
+int application_create_input(cube_input **input)
+{
+    CUBE_BEGIN_FUNCTION
+    CUBE_ASSERT(input != NULL, "invalid input handle")
+
+    *input = calloc(1, sizeof(cube_input));
+    CUBE_ASSERT(*input != NULL, "failed to allocate input")
+
+    (*input)->frequency = SDL_GetPerformanceFrequency();
+    // zero is reserved for a scene no event has reached yet
+    (*input)->next_id = 1;
+    CUBE_END_FUNCTION
+}
+
+// waits up to timeout for the first event, then drains whatever else is queued
+uint32_t application_input_poll(cube_input *input, Sint32 timeout)
+{
+    cube_input_event *input_event;
+
+    input->event_count = 0;
+    input_event = input->events;
+    if (SDL_WaitEventTimeout(&input_event->event, timeout) <= 0)
+    {
+        return 0;
+    }
+    do
+    {
+        application_input_stamp(input, input_event);
+        input->event_count++;
+        if (input->event_count == CUBE_INPUT_EVENT_CAPACITY)
+        {
+            break;
+        }
+        input_event = input->events + input->event_count;
+    } while (SDL_PollEvent(&input_event->event) > 0);
+    return input->event_count;
+}
+
+// every event up to input_id was applied to the scene this frame showed
+void application_input_present(cube_input *input, Uint64 input_id, Uint64 present_counter)
+{
+    cube_input_trace *trace;
+    Uint64 trace_id;
+    Uint64 stamped_id;
+    Uint64 timestamp;
+    Uint64 latency;
+    int sequence;
+    Uint64 microseconds;
+    uint32_t bucket;
+
+    for (trace_id = input->presented_id + 1; trace_id <= input_id; trace_id++)
+    {
+        trace = input->traces + (trace_id & (CUBE_INPUT_TRACE_CAPACITY - 1));
+        sequence = SDL_AtomicGet(&trace->sequence);
+        SDL_MemoryBarrierAcquire();
+        stamped_id = trace->id;
+        timestamp = trace->timestamp;
+        SDL_MemoryBarrierAcquire();
+
+        // torn by a concurrent stamp or already overwritten by a newer event, the render thread fell too far behind
+        if ((sequence & 1) != 0 ||
+            SDL_AtomicGet(&trace->sequence) != sequence ||
+            stamped_id != trace_id ||
+            timestamp > present_counter)
+        {
+            input->dropped_count++;
+            continue;
+        }
+        latency = present_counter - timestamp;
+        microseconds = (latency * CUBE_INPUT_MICROSECONDS) / input->frequency;
+        bucket = 0;
+        while (bucket + 1 < CUBE_INPUT_HISTOGRAM_BUCKETS && (microseconds >> (bucket + 1)) > 0)
+        {
+            bucket++;
+        }
+        input->histogram[bucket]++;
+        input->sample_count++;
+        input->latency_sum += latency;
+        input->latency_max = SDL_max(input->latency_max, latency);
+    }
+    input->presented_id = SDL_max(input->presented_id, input_id);
+}
+
+void application_input_report(const cube_input *input)
+{
+    Uint64 cumulative;
+    Uint64 p50;
+    Uint64 p99;
+    uint32_t bucket;
+
+    if (input->sample_count == 0)
+    {
+        return;
+    }
+    p50 = 0;
+    p99 = 0;
+    cumulative = 0;
+    for (bucket = 0; bucket < CUBE_INPUT_HISTOGRAM_BUCKETS; bucket++)
+    {
+        cumulative += input->histogram[bucket];
+        if (p50 == 0 && cumulative * 2 >= input->sample_count)
+        {
+            p50 = (Uint64)1 << (bucket + 1);
+        }
+        if (p99 == 0 && cumulative * 100 >= input->sample_count * 99)
+        {
+            p99 = (Uint64)1 << (bucket + 1);
+        }
+    }
+    printf(
+        "input to present latency: %llu events, %llu dropped, mean %.3f ms, max %.3f ms, p50 < %.3f ms, p99 < %.3f ms\n",
+        (unsigned long long)input->sample_count,
+        (unsigned long long)input->dropped_count,
+        application_input_milliseconds(input, input->latency_sum / input->sample_count),
+        application_input_milliseconds(input, input->latency_max),
+        (double)p50 / 1000.0,
+        (double)p99 / 1000.0);
+    for (bucket = 0; bucket < CUBE_INPUT_HISTOGRAM_BUCKETS; bucket++)
+    {
+        if (input->histogram[bucket] > 0)
+        {
+            printf(
+                "    [%10llu us, %10llu us) %llu\n",
+                (unsigned long long)((bucket == 0) ? 0 : ((Uint64)1 << bucket)),
+                (unsigned long long)((Uint64)1 << (bucket + 1)),
+                (unsigned long long)input->histogram[bucket]);
+        }
+    }
+}
+
+void application_destroy_input(cube_input *input)
+{
+    free(input);
+}
+
+void application_input_stamp(cube_input *input, cube_input_event *input_event)
+{
+    cube_input_trace *trace;
+    int sequence;
+
+    input_event->id = input->next_id++;
+    input_event->timestamp = SDL_GetPerformanceCounter();
+    trace = input->traces + (input_event->id & (CUBE_INPUT_TRACE_CAPACITY - 1));
+
+    // only this thread writes the sequence, so a plain increment around the stores is enough
+    sequence = SDL_AtomicGet(&trace->sequence);
+    SDL_AtomicSet(&trace->sequence, sequence + 1);
+    SDL_MemoryBarrierRelease();
+    trace->timestamp = input_event->timestamp;
+    trace->id = input_event->id;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&trace->sequence, sequence + 2);
+}
+
+double application_input_milliseconds(const cube_input *input, Uint64 counter)
+{
+    return ((double)counter * 1000.0) / (double)input->frequency;
+}
\ No newline at end of file
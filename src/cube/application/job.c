@@ -0,0 +1,363 @@
+#include "cube.h"
+
+#define CUBE_JOB_THREADS_VARIABLE "CUBE_JOB_THREADS"
+#define CUBE_JOB_SPIN_COUNT 64
+#define CUBE_JOB_SLEEP_MILLISECONDS 1
+
+static int application_jobs_worker(void *data);
+static SDL_bool application_jobs_push(cube_job_worker *worker, const cube_job *job);
+static SDL_bool application_jobs_pop(cube_job_worker *worker, cube_job *job);
+static SDL_bool application_jobs_steal(cube_job_worker *worker, cube_job *job);
+static SDL_bool application_jobs_find(cube_jobs *jobs, cube_job_worker *worker, cube_job *job);
+static void application_jobs_run(const cube_job *job);
+
+// the calling thread helps while it waits, so it counts as one of the cores
+int application_create_jobs(cube_jobs **jobs, uint32_t worker_count)
+{
+    CUBE_BEGIN_FUNCTION
+    const char *thread_variable;
+    cube_job_worker *worker;
+    uint32_t worker_index;
+
+    CUBE_ASSERT(jobs != NULL, "invalid jobs handle")
+
+    if (worker_count == CUBE_JOB_DEFAULT_WORKERS)
+    {
+        thread_variable = SDL_getenv(CUBE_JOB_THREADS_VARIABLE);
+        worker_count = (thread_variable != NULL)
+                           ? (uint32_t)SDL_atoi(thread_variable)
+                           : (uint32_t)SDL_max(SDL_GetCPUCount() - 1, 0);
+    }
+    worker_count = SDL_min(worker_count, CUBE_JOB_MAX_WORKERS);
+
+    *jobs = calloc(1, sizeof(cube_jobs));
+    CUBE_ASSERT(*jobs != NULL, "failed to allocate jobs")
+    (*jobs)->worker_key = SDL_TLSCreate();
+    CUBE_ASSERT((*jobs)->worker_key != 0, SDL_GetError())
+    (*jobs)->wake = SDL_CreateSemaphore(0);
+    CUBE_ASSERT((*jobs)->wake != NULL, SDL_GetError())
+    (*jobs)->injection_mutex = SDL_CreateMutex();
+    CUBE_ASSERT((*jobs)->injection_mutex != NULL, SDL_GetError())
+    if (worker_count == 0)
+    {
+        goto done;
+    }
+
+    (*jobs)->workers = calloc(worker_count, sizeof(cube_job_worker));
+    CUBE_ASSERT((*jobs)->workers != NULL, "failed to allocate job workers")
+    (*jobs)->worker_count = worker_count;
+    SDL_AtomicSet(&(*jobs)->running, 1);
+    for (worker_index = 0; worker_index < worker_count; worker_index++)
+    {
+        worker = (*jobs)->workers + worker_index;
+        worker->index = worker_index;
+        worker->victim = (worker_index + 1) % worker_count;
+        worker->jobs = *jobs;
+        worker->thread = SDL_CreateThread(application_jobs_worker, "cube_job", worker);
+        CUBE_ASSERT(worker->thread != NULL, SDL_GetError())
+    }
+    CUBE_END_FUNCTION
+}
+
+// workers push onto their own deque, every other thread goes through the injection ring;
+// with no room left the job runs before this returns
+void application_jobs_submit(
+    cube_jobs *jobs,
+    cube_job_function function,
+    void *data,
+    uint32_t begin,
+    uint32_t end,
+    cube_job_counter *counter)
+{
+    cube_job_worker *worker;
+    cube_job job;
+    SDL_bool queued;
+
+    job.function = function;
+    job.data = data;
+    job.begin = begin;
+    job.end = end;
+    job.counter = counter;
+    if (counter != NULL)
+    {
+        SDL_AtomicAdd(&counter->pending, 1);
+    }
+
+    worker = SDL_TLSGet(jobs->worker_key);
+    if (worker != NULL)
+    {
+        queued = application_jobs_push(worker, &job);
+    }
+    else
+    {
+        SDL_LockMutex(jobs->injection_mutex);
+        queued = (jobs->injection_tail - jobs->injection_head < CUBE_JOB_CAPACITY) ? SDL_TRUE : SDL_FALSE;
+        if (queued)
+        {
+            jobs->injection[jobs->injection_tail % CUBE_JOB_CAPACITY] = job;
+            jobs->injection_tail++;
+            SDL_AtomicAdd(&jobs->injected, 1);
+        }
+        SDL_UnlockMutex(jobs->injection_mutex);
+    }
+
+    if (!queued)
+    {
+        application_jobs_run(&job);
+    }
+    else if (SDL_AtomicGet(&jobs->sleeping) > 0)
+    {
+        SDL_SemPost(jobs->wake);
+    }
+}
+
+// runs one queued job on the calling thread, reports whether there was one
+SDL_bool application_jobs_help(cube_jobs *jobs)
+{
+    cube_job job;
+
+    if (!application_jobs_find(jobs, SDL_TLSGet(jobs->worker_key), &job))
+    {
+        return SDL_FALSE;
+    }
+    application_jobs_run(&job);
+    return SDL_TRUE;
+}
+
+// never sleeps, the jobs still pending may be sitting in this thread's own deque
+void application_jobs_wait(cube_jobs *jobs, cube_job_counter *counter)
+{
+    while (SDL_AtomicGet(&counter->pending) > 0)
+    {
+        if (!application_jobs_help(jobs))
+        {
+            SDL_CPUPauseInstruction();
+        }
+    }
+}
+
+// splits [0, count) into ranges of grain items, a grain of zero spreads four ranges per core
+void application_jobs_parallel_for(
+    cube_jobs *jobs,
+    cube_job_function function,
+    void *data,
+    uint32_t count,
+    uint32_t grain)
+{
+    cube_job_counter counter;
+    uint32_t begin;
+
+    if (count == 0)
+    {
+        return;
+    }
+    if (grain == 0)
+    {
+        grain = SDL_max(count / ((jobs->worker_count + 1) * 4), 1);
+    }
+    if (jobs->worker_count == 0 || count <= grain)
+    {
+        function(data, 0, count);
+        return;
+    }
+
+    // the first range stays on this thread, the rest are up for stealing meanwhile
+    SDL_AtomicSet(&counter.pending, 0);
+    for (begin = grain; begin < count; begin += grain)
+    {
+        application_jobs_submit(jobs, function, data, begin, SDL_min(begin + grain, count), &counter);
+    }
+    function(data, 0, grain);
+    application_jobs_wait(jobs, &counter);
+}
+
+// every job has run by the time the workers are joined
+void application_destroy_jobs(cube_jobs *jobs)
+{
+    uint32_t worker_index;
+
+    if (jobs != NULL)
+    {
+        while (application_jobs_help(jobs))
+        {
+        }
+        SDL_AtomicSet(&jobs->running, 0);
+        for (worker_index = 0; worker_index < jobs->worker_count; worker_index++)
+        {
+            SDL_SemPost(jobs->wake);
+        }
+        for (worker_index = 0; worker_index < jobs->worker_count; worker_index++)
+        {
+            if ((jobs->workers + worker_index)->thread != NULL)
+            {
+                SDL_WaitThread((jobs->workers + worker_index)->thread, NULL);
+            }
+        }
+        SDL_DestroyMutex(jobs->injection_mutex);
+        SDL_DestroySemaphore(jobs->wake);
+        free(jobs->workers);
+        free(jobs);
+    }
+}
+
+int application_jobs_worker(void *data)
+{
+    cube_job_worker *worker;
+    cube_jobs *jobs;
+    cube_job job;
+    uint32_t spin;
+
+    worker = data;
+    jobs = worker->jobs;
+    SDL_TLSSet(jobs->worker_key, worker, NULL);
+    CUBE_PROFILE_THREAD("job")
+    spin = 0;
+    for (;;)
+    {
+        if (application_jobs_find(jobs, worker, &job))
+        {
+            application_jobs_run(&job);
+            spin = 0;
+            continue;
+        }
+        if (SDL_AtomicGet(&jobs->running) == 0)
+        {
+            break;
+        }
+        if (++spin < CUBE_JOB_SPIN_COUNT)
+        {
+            SDL_CPUPauseInstruction();
+            continue;
+        }
+
+        // announced before the last look, a submit after it sees the sleeper and posts
+        SDL_AtomicAdd(&jobs->sleeping, 1);
+        if (!application_jobs_find(jobs, worker, &job))
+        {
+            SDL_SemWaitTimeout(jobs->wake, CUBE_JOB_SLEEP_MILLISECONDS);
+            SDL_AtomicAdd(&jobs->sleeping, -1);
+            continue;
+        }
+        SDL_AtomicAdd(&jobs->sleeping, -1);
+        application_jobs_run(&job);
+        spin = 0;
+    }
+    return 0;
+}
+
+// indices only grow, differences are taken unsigned so they survive the wrap
+SDL_bool application_jobs_push(cube_job_worker *worker, const cube_job *job)
+{
+    uint32_t bottom;
+    uint32_t top;
+
+    bottom = (uint32_t)SDL_AtomicGet(&worker->bottom);
+    top = (uint32_t)SDL_AtomicGet(&worker->top);
+    if (bottom - top >= CUBE_JOB_CAPACITY)
+    {
+        return SDL_FALSE;
+    }
+    worker->slots[bottom % CUBE_JOB_CAPACITY] = *job;
+    SDL_AtomicSet(&worker->bottom, (int)(bottom + 1));
+    return SDL_TRUE;
+}
+
+// owner only, newest first so a range is still warm when it runs
+SDL_bool application_jobs_pop(cube_job_worker *worker, cube_job *job)
+{
+    uint32_t bottom;
+    uint32_t top;
+
+    bottom = (uint32_t)SDL_AtomicGet(&worker->bottom) - 1;
+    SDL_AtomicSet(&worker->bottom, (int)bottom);
+    top = (uint32_t)SDL_AtomicGet(&worker->top);
+    if ((int)(bottom - top) < 0)
+    {
+        SDL_AtomicSet(&worker->bottom, (int)top);
+        return SDL_FALSE;
+    }
+    *job = worker->slots[bottom % CUBE_JOB_CAPACITY];
+    if (bottom != top)
+    {
+        return SDL_TRUE;
+    }
+
+    // the last job, a thief may be after it too
+    SDL_AtomicSet(&worker->bottom, (int)(top + 1));
+    return SDL_AtomicCAS(&worker->top, (int)top, (int)(top + 1));
+}
+
+// any thread, oldest first; the copy only counts if top has not moved meanwhile
+SDL_bool application_jobs_steal(cube_job_worker *worker, cube_job *job)
+{
+    uint32_t bottom;
+    uint32_t top;
+
+    top = (uint32_t)SDL_AtomicGet(&worker->top);
+    bottom = (uint32_t)SDL_AtomicGet(&worker->bottom);
+    if ((int)(bottom - top) <= 0)
+    {
+        return SDL_FALSE;
+    }
+    *job = worker->slots[top % CUBE_JOB_CAPACITY];
+    return SDL_AtomicCAS(&worker->top, (int)top, (int)(top + 1));
+}
+
+// own deque, then the injection ring, then one pass over the other workers
+SDL_bool application_jobs_find(cube_jobs *jobs, cube_job_worker *worker, cube_job *job)
+{
+    uint32_t victim;
+    uint32_t attempt;
+    SDL_bool found;
+
+    if (worker != NULL && application_jobs_pop(worker, job))
+    {
+        return SDL_TRUE;
+    }
+
+    // idle workers look at the count rather than queue up on the lock
+    if (SDL_AtomicGet(&jobs->injected) > 0)
+    {
+        found = SDL_FALSE;
+        SDL_LockMutex(jobs->injection_mutex);
+        if (jobs->injection_head != jobs->injection_tail)
+        {
+            *job = jobs->injection[jobs->injection_head % CUBE_JOB_CAPACITY];
+            jobs->injection_head++;
+            SDL_AtomicAdd(&jobs->injected, -1);
+            found = SDL_TRUE;
+        }
+        SDL_UnlockMutex(jobs->injection_mutex);
+        if (found)
+        {
+            return SDL_TRUE;
+        }
+    }
+
+    victim = (worker != NULL) ? worker->victim : 0;
+    for (attempt = 0; attempt < jobs->worker_count; attempt++)
+    {
+        if ((jobs->workers + victim) != worker && application_jobs_steal(jobs->workers + victim, job))
+        {
+            // the next search starts where this one succeeded
+            if (worker != NULL)
+            {
+                worker->victim = victim;
+            }
+            return SDL_TRUE;
+        }
+        victim = (victim + 1) % jobs->worker_count;
+    }
+    return SDL_FALSE;
+}
+
+void application_jobs_run(const cube_job *job)
+{
+    CUBE_PROFILE_BEGIN(job_zone)
+    job->function(job->data, job->begin, job->end);
+    CUBE_PROFILE_END(job_zone, "job")
+    if (job->counter != NULL)
+    {
+        SDL_AtomicAdd(&job->counter->pending, -1);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include "cube.h"
+
+#ifdef CUBE_PROFILE
+
+#define CUBE_PROFILE_OUTPUT_VARIABLE "CUBE_PROFILE_OUTPUT"
+#define CUBE_PROFILE_OUTPUT_DEFAULT "cube_trace.json"
+#define CUBE_PROFILE_CPU_PROCESS 1
+#define CUBE_PROFILE_GPU_PROCESS 2
+
+static cube_profile *application_profile;
+
+static cube_profile_thread *application_profile_current(void);
+static void application_profile_record(cube_profile_kind kind, const char *name, Uint64 start, Sint64 value);
+static double application_profile_microseconds(Uint64 counter);
+static int application_profile_write(const char *path);
+
+// one instance per process, so zones can be recorded from anywhere without a handle
+int application_create_profile(void)
+{
+    CUBE_BEGIN_FUNCTION
+    application_profile = calloc(1, sizeof(cube_profile));
+    CUBE_ASSERT(application_profile != NULL, "failed to allocate profile")
+    application_profile->thread_key = SDL_TLSCreate();
+    CUBE_ASSERT(application_profile->thread_key != 0, SDL_GetError())
+    application_profile->mutex = SDL_CreateMutex();
+    CUBE_ASSERT(application_profile->mutex != NULL, SDL_GetError())
+    application_profile->origin = SDL_GetPerformanceCounter();
+    application_profile->frequency = SDL_GetPerformanceFrequency();
+    CUBE_END_FUNCTION
+}
+
+// names the calling thread in the trace, registering it if this is its first event
+void application_profile_thread(const char *name)
+{
+    cube_profile_thread *thread;
+
+    thread = application_profile_current();
+    if (thread != NULL)
+    {
+        thread->name = name;
+    }
+}
+
+void application_profile_zone(const char *name, Uint64 start)
+{
+    application_profile_record(CUBE_PROFILE_KIND_ZONE, name, start, (Sint64)SDL_GetPerformanceCounter());
+}
+
+// start and end are already on the host clock, the caller has done the calibration
+void application_profile_gpu_zone(const char *name, Uint64 start, Uint64 end)
+{
+    application_profile_record(CUBE_PROFILE_KIND_GPU_ZONE, name, start, (Sint64)end);
+}
+
+void application_profile_counter(const char *name, Sint64 value)
+{
+    application_profile_record(CUBE_PROFILE_KIND_COUNTER, name, SDL_GetPerformanceCounter(), value);
+}
+
+// every recording thread has stopped by now, the buffers are read as they stand
+void application_destroy_profile(void)
+{
+    const char *output_variable;
+    uint32_t thread_index;
+
+    if (application_profile != NULL)
+    {
+        output_variable = SDL_getenv(CUBE_PROFILE_OUTPUT_VARIABLE);
+        if (output_variable == NULL)
+        {
+            output_variable = CUBE_PROFILE_OUTPUT_DEFAULT;
+        }
+        if (application_profile_write(output_variable) == CUBE_SUCCESS)
+        {
+            printf("wrote trace to %s\n", output_variable);
+        }
+        for (thread_index = 0; thread_index < application_profile->thread_count; thread_index++)
+        {
+            free(application_profile->threads[thread_index]);
+        }
+        SDL_DestroyMutex(application_profile->mutex);
+        free(application_profile);
+        application_profile = NULL;
+    }
+}
+
+// the lock is only taken the first time a thread records
+cube_profile_thread *application_profile_current(void)
+{
+    cube_profile_thread *thread;
+
+    if (application_profile == NULL)
+    {
+        return NULL;
+    }
+    thread = SDL_TLSGet(application_profile->thread_key);
+    if (thread != NULL)
+    {
+        return thread;
+    }
+
+    SDL_LockMutex(application_profile->mutex);
+    if (application_profile->thread_count < CUBE_PROFILE_MAX_THREADS)
+    {
+        thread = calloc(1, sizeof(cube_profile_thread));
+        if (thread != NULL)
+        {
+            application_profile->threads[application_profile->thread_count++] = thread;
+            SDL_TLSSet(application_profile->thread_key, thread, NULL);
+        }
+    }
+    SDL_UnlockMutex(application_profile->mutex);
+    return thread;
+}
+
+// a full buffer drops the newest events and counts them, it never blocks the thread
+void application_profile_record(cube_profile_kind kind, const char *name, Uint64 start, Sint64 value)
+{
+    cube_profile_thread *thread;
+    cube_profile_event *event;
+    int count;
+
+    thread = application_profile_current();
+    if (thread == NULL)
+    {
+        return;
+    }
+    count = SDL_AtomicGet(&thread->count);
+    if (count == CUBE_PROFILE_EVENT_CAPACITY)
+    {
+        SDL_AtomicAdd(&thread->dropped, 1);
+        return;
+    }
+    event = thread->events + count;
+    event->name = name;
+    event->kind = kind;
+    event->start = start;
+    event->value = value;
+    SDL_AtomicSet(&thread->count, count + 1);
+}
+
+double application_profile_microseconds(Uint64 counter)
+{
+    return (double)(Sint64)(counter - application_profile->origin) * 1e6 / (double)application_profile->frequency;
+}
+
+// chrome trace event format, loads in chrome://tracing and ui.perfetto.dev
+int application_profile_write(const char *path)
+{
+    CUBE_BEGIN_FUNCTION
+    FILE *file;
+    cube_profile_thread *thread;
+    const cube_profile_event *event;
+    uint32_t thread_index;
+    int event_index;
+    int event_count;
+    const char *separator;
+
+    file = fopen(path, "w");
+    CUBE_ASSERT(file != NULL, strerror(errno))
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(
+        file,
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"cpu\"}},\n"
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"gpu\"}},\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":1,\"args\":{\"name\":\"graphics queue\"}}",
+        CUBE_PROFILE_CPU_PROCESS,
+        CUBE_PROFILE_GPU_PROCESS,
+        CUBE_PROFILE_GPU_PROCESS);
+    separator = ",\n";
+    for (thread_index = 0; thread_index < application_profile->thread_count; thread_index++)
+    {
+        thread = application_profile->threads[thread_index];
+        event_count = SDL_AtomicGet(&thread->count);
+        fprintf(
+            file,
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+            separator,
+            CUBE_PROFILE_CPU_PROCESS,
+            thread_index + 1,
+            (thread->name != NULL) ? thread->name : "thread");
+        if (SDL_AtomicGet(&thread->dropped) > 0)
+        {
+            fprintf(
+                stderr,
+                "profile: %s dropped %d events\n",
+                (thread->name != NULL) ? thread->name : "thread",
+                SDL_AtomicGet(&thread->dropped));
+        }
+        for (event_index = 0; event_index < event_count; event_index++)
+        {
+            event = thread->events + event_index;
+            switch (event->kind)
+            {
+            case CUBE_PROFILE_KIND_ZONE:
+                fprintf(
+                    file,
+                    "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    separator,
+                    event->name,
+                    CUBE_PROFILE_CPU_PROCESS,
+                    thread_index + 1,
+                    application_profile_microseconds(event->start),
+                    application_profile_microseconds((Uint64)event->value) - application_profile_microseconds(event->start));
+                break;
+            case CUBE_PROFILE_KIND_GPU_ZONE:
+                fprintf(
+                    file,
+                    "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                    separator,
+                    event->name,
+                    CUBE_PROFILE_GPU_PROCESS,
+                    application_profile_microseconds(event->start),
+                    application_profile_microseconds((Uint64)event->value) - application_profile_microseconds(event->start));
+                break;
+            case CUBE_PROFILE_KIND_COUNTER:
+                fprintf(
+                    file,
+                    "%s{\"name\":\"%s\",\"ph\":\"C\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+                    separator,
+                    event->name,
+                    CUBE_PROFILE_CPU_PROCESS,
+                    thread_index + 1,
+                    application_profile_microseconds(event->start),
+                    (long long)event->value);
+                break;
+            }
+        }
+    }
+    fprintf(file, "\n]}\n");
+    CUBE_ASSERT(fclose(file) == 0, strerror(errno))
+    CUBE_END_FUNCTION
+}
+
+#endif
\ No newline at end of file
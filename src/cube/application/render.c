@@ -0,0 +1,252 @@
+#include "cube.h"
+
+#define CUBE_RENDER_SCENE_FRESH 4
+#define CUBE_RENDER_SCENE_INDEX 3
+#define CUBE_RENDER_FRAME_LIMIT_VARIABLE "CUBE_FRAME_LIMIT"
+#define CUBE_RENDER_METRICS_VARIABLE "CUBE_METRICS"
+
+static int application_render_thread(void *data);
+static int application_render_pop(cube_render *render, cube_render_command *command);
+static const cube_scene *application_render_consume(cube_render *render);
+static void application_render_measure(cube_render *render);
+static int application_render_report(const cube_render *render, const char *path);
+static int application_render_compare_times(const void *a, const void *b);
+
+int application_create_render(
+    cube_render **render,
+    cube_graphics *graphics,
+    cube_input *input,
+    const cube_scene *scene,
+    Uint64 start_counter)
+{
+    CUBE_BEGIN_FUNCTION
+    uint32_t slot;
+    const char *frame_limit_variable;
+
+    CUBE_ASSERT(render != NULL, "invalid render handle")
+
+    *render = SDL_SIMDAlloc(sizeof(cube_render));
+    CUBE_ASSERT(*render != NULL, "failed to allocate render")
+    SDL_memset(*render, 0, sizeof(cube_render));
+
+    (*render)->graphics = graphics;
+    (*render)->input = input;
+    for (slot = 0; slot < CUBE_RENDER_SCENE_SLOTS; slot++)
+    {
+        (*render)->exchange.scenes[slot] = *scene;
+    }
+    (*render)->exchange.back = 0;
+    (*render)->exchange.front = 1;
+    SDL_AtomicSet(&(*render)->exchange.shared, 2);
+    SDL_AtomicSet(&(*render)->queue.head, 0);
+    SDL_AtomicSet(&(*render)->queue.tail, 0);
+    SDL_AtomicSet(&(*render)->failed, 0);
+    (*render)->start_counter = start_counter;
+    // a limited run asks the main thread to quit once the last frame is presented
+    frame_limit_variable = SDL_getenv(CUBE_RENDER_FRAME_LIMIT_VARIABLE);
+    (*render)->frame_limit = (frame_limit_variable != NULL) ? SDL_strtoull(frame_limit_variable, NULL, 10) : 0;
+
+    (*render)->thread = SDL_CreateThread(application_render_thread, "cube_render", *render);
+    CUBE_ASSERT((*render)->thread != NULL, SDL_GetError())
+    CUBE_END_FUNCTION
+}
+
+// producer side, only ever called from the main thread
+int application_render_push(cube_render *render, const cube_render_command *command)
+{
+    CUBE_BEGIN_FUNCTION
+    int head;
+    int tail;
+
+    tail = SDL_AtomicGet(&render->queue.tail);
+    head = SDL_AtomicGet(&render->queue.head);
+    CUBE_ASSERT(tail - head < CUBE_RENDER_QUEUE_CAPACITY, "render queue is full")
+
+    render->queue.commands[tail & (CUBE_RENDER_QUEUE_CAPACITY - 1)] = *command;
+    SDL_AtomicSet(&render->queue.tail, tail + 1);
+    CUBE_END_FUNCTION
+}
+
+// the back slot is swapped into the shared slot, never copied while the render thread reads
+void application_render_publish(cube_render *render, const cube_scene *scene)
+{
+    int shared;
+
+    render->exchange.scenes[render->exchange.back] = *scene;
+    shared = SDL_AtomicSet(
+        &render->exchange.shared,
+        render->exchange.back | CUBE_RENDER_SCENE_FRESH);
+    render->exchange.back = shared & CUBE_RENDER_SCENE_INDEX;
+}
+
+SDL_bool application_render_failed(cube_render *render)
+{
+    return (SDL_AtomicGet(&render->failed) != 0) ? SDL_TRUE : SDL_FALSE;
+}
+
+void application_destroy_render(cube_render *render)
+{
+    const cube_render_command stop_command = {
+        .type = CUBE_RENDER_COMMAND_STOP,
+    };
+    const char *metrics_variable;
+
+    if (render != NULL)
+    {
+        if (render->thread != NULL)
+        {
+            // a failed render thread has already left its loop and stopped draining
+            while (application_render_failed(render) == SDL_FALSE &&
+                   application_render_push(render, &stop_command) != CUBE_SUCCESS)
+            {
+                SDL_Delay(1);
+            }
+            SDL_WaitThread(render->thread, NULL);
+        }
+        metrics_variable = SDL_getenv(CUBE_RENDER_METRICS_VARIABLE);
+        if (metrics_variable != NULL && render->frame_count > 0)
+        {
+            application_render_report(render, metrics_variable);
+        }
+        SDL_SIMDFree(render);
+    }
+}
+
+int application_render_thread(void *data)
+{
+    cube_render *render;
+    cube_render_command command;
+    const cube_scene *scene;
+
+    render = data;
+    CUBE_PROFILE_THREAD("render")
+    for (;;)
+    {
+        while (application_render_pop(render, &command) == CUBE_SUCCESS)
+        {
+            switch (command.type)
+            {
+            case CUBE_RENDER_COMMAND_STOP:
+                return CUBE_SUCCESS;
+            }
+        }
+        if (render->frame_limit > 0 && render->frame_count >= render->frame_limit)
+        {
+            SDL_Delay(1);
+            continue;
+        }
+        scene = application_render_consume(render);
+        if (graphics_render(render->graphics, scene) != CUBE_SUCCESS)
+        {
+            SDL_AtomicSet(&render->failed, 1);
+            return CUBE_FAILURE;
+        }
+        application_input_present(
+            render->input,
+            scene->input_id,
+            SDL_GetPerformanceCounter());
+        application_render_measure(render);
+    }
+}
+
+int application_render_pop(cube_render *render, cube_render_command *command)
+{
+    int head;
+    int tail;
+
+    head = SDL_AtomicGet(&render->queue.head);
+    tail = SDL_AtomicGet(&render->queue.tail);
+    if (head == tail)
+    {
+        return CUBE_FAILURE;
+    }
+    *command = render->queue.commands[head & (CUBE_RENDER_QUEUE_CAPACITY - 1)];
+    SDL_AtomicSet(&render->queue.head, head + 1);
+    return CUBE_SUCCESS;
+}
+
+// keeps drawing the last scene when the main thread has not published since
+const cube_scene *application_render_consume(cube_render *render)
+{
+    int shared;
+
+    if ((SDL_AtomicGet(&render->exchange.shared) & CUBE_RENDER_SCENE_FRESH) != 0)
+    {
+        shared = SDL_AtomicSet(&render->exchange.shared, render->exchange.front);
+        render->exchange.front = shared & CUBE_RENDER_SCENE_INDEX;
+    }
+    return &render->exchange.scenes[render->exchange.front];
+}
+
+void application_render_measure(cube_render *render)
+{
+    Uint64 now;
+    SDL_Event quit_event;
+
+    now = SDL_GetPerformanceCounter();
+    if (render->frame_count == 0)
+    {
+        render->startup = now - render->start_counter;
+    }
+    else if (render->frame_count - 1 < CUBE_RENDER_METRIC_CAPACITY)
+    {
+        render->frame_times[render->frame_count - 1] = now - render->last_counter;
+    }
+    render->last_counter = now;
+    render->frame_count++;
+    if (render->frame_count == render->frame_limit)
+    {
+        SDL_zero(quit_event);
+        quit_event.type = SDL_QUIT;
+        SDL_PushEvent(&quit_event);
+    }
+}
+
+// one name and value per line, every value a time in milliseconds
+int application_render_report(const cube_render *render, const char *path)
+{
+    CUBE_BEGIN_FUNCTION
+    FILE *file;
+    Uint64 *frame_times;
+    Uint64 frame_time_count;
+    Uint64 frame_time_sum;
+    Uint64 frame_index;
+    double milliseconds;
+    int write_error;
+
+    milliseconds = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    frame_time_count = SDL_min(render->frame_count - 1, (Uint64)CUBE_RENDER_METRIC_CAPACITY);
+    frame_times = CUBE_CALLOC(frame_time_count + 1, sizeof(Uint64));
+    CUBE_ASSERT(frame_times != NULL, "failed to allocate frame times")
+    SDL_memcpy(frame_times, render->frame_times, frame_time_count * sizeof(Uint64));
+    SDL_qsort(frame_times, frame_time_count, sizeof(Uint64), application_render_compare_times);
+    frame_time_sum = 0;
+    for (frame_index = 0; frame_index < frame_time_count; frame_index++)
+    {
+        frame_time_sum += *(frame_times + frame_index);
+    }
+
+    file = fopen(path, "w");
+    CUBE_ASSERT(file != NULL, strerror(errno))
+    fprintf(file, "startup_ms %.3f\n", (double)render->startup * milliseconds);
+    if (frame_time_count > 0)
+    {
+        fprintf(file, "frame_mean_ms %.3f\n", (double)frame_time_sum / (double)frame_time_count * milliseconds);
+        fprintf(file, "frame_p50_ms %.3f\n", (double)*(frame_times + frame_time_count / 2) * milliseconds);
+        fprintf(file, "frame_p95_ms %.3f\n", (double)*(frame_times + frame_time_count * 95 / 100) * milliseconds);
+        fprintf(file, "frame_max_ms %.3f\n", (double)*(frame_times + frame_time_count - 1) * milliseconds);
+    }
+    write_error = ferror(file);
+    CUBE_ASSERT(fclose(file) == 0 && write_error == 0, "failed to write metrics")
+    CUBE_END_FUNCTION
+}
+
+int application_render_compare_times(const void *a, const void *b)
+{
+    const Uint64 *first;
+    const Uint64 *second;
+
+    first = a;
+    second = b;
+    return (*first > *second) - (*first < *second);
+}
\ No newline at end of file
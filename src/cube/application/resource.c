@@ -0,0 +1,378 @@
+#include "cube.h"
+
+#include <sys/stat.h>
+
+static int application_resources_scan(cube_resources *resources, const char *relative_directory);
+static int application_resources_add(cube_resources *resources, const char *relative_path, size_t file_size);
+static cube_resource_type application_resources_type(const char *file_name);
+static int application_resources_compare(const void *left, const void *right);
+static void application_resources_job(void *data, uint32_t begin, uint32_t end);
+
+static const struct
+{
+    const char *extension;
+    cube_resource_type type;
+} application_resources_extensions[] = {
+    {".spv", CUBE_RESOURCE_SHADER},
+    {".wav", CUBE_RESOURCE_SOUND},
+    {".obj", CUBE_RESOURCE_MESH},
+    {".gltf", CUBE_RESOURCE_MESH},
+    {".glb", CUBE_RESOURCE_MESH},
+    {".ktx2", CUBE_RESOURCE_TEXTURE},
+};
+
+int application_create_resources(
+    cube_resources **resources,
+    cube_jobs *jobs,
+    const char *directory)
+{
+    CUBE_BEGIN_FUNCTION
+    uint32_t resource_index;
+    cube_resource_type type;
+
+    CUBE_ASSERT(resources != NULL, "invalid resources handle")
+
+    *resources = calloc(1, sizeof(cube_resources));
+    CUBE_ASSERT(*resources != NULL, "failed to allocate resources")
+    (*resources)->directory = SDL_strdup(directory);
+    CUBE_ASSERT((*resources)->directory != NULL, "failed to allocate resource directory")
+    (*resources)->jobs = jobs;
+    SDL_AtomicSet(&(*resources)->running, 1);
+
+    // only names and sizes are read here, contents are left to the jobs
+    CUBE_ASSERT(application_resources_scan(*resources, NULL) == CUBE_SUCCESS, "failed to scan resources")
+    SDL_qsort(
+        (*resources)->resources,
+        (*resources)->resource_count,
+        sizeof(cube_resource),
+        application_resources_compare);
+    for (resource_index = (*resources)->resource_count; resource_index > 0; resource_index--)
+    {
+        type = ((*resources)->resources + resource_index - 1)->type;
+        (*resources)->type_first[type] = resource_index - 1;
+        (*resources)->type_count[type]++;
+    }
+
+    (*resources)->mutex = SDL_CreateMutex();
+    CUBE_ASSERT((*resources)->mutex != NULL, SDL_GetError())
+    (*resources)->completed = SDL_CreateCond();
+    CUBE_ASSERT((*resources)->completed != NULL, SDL_GetError())
+    CUBE_END_FUNCTION
+}
+
+int application_resources_find(
+    const cube_resources *resources,
+    cube_resource_type type,
+    const char *file_name,
+    uint32_t *resource)
+{
+    CUBE_BEGIN_FUNCTION
+    uint32_t resource_index;
+
+    for (resource_index = resources->type_first[type];
+         resource_index < resources->type_first[type] + resources->type_count[type];
+         resource_index++)
+    {
+        if (SDL_strcmp((resources->resources + resource_index)->file_name, file_name) == 0)
+        {
+            *resource = resource_index;
+            goto done;
+        }
+    }
+    CUBE_ASSERT(SDL_FALSE, "failed to find resource")
+    CUBE_END_FUNCTION
+}
+
+// queues the resource once, a resource already queued or loaded keeps its first callback
+int application_resources_load(
+    cube_resources *resources,
+    uint32_t resource,
+    cube_resource_callback callback,
+    void *userdata)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_resource *entry;
+
+    CUBE_ASSERT(resource < resources->resource_count, "invalid resource")
+    entry = resources->resources + resource;
+    if (!SDL_AtomicCAS(&entry->state, CUBE_RESOURCE_UNLOADED, CUBE_RESOURCE_QUEUED))
+    {
+        CUBE_ASSERT(SDL_AtomicGet(&entry->state) != CUBE_RESOURCE_FAILED, "resource failed to load")
+        goto done;
+    }
+    entry->callback = callback;
+    entry->userdata = userdata;
+    application_jobs_submit(
+        resources->jobs,
+        application_resources_job,
+        resources,
+        resource,
+        resource + 1,
+        &resources->pending);
+    CUBE_END_FUNCTION
+}
+
+// runs other jobs until the resource and its callback are done, queueing it first if nobody has
+int application_resources_wait(cube_resources *resources, uint32_t resource)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_resource *entry;
+
+    CUBE_ASSERT(
+        application_resources_load(
+            resources,
+            resource,
+            NULL,
+            NULL) == CUBE_SUCCESS,
+        "failed to load resource")
+    entry = resources->resources + resource;
+
+    // with nothing left to help with, the job is running elsewhere and will broadcast
+    while (SDL_AtomicGet(&entry->state) == CUBE_RESOURCE_QUEUED)
+    {
+        if (application_jobs_help(resources->jobs))
+        {
+            continue;
+        }
+        SDL_LockMutex(resources->mutex);
+        if (SDL_AtomicGet(&entry->state) == CUBE_RESOURCE_QUEUED)
+        {
+            SDL_CondWaitTimeout(resources->completed, resources->mutex, 1);
+        }
+        SDL_UnlockMutex(resources->mutex);
+    }
+    CUBE_ASSERT(SDL_AtomicGet(&entry->state) == CUBE_RESOURCE_LOADED, entry->path)
+    CUBE_END_FUNCTION
+}
+
+// frees the contents, the entry can be loaded again afterwards
+void application_resources_release(cube_resources *resources, uint32_t resource)
+{
+    cube_resource *entry;
+
+    entry = resources->resources + resource;
+    if (SDL_AtomicGet(&entry->state) == CUBE_RESOURCE_LOADED ||
+        SDL_AtomicGet(&entry->state) == CUBE_RESOURCE_FAILED)
+    {
+        SDL_free(entry->data);
+        entry->data = NULL;
+        entry->size = 0;
+        SDL_AtomicSet(&entry->state, CUBE_RESOURCE_UNLOADED);
+    }
+}
+
+// queued resources that no job has started yet are dropped
+void application_destroy_resources(cube_resources *resources)
+{
+    uint32_t resource_index;
+
+    if (resources != NULL)
+    {
+        SDL_AtomicSet(&resources->running, 0);
+        if (resources->jobs != NULL)
+        {
+            application_jobs_wait(resources->jobs, &resources->pending);
+        }
+        for (resource_index = 0; resource_index < resources->resource_count; resource_index++)
+        {
+            SDL_free((resources->resources + resource_index)->data);
+            SDL_free((resources->resources + resource_index)->path);
+        }
+        SDL_DestroyCond(resources->completed);
+        SDL_DestroyMutex(resources->mutex);
+        free(resources->resources);
+        SDL_free(resources->directory);
+        free(resources);
+    }
+}
+
+int application_resources_scan(cube_resources *resources, const char *relative_directory)
+{
+    CUBE_BEGIN_FUNCTION
+    char *directory_path;
+    char *relative_path;
+    char *entry_path;
+    DIR *directory;
+    struct dirent *entry;
+    struct stat entry_stat;
+
+    if (relative_directory == NULL)
+    {
+        directory_path = SDL_strdup(resources->directory);
+    }
+    else
+    {
+        CUBE_ASSERT(
+            SDL_asprintf(
+                &directory_path,
+                "%s%s%s",
+                resources->directory,
+                PATH_SEPARATOR,
+                relative_directory) >= 0,
+            "failed to allocate directory path")
+    }
+    CUBE_ASSERT(directory_path != NULL, "failed to allocate directory path")
+    CUBE_PUSH(directory_path);
+
+    directory = opendir(directory_path);
+    CUBE_ASSERT(directory != NULL, "failed to open resource directory")
+    while ((entry = readdir(directory)) != NULL)
+    {
+        if (SDL_strcmp(entry->d_name, ".") == 0 || SDL_strcmp(entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+        if (relative_directory == NULL)
+        {
+            relative_path = SDL_strdup(entry->d_name);
+        }
+        else if (SDL_asprintf(&relative_path, "%s%s%s", relative_directory, PATH_SEPARATOR, entry->d_name) < 0)
+        {
+            relative_path = NULL;
+        }
+        if (relative_path == NULL)
+        {
+            closedir(directory);
+            CUBE_ASSERT(SDL_FALSE, "failed to allocate resource path")
+        }
+        CUBE_PUSH(relative_path);
+
+        // stat rather than d_type, which not every file system fills in
+        if (SDL_asprintf(&entry_path, "%s%s%s", resources->directory, PATH_SEPARATOR, relative_path) < 0)
+        {
+            closedir(directory);
+            CUBE_ASSERT(SDL_FALSE, "failed to allocate resource path")
+        }
+        CUBE_PUSH(entry_path);
+        if (stat(entry_path, &entry_stat) != 0)
+        {
+            closedir(directory);
+            CUBE_ASSERT(SDL_FALSE, "failed to stat resource")
+        }
+
+        if (S_ISDIR(entry_stat.st_mode))
+        {
+            if (application_resources_scan(resources, relative_path) != CUBE_SUCCESS)
+            {
+                closedir(directory);
+                CUBE_ASSERT(SDL_FALSE, "failed to scan resource subdirectory")
+            }
+        }
+        else if (S_ISREG(entry_stat.st_mode))
+        {
+            if (application_resources_add(resources, relative_path, (size_t)entry_stat.st_size) != CUBE_SUCCESS)
+            {
+                closedir(directory);
+                CUBE_ASSERT(SDL_FALSE, "failed to add resource")
+            }
+        }
+    }
+    closedir(directory);
+    CUBE_END_FUNCTION
+}
+
+int application_resources_add(cube_resources *resources, const char *relative_path, size_t file_size)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_resource *grown;
+    cube_resource *entry;
+    const char *separator;
+
+    // doubled whenever the count reaches a power of two
+    if ((resources->resource_count & (resources->resource_count - 1)) == 0)
+    {
+        grown = realloc(
+            resources->resources,
+            (size_t)SDL_max(resources->resource_count * 2, 16) * sizeof(cube_resource));
+        CUBE_ASSERT(grown != NULL, "failed to grow resource index")
+        resources->resources = grown;
+    }
+    entry = resources->resources + resources->resource_count;
+    SDL_memset(entry, 0, sizeof(cube_resource));
+    CUBE_ASSERT(
+        SDL_asprintf(
+            &entry->path,
+            "%s%s%s",
+            resources->directory,
+            PATH_SEPARATOR,
+            relative_path) >= 0,
+        "failed to allocate resource path")
+    separator = SDL_strrchr(entry->path, *PATH_SEPARATOR);
+    entry->file_name = (separator != NULL) ? separator + 1 : entry->path;
+    entry->type = application_resources_type(entry->file_name);
+    entry->file_size = file_size;
+    SDL_AtomicSet(&entry->state, CUBE_RESOURCE_UNLOADED);
+    resources->resource_count++;
+    CUBE_END_FUNCTION
+}
+
+cube_resource_type application_resources_type(const char *file_name)
+{
+    uint32_t extension_index;
+    size_t name_length;
+    size_t extension_length;
+
+    name_length = SDL_strlen(file_name);
+    for (extension_index = 0;
+         extension_index < sizeof(application_resources_extensions) / sizeof(*application_resources_extensions);
+         extension_index++)
+    {
+        extension_length = SDL_strlen(application_resources_extensions[extension_index].extension);
+        if (name_length > extension_length &&
+            SDL_strcasecmp(
+                file_name + name_length - extension_length,
+                application_resources_extensions[extension_index].extension) == 0)
+        {
+            return application_resources_extensions[extension_index].type;
+        }
+    }
+    return CUBE_RESOURCE_OTHER;
+}
+
+int application_resources_compare(const void *left, const void *right)
+{
+    const cube_resource *left_resource;
+    const cube_resource *right_resource;
+
+    left_resource = left;
+    right_resource = right;
+    if (left_resource->type != right_resource->type)
+    {
+        return (left_resource->type < right_resource->type) ? -1 : 1;
+    }
+    return SDL_strcmp(left_resource->path, right_resource->path);
+}
+
+void application_resources_job(void *data, uint32_t begin, uint32_t end)
+{
+    cube_resources *resources;
+    cube_resource *entry;
+    uint32_t resource;
+    int state;
+
+    resources = data;
+    for (resource = begin; resource < end; resource++)
+    {
+        entry = resources->resources + resource;
+        state = CUBE_RESOURCE_LOADED;
+        if (SDL_AtomicGet(&resources->running) == 0)
+        {
+            state = CUBE_RESOURCE_FAILED;
+        }
+        else if ((entry->data = SDL_LoadFile(entry->path, &entry->size)) == NULL)
+        {
+            fprintf(stderr, "%s: %s\n", entry->path, SDL_GetError());
+            state = CUBE_RESOURCE_FAILED;
+        }
+        else if (entry->callback != NULL && entry->callback(resources, resource, entry->userdata) != CUBE_SUCCESS)
+        {
+            state = CUBE_RESOURCE_FAILED;
+        }
+
+        // published under the lock so a waiter cannot miss the broadcast
+        SDL_LockMutex(resources->mutex);
+        SDL_AtomicSet(&entry->state, state);
+        SDL_CondBroadcast(resources->completed);
+        SDL_UnlockMutex(resources->mutex);
+    }
+}
\ No newline at end of file
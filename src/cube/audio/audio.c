@@ -0,0 +1,415 @@
+#include "cube.h"
+
+#define CUBE_AUDIO_FREQUENCY 48000
+#define CUBE_AUDIO_SAMPLES 512
+
+static int audio_create_device(cube_audio *audio);
+static int audio_create_sounds(cube_audio *audio);
+static int audio_load_sound(cube_resources *resources, uint32_t resource, void *userdata);
+static int audio_create_sound(cube_audio *audio, const void *data, size_t size, cube_sound *sound);
+static void audio_callback(void *userdata, Uint8 *stream, int len);
+static void audio_start_voices(cube_audio *audio);
+static void audio_mix_voice(cube_voice *voice, float *stream, Uint32 frame_count);
+static int audio_resample_sound(cube_audio *audio, int source_rate, cube_sound *sound);
+
+int audio_create(cube_audio **audio, cube_resources *resources)
+{
+    CUBE_BEGIN_FUNCTION
+    CUBE_ASSERT(audio != NULL, "invalid audio handle")
+
+    *audio = SDL_SIMDAlloc(sizeof(cube_audio));
+    CUBE_ASSERT(*audio != NULL, "failed to allocate audio")
+    SDL_memset(*audio, 0, sizeof(cube_audio));
+
+    (*audio)->resources = resources;
+
+    CUBE_ASSERT(audio_create_device(*audio) == CUBE_SUCCESS, "failed to create audio device")
+    CUBE_ASSERT(audio_create_sounds(*audio) == CUBE_SUCCESS, "failed to create sounds")
+    CUBE_ASSERT(audio_create_streams(*audio) == CUBE_SUCCESS, "failed to create streams")
+
+    // sounds still decoding on the workers are simply not playable yet
+    SDL_PauseAudioDevice((*audio)->device_id, 0);
+    CUBE_END_FUNCTION
+}
+
+int audio_find_sound(const cube_audio *audio, const char *name, uint32_t *sound)
+{
+    CUBE_BEGIN_FUNCTION
+    uint32_t sound_index;
+
+    for (sound_index = 0; sound_index < audio->sound_count; sound_index++)
+    {
+        if (SDL_strcmp((audio->sounds + sound_index)->name, name) == 0)
+        {
+            *sound = sound_index;
+            goto done;
+        }
+    }
+    CUBE_ASSERT(sound_index < audio->sound_count, "failed to find sound")
+    CUBE_END_FUNCTION
+}
+
+// producer side of the trigger queue, only ever called from the main thread
+int audio_play(cube_audio *audio, uint32_t sound, float gain, float pan)
+{
+    cube_audio_trigger *trigger;
+    int head;
+    int tail;
+
+    if (sound >= audio->sound_count || SDL_AtomicGet(&(audio->sounds + sound)->ready) == 0)
+    {
+        return CUBE_FAILURE;
+    }
+    tail = SDL_AtomicGet(&audio->queue.tail);
+    head = SDL_AtomicGet(&audio->queue.head);
+    if (tail - head >= CUBE_AUDIO_TRIGGER_CAPACITY)
+    {
+        SDL_AtomicAdd(&audio->dropped_triggers, 1);
+        return CUBE_FAILURE;
+    }
+    trigger = audio->queue.triggers + (tail & (CUBE_AUDIO_TRIGGER_CAPACITY - 1));
+    trigger->sound = sound;
+    trigger->gain = gain;
+    trigger->pan = SDL_clamp(pan, -1.0f, 1.0f);
+    SDL_AtomicSet(&audio->queue.tail, tail + 1);
+    return CUBE_SUCCESS;
+}
+
+// streamed tracks are left to explicit audio_play calls, sounds still loading are skipped
+int audio_play_random(cube_audio *audio)
+{
+    uint32_t sound_index;
+    uint32_t short_count;
+    uint32_t pick;
+
+    short_count = 0;
+    for (sound_index = 0; sound_index < audio->sound_count; sound_index++)
+    {
+        if ((audio->sounds + sound_index)->pcm == NULL &&
+            SDL_AtomicGet(&(audio->sounds + sound_index)->ready) != 0)
+        {
+            short_count++;
+        }
+    }
+    if (short_count == 0)
+    {
+        return CUBE_FAILURE;
+    }
+    pick = (uint32_t)rand() % short_count;
+    for (sound_index = 0; sound_index < audio->sound_count; sound_index++)
+    {
+        if ((audio->sounds + sound_index)->pcm == NULL &&
+            SDL_AtomicGet(&(audio->sounds + sound_index)->ready) != 0)
+        {
+            if (pick == 0)
+            {
+                break;
+            }
+            pick--;
+        }
+    }
+    return audio_play(audio, sound_index, 1.0f, 0.0f);
+}
+
+void audio_destroy(cube_audio *audio)
+{
+    uint32_t sound_index;
+
+    if (audio != NULL)
+    {
+        if (audio->device_id != 0)
+        {
+            SDL_CloseAudioDevice(audio->device_id);
+        }
+        audio_destroy_streams(audio);
+        for (sound_index = 0; sound_index < audio->sound_count; sound_index++)
+        {
+            audio_destroy_stream_sound(audio->sounds + sound_index);
+            SDL_free((audio->sounds + sound_index)->samples);
+            SDL_free((audio->sounds + sound_index)->name);
+        }
+        free(audio->sounds);
+        SDL_SIMDFree(audio);
+    }
+}
+
+int audio_create_device(cube_audio *audio)
+{
+    CUBE_BEGIN_FUNCTION
+    const SDL_AudioSpec desired_spec = {
+        .freq = CUBE_AUDIO_FREQUENCY,
+        .format = AUDIO_F32SYS,
+        .channels = CUBE_AUDIO_CHANNELS,
+        .samples = CUBE_AUDIO_SAMPLES,
+        .callback = audio_callback,
+        .userdata = audio,
+    };
+
+    // the mix stays float stereo, only the rate follows the hardware
+    audio->device_id = SDL_OpenAudioDevice(
+        NULL,
+        0,
+        &desired_spec,
+        &audio->spec,
+        SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_SAMPLES_CHANGE);
+    CUBE_ASSERT(audio->device_id != 0, SDL_GetError())
+    CUBE_END_FUNCTION
+}
+
+int audio_create_sounds(cube_audio *audio)
+{
+    CUBE_BEGIN_FUNCTION
+    const cube_resources *resources;
+    const cube_resource *resource;
+    cube_sound *sound;
+    uint32_t sound_index;
+    SDL_bool streamed;
+
+    // the resource index is sorted, so sound indices do not depend on directory order
+    resources = audio->resources;
+    audio->sounds = calloc(resources->type_count[CUBE_RESOURCE_SOUND], sizeof(cube_sound));
+    CUBE_ASSERT(
+        resources->type_count[CUBE_RESOURCE_SOUND] == 0 || audio->sounds != NULL,
+        "failed to allocate sounds")
+    for (sound_index = 0; sound_index < resources->type_count[CUBE_RESOURCE_SOUND]; sound_index++)
+    {
+        resource = resources->resources + resources->type_first[CUBE_RESOURCE_SOUND] + sound_index;
+        sound = audio->sounds + sound_index;
+        audio->sound_count = sound_index + 1;
+        sound->name = SDL_strdup(resource->file_name);
+        CUBE_ASSERT(sound->name != NULL, "failed to allocate sound name")
+
+        // long tracks stay in the mapped file and are decoded ahead of the callback
+        streamed = SDL_FALSE;
+        if (resource->file_size >= CUBE_AUDIO_STREAM_THRESHOLD)
+        {
+            CUBE_ASSERT(
+                audio_create_stream_sound(
+                    audio,
+                    resource->path,
+                    sound,
+                    &streamed) == CUBE_SUCCESS,
+                "failed to create stream sound")
+        }
+        if (streamed)
+        {
+            SDL_AtomicSet(&sound->ready, 1);
+            continue;
+        }
+        CUBE_ASSERT(
+            application_resources_load(
+                audio->resources,
+                resources->type_first[CUBE_RESOURCE_SOUND] + sound_index,
+                audio_load_sound,
+                audio) == CUBE_SUCCESS,
+            "failed to queue sound")
+    }
+    CUBE_END_FUNCTION
+}
+
+// runs on a resource worker, the wav bytes are freed as soon as they are decoded
+int audio_load_sound(cube_resources *resources, uint32_t resource, void *userdata)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_audio *audio;
+    cube_resource *entry;
+    cube_sound *sound;
+
+    audio = userdata;
+    entry = resources->resources + resource;
+    sound = audio->sounds + (resource - resources->type_first[CUBE_RESOURCE_SOUND]);
+    cube_result = audio_create_sound(audio, entry->data, entry->size, sound);
+    SDL_free(entry->data);
+    entry->data = NULL;
+    entry->size = 0;
+    CUBE_ASSERT(cube_result == CUBE_SUCCESS, entry->path)
+    SDL_AtomicSet(&sound->ready, 1);
+    CUBE_END_FUNCTION
+}
+
+int audio_create_sound(cube_audio *audio, const void *data, size_t size, cube_sound *sound)
+{
+    CUBE_BEGIN_FUNCTION
+    SDL_AudioSpec wav_spec;
+    Uint8 *wav_buffer;
+    Uint32 wav_length;
+    SDL_AudioCVT cvt;
+
+    CUBE_ASSERT(
+        SDL_LoadWAV_RW(
+            SDL_RWFromConstMem(data, (int)size),
+            1,
+            &wav_spec,
+            &wav_buffer,
+            &wav_length) != NULL,
+        SDL_GetError())
+    CUBE_PUSH(wav_buffer);
+
+    // format and channels through SDL, the rate through the polyphase resampler
+    CUBE_ASSERT(
+        SDL_BuildAudioCVT(
+            &cvt,
+            wav_spec.format,
+            wav_spec.channels,
+            wav_spec.freq,
+            audio->spec.format,
+            audio->spec.channels,
+            wav_spec.freq) >= 0,
+        SDL_GetError())
+
+    // converted in place, the buffer must hold the largest intermediate stage
+    cvt.len = (int)wav_length;
+    cvt.buf = SDL_malloc((size_t)wav_length * (size_t)cvt.len_mult);
+    CUBE_ASSERT(cvt.buf != NULL, "failed to allocate sound samples")
+    SDL_memcpy(cvt.buf, wav_buffer, wav_length);
+    if (cvt.needed != 0 && SDL_ConvertAudio(&cvt) != 0)
+    {
+        SDL_free(cvt.buf);
+        CUBE_ASSERT(SDL_FALSE, SDL_GetError())
+    }
+    if (cvt.needed == 0)
+    {
+        cvt.len_cvt = cvt.len;
+    }
+
+    sound->samples = (float *)cvt.buf;
+    sound->frame_count = (Uint32)cvt.len_cvt / (audio->spec.channels * sizeof(float));
+    if (wav_spec.freq != audio->spec.freq)
+    {
+        CUBE_ASSERT(
+            audio_resample_sound(audio, wav_spec.freq, sound) == CUBE_SUCCESS,
+            "failed to resample sound")
+    }
+    CUBE_END_FUNCTION
+}
+
+int audio_resample_sound(cube_audio *audio, int source_rate, cube_sound *sound)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_resampler resampler;
+    float *samples;
+    Uint32 frame_count;
+
+    CUBE_ASSERT(
+        audio_create_resampler(
+            &resampler,
+            source_rate,
+            audio->spec.freq) == CUBE_SUCCESS,
+        "failed to create resampler")
+    frame_count = audio_resample_length(&resampler, sound->frame_count);
+    samples = SDL_malloc((size_t)frame_count * CUBE_AUDIO_CHANNELS * sizeof(float));
+    if (samples == NULL ||
+        audio_resample(
+            &resampler,
+            sound->samples,
+            sound->frame_count,
+            samples,
+            frame_count) != CUBE_SUCCESS)
+    {
+        SDL_free(samples);
+        audio_destroy_resampler(&resampler);
+        CUBE_ASSERT(SDL_FALSE, "failed to resample sound samples")
+    }
+    audio_destroy_resampler(&resampler);
+
+    SDL_free(sound->samples);
+    sound->samples = samples;
+    sound->frame_count = frame_count;
+    CUBE_END_FUNCTION
+}
+
+// runs on the audio thread: no locks, no allocation
+void audio_callback(void *userdata, Uint8 *stream, int len)
+{
+    cube_audio *audio;
+    float *samples;
+    Uint32 frame_count;
+    uint32_t voice_index;
+
+    audio = userdata;
+    samples = (float *)stream;
+    frame_count = (Uint32)len / (CUBE_AUDIO_CHANNELS * sizeof(float));
+
+    audio_start_voices(audio);
+    SDL_memset(stream, 0, (size_t)len);
+    for (voice_index = 0; voice_index < CUBE_AUDIO_VOICE_COUNT; voice_index++)
+    {
+        if (audio->voices[voice_index].sound != NULL)
+        {
+            audio_mix_voice(audio->voices + voice_index, samples, frame_count);
+        }
+    }
+    audio_mix_streams(audio, samples, frame_count);
+    audio_clamp(samples, frame_count * CUBE_AUDIO_CHANNELS);
+}
+
+void audio_start_voices(cube_audio *audio)
+{
+    const cube_audio_trigger *trigger;
+    cube_voice *voice;
+    uint32_t voice_index;
+    float angle;
+    float gain[2];
+    int head;
+    int tail;
+
+    head = SDL_AtomicGet(&audio->queue.head);
+    tail = SDL_AtomicGet(&audio->queue.tail);
+    for (; head != tail; head++)
+    {
+        trigger = audio->queue.triggers + (head & (CUBE_AUDIO_TRIGGER_CAPACITY - 1));
+
+        // constant power pan
+        angle = (trigger->pan + 1.0f) * 3.14159265f / 4.0f;
+        gain[0] = trigger->gain * cosf(angle);
+        gain[1] = trigger->gain * sinf(angle);
+
+        // streams are never stolen, a trigger with every stream busy is dropped
+        if ((audio->sounds + trigger->sound)->pcm != NULL)
+        {
+            if (!audio_start_stream(audio, audio->sounds + trigger->sound, gain))
+            {
+                SDL_AtomicAdd(&audio->dropped_triggers, 1);
+            }
+            continue;
+        }
+
+        // take a free voice, or steal the one furthest through its sound
+        voice = audio->voices;
+        for (voice_index = 0; voice_index < CUBE_AUDIO_VOICE_COUNT; voice_index++)
+        {
+            if (audio->voices[voice_index].sound == NULL)
+            {
+                voice = audio->voices + voice_index;
+                break;
+            }
+            if (audio->voices[voice_index].position > voice->position)
+            {
+                voice = audio->voices + voice_index;
+            }
+        }
+
+        voice->sound = audio->sounds + trigger->sound;
+        voice->position = 0;
+        voice->gain[0] = gain[0];
+        voice->gain[1] = gain[1];
+    }
+    SDL_AtomicSet(&audio->queue.head, head);
+}
+
+void audio_mix_voice(cube_voice *voice, float *stream, Uint32 frame_count)
+{
+    Uint32 mix_count;
+
+    mix_count = SDL_min(frame_count, voice->sound->frame_count - voice->position);
+    audio_mix_stereo(
+        stream,
+        voice->sound->samples + (size_t)voice->position * CUBE_AUDIO_CHANNELS,
+        mix_count,
+        voice->gain);
+    voice->position += mix_count;
+    if (voice->position >= voice->sound->frame_count)
+    {
+        voice->sound = NULL;
+    }
+}
\ No newline at end of file
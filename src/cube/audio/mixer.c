@@ -0,0 +1,380 @@
+#include "cube.h"
+
+#define CUBE_AUDIO_RESAMPLER_MAX_PHASES 2048
+#define CUBE_AUDIO_RESAMPLER_BANDWIDTH 0.92f
+#define CUBE_AUDIO_RESAMPLER_ROW (CUBE_AUDIO_RESAMPLER_TAPS * 2)
+#define CUBE_AUDIO_PI 3.14159265358979323846
+
+static uint32_t audio_mix_stereo_kernels(
+    float *stream,
+    const float *source,
+    uint32_t frame_count,
+    const float gain[2]);
+static double audio_resampler_sinc(double x);
+static double audio_resampler_window(double x);
+
+#if !defined(CUBE_SSE2)
+static void audio_resample_frame_scalar(const float *coefficients, const float *window, float *target);
+#endif
+
+#if defined(CUBE_SSE2)
+static uint32_t audio_mix_stereo_sse2(
+    float *stream,
+    const float *source,
+    uint32_t begin,
+    uint32_t end,
+    const float gain[2]);
+static uint32_t audio_clamp_sse2(float *stream, uint32_t begin, uint32_t end);
+static void audio_resample_frame_sse2(const float *coefficients, const float *window, float *target);
+#endif
+
+#if defined(CUBE_AVX2)
+static uint32_t audio_mix_stereo_avx2(
+    float *stream,
+    const float *source,
+    uint32_t begin,
+    uint32_t end,
+    const float gain[2]);
+static uint32_t audio_clamp_avx2(float *stream, uint32_t begin, uint32_t end);
+static void audio_resample_frame_avx2(const float *coefficients, const float *window, float *target);
+#endif
+
+// adds gain scaled interleaved stereo frames from source onto stream
+void audio_mix_stereo(
+    float *stream,
+    const float *source,
+    uint32_t frame_count,
+    const float gain[2])
+{
+    uint32_t index;
+
+    index = audio_mix_stereo_kernels(stream, source, frame_count, gain);
+    audio_mix_stereo_scalar(stream + index * 2, source + index * 2, frame_count - index, gain);
+}
+
+void audio_mix_stereo_scalar(
+    float *stream,
+    const float *source,
+    uint32_t frame_count,
+    const float gain[2])
+{
+    uint32_t index;
+
+    for (index = 0; index < frame_count; index++)
+    {
+        *(stream + index * 2) += *(source + index * 2) * gain[0];
+        *(stream + index * 2 + 1) += *(source + index * 2 + 1) * gain[1];
+    }
+}
+
+void audio_clamp(float *stream, uint32_t sample_count)
+{
+    uint32_t index;
+
+    index = 0;
+#if defined(CUBE_AVX2)
+    index = audio_clamp_avx2(stream, index, sample_count);
+#endif
+#if defined(CUBE_SSE2)
+    index = audio_clamp_sse2(stream, index, sample_count);
+#endif
+    for (; index < sample_count; index++)
+    {
+        *(stream + index) = SDL_clamp(*(stream + index), -1.0f, 1.0f);
+    }
+}
+
+int audio_create_resampler(cube_resampler *resampler, int source_rate, int target_rate)
+{
+    CUBE_BEGIN_FUNCTION
+    int a;
+    int b;
+    int divisor;
+    uint32_t phase;
+    uint32_t tap;
+    double cutoff;
+    double offset;
+    double coefficient;
+    double sum;
+    float *row;
+
+    CUBE_ASSERT(source_rate > 0 && target_rate > 0, "invalid sample rates")
+
+    a = source_rate;
+    b = target_rate;
+    while (b != 0)
+    {
+        divisor = a % b;
+        a = b;
+        b = divisor;
+    }
+    resampler->up = (uint32_t)(target_rate / a);
+    resampler->down = (uint32_t)(source_rate / a);
+
+    // coprime rates with huge factors are approximated, the pitch error stays far below audible
+    if (resampler->up > CUBE_AUDIO_RESAMPLER_MAX_PHASES)
+    {
+        resampler->down = (uint32_t)(((uint64_t)resampler->down * CUBE_AUDIO_RESAMPLER_MAX_PHASES + resampler->up / 2) / resampler->up);
+        resampler->down = SDL_max(resampler->down, 1);
+        resampler->up = CUBE_AUDIO_RESAMPLER_MAX_PHASES;
+    }
+
+    resampler->coefficients = SDL_SIMDAlloc((size_t)resampler->up * CUBE_AUDIO_RESAMPLER_ROW * sizeof(float));
+    CUBE_ASSERT(resampler->coefficients != NULL, "failed to allocate resampler coefficients")
+
+    // windowed sinc, narrowed below the source nyquist when downsampling
+    cutoff = CUBE_AUDIO_RESAMPLER_BANDWIDTH * SDL_min(1.0, (double)resampler->up / (double)resampler->down);
+    for (phase = 0; phase < resampler->up; phase++)
+    {
+        row = resampler->coefficients + (size_t)phase * CUBE_AUDIO_RESAMPLER_ROW;
+        sum = 0.0;
+        for (tap = 0; tap < CUBE_AUDIO_RESAMPLER_TAPS; tap++)
+        {
+            offset = (double)tap - (double)(CUBE_AUDIO_RESAMPLER_TAPS / 2 - 1) - (double)phase / (double)resampler->up;
+            coefficient = cutoff * audio_resampler_sinc(cutoff * offset) *
+                          audio_resampler_window(offset / (double)(CUBE_AUDIO_RESAMPLER_TAPS / 2));
+            *(row + tap * 2) = (float)coefficient;
+            sum += coefficient;
+        }
+        // unity gain at dc for every phase
+        for (tap = 0; tap < CUBE_AUDIO_RESAMPLER_TAPS; tap++)
+        {
+            *(row + tap * 2) = (float)(*(row + tap * 2) / sum);
+            *(row + tap * 2 + 1) = *(row + tap * 2);
+        }
+    }
+    CUBE_END_FUNCTION
+}
+
+uint32_t audio_resample_length(const cube_resampler *resampler, uint32_t source_frame_count)
+{
+    return (uint32_t)(((uint64_t)source_frame_count * resampler->up) / resampler->down);
+}
+
+int audio_resample(
+    const cube_resampler *resampler,
+    const float *source,
+    uint32_t source_frame_count,
+    float *target,
+    uint32_t target_frame_count)
+{
+    CUBE_BEGIN_FUNCTION
+    float *padded;
+    uint32_t frame;
+    uint64_t position;
+    uint32_t phase;
+
+    // zero frames on both sides so every window stays inside the buffer
+    padded = SDL_SIMDAlloc(((size_t)source_frame_count + CUBE_AUDIO_RESAMPLER_TAPS + 1) * 2 * sizeof(float));
+    CUBE_ASSERT(padded != NULL, "failed to allocate resampler input")
+    CUBE_PUSH(padded);
+    SDL_memset(padded, 0, ((size_t)source_frame_count + CUBE_AUDIO_RESAMPLER_TAPS + 1) * 2 * sizeof(float));
+    SDL_memcpy(
+        padded + (CUBE_AUDIO_RESAMPLER_TAPS / 2) * 2,
+        source,
+        (size_t)source_frame_count * 2 * sizeof(float));
+
+    position = 0;
+    phase = 0;
+    for (frame = 0; frame < target_frame_count; frame++)
+    {
+        audio_resample_frame(resampler, phase, padded + (position + 1) * 2, target + (size_t)frame * 2);
+        phase += resampler->down;
+        position += phase / resampler->up;
+        phase %= resampler->up;
+    }
+    CUBE_END_FUNCTION
+}
+
+// one output frame from the taps starting at window, window is interleaved stereo
+void audio_resample_frame(
+    const cube_resampler *resampler,
+    uint32_t phase,
+    const float *window,
+    float *target)
+{
+    const float *coefficients;
+
+    coefficients = resampler->coefficients + (size_t)phase * CUBE_AUDIO_RESAMPLER_ROW;
+#if defined(CUBE_AVX2)
+    audio_resample_frame_avx2(coefficients, window, target);
+#elif defined(CUBE_SSE2)
+    audio_resample_frame_sse2(coefficients, window, target);
+#else
+    audio_resample_frame_scalar(coefficients, window, target);
+#endif
+}
+
+void audio_destroy_resampler(cube_resampler *resampler)
+{
+    SDL_SIMDFree(resampler->coefficients);
+    resampler->coefficients = NULL;
+}
+
+uint32_t audio_mix_stereo_kernels(
+    float *stream,
+    const float *source,
+    uint32_t frame_count,
+    const float gain[2])
+{
+    uint32_t index;
+
+    index = 0;
+#if defined(CUBE_AVX2)
+    index = audio_mix_stereo_avx2(stream, source, index, frame_count, gain);
+#endif
+#if defined(CUBE_SSE2)
+    index = audio_mix_stereo_sse2(stream, source, index, frame_count, gain);
+#endif
+    return index;
+}
+
+#if !defined(CUBE_SSE2)
+void audio_resample_frame_scalar(const float *coefficients, const float *window, float *target)
+{
+    float left;
+    float right;
+    uint32_t tap;
+
+    left = 0.0f;
+    right = 0.0f;
+    for (tap = 0; tap < CUBE_AUDIO_RESAMPLER_TAPS; tap++)
+    {
+        left += *(coefficients + tap * 2) * *(window + tap * 2);
+        right += *(coefficients + tap * 2 + 1) * *(window + tap * 2 + 1);
+    }
+    *target = left;
+    *(target + 1) = right;
+}
+#endif
+
+double audio_resampler_sinc(double x)
+{
+    if (fabs(x) < 1e-9)
+    {
+        return 1.0;
+    }
+    return sin(CUBE_AUDIO_PI * x) / (CUBE_AUDIO_PI * x);
+}
+
+// blackman over [-1, 1]
+double audio_resampler_window(double x)
+{
+    if (fabs(x) >= 1.0)
+    {
+        return 0.0;
+    }
+    return 0.42 + 0.5 * cos(CUBE_AUDIO_PI * x) + 0.08 * cos(2.0 * CUBE_AUDIO_PI * x);
+}
+
+#if defined(CUBE_SSE2)
+// two stereo frames per register, the gain pair repeats across lanes
+uint32_t audio_mix_stereo_sse2(
+    float *stream,
+    const float *source,
+    uint32_t begin,
+    uint32_t end,
+    const float gain[2])
+{
+    const __m128 gains = _mm_setr_ps(gain[0], gain[1], gain[0], gain[1]);
+    __m128 mixed_0, mixed_1;
+    uint32_t index;
+
+    for (index = begin; index + 4 <= end; index += 4)
+    {
+        mixed_0 = _mm_add_ps(
+            _mm_loadu_ps(stream + index * 2),
+            _mm_mul_ps(_mm_loadu_ps(source + index * 2), gains));
+        mixed_1 = _mm_add_ps(
+            _mm_loadu_ps(stream + index * 2 + 4),
+            _mm_mul_ps(_mm_loadu_ps(source + index * 2 + 4), gains));
+        _mm_storeu_ps(stream + index * 2, mixed_0);
+        _mm_storeu_ps(stream + index * 2 + 4, mixed_1);
+    }
+    return index;
+}
+
+uint32_t audio_clamp_sse2(float *stream, uint32_t begin, uint32_t end)
+{
+    const __m128 lower = _mm_set1_ps(-1.0f);
+    const __m128 upper = _mm_set1_ps(1.0f);
+    uint32_t index;
+
+    for (index = begin; index + 4 <= end; index += 4)
+    {
+        _mm_storeu_ps(stream + index, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(stream + index), lower), upper));
+    }
+    return index;
+}
+
+void audio_resample_frame_sse2(const float *coefficients, const float *window, float *target)
+{
+    __m128 sum;
+    uint32_t index;
+
+    sum = _mm_setzero_ps();
+    for (index = 0; index < CUBE_AUDIO_RESAMPLER_ROW; index += 4)
+    {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(coefficients + index), _mm_loadu_ps(window + index)));
+    }
+    // lanes hold left, right, left, right
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    _mm_storel_pi((__m64 *)target, sum);
+}
+#endif
+
+#if defined(CUBE_AVX2)
+uint32_t audio_mix_stereo_avx2(
+    float *stream,
+    const float *source,
+    uint32_t begin,
+    uint32_t end,
+    const float gain[2])
+{
+    const __m256 gains = _mm256_setr_ps(gain[0], gain[1], gain[0], gain[1], gain[0], gain[1], gain[0], gain[1]);
+    __m256 mixed_0, mixed_1;
+    uint32_t index;
+
+    for (index = begin; index + 8 <= end; index += 8)
+    {
+        mixed_0 = _mm256_add_ps(
+            _mm256_loadu_ps(stream + index * 2),
+            _mm256_mul_ps(_mm256_loadu_ps(source + index * 2), gains));
+        mixed_1 = _mm256_add_ps(
+            _mm256_loadu_ps(stream + index * 2 + 8),
+            _mm256_mul_ps(_mm256_loadu_ps(source + index * 2 + 8), gains));
+        _mm256_storeu_ps(stream + index * 2, mixed_0);
+        _mm256_storeu_ps(stream + index * 2 + 8, mixed_1);
+    }
+    return index;
+}
+
+uint32_t audio_clamp_avx2(float *stream, uint32_t begin, uint32_t end)
+{
+    const __m256 lower = _mm256_set1_ps(-1.0f);
+    const __m256 upper = _mm256_set1_ps(1.0f);
+    uint32_t index;
+
+    for (index = begin; index + 8 <= end; index += 8)
+    {
+        _mm256_storeu_ps(stream + index, _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(stream + index), lower), upper));
+    }
+    return index;
+}
+
+void audio_resample_frame_avx2(const float *coefficients, const float *window, float *target)
+{
+    __m256 sum;
+    __m128 half;
+    uint32_t index;
+
+    sum = _mm256_setzero_ps();
+    for (index = 0; index < CUBE_AUDIO_RESAMPLER_ROW; index += 8)
+    {
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_load_ps(coefficients + index), _mm256_loadu_ps(window + index)));
+    }
+    half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    _mm_storel_pi((__m64 *)target, half);
+}
+#endif
\ No newline at end of file
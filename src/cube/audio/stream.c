@@ -0,0 +1,578 @@
+#include "cube.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define CUBE_AUDIO_STREAM_INTERVAL 10
+#define CUBE_AUDIO_STREAM_RELEASE (256 << 10)
+#define CUBE_AUDIO_STREAM_STAGING (CUBE_AUDIO_STREAM_CHUNK + CUBE_AUDIO_RESAMPLER_TAPS + 1)
+#define CUBE_AUDIO_WAVE_PCM 0x0001
+#define CUBE_AUDIO_WAVE_FLOAT 0x0003
+#define CUBE_AUDIO_WAVE_EXTENSIBLE 0xFFFE
+
+static int audio_map_file(const char *path, cube_mapping *mapping);
+static void audio_unmap_file(cube_mapping *mapping);
+static void audio_release_file(const cube_mapping *mapping, size_t offset, size_t size);
+static Uint16 audio_read_u16(const Uint8 *data);
+static Uint32 audio_read_u32(const Uint8 *data);
+static SDL_bool audio_parse_wave(cube_sound *sound, int *source_rate);
+static int audio_stream_thread(void *data);
+static void audio_fill_stream(cube_stream *stream);
+static void audio_reset_stream(cube_stream *stream);
+static Uint32 audio_fill_direct(cube_stream *stream, Uint32 write, Uint32 free_count);
+static Uint32 audio_fill_resampled(cube_stream *stream, Uint32 write, Uint32 free_count);
+static void audio_refill_staging(cube_stream *stream);
+static void audio_decode(const cube_sound *sound, Uint32 first_frame, Uint32 frame_count, float *target);
+static void audio_release_stream(cube_stream *stream);
+
+// maps the file and keeps it when it is long enough and in a format the stream thread decodes,
+// anything else is left for the preloaded path
+int audio_create_stream_sound(
+    cube_audio *audio,
+    const char *sound_path,
+    cube_sound *sound,
+    SDL_bool *streamed)
+{
+    CUBE_BEGIN_FUNCTION
+    int source_rate;
+
+    *streamed = SDL_FALSE;
+    CUBE_ASSERT(audio_map_file(sound_path, &sound->mapping) == CUBE_SUCCESS, "failed to map sound")
+    if (!audio_parse_wave(sound, &source_rate) ||
+        (size_t)sound->source_frame_count * sound->source_channels * SDL_AUDIO_BITSIZE(sound->source_format) / 8 <
+            CUBE_AUDIO_STREAM_THRESHOLD)
+    {
+        audio_unmap_file(&sound->mapping);
+        sound->pcm = NULL;
+        goto done;
+    }
+
+    sound->frame_count = sound->source_frame_count;
+    if (source_rate != audio->spec.freq)
+    {
+        if (audio_create_resampler(&sound->resampler, source_rate, audio->spec.freq) != CUBE_SUCCESS)
+        {
+            audio_unmap_file(&sound->mapping);
+            CUBE_ASSERT(SDL_FALSE, "failed to create stream resampler")
+        }
+        sound->frame_count = audio_resample_length(&sound->resampler, sound->source_frame_count);
+    }
+    *streamed = SDL_TRUE;
+    CUBE_END_FUNCTION
+}
+
+int audio_create_streams(cube_audio *audio)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_stream *stream;
+    uint32_t sound_index;
+    uint32_t stream_index;
+
+    for (sound_index = 0; sound_index < audio->sound_count; sound_index++)
+    {
+        if ((audio->sounds + sound_index)->pcm != NULL)
+        {
+            break;
+        }
+    }
+    if (sound_index == audio->sound_count)
+    {
+        goto done;
+    }
+
+    // resident memory is the rings and staging buffers, whatever the length of the files
+    for (stream_index = 0; stream_index < CUBE_AUDIO_STREAM_COUNT; stream_index++)
+    {
+        stream = audio->streams + stream_index;
+        stream->ring = SDL_SIMDAlloc((size_t)CUBE_AUDIO_STREAM_CAPACITY * CUBE_AUDIO_CHANNELS * sizeof(float));
+        CUBE_ASSERT(stream->ring != NULL, "failed to allocate stream ring")
+        stream->staging = SDL_SIMDAlloc((size_t)CUBE_AUDIO_STREAM_STAGING * CUBE_AUDIO_CHANNELS * sizeof(float));
+        CUBE_ASSERT(stream->staging != NULL, "failed to allocate stream staging")
+        SDL_AtomicSet(&stream->state, CUBE_STREAM_IDLE);
+    }
+
+    SDL_AtomicSet(&audio->streaming, 1);
+    audio->stream_thread = SDL_CreateThread(audio_stream_thread, "cube_audio_stream", audio);
+    CUBE_ASSERT(audio->stream_thread != NULL, SDL_GetError())
+    CUBE_END_FUNCTION
+}
+
+// runs on the audio thread, a stream is only ever claimed from idle so the stream thread never races a restart
+SDL_bool audio_start_stream(cube_audio *audio, const cube_sound *sound, const float gain[2])
+{
+    cube_stream *stream;
+    uint32_t stream_index;
+
+    if (audio->stream_thread == NULL)
+    {
+        return SDL_FALSE;
+    }
+    for (stream_index = 0; stream_index < CUBE_AUDIO_STREAM_COUNT; stream_index++)
+    {
+        stream = audio->streams + stream_index;
+        if (SDL_AtomicGet(&stream->state) == CUBE_STREAM_IDLE)
+        {
+            stream->sound = sound;
+            stream->position = 0;
+            stream->gain[0] = gain[0];
+            stream->gain[1] = gain[1];
+            SDL_AtomicSet(&stream->state, CUBE_STREAM_STARTING);
+            return SDL_TRUE;
+        }
+    }
+    return SDL_FALSE;
+}
+
+// runs on the audio thread: consumes whatever the stream thread has prefetched
+void audio_mix_streams(cube_audio *audio, float *stream, Uint32 frame_count)
+{
+    cube_stream *source;
+    uint32_t stream_index;
+    int state;
+    Uint32 read;
+    Uint32 available;
+    Uint32 mix_count;
+    Uint32 first_count;
+
+    for (stream_index = 0; stream_index < CUBE_AUDIO_STREAM_COUNT; stream_index++)
+    {
+        source = audio->streams + stream_index;
+
+        // state before indices, a draining stream has published its last frame
+        state = SDL_AtomicGet(&source->state);
+        if (state != CUBE_STREAM_PLAYING && state != CUBE_STREAM_DRAINING)
+        {
+            continue;
+        }
+        read = (Uint32)SDL_AtomicGet(&source->read);
+        available = (Uint32)SDL_AtomicGet(&source->write) - read;
+        mix_count = SDL_min(frame_count, available);
+        first_count = SDL_min(mix_count, CUBE_AUDIO_STREAM_CAPACITY - (read & (CUBE_AUDIO_STREAM_CAPACITY - 1)));
+        audio_mix_stereo(
+            stream,
+            source->ring + (size_t)(read & (CUBE_AUDIO_STREAM_CAPACITY - 1)) * CUBE_AUDIO_CHANNELS,
+            first_count,
+            source->gain);
+        audio_mix_stereo(
+            stream + (size_t)first_count * CUBE_AUDIO_CHANNELS,
+            source->ring,
+            mix_count - first_count,
+            source->gain);
+        SDL_AtomicSet(&source->read, (int)(read + mix_count));
+
+        // an empty ring before the first frame is start latency, not an underrun
+        if (mix_count == available && state == CUBE_STREAM_DRAINING)
+        {
+            SDL_AtomicSet(&source->state, CUBE_STREAM_IDLE);
+        }
+        else if (mix_count < frame_count && source->position != 0)
+        {
+            SDL_AtomicAdd(&audio->stream_underruns, 1);
+            CUBE_PROFILE_COUNTER("stream underruns", SDL_AtomicGet(&audio->stream_underruns))
+        }
+        source->position += mix_count;
+    }
+}
+
+void audio_destroy_streams(cube_audio *audio)
+{
+    uint32_t stream_index;
+
+    if (audio->stream_thread != NULL)
+    {
+        SDL_AtomicSet(&audio->streaming, 0);
+        SDL_WaitThread(audio->stream_thread, NULL);
+        audio->stream_thread = NULL;
+    }
+    for (stream_index = 0; stream_index < CUBE_AUDIO_STREAM_COUNT; stream_index++)
+    {
+        SDL_SIMDFree(audio->streams[stream_index].ring);
+        SDL_SIMDFree(audio->streams[stream_index].staging);
+        audio->streams[stream_index].ring = NULL;
+        audio->streams[stream_index].staging = NULL;
+    }
+}
+
+void audio_destroy_stream_sound(cube_sound *sound)
+{
+    audio_destroy_resampler(&sound->resampler);
+    audio_unmap_file(&sound->mapping);
+    sound->pcm = NULL;
+}
+
+int audio_map_file(const char *path, cube_mapping *mapping)
+{
+    CUBE_BEGIN_FUNCTION
+#ifdef _WIN32
+    LARGE_INTEGER file_size;
+
+    mapping->file = CreateFileA(
+        path,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN,
+        NULL);
+    CUBE_ASSERT(mapping->file != INVALID_HANDLE_VALUE, "failed to open sound file")
+    if (!GetFileSizeEx(mapping->file, &file_size) || file_size.QuadPart == 0)
+    {
+        CloseHandle(mapping->file);
+        CUBE_ASSERT(SDL_FALSE, "failed to size sound file")
+    }
+    mapping->view = CreateFileMappingA(mapping->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping->view == NULL)
+    {
+        CloseHandle(mapping->file);
+        CUBE_ASSERT(SDL_FALSE, "failed to create sound file mapping")
+    }
+    mapping->data = MapViewOfFile(mapping->view, FILE_MAP_READ, 0, 0, 0);
+    if (mapping->data == NULL)
+    {
+        CloseHandle(mapping->view);
+        CloseHandle(mapping->file);
+        CUBE_ASSERT(SDL_FALSE, "failed to map sound file")
+    }
+    mapping->size = (size_t)file_size.QuadPart;
+#else
+    int file;
+    struct stat file_stat;
+
+    file = open(path, O_RDONLY);
+    CUBE_ASSERT(file >= 0, strerror(errno))
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0)
+    {
+        close(file);
+        CUBE_ASSERT(SDL_FALSE, "failed to size sound file")
+    }
+    mapping->data = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    CUBE_ASSERT(mapping->data != MAP_FAILED, strerror(errno))
+    mapping->size = (size_t)file_stat.st_size;
+
+    // read ahead of the stream thread, dropped again behind it
+    madvise(mapping->data, mapping->size, MADV_SEQUENTIAL);
+#endif
+    CUBE_END_FUNCTION
+}
+
+void audio_unmap_file(cube_mapping *mapping)
+{
+    if (mapping->data == NULL)
+    {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(mapping->data);
+    CloseHandle(mapping->view);
+    CloseHandle(mapping->file);
+#else
+    munmap(mapping->data, mapping->size);
+#endif
+    mapping->data = NULL;
+    mapping->size = 0;
+}
+
+// pages behind the read position go back to the page cache, they are faulted in again on a restart
+void audio_release_file(const cube_mapping *mapping, size_t offset, size_t size)
+{
+#ifdef _WIN32
+    VirtualUnlock((Uint8 *)mapping->data + offset, size);
+#else
+    madvise((Uint8 *)mapping->data + offset, size, MADV_DONTNEED);
+#endif
+}
+
+Uint16 audio_read_u16(const Uint8 *data)
+{
+    return (Uint16)(*data | (*(data + 1) << 8));
+}
+
+Uint32 audio_read_u32(const Uint8 *data)
+{
+    return (Uint32)*data | ((Uint32) * (data + 1) << 8) | ((Uint32) * (data + 2) << 16) | ((Uint32) * (data + 3) << 24);
+}
+
+// 16 bit integer and 32 bit float pcm, mono or stereo
+SDL_bool audio_parse_wave(cube_sound *sound, int *source_rate)
+{
+    const Uint8 *data;
+    size_t offset;
+    size_t chunk_size;
+    Uint16 format;
+    Uint16 channels;
+    Uint16 bits;
+    SDL_bool has_format;
+
+    data = sound->mapping.data;
+    if (sound->mapping.size < 12 ||
+        SDL_memcmp(data, "RIFF", 4) != 0 ||
+        SDL_memcmp(data + 8, "WAVE", 4) != 0)
+    {
+        return SDL_FALSE;
+    }
+
+    has_format = SDL_FALSE;
+    format = 0;
+    channels = 0;
+    bits = 0;
+    offset = 12;
+    while (offset + 8 <= sound->mapping.size)
+    {
+        chunk_size = audio_read_u32(data + offset + 4);
+        if (chunk_size > sound->mapping.size - offset - 8)
+        {
+            return SDL_FALSE;
+        }
+        if (SDL_memcmp(data + offset, "fmt ", 4) == 0 && chunk_size >= 16)
+        {
+            format = audio_read_u16(data + offset + 8);
+            channels = audio_read_u16(data + offset + 10);
+            *source_rate = (int)audio_read_u32(data + offset + 12);
+            bits = audio_read_u16(data + offset + 22);
+            if (format == CUBE_AUDIO_WAVE_EXTENSIBLE && chunk_size >= 26)
+            {
+                format = audio_read_u16(data + offset + 32);
+            }
+            has_format = SDL_TRUE;
+        }
+        else if (SDL_memcmp(data + offset, "data", 4) == 0 && has_format)
+        {
+            if ((format == CUBE_AUDIO_WAVE_PCM && bits == 16) ||
+                (format == CUBE_AUDIO_WAVE_FLOAT && bits == 32))
+            {
+                if ((channels == 1 || channels == 2) && *source_rate > 0)
+                {
+                    sound->pcm = data + offset + 8;
+                    sound->source_format = (format == CUBE_AUDIO_WAVE_PCM) ? AUDIO_S16LSB : AUDIO_F32LSB;
+                    sound->source_channels = (Uint8)channels;
+                    sound->source_frame_count = (Uint32)(chunk_size / (channels * bits / 8));
+                    return SDL_TRUE;
+                }
+            }
+            return SDL_FALSE;
+        }
+        // chunks are padded to an even size
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+    return SDL_FALSE;
+}
+
+int audio_stream_thread(void *data)
+{
+    cube_audio *audio;
+    uint32_t stream_index;
+
+    audio = data;
+    CUBE_PROFILE_THREAD("audio stream")
+    while (SDL_AtomicGet(&audio->streaming) != 0)
+    {
+        for (stream_index = 0; stream_index < CUBE_AUDIO_STREAM_COUNT; stream_index++)
+        {
+            audio_fill_stream(audio->streams + stream_index);
+        }
+        SDL_Delay(CUBE_AUDIO_STREAM_INTERVAL);
+    }
+    return 0;
+}
+
+void audio_fill_stream(cube_stream *stream)
+{
+    int state;
+    Uint32 write;
+    Uint32 free_count;
+
+    state = SDL_AtomicGet(&stream->state);
+    if (state == CUBE_STREAM_STARTING)
+    {
+        // the callback leaves a starting stream alone, so the indices can be rewound here
+        audio_reset_stream(stream);
+        SDL_AtomicSet(&stream->state, CUBE_STREAM_PLAYING);
+        state = CUBE_STREAM_PLAYING;
+    }
+    if (state != CUBE_STREAM_PLAYING)
+    {
+        return;
+    }
+
+    write = (Uint32)SDL_AtomicGet(&stream->write);
+    free_count = CUBE_AUDIO_STREAM_CAPACITY - (write - (Uint32)SDL_AtomicGet(&stream->read));
+    if (stream->sound->resampler.coefficients == NULL)
+    {
+        write += audio_fill_direct(stream, write, free_count);
+    }
+    else
+    {
+        write += audio_fill_resampled(stream, write, free_count);
+    }
+    SDL_AtomicSet(&stream->write, (int)write);
+    audio_release_stream(stream);
+
+    if (stream->produced >= stream->sound->frame_count)
+    {
+        SDL_AtomicSet(&stream->state, CUBE_STREAM_DRAINING);
+    }
+}
+
+void audio_reset_stream(cube_stream *stream)
+{
+    SDL_AtomicSet(&stream->read, 0);
+    SDL_AtomicSet(&stream->write, 0);
+    stream->source_position = 0;
+    stream->produced = 0;
+    stream->released = 0;
+
+    // half a window of silence ahead of the first source frame, as in audio_resample
+    SDL_memset(stream->staging, 0, (CUBE_AUDIO_RESAMPLER_TAPS / 2) * CUBE_AUDIO_CHANNELS * sizeof(float));
+    stream->staging_count = CUBE_AUDIO_RESAMPLER_TAPS / 2;
+    stream->base = 0;
+    stream->window = 0;
+    stream->phase = 0;
+}
+
+Uint32 audio_fill_direct(cube_stream *stream, Uint32 write, Uint32 free_count)
+{
+    Uint32 frame_count;
+    Uint32 first_count;
+
+    frame_count = SDL_min(free_count, stream->sound->source_frame_count - stream->source_position);
+    first_count = SDL_min(frame_count, CUBE_AUDIO_STREAM_CAPACITY - (write & (CUBE_AUDIO_STREAM_CAPACITY - 1)));
+    audio_decode(
+        stream->sound,
+        stream->source_position,
+        first_count,
+        stream->ring + (size_t)(write & (CUBE_AUDIO_STREAM_CAPACITY - 1)) * CUBE_AUDIO_CHANNELS);
+    audio_decode(
+        stream->sound,
+        stream->source_position + first_count,
+        frame_count - first_count,
+        stream->ring);
+    stream->source_position += frame_count;
+    stream->produced += frame_count;
+    return frame_count;
+}
+
+// the offline resampler run incrementally, staging holds padded source frames from base onwards
+Uint32 audio_fill_resampled(cube_stream *stream, Uint32 write, Uint32 free_count)
+{
+    const cube_resampler *resampler;
+    Uint32 frame_count;
+
+    resampler = &stream->sound->resampler;
+    frame_count = 0;
+    while (frame_count < free_count && stream->produced < stream->sound->frame_count)
+    {
+        if (stream->window + 1 + CUBE_AUDIO_RESAMPLER_TAPS > stream->base + stream->staging_count)
+        {
+            audio_refill_staging(stream);
+            continue;
+        }
+        audio_resample_frame(
+            resampler,
+            stream->phase,
+            stream->staging + (size_t)(stream->window + 1 - stream->base) * CUBE_AUDIO_CHANNELS,
+            stream->ring + (size_t)((write + frame_count) & (CUBE_AUDIO_STREAM_CAPACITY - 1)) * CUBE_AUDIO_CHANNELS);
+        stream->phase += resampler->down;
+        stream->window += stream->phase / resampler->up;
+        stream->phase %= resampler->up;
+        stream->produced++;
+        frame_count++;
+    }
+    return frame_count;
+}
+
+void audio_refill_staging(cube_stream *stream)
+{
+    uint32_t discard_count;
+    uint32_t space;
+    Uint32 frame_count;
+
+    // frames before the next window are done with
+    discard_count = (uint32_t)SDL_min(stream->window + 1 - stream->base, (uint64_t)stream->staging_count);
+    SDL_memmove(
+        stream->staging,
+        stream->staging + (size_t)discard_count * CUBE_AUDIO_CHANNELS,
+        (size_t)(stream->staging_count - discard_count) * CUBE_AUDIO_CHANNELS * sizeof(float));
+    stream->staging_count -= discard_count;
+    stream->base += discard_count;
+
+    space = CUBE_AUDIO_STREAM_STAGING - stream->staging_count;
+    if (stream->source_position < stream->sound->source_frame_count)
+    {
+        frame_count = SDL_min(space, stream->sound->source_frame_count - stream->source_position);
+        audio_decode(
+            stream->sound,
+            stream->source_position,
+            frame_count,
+            stream->staging + (size_t)stream->staging_count * CUBE_AUDIO_CHANNELS);
+        stream->source_position += frame_count;
+        stream->staging_count += frame_count;
+    }
+    else
+    {
+        // trailing silence flushes the last windows
+        SDL_memset(
+            stream->staging + (size_t)stream->staging_count * CUBE_AUDIO_CHANNELS,
+            0,
+            (size_t)space * CUBE_AUDIO_CHANNELS * sizeof(float));
+        stream->staging_count += space;
+    }
+}
+
+// little endian pcm to interleaved stereo float, mono samples land on both channels
+void audio_decode(const cube_sound *sound, Uint32 first_frame, Uint32 frame_count, float *target)
+{
+    const Uint8 *source;
+    Uint32 sample_count;
+    Uint32 sample;
+    float value;
+    Uint32 bits;
+
+    sample_count = frame_count * sound->source_channels;
+    if (sound->source_format == AUDIO_S16LSB)
+    {
+        source = sound->pcm + (size_t)first_frame * sound->source_channels * sizeof(Sint16);
+        for (sample = 0; sample < sample_count; sample++)
+        {
+            value = (float)(Sint16)audio_read_u16(source + (size_t)sample * sizeof(Sint16)) * (1.0f / 32768.0f);
+            *(target + sample * CUBE_AUDIO_CHANNELS / sound->source_channels) = value;
+            if (sound->source_channels == 1)
+            {
+                *(target + sample * CUBE_AUDIO_CHANNELS + 1) = value;
+            }
+        }
+    }
+    else
+    {
+        source = sound->pcm + (size_t)first_frame * sound->source_channels * sizeof(float);
+        for (sample = 0; sample < sample_count; sample++)
+        {
+            bits = audio_read_u32(source + (size_t)sample * sizeof(float));
+            SDL_memcpy(&value, &bits, sizeof(float));
+            *(target + sample * CUBE_AUDIO_CHANNELS / sound->source_channels) = value;
+            if (sound->source_channels == 1)
+            {
+                *(target + sample * CUBE_AUDIO_CHANNELS + 1) = value;
+            }
+        }
+    }
+}
+
+void audio_release_stream(cube_stream *stream)
+{
+    size_t offset;
+
+    offset = (size_t)(stream->sound->pcm - (const Uint8 *)stream->sound->mapping.data) +
+             (size_t)stream->source_position * stream->sound->source_channels *
+                 SDL_AUDIO_BITSIZE(stream->sound->source_format) / 8;
+    offset -= offset % CUBE_AUDIO_STREAM_RELEASE;
+    if (offset > stream->released)
+    {
+        audio_release_file(&stream->sound->mapping, stream->released, offset - stream->released);
+        stream->released = offset;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,319 @@
+#include "cube.h"
+
+#define CUBE_ANIMATION_VARIABLE "CUBE_GPU_ANIMATION"
+#define CUBE_ANIMATION_GROUP_SIZE 64
+
+static int graphics_create_animation_buffers(cube_graphics *graphics);
+static int graphics_create_animation_pipeline(cube_graphics *graphics);
+static int graphics_create_animation_descriptor_set(cube_graphics *graphics);
+
+// before the frame pool, whose host visible instance buffers this replaces
+int graphics_create_animation(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    const char *animation_variable;
+
+    graphics->animation = NULL;
+
+    // without it every frame rotates and writes the matrices on the job workers
+    animation_variable = SDL_getenv(CUBE_ANIMATION_VARIABLE);
+    if (animation_variable != NULL && SDL_atoi(animation_variable) == 0)
+    {
+        goto done;
+    }
+    if (graphics_util_has_shader(graphics, "animate.spv") == VK_FALSE)
+    {
+        goto done;
+    }
+
+    graphics->animation = calloc(1, sizeof(cube_animation));
+    CUBE_ASSERT(graphics->animation != NULL, "failed to allocate animation")
+    CUBE_ASSERT(
+        graphics_create_animation_buffers(graphics) == CUBE_SUCCESS,
+        "failed to create animation buffers")
+    CUBE_ASSERT(
+        graphics_create_animation_pipeline(graphics) == CUBE_SUCCESS,
+        "failed to create animation pipeline")
+    CUBE_ASSERT(
+        graphics_create_animation_descriptor_set(graphics) == CUBE_SUCCESS,
+        "failed to create animation descriptor set")
+    CUBE_END_FUNCTION
+}
+
+// recorded ahead of every pass, nothing is written from the host
+void graphics_render_animate_frame(cube_graphics *graphics, cube_frame *frame, const cube_scene *scene)
+{
+    cube_animation *animation;
+    cube_animation_constants constants;
+    const VkMemoryBarrier after_barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+    };
+
+    animation = graphics->animation;
+    constants.angle = scene->angle;
+    constants.instance_count = graphics->instance_count;
+
+    // the previous frame's draws finish reading before the matrices are overwritten
+    vkCmdPipelineBarrier(
+        frame->command_buffer,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0, NULL,
+        0, NULL,
+        0, NULL);
+    vkCmdBindPipeline(
+        frame->command_buffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        animation->pipeline);
+    vkCmdBindDescriptorSets(
+        frame->command_buffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        animation->pipeline_layout,
+        0, 1,
+        &animation->descriptor_set,
+        0, NULL);
+    vkCmdPushConstants(
+        frame->command_buffer,
+        animation->pipeline_layout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(cube_animation_constants),
+        &constants);
+    vkCmdDispatch(
+        frame->command_buffer,
+        (graphics->instance_count + CUBE_ANIMATION_GROUP_SIZE - 1) / CUBE_ANIMATION_GROUP_SIZE,
+        1, 1);
+    vkCmdPipelineBarrier(
+        frame->command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        0,
+        1, &after_barrier,
+        0, NULL,
+        0, NULL);
+}
+
+void graphics_destroy_animation(cube_graphics *graphics)
+{
+    cube_animation *animation;
+
+    animation = graphics->animation;
+    if (animation == NULL)
+    {
+        return;
+    }
+    if (animation->descriptor_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(graphics->logical_device, animation->descriptor_pool, NULL);
+    }
+    if (animation->pipeline != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(graphics->logical_device, animation->pipeline, NULL);
+    }
+    if (animation->pipeline_layout != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineLayout(graphics->logical_device, animation->pipeline_layout, NULL);
+    }
+    if (animation->set_layout != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorSetLayout(graphics->logical_device, animation->set_layout, NULL);
+    }
+    if (animation->matrix_buffer != VK_NULL_HANDLE)
+    {
+        vmaDestroyBuffer(graphics->allocator, animation->matrix_buffer, animation->matrix_allocation);
+    }
+    if (animation->state_buffer != VK_NULL_HANDLE)
+    {
+        vmaDestroyBuffer(graphics->allocator, animation->state_buffer, animation->state_allocation);
+    }
+    free(animation);
+    graphics->animation = NULL;
+}
+
+// every instance starts from its transform and spins about z once per scene turn,
+// the whole turns keep the wrap of the scene angle seamless
+int graphics_create_animation_buffers(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_animation *animation;
+    const cube_transforms *transforms;
+    cube_animation_state *states;
+    cube_animation_state *state;
+    uint32_t index;
+    const VkBufferCreateInfo matrix_buffer_create_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = (VkDeviceSize)graphics->instance_count * sizeof(float[4][4]),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    const VmaAllocationCreateInfo matrix_allocation_create_info = {
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+    };
+
+    animation = graphics->animation;
+    transforms = graphics->transforms;
+    states = CUBE_CALLOC(graphics->instance_count, sizeof(cube_animation_state));
+    CUBE_ASSERT(states != NULL, "failed to allocate animation states")
+    for (index = 0; index < graphics->instance_count; index++)
+    {
+        state = states + index;
+        state->position[0] = *(transforms->position_x + index);
+        state->position[1] = *(transforms->position_y + index);
+        state->position[2] = *(transforms->position_z + index);
+        state->scale[0] = *(transforms->scale_x + index);
+        state->scale[1] = *(transforms->scale_y + index);
+        state->scale[2] = *(transforms->scale_z + index);
+        state->rotation[0] = *(transforms->rotation_x + index);
+        state->rotation[1] = *(transforms->rotation_y + index);
+        state->rotation[2] = *(transforms->rotation_z + index);
+        state->rotation[3] = *(transforms->rotation_w + index);
+        state->axis[2] = 1.0f;
+        state->angular_velocity = 1.0f;
+        state->phase = 0.0f;
+    }
+    CUBE_ASSERT(
+        graphics_util_upload_buffer(
+            graphics,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            states,
+            graphics->instance_count * sizeof(cube_animation_state),
+            &animation->state_buffer,
+            &animation->state_allocation) == CUBE_SUCCESS,
+        "failed to upload animation states")
+
+    // only one frame is in flight, so the frames share the matrices
+    VK_CHECK_RESULT(
+        vmaCreateBuffer(
+            graphics->allocator,
+            &matrix_buffer_create_info,
+            &matrix_allocation_create_info,
+            &animation->matrix_buffer,
+            &animation->matrix_allocation,
+            NULL))
+    CUBE_END_FUNCTION
+}
+
+int graphics_create_animation_pipeline(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_animation *animation;
+    VkShaderModule shader;
+    const VkDescriptorSetLayoutBinding bindings[] = {
+        {.binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
+        {.binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
+    };
+    const VkDescriptorSetLayoutCreateInfo set_layout_create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = sizeof(bindings) / sizeof(bindings[0]),
+        .pBindings = &bindings[0],
+    };
+    const VkPushConstantRange push_constant_range = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(cube_animation_constants),
+    };
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_constant_range,
+    };
+    VkComputePipelineCreateInfo pipeline_create_info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pName = "main",
+        },
+    };
+
+    animation = graphics->animation;
+    CUBE_ASSERT(
+        graphics_util_load_shader(
+            graphics,
+            "animate.spv",
+            &shader) == CUBE_SUCCESS,
+        "failed to load animation shader")
+    VK_CHECK_RESULT(
+        vkCreateDescriptorSetLayout(
+            graphics->logical_device,
+            &set_layout_create_info,
+            NULL,
+            &animation->set_layout))
+    pipeline_layout_create_info.pSetLayouts = &animation->set_layout;
+    VK_CHECK_RESULT(
+        vkCreatePipelineLayout(
+            graphics->logical_device,
+            &pipeline_layout_create_info,
+            NULL,
+            &animation->pipeline_layout))
+    pipeline_create_info.stage.module = shader;
+    pipeline_create_info.layout = animation->pipeline_layout;
+    vk_result = vkCreateComputePipelines(
+        graphics->logical_device,
+        graphics->pipeline_cache,
+        1,
+        &pipeline_create_info,
+        NULL,
+        &animation->pipeline);
+    vkDestroyShaderModule(graphics->logical_device, shader, NULL);
+    CUBE_ASSERT(vk_result == VK_SUCCESS, "failed to create animation pipeline")
+    CUBE_END_FUNCTION
+}
+
+int graphics_create_animation_descriptor_set(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_animation *animation;
+    const VkDescriptorPoolSize pool_size = {
+        .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 2,
+    };
+    const VkDescriptorPoolCreateInfo pool_create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes = &pool_size,
+    };
+    VkDescriptorSetAllocateInfo set_allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorSetCount = 1,
+    };
+    VkDescriptorBufferInfo buffer_infos[2];
+    VkWriteDescriptorSet writes[2];
+    uint32_t write_index;
+
+    animation = graphics->animation;
+    VK_CHECK_RESULT(
+        vkCreateDescriptorPool(
+            graphics->logical_device,
+            &pool_create_info,
+            NULL,
+            &animation->descriptor_pool))
+    set_allocate_info.descriptorPool = animation->descriptor_pool;
+    set_allocate_info.pSetLayouts = &animation->set_layout;
+    VK_CHECK_RESULT(
+        vkAllocateDescriptorSets(
+            graphics->logical_device,
+            &set_allocate_info,
+            &animation->descriptor_set))
+
+    buffer_infos[0] = (VkDescriptorBufferInfo){animation->state_buffer, 0, VK_WHOLE_SIZE};
+    buffer_infos[1] = (VkDescriptorBufferInfo){animation->matrix_buffer, 0, VK_WHOLE_SIZE};
+    for (write_index = 0; write_index < 2; write_index++)
+    {
+        writes[write_index] = (VkWriteDescriptorSet){
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = animation->descriptor_set,
+            .dstBinding = write_index,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &buffer_infos[write_index],
+        };
+    }
+    vkUpdateDescriptorSets(graphics->logical_device, 2, &writes[0], 0, NULL);
+    CUBE_END_FUNCTION
+}
\ No newline at end of file
@@ -0,0 +1,342 @@
+#include "cube.h"
+
+static int graphics_create_bindless_set(cube_graphics *graphics);
+static int graphics_create_bindless_materials(cube_graphics *graphics);
+
+// only where descriptor indexing was enabled, otherwise every draw reads the per-frame set alone
+int graphics_create_bindless(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    if (graphics->descriptor_indexing == VK_FALSE)
+    {
+        goto done;
+    }
+    if (graphics_util_has_shader(graphics, "bindless_vert.spv") == VK_FALSE ||
+        graphics_util_has_shader(graphics, "bindless_frag.spv") == VK_FALSE)
+    {
+        goto done;
+    }
+    graphics->bindless = calloc(1, sizeof(cube_bindless));
+    CUBE_ASSERT(graphics->bindless != NULL, "failed to allocate bindless")
+    graphics->bindless->buffer_capacity = SDL_min(
+        CUBE_BINDLESS_BUFFER_CAPACITY,
+        graphics->capabilities.max_bindless_buffers);
+    graphics->bindless->image_capacity = SDL_min(
+        CUBE_BINDLESS_IMAGE_CAPACITY,
+        graphics->capabilities.max_bindless_images);
+
+    CUBE_ASSERT(graphics_create_bindless_set(graphics) == CUBE_SUCCESS, "failed to create bindless set")
+    CUBE_ASSERT(
+        graphics_create_bindless_materials(graphics) == CUBE_SUCCESS,
+        "failed to create bindless materials")
+    CUBE_END_FUNCTION
+}
+
+// update after bind lets a slot be written while earlier frames still read the set
+int graphics_bindless_add_buffer(
+    cube_graphics *graphics,
+    VkBuffer buffer,
+    VkDeviceSize range,
+    uint32_t *index)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_bindless *bindless;
+    const VkDescriptorBufferInfo buffer_info = {
+        .buffer = buffer,
+        .offset = 0,
+        .range = range,
+    };
+    VkWriteDescriptorSet write_descriptor_set = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstBinding = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .pBufferInfo = &buffer_info,
+    };
+
+    bindless = graphics->bindless;
+    CUBE_ASSERT(bindless->buffer_count < bindless->buffer_capacity, "bindless buffers are full")
+    write_descriptor_set.dstSet = bindless->descriptor_set;
+    write_descriptor_set.dstArrayElement = bindless->buffer_count;
+    vkUpdateDescriptorSets(graphics->logical_device, 1, &write_descriptor_set, 0, NULL);
+    *index = bindless->buffer_count++;
+    CUBE_END_FUNCTION
+}
+
+int graphics_bindless_add_image(cube_graphics *graphics, VkImageView image_view, uint32_t *index)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_bindless *bindless;
+    const VkDescriptorImageInfo image_info = {
+        .imageView = image_view,
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+    VkWriteDescriptorSet write_descriptor_set = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstBinding = 1,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+        .pImageInfo = &image_info,
+    };
+
+    bindless = graphics->bindless;
+    CUBE_ASSERT(bindless->image_count < bindless->image_capacity, "bindless images are full")
+    write_descriptor_set.dstSet = bindless->descriptor_set;
+    write_descriptor_set.dstArrayElement = bindless->image_count;
+    vkUpdateDescriptorSets(graphics->logical_device, 1, &write_descriptor_set, 0, NULL);
+    *index = bindless->image_count++;
+    CUBE_END_FUNCTION
+}
+
+int graphics_bindless_add_sampler(cube_graphics *graphics, VkSampler sampler, uint32_t *index)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_bindless *bindless;
+    const VkDescriptorImageInfo image_info = {
+        .sampler = sampler,
+    };
+    VkWriteDescriptorSet write_descriptor_set = {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstBinding = 2,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+        .pImageInfo = &image_info,
+    };
+
+    bindless = graphics->bindless;
+    CUBE_ASSERT(bindless->sampler_count < CUBE_BINDLESS_SAMPLER_CAPACITY, "bindless samplers are full")
+    write_descriptor_set.dstSet = bindless->descriptor_set;
+    write_descriptor_set.dstArrayElement = bindless->sampler_count;
+    vkUpdateDescriptorSets(graphics->logical_device, 1, &write_descriptor_set, 0, NULL);
+    *index = bindless->sampler_count++;
+    CUBE_END_FUNCTION
+}
+
+// a new material lands past every index a submitted frame can reach, so the write needs no wait
+int graphics_bindless_add_material(cube_graphics *graphics, const cube_material *material, uint32_t *index)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_bindless *bindless;
+
+    bindless = graphics->bindless;
+    CUBE_ASSERT(bindless->material_count < CUBE_BINDLESS_MATERIAL_CAPACITY, "bindless materials are full")
+    *(bindless->materials + bindless->material_count) = *material;
+    *index = bindless->material_count++;
+    CUBE_END_FUNCTION
+}
+
+// a frame already submitted may still draw the instance with its previous material
+void graphics_bindless_set_instance_material(cube_graphics *graphics, uint32_t instance, uint32_t material)
+{
+    *(graphics->bindless->instance_materials + instance) = material;
+}
+
+// once per command buffer, after the per-frame set
+void graphics_render_bind_bindless(cube_graphics *graphics, VkCommandBuffer command_buffer)
+{
+    if (graphics->bindless == NULL)
+    {
+        return;
+    }
+    vkCmdBindDescriptorSets(
+        command_buffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        graphics->pipeline_layout,
+        1, 1,
+        &graphics->bindless->descriptor_set,
+        0, NULL);
+    vkCmdPushConstants(
+        command_buffer,
+        graphics->pipeline_layout,
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        0,
+        sizeof(cube_bindless_constants),
+        &graphics->bindless->constants);
+}
+
+void graphics_destroy_bindless(cube_graphics *graphics)
+{
+    cube_bindless *bindless;
+
+    bindless = graphics->bindless;
+    if (bindless == NULL)
+    {
+        return;
+    }
+    if (bindless->instance_buffer != VK_NULL_HANDLE)
+    {
+        vmaDestroyBuffer(graphics->allocator, bindless->instance_buffer, bindless->instance_buffer_allocation);
+    }
+    if (bindless->material_buffer != VK_NULL_HANDLE)
+    {
+        vmaDestroyBuffer(graphics->allocator, bindless->material_buffer, bindless->material_buffer_allocation);
+    }
+    if (bindless->descriptor_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(graphics->logical_device, bindless->descriptor_pool, NULL);
+    }
+    if (bindless->descriptor_set_layout != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorSetLayout(graphics->logical_device, bindless->descriptor_set_layout, NULL);
+    }
+    free(bindless);
+    graphics->bindless = NULL;
+}
+
+int graphics_create_bindless_set(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_bindless *bindless;
+    const VkDescriptorBindingFlags binding_flags[] = {
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+    };
+    const VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = sizeof(binding_flags) / sizeof(binding_flags[0]),
+        .pBindingFlags = &binding_flags[0],
+    };
+    VkDescriptorSetLayoutBinding bindings[] = {
+        {
+            .binding = 0,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        },
+        {
+            .binding = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+        },
+        {
+            .binding = 2,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+            .descriptorCount = CUBE_BINDLESS_SAMPLER_CAPACITY,
+            .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+        },
+    };
+    const VkDescriptorSetLayoutCreateInfo set_layout_create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &binding_flags_create_info,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        .bindingCount = sizeof(bindings) / sizeof(bindings[0]),
+        .pBindings = &bindings[0],
+    };
+    VkDescriptorPoolSize pool_sizes[] = {
+        {.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+        {.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE},
+        {.type = VK_DESCRIPTOR_TYPE_SAMPLER, .descriptorCount = CUBE_BINDLESS_SAMPLER_CAPACITY},
+    };
+    const VkDescriptorPoolCreateInfo pool_create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+        .maxSets = 1,
+        .poolSizeCount = sizeof(pool_sizes) / sizeof(pool_sizes[0]),
+        .pPoolSizes = &pool_sizes[0],
+    };
+    VkDescriptorSetAllocateInfo set_allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorSetCount = 1,
+    };
+
+    bindless = graphics->bindless;
+    bindings[0].descriptorCount = bindless->buffer_capacity;
+    bindings[1].descriptorCount = bindless->image_capacity;
+    pool_sizes[0].descriptorCount = bindless->buffer_capacity;
+    pool_sizes[1].descriptorCount = bindless->image_capacity;
+    VK_CHECK_RESULT(
+        vkCreateDescriptorSetLayout(
+            graphics->logical_device,
+            &set_layout_create_info,
+            NULL,
+            &bindless->descriptor_set_layout))
+    VK_CHECK_RESULT(
+        vkCreateDescriptorPool(
+            graphics->logical_device,
+            &pool_create_info,
+            NULL,
+            &bindless->descriptor_pool))
+    set_allocate_info.descriptorPool = bindless->descriptor_pool;
+    set_allocate_info.pSetLayouts = &bindless->descriptor_set_layout;
+    VK_CHECK_RESULT(
+        vkAllocateDescriptorSets(
+            graphics->logical_device,
+            &set_allocate_info,
+            &bindless->descriptor_set))
+    CUBE_END_FUNCTION
+}
+
+// material 0 is untinted and untextured, every instance starts on it
+int graphics_create_bindless_materials(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_bindless *bindless;
+    const VkBufferCreateInfo material_buffer_create_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = CUBE_BINDLESS_MATERIAL_CAPACITY * sizeof(cube_material),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    const VkBufferCreateInfo instance_buffer_create_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = (VkDeviceSize)graphics->instance_count * sizeof(uint32_t),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    // materials are written in place while frames read them, nothing is flushed
+    const VmaAllocationCreateInfo material_allocation_create_info = {
+        .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .requiredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+    };
+    const cube_material default_material = {
+        .color = {1.0f, 1.0f, 1.0f, 1.0f},
+        .texture = CUBE_BINDLESS_NONE,
+        .sampler = CUBE_BINDLESS_NONE,
+    };
+    VmaAllocationInfo material_allocation_info;
+    VmaAllocationInfo instance_allocation_info;
+    uint32_t material_index;
+
+    bindless = graphics->bindless;
+    VK_CHECK_RESULT(
+        vmaCreateBuffer(
+            graphics->allocator,
+            &material_buffer_create_info,
+            &material_allocation_create_info,
+            &bindless->material_buffer,
+            &bindless->material_buffer_allocation,
+            &material_allocation_info))
+    bindless->materials = material_allocation_info.pMappedData;
+    CUBE_ASSERT(
+        graphics_bindless_add_material(graphics, &default_material, &material_index) == CUBE_SUCCESS,
+        "failed to add default material")
+
+    // host visible too, so materials can be reassigned without an upload
+    VK_CHECK_RESULT(
+        vmaCreateBuffer(
+            graphics->allocator,
+            &instance_buffer_create_info,
+            &material_allocation_create_info,
+            &bindless->instance_buffer,
+            &bindless->instance_buffer_allocation,
+            &instance_allocation_info))
+    bindless->instance_materials = instance_allocation_info.pMappedData;
+    SDL_memset(bindless->instance_materials, 0, instance_buffer_create_info.size);
+
+    CUBE_ASSERT(
+        graphics_bindless_add_buffer(
+            graphics,
+            bindless->material_buffer,
+            VK_WHOLE_SIZE,
+            &bindless->constants.material_buffer) == CUBE_SUCCESS,
+        "failed to bind material buffer")
+    CUBE_ASSERT(
+        graphics_bindless_add_buffer(
+            graphics,
+            bindless->instance_buffer,
+            VK_WHOLE_SIZE,
+            &bindless->constants.instance_buffer) == CUBE_SUCCESS,
+        "failed to bind instance buffer")
+    CUBE_END_FUNCTION
+}
\ No newline at end of file
@@ -0,0 +1,657 @@
+#include "cube.h"
+
+#define CUBE_CULLING_VARIABLE "CUBE_CULLING"
+#define CUBE_BVH_PHASE_CODES 0
+#define CUBE_BVH_PHASE_NODES 1
+#define CUBE_BVH_PHASE_BOUNDS 2
+#define CUBE_BVH_TASK_MINIMUM 4096
+#define CUBE_BVH_STACK_SIZE 128
+// at most two to the depth roots, which is CUBE_BVH_CULL_ROOTS
+#define CUBE_BVH_CULL_DEPTH 6
+#define CUBE_BVH_CULL_MINIMUM 4096
+#define CUBE_BVH_RADIX_BITS 10
+#define CUBE_BVH_RADIX_PASSES 3
+#define CUBE_BVH_OUTSIDE 0
+#define CUBE_BVH_INTERSECT 1
+#define CUBE_BVH_INSIDE 2
+
+static int graphics_bvh_run(cube_bvh *bvh, const cube_transforms *transforms, int phase);
+static void graphics_bvh_run_job(void *data, uint32_t begin, uint32_t end);
+static uint32_t graphics_bvh_cull_roots(
+    const cube_bvh *bvh,
+    const cube_frustum *frustum,
+    uint32_t *roots);
+static void graphics_bvh_cull_job(void *data, uint32_t begin, uint32_t end);
+static uint32_t graphics_bvh_cull_node(
+    const cube_bvh *bvh,
+    const cube_frustum *frustum,
+    uint32_t root,
+    uint32_t *visible);
+static int graphics_bvh_sort(cube_bvh *bvh);
+static uint32_t graphics_bvh_expand_bits(uint32_t value);
+static uint32_t graphics_bvh_morton_code(const cube_bvh *bvh, float x, float y, float z);
+static int graphics_bvh_common_prefix(const cube_bvh *bvh, uint32_t first, int64_t second);
+static void graphics_bvh_build_node(cube_bvh *bvh, uint32_t index);
+static void graphics_bvh_leaf_bounds(const cube_transforms *transforms, uint32_t object, cube_bvh_node *node);
+static void graphics_bvh_merge(cube_bvh *bvh, uint32_t index);
+static int graphics_bvh_test(const cube_frustum *frustum, const cube_bvh_node *node);
+
+int graphics_create_bvh(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    const char *culling_variable;
+    cube_bvh *bvh;
+    uint32_t index;
+
+    graphics->visible_instances = calloc(graphics->instance_count, sizeof(uint32_t));
+    CUBE_ASSERT(graphics->visible_instances != NULL, "failed to allocate visible instances")
+    for (index = 0; index < graphics->instance_count; index++)
+    {
+        *(graphics->visible_instances + index) = index;
+    }
+    graphics->visible_count = graphics->instance_count;
+
+    // culling disabled, every instance stays visible
+    culling_variable = SDL_getenv(CUBE_CULLING_VARIABLE);
+    if (culling_variable != NULL && SDL_atoi(culling_variable) == 0)
+    {
+        goto done;
+    }
+
+    graphics->bvh = calloc(1, sizeof(cube_bvh));
+    CUBE_ASSERT(graphics->bvh != NULL, "failed to allocate bvh")
+
+    bvh = graphics->bvh;
+    bvh->object_count = graphics->transforms->count;
+    bvh->node_count = 2 * bvh->object_count - 1;
+    bvh->jobs = graphics->jobs;
+    bvh->nodes = calloc(bvh->node_count, sizeof(cube_bvh_node));
+    bvh->parents = calloc(bvh->node_count, sizeof(uint32_t));
+    bvh->objects = calloc(bvh->object_count, sizeof(uint32_t));
+    bvh->codes = calloc(bvh->object_count, sizeof(uint32_t));
+    bvh->visits = calloc(bvh->object_count, sizeof(SDL_atomic_t));
+    CUBE_ASSERT(
+        bvh->nodes != NULL &&
+            bvh->parents != NULL &&
+            bvh->objects != NULL &&
+            bvh->codes != NULL &&
+            bvh->visits != NULL,
+        "failed to allocate bvh arrays")
+
+    CUBE_ASSERT(
+        graphics_bvh_build(
+            bvh,
+            graphics->transforms) == CUBE_SUCCESS,
+        "failed to build bvh")
+    CUBE_END_FUNCTION
+}
+
+int graphics_bvh_build(cube_bvh *bvh, const cube_transforms *transforms)
+{
+    CUBE_BEGIN_FUNCTION
+    uint32_t index;
+    uint32_t axis;
+    const float *positions[3] = {
+        transforms->position_x,
+        transforms->position_y,
+        transforms->position_z,
+    };
+
+    // morton codes are quantized against the bounds of the object centers
+    for (axis = 0; axis < 3; axis++)
+    {
+        bvh->scene_min[axis] = *positions[axis];
+        bvh->scene_max[axis] = *positions[axis];
+        for (index = 1; index < bvh->object_count; index++)
+        {
+            bvh->scene_min[axis] = SDL_min(bvh->scene_min[axis], *(positions[axis] + index));
+            bvh->scene_max[axis] = SDL_max(bvh->scene_max[axis], *(positions[axis] + index));
+        }
+    }
+
+    CUBE_ASSERT(
+        graphics_bvh_run(
+            bvh,
+            transforms,
+            CUBE_BVH_PHASE_CODES) == CUBE_SUCCESS,
+        "failed to compute morton codes")
+    CUBE_ASSERT(graphics_bvh_sort(bvh) == CUBE_SUCCESS, "failed to sort morton codes")
+
+    SDL_memset(bvh->visits, 0, bvh->object_count * sizeof(SDL_atomic_t));
+    *(bvh->parents + 0) = CUBE_BVH_LEAF;
+    CUBE_ASSERT(
+        graphics_bvh_run(
+            bvh,
+            transforms,
+            CUBE_BVH_PHASE_NODES) == CUBE_SUCCESS,
+        "failed to build bvh nodes")
+    CUBE_ASSERT(
+        graphics_bvh_run(
+            bvh,
+            transforms,
+            CUBE_BVH_PHASE_BOUNDS) == CUBE_SUCCESS,
+        "failed to compute bvh bounds")
+    CUBE_END_FUNCTION
+}
+
+void graphics_bvh_frustum(const cube_mat4 *view_projection, cube_frustum *frustum)
+{
+    const float signs[6] = {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f};
+    uint32_t plane;
+    uint32_t row;
+
+    // Gribb/Hartmann: each plane is row 3 plus or minus row 0, 1 or 2
+    for (plane = 0; plane < 6; plane++)
+    {
+        row = plane / 2;
+        frustum->x[plane] = view_projection->m[0][3] + signs[plane] * view_projection->m[0][row];
+        frustum->y[plane] = view_projection->m[1][3] + signs[plane] * view_projection->m[1][row];
+        frustum->z[plane] = view_projection->m[2][3] + signs[plane] * view_projection->m[2][row];
+        frustum->w[plane] = view_projection->m[3][3] + signs[plane] * view_projection->m[3][row];
+    }
+    // padding planes accept everything
+    for (plane = 6; plane < 8; plane++)
+    {
+        frustum->x[plane] = 0.0f;
+        frustum->y[plane] = 0.0f;
+        frustum->z[plane] = 0.0f;
+        frustum->w[plane] = 1.0f;
+    }
+    for (plane = 0; plane < 8; plane++)
+    {
+        frustum->abs_x[plane] = fabsf(frustum->x[plane]);
+        frustum->abs_y[plane] = fabsf(frustum->y[plane]);
+        frustum->abs_z[plane] = fabsf(frustum->z[plane]);
+    }
+}
+
+// subtrees near the root are split across the jobs, the result matches a single walk
+uint32_t graphics_bvh_cull(
+    const cube_bvh *bvh,
+    const cube_frustum *frustum,
+    uint32_t *visible)
+{
+    cube_bvh_cull_task task;
+    uint32_t root_index;
+    uint32_t visible_count;
+
+    if (bvh->jobs->worker_count == 0 || bvh->object_count < CUBE_BVH_CULL_MINIMUM)
+    {
+        return graphics_bvh_cull_node(bvh, frustum, 0, visible);
+    }
+
+    task.bvh = bvh;
+    task.frustum = frustum;
+    task.visible = visible;
+    task.root_count = graphics_bvh_cull_roots(bvh, frustum, &task.roots[0]);
+    application_jobs_parallel_for(
+        bvh->jobs,
+        graphics_bvh_cull_job,
+        &task,
+        task.root_count,
+        1);
+
+    // roots come in leaf order, so every survivor moves down or stays put
+    visible_count = 0;
+    for (root_index = 0; root_index < task.root_count; root_index++)
+    {
+        SDL_memmove(
+            visible + visible_count,
+            visible + (bvh->nodes + task.roots[root_index])->first,
+            task.counts[root_index] * sizeof(uint32_t));
+        visible_count += task.counts[root_index];
+    }
+    return visible_count;
+}
+
+void graphics_destroy_bvh(cube_graphics *graphics)
+{
+    cube_bvh *bvh;
+
+    bvh = graphics->bvh;
+    if (bvh != NULL)
+    {
+        free(bvh->nodes);
+        free(bvh->parents);
+        free(bvh->objects);
+        free(bvh->codes);
+        free(bvh->visits);
+        free(bvh);
+        graphics->bvh = NULL;
+    }
+    free(graphics->visible_instances);
+    graphics->visible_instances = NULL;
+}
+
+int graphics_bvh_run(cube_bvh *bvh, const cube_transforms *transforms, int phase)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_bvh_task task;
+
+    task.bvh = bvh;
+    task.transforms = transforms;
+    task.phase = phase;
+    application_jobs_parallel_for(
+        bvh->jobs,
+        graphics_bvh_run_job,
+        &task,
+        bvh->object_count,
+        CUBE_BVH_TASK_MINIMUM);
+    CUBE_END_FUNCTION
+}
+
+void graphics_bvh_run_job(void *data, uint32_t begin, uint32_t end)
+{
+    cube_bvh_task *task;
+    cube_bvh *bvh;
+    const cube_transforms *transforms;
+    uint32_t index;
+    uint32_t object;
+    uint32_t node_index;
+
+    task = data;
+    bvh = task->bvh;
+    transforms = task->transforms;
+    for (index = begin; index < end; index++)
+    {
+        switch (task->phase)
+        {
+        case CUBE_BVH_PHASE_CODES:
+            *(bvh->codes + index) = graphics_bvh_morton_code(
+                bvh,
+                *(transforms->position_x + index),
+                *(transforms->position_y + index),
+                *(transforms->position_z + index));
+            *(bvh->objects + index) = index;
+            break;
+        case CUBE_BVH_PHASE_NODES:
+            // internal nodes come first, leaf i follows at object_count - 1 + i
+            node_index = bvh->object_count - 1 + index;
+            object = *(bvh->objects + index);
+            graphics_bvh_leaf_bounds(transforms, object, bvh->nodes + node_index);
+            (bvh->nodes + node_index)->left = object;
+            (bvh->nodes + node_index)->right = CUBE_BVH_LEAF;
+            (bvh->nodes + node_index)->first = index;
+            (bvh->nodes + node_index)->last = index;
+            if (index + 1 < bvh->object_count)
+            {
+                graphics_bvh_build_node(bvh, index);
+            }
+            break;
+        case CUBE_BVH_PHASE_BOUNDS:
+            // the second child to arrive at a parent merges it and keeps climbing
+            node_index = *(bvh->parents + bvh->object_count - 1 + index);
+            while (node_index != CUBE_BVH_LEAF &&
+                   SDL_AtomicAdd(bvh->visits + node_index, 1) != 0)
+            {
+                graphics_bvh_merge(bvh, node_index);
+                node_index = *(bvh->parents + node_index);
+            }
+            break;
+        }
+    }
+}
+
+// the top levels are walked here, whatever is still undecided below them becomes a root
+uint32_t graphics_bvh_cull_roots(
+    const cube_bvh *bvh,
+    const cube_frustum *frustum,
+    uint32_t *roots)
+{
+    uint32_t stack[CUBE_BVH_CULL_DEPTH * 2 + 1];
+    uint32_t depths[CUBE_BVH_CULL_DEPTH * 2 + 1];
+    uint32_t stack_size;
+    uint32_t root_count;
+    uint32_t depth;
+    const cube_bvh_node *node;
+    int test;
+
+    root_count = 0;
+    stack_size = 0;
+    stack[stack_size] = 0;
+    depths[stack_size++] = 0;
+    while (stack_size > 0)
+    {
+        node = bvh->nodes + stack[--stack_size];
+        depth = depths[stack_size];
+        test = graphics_bvh_test(frustum, node);
+        if (test == CUBE_BVH_OUTSIDE)
+        {
+            continue;
+        }
+        if (test == CUBE_BVH_INSIDE || depth == CUBE_BVH_CULL_DEPTH || node->right == CUBE_BVH_LEAF)
+        {
+            *(roots + root_count++) = stack[stack_size];
+            continue;
+        }
+        stack[stack_size] = node->right;
+        depths[stack_size++] = depth + 1;
+        stack[stack_size] = node->left;
+        depths[stack_size++] = depth + 1;
+    }
+    return root_count;
+}
+
+void graphics_bvh_cull_job(void *data, uint32_t begin, uint32_t end)
+{
+    cube_bvh_cull_task *task;
+    uint32_t root_index;
+
+    task = data;
+    for (root_index = begin; root_index < end; root_index++)
+    {
+        task->counts[root_index] = graphics_bvh_cull_node(
+            task->bvh,
+            task->frustum,
+            task->roots[root_index],
+            task->visible + (task->bvh->nodes + task->roots[root_index])->first);
+    }
+}
+
+uint32_t graphics_bvh_cull_node(
+    const cube_bvh *bvh,
+    const cube_frustum *frustum,
+    uint32_t root,
+    uint32_t *visible)
+{
+    uint32_t stack[CUBE_BVH_STACK_SIZE];
+    uint32_t stack_size;
+    uint32_t visible_count;
+    uint32_t object_index;
+    const cube_bvh_node *node;
+    int test;
+
+    visible_count = 0;
+    stack_size = 0;
+    stack[stack_size++] = root;
+    while (stack_size > 0)
+    {
+        node = bvh->nodes + stack[--stack_size];
+        test = graphics_bvh_test(frustum, node);
+        if (test == CUBE_BVH_OUTSIDE)
+        {
+            continue;
+        }
+        // leaves under a node are contiguous, so accepted subtrees are copied whole
+        if (test == CUBE_BVH_INSIDE ||
+            node->right == CUBE_BVH_LEAF ||
+            stack_size + 2 > CUBE_BVH_STACK_SIZE)
+        {
+            for (object_index = node->first; object_index <= node->last; object_index++)
+            {
+                *(visible + visible_count++) = *(bvh->objects + object_index);
+            }
+            continue;
+        }
+        stack[stack_size++] = node->right;
+        stack[stack_size++] = node->left;
+    }
+    return visible_count;
+}
+
+int graphics_bvh_sort(cube_bvh *bvh)
+{
+    CUBE_BEGIN_FUNCTION
+    uint32_t histogram[1 << CUBE_BVH_RADIX_BITS];
+    uint32_t *codes;
+    uint32_t *objects;
+    uint32_t *sorted_codes;
+    uint32_t *sorted_objects;
+    uint32_t *swap;
+    uint32_t pass;
+    uint32_t shift;
+    uint32_t bucket;
+    uint32_t offset;
+    uint32_t count;
+    uint32_t index;
+
+    sorted_codes = CUBE_CALLOC(bvh->object_count, sizeof(uint32_t));
+    CUBE_ASSERT(sorted_codes != NULL, "failed to allocate sort codes")
+    sorted_objects = CUBE_CALLOC(bvh->object_count, sizeof(uint32_t));
+    CUBE_ASSERT(sorted_objects != NULL, "failed to allocate sort objects")
+
+    // stable least significant digit radix sort over the 30 bit codes
+    codes = bvh->codes;
+    objects = bvh->objects;
+    for (pass = 0; pass < CUBE_BVH_RADIX_PASSES; pass++)
+    {
+        shift = pass * CUBE_BVH_RADIX_BITS;
+        SDL_memset(&histogram[0], 0, sizeof(histogram));
+        for (index = 0; index < bvh->object_count; index++)
+        {
+            histogram[(*(codes + index) >> shift) & ((1 << CUBE_BVH_RADIX_BITS) - 1)]++;
+        }
+        offset = 0;
+        for (bucket = 0; bucket < (1 << CUBE_BVH_RADIX_BITS); bucket++)
+        {
+            count = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += count;
+        }
+        for (index = 0; index < bvh->object_count; index++)
+        {
+            bucket = (*(codes + index) >> shift) & ((1 << CUBE_BVH_RADIX_BITS) - 1);
+            *(sorted_codes + histogram[bucket]) = *(codes + index);
+            *(sorted_objects + histogram[bucket]) = *(objects + index);
+            histogram[bucket]++;
+        }
+        swap = codes;
+        codes = sorted_codes;
+        sorted_codes = swap;
+        swap = objects;
+        objects = sorted_objects;
+        sorted_objects = swap;
+    }
+    if (codes != bvh->codes)
+    {
+        SDL_memcpy(bvh->codes, codes, bvh->object_count * sizeof(uint32_t));
+        SDL_memcpy(bvh->objects, objects, bvh->object_count * sizeof(uint32_t));
+    }
+    CUBE_END_FUNCTION
+}
+
+uint32_t graphics_bvh_expand_bits(uint32_t value)
+{
+    value = (value * 0x00010001u) & 0xFF0000FFu;
+    value = (value * 0x00000101u) & 0x0F00F00Fu;
+    value = (value * 0x00000011u) & 0xC30C30C3u;
+    value = (value * 0x00000005u) & 0x49249249u;
+    return value;
+}
+
+uint32_t graphics_bvh_morton_code(const cube_bvh *bvh, float x, float y, float z)
+{
+    const float position[3] = {x, y, z};
+    uint32_t cells[3];
+    uint32_t axis;
+    float range;
+    float normalized;
+
+    for (axis = 0; axis < 3; axis++)
+    {
+        range = bvh->scene_max[axis] - bvh->scene_min[axis];
+        normalized = (range > 0.0f) ? (position[axis] - bvh->scene_min[axis]) / range : 0.0f;
+        cells[axis] = (uint32_t)CLAMP(normalized * 1024.0f, 0.0f, 1023.0f);
+    }
+    return (graphics_bvh_expand_bits(cells[0]) << 2) |
+           (graphics_bvh_expand_bits(cells[1]) << 1) |
+           graphics_bvh_expand_bits(cells[2]);
+}
+
+// length of the shared key prefix, with the sorted position breaking ties
+int graphics_bvh_common_prefix(const cube_bvh *bvh, uint32_t first, int64_t second)
+{
+    uint64_t difference;
+    uint32_t high;
+
+    if (second < 0 || second >= (int64_t)bvh->object_count)
+    {
+        return -1;
+    }
+    difference = (((uint64_t)*(bvh->codes + first) << 32) | first) ^
+                 (((uint64_t)*(bvh->codes + second) << 32) | (uint32_t)second);
+    high = (uint32_t)(difference >> 32);
+    if (high != 0)
+    {
+        return 31 - SDL_MostSignificantBitIndex32(high);
+    }
+    return 63 - SDL_MostSignificantBitIndex32((uint32_t)difference);
+}
+
+// Karras 2012: each internal node finds its key range and split independently
+void graphics_bvh_build_node(cube_bvh *bvh, uint32_t index)
+{
+    int64_t direction;
+    int minimum_prefix;
+    int node_prefix;
+    int64_t maximum_length;
+    int64_t length;
+    int64_t step;
+    int64_t split;
+    int64_t other;
+    int64_t gamma;
+    cube_bvh_node *node;
+
+    direction = (graphics_bvh_common_prefix(bvh, index, (int64_t)index + 1) -
+                 graphics_bvh_common_prefix(bvh, index, (int64_t)index - 1)) >= 0
+                    ? 1
+                    : -1;
+    minimum_prefix = graphics_bvh_common_prefix(bvh, index, (int64_t)index - direction);
+
+    maximum_length = 2;
+    while (graphics_bvh_common_prefix(bvh, index, (int64_t)index + maximum_length * direction) > minimum_prefix)
+    {
+        maximum_length *= 2;
+    }
+    length = 0;
+    for (step = maximum_length / 2; step >= 1; step /= 2)
+    {
+        if (graphics_bvh_common_prefix(bvh, index, (int64_t)index + (length + step) * direction) > minimum_prefix)
+        {
+            length += step;
+        }
+    }
+    other = (int64_t)index + length * direction;
+
+    node_prefix = graphics_bvh_common_prefix(bvh, index, other);
+    split = 0;
+    step = length;
+    do
+    {
+        step = (step + 1) / 2;
+        if (graphics_bvh_common_prefix(bvh, index, (int64_t)index + (split + step) * direction) > node_prefix)
+        {
+            split += step;
+        }
+    } while (step > 1);
+    gamma = (int64_t)index + split * direction + SDL_min(direction, 0);
+
+    node = bvh->nodes + index;
+    node->first = (uint32_t)SDL_min((int64_t)index, other);
+    node->last = (uint32_t)SDL_max((int64_t)index, other);
+    node->left = (node->first == (uint32_t)gamma)
+                     ? bvh->object_count - 1 + (uint32_t)gamma
+                     : (uint32_t)gamma;
+    node->right = (node->last == (uint32_t)gamma + 1)
+                      ? bvh->object_count - 1 + (uint32_t)gamma + 1
+                      : (uint32_t)gamma + 1;
+    *(bvh->parents + node->left) = index;
+    *(bvh->parents + node->right) = index;
+}
+
+// box around the bounding sphere, spinning never changes it and positions stay put, so the tree is built once
+void graphics_bvh_leaf_bounds(const cube_transforms *transforms, uint32_t object, cube_bvh_node *node)
+{
+    float sphere[4];
+    uint32_t axis;
+
+    graphics_transforms_sphere(transforms, object, sphere);
+    for (axis = 0; axis < 3; axis++)
+    {
+        node->min[axis] = sphere[axis] - sphere[3];
+        node->max[axis] = sphere[axis] + sphere[3];
+    }
+}
+
+void graphics_bvh_merge(cube_bvh *bvh, uint32_t index)
+{
+    cube_bvh_node *node;
+    const cube_bvh_node *left;
+    const cube_bvh_node *right;
+    uint32_t axis;
+
+    node = bvh->nodes + index;
+    left = bvh->nodes + node->left;
+    right = bvh->nodes + node->right;
+    for (axis = 0; axis < 3; axis++)
+    {
+        node->min[axis] = SDL_min(left->min[axis], right->min[axis]);
+        node->max[axis] = SDL_max(left->max[axis], right->max[axis]);
+    }
+}
+
+// box against all planes at once: outside if fully behind any plane,
+// inside if fully in front of every plane
+int graphics_bvh_test(const cube_frustum *frustum, const cube_bvh_node *node)
+{
+    int outside;
+    int crossing;
+    uint32_t plane;
+#if defined(CUBE_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 center_x = _mm_set1_ps(0.5f * (node->min[0] + node->max[0]));
+    const __m128 center_y = _mm_set1_ps(0.5f * (node->min[1] + node->max[1]));
+    const __m128 center_z = _mm_set1_ps(0.5f * (node->min[2] + node->max[2]));
+    const __m128 extent_x = _mm_set1_ps(0.5f * (node->max[0] - node->min[0]));
+    const __m128 extent_y = _mm_set1_ps(0.5f * (node->max[1] - node->min[1]));
+    const __m128 extent_z = _mm_set1_ps(0.5f * (node->max[2] - node->min[2]));
+    __m128 distance;
+    __m128 radius;
+
+    outside = 0;
+    crossing = 0;
+    for (plane = 0; plane < 8; plane += 4)
+    {
+        distance = _mm_add_ps(
+            _mm_add_ps(
+                _mm_mul_ps(_mm_load_ps(frustum->x + plane), center_x),
+                _mm_mul_ps(_mm_load_ps(frustum->y + plane), center_y)),
+            _mm_add_ps(
+                _mm_mul_ps(_mm_load_ps(frustum->z + plane), center_z),
+                _mm_load_ps(frustum->w + plane)));
+        radius = _mm_add_ps(
+            _mm_add_ps(
+                _mm_mul_ps(_mm_load_ps(frustum->abs_x + plane), extent_x),
+                _mm_mul_ps(_mm_load_ps(frustum->abs_y + plane), extent_y)),
+            _mm_mul_ps(_mm_load_ps(frustum->abs_z + plane), extent_z));
+        outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+        crossing |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), zero));
+    }
+#else
+    float center[3];
+    float extent[3];
+    float distance;
+    float radius;
+    uint32_t axis;
+
+    for (axis = 0; axis < 3; axis++)
+    {
+        center[axis] = 0.5f * (node->min[axis] + node->max[axis]);
+        extent[axis] = 0.5f * (node->max[axis] - node->min[axis]);
+    }
+    outside = 0;
+    crossing = 0;
+    for (plane = 0; plane < 6; plane++)
+    {
+        distance = frustum->x[plane] * center[0] + frustum->y[plane] * center[1] + frustum->z[plane] * center[2] + frustum->w[plane];
+        radius = frustum->abs_x[plane] * extent[0] + frustum->abs_y[plane] * extent[1] + frustum->abs_z[plane] * extent[2];
+        outside |= (distance + radius < 0.0f);
+        crossing |= (distance - radius < 0.0f);
+    }
+#endif
+    if (outside)
+    {
+        return CUBE_BVH_OUTSIDE;
+    }
+    return crossing ? CUBE_BVH_INTERSECT : CUBE_BVH_INSIDE;
+}
\ No newline at end of file
@@ -0,0 +1,521 @@
+#include "cube.h"
+
+#define CUBE_CAPTURE_VARIABLE "CUBE_CAPTURE"
+#define CUBE_CAPTURE_DIRECTORY_VARIABLE "CUBE_CAPTURE_DIRECTORY"
+#define CUBE_CAPTURE_FIRST_VARIABLE "CUBE_CAPTURE_FIRST"
+#define CUBE_CAPTURE_COUNT_VARIABLE "CUBE_CAPTURE_COUNT"
+// plays back with ffplay -f rawvideo -pixel_format rgba -video_size <width>x<height>
+#define CUBE_CAPTURE_RAW_NAME "capture.rgba"
+#define CUBE_CAPTURE_PATH_LENGTH 1024
+#define CUBE_CAPTURE_STORED_BLOCK 65535
+#define CUBE_CAPTURE_ADLER_MODULUS 65521
+#define CUBE_CAPTURE_ADLER_RUN 5552
+
+static uint32_t graphics_capture_crc_table[256];
+
+static int graphics_capture_thread(void *data);
+static int graphics_capture_write(cube_graphics *graphics, const cube_capture_slot *slot);
+static int graphics_capture_write_png(cube_capture *capture, const cube_capture_slot *slot);
+static int graphics_capture_write_raw(cube_capture *capture, const cube_capture_slot *slot);
+static void graphics_capture_convert_row(cube_capture *capture, const uint8_t *source, uint32_t channels);
+static void graphics_capture_png_bytes(cube_capture_png *png, const void *bytes, size_t length);
+static void graphics_capture_png_deflate(cube_capture_png *png, const uint8_t *bytes, size_t length);
+static void graphics_capture_png_uint32(cube_capture_png *png, uint32_t value);
+
+// off unless CUBE_CAPTURE names a format, png writes one file per frame and raw appends every frame to one stream
+int graphics_create_capture(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    const char *capture_variable;
+    const char *directory_variable;
+    const char *first_variable;
+    const char *count_variable;
+    cube_capture *capture;
+    VkBufferCreateInfo buffer_create_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    const VmaAllocationCreateInfo allocation_create_info = {
+        .usage = VMA_MEMORY_USAGE_GPU_TO_CPU,
+        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+    };
+    VmaAllocationInfo allocation_info;
+    char path[CUBE_CAPTURE_PATH_LENGTH];
+    uint32_t slot_index;
+    uint32_t table_index;
+    uint32_t crc;
+    uint32_t bit;
+
+    capture_variable = SDL_getenv(CUBE_CAPTURE_VARIABLE);
+    if (capture_variable == NULL || *capture_variable == '\0')
+    {
+        goto done;
+    }
+    if ((graphics->surface_capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+    {
+        goto done;
+    }
+    CUBE_ASSERT(
+        graphics->surface_format.format == VK_FORMAT_B8G8R8A8_UNORM ||
+            graphics->surface_format.format == VK_FORMAT_B8G8R8A8_SRGB ||
+            graphics->surface_format.format == VK_FORMAT_R8G8B8A8_UNORM ||
+            graphics->surface_format.format == VK_FORMAT_R8G8B8A8_SRGB,
+        "unsupported capture format")
+
+    graphics->capture = calloc(1, sizeof(cube_capture));
+    CUBE_ASSERT(graphics->capture != NULL, "failed to allocate capture")
+    capture = graphics->capture;
+    if (SDL_strcasecmp(capture_variable, "png") == 0)
+    {
+        capture->format = CUBE_CAPTURE_FORMAT_PNG;
+    }
+    else
+    {
+        CUBE_ASSERT(SDL_strcasecmp(capture_variable, "raw") == 0, "capture format is png or raw")
+        capture->format = CUBE_CAPTURE_FORMAT_RAW;
+    }
+    directory_variable = SDL_getenv(CUBE_CAPTURE_DIRECTORY_VARIABLE);
+    capture->directory = SDL_strdup((directory_variable != NULL) ? directory_variable : ".");
+    CUBE_ASSERT(capture->directory != NULL, "failed to allocate capture directory")
+    first_variable = SDL_getenv(CUBE_CAPTURE_FIRST_VARIABLE);
+    capture->first = (first_variable != NULL) ? SDL_strtoull(first_variable, NULL, 10) : 0;
+    count_variable = SDL_getenv(CUBE_CAPTURE_COUNT_VARIABLE);
+    capture->count = (count_variable != NULL) ? SDL_strtoull(count_variable, NULL, 10) : 0;
+    capture->width = graphics->display_size.width;
+    capture->height = graphics->display_size.height;
+    capture->swizzle =
+        graphics->surface_format.format == VK_FORMAT_B8G8R8A8_UNORM ||
+        graphics->surface_format.format == VK_FORMAT_B8G8R8A8_SRGB;
+    capture->row = malloc((size_t)capture->width * 4 + 1);
+    CUBE_ASSERT(capture->row != NULL, "failed to allocate capture row")
+
+    // the slots stay mapped, the render loop never touches their contents
+    buffer_create_info.size = (VkDeviceSize)capture->width * capture->height * 4;
+    for (slot_index = 0; slot_index < CUBE_CAPTURE_SLOTS; slot_index++)
+    {
+        VK_CHECK_RESULT(
+            vmaCreateBuffer(
+                graphics->allocator,
+                &buffer_create_info,
+                &allocation_create_info,
+                &capture->slots[slot_index].buffer,
+                &capture->slots[slot_index].allocation,
+                &allocation_info))
+        capture->slots[slot_index].mapping = allocation_info.pMappedData;
+        SDL_AtomicSet(&capture->slots[slot_index].busy, 0);
+    }
+
+    for (table_index = 0; table_index < 256; table_index++)
+    {
+        crc = table_index;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+        }
+        graphics_capture_crc_table[table_index] = crc;
+    }
+
+    if (capture->format == CUBE_CAPTURE_FORMAT_RAW)
+    {
+        SDL_snprintf(path, sizeof(path), "%s" PATH_SEPARATOR CUBE_CAPTURE_RAW_NAME, capture->directory);
+        capture->stream = fopen(path, "wb");
+        CUBE_ASSERT(capture->stream != NULL, strerror(errno))
+    }
+
+    SDL_AtomicSet(&capture->handed, 0);
+    SDL_AtomicSet(&capture->failed, 0);
+    capture->ready = SDL_CreateSemaphore(0);
+    CUBE_ASSERT(capture->ready != NULL, SDL_GetError())
+    capture->thread = SDL_CreateThread(graphics_capture_thread, "cube_capture", graphics);
+    CUBE_ASSERT(capture->thread != NULL, SDL_GetError())
+    CUBE_END_FUNCTION
+}
+
+// a barrier pair and a copy after the last pass, a frame with no free slot is dropped rather than waited for
+void graphics_render_capture_frame(cube_graphics *graphics, cube_frame *frame)
+{
+    cube_capture *capture;
+    cube_capture_slot *slot;
+    uint64_t capture_frame;
+    VkImageMemoryBarrier image_barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = frame->image,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    };
+    VkBufferMemoryBarrier buffer_barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+    VkBufferImageCopy region = {
+        .bufferOffset = 0,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+        .imageOffset = {0, 0, 0},
+    };
+
+    capture = graphics->capture;
+    if (capture == NULL)
+    {
+        return;
+    }
+    capture_frame = capture->frame++;
+    if (capture_frame < capture->first ||
+        (capture->count > 0 && capture->captured >= capture->count) ||
+        SDL_AtomicGet(&capture->failed) != 0)
+    {
+        return;
+    }
+    slot = capture->slots + capture->record_index;
+    // the writer still holds this slot, the frame is skipped
+    if (SDL_AtomicGet(&slot->busy) != 0)
+    {
+        return;
+    }
+    SDL_AtomicSet(&slot->busy, 1);
+    slot->frame = capture_frame;
+
+    vkCmdPipelineBarrier(
+        frame->command_buffer,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, NULL,
+        0, NULL,
+        1, &image_barrier);
+    region.imageExtent.width = capture->width;
+    region.imageExtent.height = capture->height;
+    region.imageExtent.depth = 1;
+    vkCmdCopyImageToBuffer(
+        frame->command_buffer,
+        frame->image,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        slot->buffer,
+        1,
+        &region);
+
+    // back to the layout present expects, the copy only read it
+    image_barrier.srcAccessMask = 0;
+    image_barrier.dstAccessMask = 0;
+    image_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    image_barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    buffer_barrier.buffer = slot->buffer;
+    vkCmdPipelineBarrier(
+        frame->command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        0, NULL,
+        1, &buffer_barrier,
+        1, &image_barrier);
+
+    capture->record_index = (capture->record_index + 1) % CUBE_CAPTURE_SLOTS;
+    capture->recorded++;
+    capture->captured++;
+}
+
+// called after acquire has waited on the timeline, so every copy recorded before this frame has landed
+void graphics_render_capture_collect(cube_graphics *graphics)
+{
+    cube_capture *capture;
+
+    capture = graphics->capture;
+    if (capture == NULL)
+    {
+        return;
+    }
+    while (capture->recorded > 0)
+    {
+        SDL_AtomicAdd(&capture->handed, 1);
+        SDL_SemPost(capture->ready);
+        capture->recorded--;
+    }
+}
+
+// after vkDeviceWaitIdle, the last recorded copies are handed over before the writer stops
+void graphics_destroy_capture(cube_graphics *graphics)
+{
+    cube_capture *capture;
+    uint32_t slot_index;
+
+    capture = graphics->capture;
+    if (capture == NULL)
+    {
+        return;
+    }
+    if (capture->thread != NULL)
+    {
+        graphics_render_capture_collect(graphics);
+        // one post past the last slot, the writer finds nothing handed and returns
+        SDL_SemPost(capture->ready);
+        SDL_WaitThread(capture->thread, NULL);
+    }
+    if (capture->ready != NULL)
+    {
+        SDL_DestroySemaphore(capture->ready);
+    }
+    if (capture->stream != NULL)
+    {
+        fclose(capture->stream);
+    }
+    for (slot_index = 0; slot_index < CUBE_CAPTURE_SLOTS; slot_index++)
+    {
+        if (capture->slots[slot_index].buffer != VK_NULL_HANDLE)
+        {
+            vmaDestroyBuffer(graphics->allocator, capture->slots[slot_index].buffer, capture->slots[slot_index].allocation);
+        }
+    }
+    free(capture->row);
+    SDL_free(capture->directory);
+    free(capture);
+    graphics->capture = NULL;
+}
+
+// slots arrive in the order they were recorded, a write error stops further capture
+int graphics_capture_thread(void *data)
+{
+    cube_graphics *graphics;
+    cube_capture *capture;
+    cube_capture_slot *slot;
+    uint32_t written;
+
+    graphics = data;
+    capture = graphics->capture;
+    CUBE_PROFILE_THREAD("capture")
+    written = 0;
+    for (;;)
+    {
+        SDL_SemWait(capture->ready);
+        if (written == (uint32_t)SDL_AtomicGet(&capture->handed))
+        {
+            return CUBE_SUCCESS;
+        }
+        slot = capture->slots + written % CUBE_CAPTURE_SLOTS;
+        if (SDL_AtomicGet(&capture->failed) == 0 &&
+            graphics_capture_write(graphics, slot) != CUBE_SUCCESS)
+        {
+            SDL_AtomicSet(&capture->failed, 1);
+        }
+        written++;
+        SDL_AtomicSet(&slot->busy, 0);
+    }
+}
+
+int graphics_capture_write(cube_graphics *graphics, const cube_capture_slot *slot)
+{
+    CUBE_BEGIN_FUNCTION
+    CUBE_PROFILE_BEGIN(write_zone)
+    VK_CHECK_RESULT(
+        vmaInvalidateAllocation(
+            graphics->allocator,
+            slot->allocation,
+            0,
+            VK_WHOLE_SIZE))
+    if (graphics->capture->format == CUBE_CAPTURE_FORMAT_PNG)
+    {
+        CUBE_ASSERT(
+            graphics_capture_write_png(graphics->capture, slot) == CUBE_SUCCESS,
+            "failed to write png")
+    }
+    else
+    {
+        CUBE_ASSERT(
+            graphics_capture_write_raw(graphics->capture, slot) == CUBE_SUCCESS,
+            "failed to write raw frame")
+    }
+    CUBE_PROFILE_END(write_zone, "graphics_capture_write")
+    CUBE_END_FUNCTION
+}
+
+// uncompressed deflate keeps the writer ahead of the render loop, any png reader accepts it
+int graphics_capture_write_png(cube_capture *capture, const cube_capture_slot *slot)
+{
+    CUBE_BEGIN_FUNCTION
+    const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    const uint8_t header[] = {8, 2, 0, 0, 0};
+    const uint8_t zlib_header[] = {0x78, 0x01};
+    const size_t row_length = (size_t)capture->width * 3 + 1;
+    char path[CUBE_CAPTURE_PATH_LENGTH];
+    cube_capture_png png;
+    uint64_t data_length;
+    uint64_t block_count;
+    uint32_t row_index;
+    int write_error;
+
+    // every scanline is filter type none followed by rgb, split into blocks of at most 65535 bytes
+    data_length = (uint64_t)row_length * capture->height;
+    block_count = (data_length + CUBE_CAPTURE_STORED_BLOCK - 1) / CUBE_CAPTURE_STORED_BLOCK;
+    CUBE_ASSERT(sizeof(zlib_header) + block_count * 5 + data_length + 4 <= 0x7FFFFFFFu, "frame too large for png")
+
+    SDL_snprintf(
+        path,
+        sizeof(path),
+        "%s" PATH_SEPARATOR "frame_%06llu.png",
+        capture->directory,
+        (unsigned long long)slot->frame);
+    png.file = fopen(path, "wb");
+    CUBE_ASSERT(png.file != NULL, strerror(errno))
+    fwrite(signature, 1, sizeof(signature), png.file);
+
+    graphics_capture_png_uint32(&png, 13);
+    png.crc = 0xFFFFFFFFu;
+    graphics_capture_png_bytes(&png, "IHDR", 4);
+    graphics_capture_png_uint32(&png, capture->width);
+    graphics_capture_png_uint32(&png, capture->height);
+    graphics_capture_png_bytes(&png, header, sizeof(header));
+    graphics_capture_png_uint32(&png, png.crc ^ 0xFFFFFFFFu);
+
+    graphics_capture_png_uint32(&png, (uint32_t)(sizeof(zlib_header) + block_count * 5 + data_length + 4));
+    png.crc = 0xFFFFFFFFu;
+    graphics_capture_png_bytes(&png, "IDAT", 4);
+    graphics_capture_png_bytes(&png, zlib_header, sizeof(zlib_header));
+    png.adler_low = 1;
+    png.adler_high = 0;
+    png.block_remaining = 0;
+    png.remaining = data_length;
+    for (row_index = 0; row_index < capture->height; row_index++)
+    {
+        graphics_capture_convert_row(
+            capture,
+            (const uint8_t *)slot->mapping + (size_t)row_index * capture->width * 4,
+            3);
+        graphics_capture_png_deflate(&png, capture->row, row_length);
+    }
+    graphics_capture_png_uint32(&png, (png.adler_high << 16) | png.adler_low);
+    graphics_capture_png_uint32(&png, png.crc ^ 0xFFFFFFFFu);
+
+    graphics_capture_png_uint32(&png, 0);
+    png.crc = 0xFFFFFFFFu;
+    graphics_capture_png_bytes(&png, "IEND", 4);
+    graphics_capture_png_uint32(&png, png.crc ^ 0xFFFFFFFFu);
+
+    // errors are sticky on the stream, checked once so the file is always closed
+    write_error = ferror(png.file);
+    CUBE_ASSERT(fclose(png.file) == 0 && write_error == 0, "failed to write png")
+    CUBE_END_FUNCTION
+}
+
+int graphics_capture_write_raw(cube_capture *capture, const cube_capture_slot *slot)
+{
+    CUBE_BEGIN_FUNCTION
+    const size_t row_length = (size_t)capture->width * 4;
+    uint32_t row_index;
+
+    for (row_index = 0; row_index < capture->height; row_index++)
+    {
+        graphics_capture_convert_row(
+            capture,
+            (const uint8_t *)slot->mapping + (size_t)row_index * row_length,
+            4);
+        // the filter byte png wants leads the row, raw frames skip it
+        CUBE_ASSERT(fwrite(capture->row + 1, 1, row_length, capture->stream) == row_length, strerror(errno))
+    }
+    CUBE_END_FUNCTION
+}
+
+// writes rgb or rgba after a leading zero, the png filter byte
+void graphics_capture_convert_row(cube_capture *capture, const uint8_t *source, uint32_t channels)
+{
+    uint8_t *destination;
+    uint32_t red;
+    uint32_t blue;
+    uint32_t pixel_index;
+
+    red = (capture->swizzle == SDL_TRUE) ? 2 : 0;
+    blue = 2 - red;
+    destination = capture->row;
+    *destination++ = 0;
+    for (pixel_index = 0; pixel_index < capture->width; pixel_index++)
+    {
+        *(destination + 0) = *(source + red);
+        *(destination + 1) = *(source + 1);
+        *(destination + 2) = *(source + blue);
+        if (channels == 4)
+        {
+            *(destination + 3) = *(source + 3);
+        }
+        destination += channels;
+        source += 4;
+    }
+}
+
+void graphics_capture_png_bytes(cube_capture_png *png, const void *bytes, size_t length)
+{
+    const uint8_t *byte;
+    size_t byte_index;
+
+    byte = bytes;
+    for (byte_index = 0; byte_index < length; byte_index++)
+    {
+        png->crc = graphics_capture_crc_table[(png->crc ^ *(byte + byte_index)) & 0xFF] ^ (png->crc >> 8);
+    }
+    fwrite(bytes, 1, length, png->file);
+}
+
+void graphics_capture_png_deflate(cube_capture_png *png, const uint8_t *bytes, size_t length)
+{
+    uint8_t block_header[5];
+    size_t run;
+    size_t byte_index;
+
+    while (length > 0)
+    {
+        if (png->block_remaining == 0)
+        {
+            png->block_remaining = (uint32_t)SDL_min(png->remaining, CUBE_CAPTURE_STORED_BLOCK);
+            block_header[0] = (png->remaining <= CUBE_CAPTURE_STORED_BLOCK) ? 1 : 0;
+            block_header[1] = (uint8_t)(png->block_remaining & 0xFF);
+            block_header[2] = (uint8_t)(png->block_remaining >> 8);
+            block_header[3] = (uint8_t)(~png->block_remaining & 0xFF);
+            block_header[4] = (uint8_t)((~png->block_remaining >> 8) & 0xFF);
+            graphics_capture_png_bytes(png, block_header, sizeof(block_header));
+        }
+        run = SDL_min(length, SDL_min(png->block_remaining, CUBE_CAPTURE_ADLER_RUN));
+        for (byte_index = 0; byte_index < run; byte_index++)
+        {
+            png->adler_low += *(bytes + byte_index);
+            png->adler_high += png->adler_low;
+        }
+        png->adler_low %= CUBE_CAPTURE_ADLER_MODULUS;
+        png->adler_high %= CUBE_CAPTURE_ADLER_MODULUS;
+        graphics_capture_png_bytes(png, bytes, run);
+        png->block_remaining -= (uint32_t)run;
+        png->remaining -= run;
+        bytes += run;
+        length -= run;
+    }
+}
+
+void graphics_capture_png_uint32(cube_capture_png *png, uint32_t value)
+{
+    const uint8_t bytes[] = {
+        (uint8_t)(value >> 24),
+        (uint8_t)(value >> 16),
+        (uint8_t)(value >> 8),
+        (uint8_t)value,
+    };
+    graphics_capture_png_bytes(png, bytes, sizeof(bytes));
+}
\ No newline at end of file
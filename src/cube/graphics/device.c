@@ -1,7 +1,32 @@
 #include "cube.h"
 
+#define CUBE_DEVICE_VARIABLE "CUBE_DEVICE"
+#define CUBE_DYNAMIC_RENDERING_VARIABLE "CUBE_DYNAMIC_RENDERING"
+#define CUBE_BINDLESS_VARIABLE "CUBE_BINDLESS"
+
 static int graphics_create_physical_device(cube_graphics *graphics);
-static int graphics_create_queue_families(cube_graphics *graphics);
+static int graphics_probe_physical_device(
+    cube_graphics *graphics,
+    VkPhysicalDevice physical_device,
+    cube_device_capabilities *capabilities);
+static int graphics_probe_queue_families(
+    cube_graphics *graphics,
+    VkPhysicalDevice physical_device,
+    cube_device_capabilities *capabilities);
+static int graphics_probe_extensions(VkPhysicalDevice physical_device, cube_device_capabilities *capabilities);
+static void graphics_probe_features2(
+    cube_graphics *graphics,
+    VkPhysicalDevice physical_device,
+    cube_device_capabilities *capabilities);
+#ifdef CUBE_PROFILE
+static int graphics_probe_calibration(
+    cube_graphics *graphics,
+    VkPhysicalDevice physical_device,
+    cube_device_capabilities *capabilities);
+#endif
+static uint64_t graphics_score_physical_device(const cube_device_capabilities *capabilities);
+static const char *graphics_device_type_name(VkPhysicalDeviceType type);
+static void graphics_print_capabilities(const cube_device_capabilities *capabilities);
 static int graphics_create_logical_device(cube_graphics *graphics);
 static int graphics_create_allocator(cube_graphics *graphics);
 static int graphics_create_command_pool(cube_graphics *graphics);
@@ -10,7 +35,6 @@ int graphics_create_device(cube_graphics *graphics)
 {
     CUBE_BEGIN_FUNCTION
     CUBE_ASSERT(graphics_create_physical_device(graphics) == CUBE_SUCCESS, "failed to create physical device")
-    CUBE_ASSERT(graphics_create_queue_families(graphics) == CUBE_SUCCESS, "failed to create queue families")
     CUBE_ASSERT(graphics_create_logical_device(graphics) == CUBE_SUCCESS, "failed to create logical device")
     CUBE_ASSERT(graphics_create_allocator(graphics) == CUBE_SUCCESS, "failed to create allocator")
     CUBE_ASSERT(graphics_create_command_pool(graphics) == CUBE_SUCCESS, "failed to create command pool")
@@ -27,29 +51,154 @@ void graphics_destroy_device(cube_graphics *graphics)
     vkDestroyDevice(graphics->logical_device, NULL);
 }
 
+// probes every device and keeps the best scored one, unless CUBE_DEVICE names another
 int graphics_create_physical_device(cube_graphics *graphics)
 {
     CUBE_BEGIN_FUNCTION
-    uint32_t count = 1;
-    vkEnumeratePhysicalDevices(
-        graphics->instance,
-        &count,
-        &graphics->physical_device);
-    CUBE_ASSERT(1 > 0, "failed to get device")
+    uint32_t physical_device_count;
+    uint32_t physical_device_index;
+    VkPhysicalDevice *physical_devices;
+    cube_device_capabilities *capabilities;
+    uint64_t *scores;
+    uint32_t selected_index;
+    const char *device_variable;
+    char *device_variable_end;
+    uint32_t override_index;
+
+    VK_CHECK_RESULT(
+        vkEnumeratePhysicalDevices(
+            graphics->instance,
+            &physical_device_count,
+            NULL))
+    CUBE_ASSERT(physical_device_count > 0, "failed to find a vulkan device")
+    physical_devices = CUBE_CALLOC(physical_device_count, sizeof(VkPhysicalDevice));
+    CUBE_ASSERT(physical_devices != NULL, "failed to allocate physical devices")
+    capabilities = CUBE_CALLOC(physical_device_count, sizeof(cube_device_capabilities));
+    CUBE_ASSERT(capabilities != NULL, "failed to allocate device capabilities")
+    scores = CUBE_CALLOC(physical_device_count, sizeof(uint64_t));
+    CUBE_ASSERT(scores != NULL, "failed to allocate device scores")
+    VK_CHECK_RESULT(
+        vkEnumeratePhysicalDevices(
+            graphics->instance,
+            &physical_device_count,
+            physical_devices))
+
+    selected_index = UINT32_MAX;
+    for (physical_device_index = 0; physical_device_index < physical_device_count; physical_device_index++)
+    {
+        CUBE_ASSERT(
+            graphics_probe_physical_device(
+                graphics,
+                *(physical_devices + physical_device_index),
+                capabilities + physical_device_index) == CUBE_SUCCESS,
+            "failed to probe physical device")
+        *(scores + physical_device_index) = graphics_score_physical_device(capabilities + physical_device_index);
+        if (*(scores + physical_device_index) > 0 &&
+            (selected_index == UINT32_MAX || *(scores + physical_device_index) > *(scores + selected_index)))
+        {
+            selected_index = physical_device_index;
+        }
+    }
+    CUBE_ASSERT(selected_index != UINT32_MAX, "failed to find a device that can render and present")
+
+    // an index or part of a name, for hybrid machines where the score picks the wrong device
+    device_variable = SDL_getenv(CUBE_DEVICE_VARIABLE);
+    if (device_variable != NULL && *device_variable != '\0')
+    {
+        override_index = (uint32_t)SDL_strtoul(device_variable, &device_variable_end, 10);
+        for (physical_device_index = 0; physical_device_index < physical_device_count; physical_device_index++)
+        {
+            if ((*device_variable_end == '\0')
+                    ? (physical_device_index != override_index)
+                    : (SDL_strstr((capabilities + physical_device_index)->name, device_variable) == NULL))
+            {
+                continue;
+            }
+
+            // a device that cannot render here keeps the scored choice
+            if (*(scores + physical_device_index) > 0)
+            {
+                selected_index = physical_device_index;
+            }
+            break;
+        }
+    }
+
+    graphics->physical_device = *(physical_devices + selected_index);
+    graphics->capabilities = *(capabilities + selected_index);
+    graphics->graphics_queue_family_index = graphics->capabilities.graphics_queue_family_index;
+    graphics->present_queue_family_index = graphics->capabilities.present_queue_family_index;
+    graphics_print_capabilities(&graphics->capabilities);
     CUBE_END_FUNCTION
 }
 
-int graphics_create_queue_families(cube_graphics *graphics)
+int graphics_probe_physical_device(
+    cube_graphics *graphics,
+    VkPhysicalDevice physical_device,
+    cube_device_capabilities *capabilities)
+{
+    CUBE_BEGIN_FUNCTION
+    VkPhysicalDeviceProperties properties;
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    VkPhysicalDeviceFeatures features;
+    uint32_t heap_index;
+
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    SDL_strlcpy(capabilities->name, properties.deviceName, sizeof(capabilities->name));
+    capabilities->type = properties.deviceType;
+    capabilities->vendor_id = properties.vendorID;
+    capabilities->device_id = properties.deviceID;
+    capabilities->api_version = properties.apiVersion;
+    capabilities->driver_version = properties.driverVersion;
+    capabilities->timestamp_period = properties.limits.timestampPeriod;
+    capabilities->max_sampler_anisotropy = properties.limits.maxSamplerAnisotropy;
+    capabilities->max_image_dimension_2d = properties.limits.maxImageDimension2D;
+
+    // integrated devices report their share of system memory here
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+    capabilities->device_local_memory = 0;
+    for (heap_index = 0; heap_index < memory_properties.memoryHeapCount; heap_index++)
+    {
+        if (memory_properties.memoryHeaps[heap_index].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            capabilities->device_local_memory += memory_properties.memoryHeaps[heap_index].size;
+        }
+    }
+
+    // indirect draws address instance data through firstInstance
+    vkGetPhysicalDeviceFeatures(physical_device, &features);
+    capabilities->sampler_anisotropy = features.samplerAnisotropy;
+    capabilities->texture_compression_bc = features.textureCompressionBC;
+    capabilities->multi_draw_indirect = features.multiDrawIndirect;
+    capabilities->draw_indirect_first_instance = features.drawIndirectFirstInstance;
+
+    CUBE_ASSERT(
+        graphics_probe_queue_families(graphics, physical_device, capabilities) == CUBE_SUCCESS,
+        "failed to probe queue families")
+    CUBE_ASSERT(graphics_probe_extensions(physical_device, capabilities) == CUBE_SUCCESS, "failed to probe extensions")
+    graphics_probe_features2(graphics, physical_device, capabilities);
+#ifdef CUBE_PROFILE
+    CUBE_ASSERT(
+        graphics_probe_calibration(graphics, physical_device, capabilities) == CUBE_SUCCESS,
+        "failed to probe calibration")
+#endif
+    CUBE_END_FUNCTION
+}
+
+int graphics_probe_queue_families(
+    cube_graphics *graphics,
+    VkPhysicalDevice physical_device,
+    cube_device_capabilities *capabilities)
 {
     CUBE_BEGIN_FUNCTION
     uint32_t queue_family_property_index;
     uint32_t queue_family_property_count;
     VkQueueFamilyProperties *queue_family_properties;
-    VkBool32 found_graphics_queue_family;
-    VkBool32 found_present_queue_family;
+    VkBool32 graphics_support;
+    VkBool32 present_support;
 
     vkGetPhysicalDeviceQueueFamilyProperties(
-        graphics->physical_device,
+        physical_device,
         &queue_family_property_count,
         NULL);
 
@@ -57,41 +206,373 @@ int graphics_create_queue_families(cube_graphics *graphics)
     CUBE_ASSERT(queue_family_properties != NULL, "failed to allocate queue family properties");
 
     vkGetPhysicalDeviceQueueFamilyProperties(
-        graphics->physical_device,
+        physical_device,
         &queue_family_property_count,
         queue_family_properties);
 
-    found_graphics_queue_family = VK_FALSE;
-    found_present_queue_family = VK_FALSE;
+    capabilities->queue_family_count = queue_family_property_count;
+    capabilities->graphics_queue_family = VK_FALSE;
+    capabilities->present_queue_family = VK_FALSE;
     for (queue_family_property_index = 0; queue_family_property_index < queue_family_property_count; queue_family_property_index++)
     {
-        if ((found_graphics_queue_family == VK_FALSE) && ((queue_family_properties + queue_family_property_index)->queueFlags & VK_QUEUE_GRAPHICS_BIT))
+        graphics_support = ((queue_family_properties + queue_family_property_index)->queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
+        VK_CHECK_RESULT(
+            vkGetPhysicalDeviceSurfaceSupportKHR(
+                physical_device,
+                queue_family_property_index,
+                graphics->surface,
+                &present_support))
+
+        // one family for both keeps the swapchain images exclusive
+        if (graphics_support == VK_TRUE && present_support == VK_TRUE)
+        {
+            capabilities->graphics_queue_family = VK_TRUE;
+            capabilities->graphics_queue_family_index = queue_family_property_index;
+            capabilities->present_queue_family = VK_TRUE;
+            capabilities->present_queue_family_index = queue_family_property_index;
+            break;
+        }
+        if (graphics_support == VK_TRUE && capabilities->graphics_queue_family == VK_FALSE)
         {
-            found_graphics_queue_family = VK_TRUE;
-            graphics->graphics_queue_family_index = queue_family_property_index;
+            capabilities->graphics_queue_family = VK_TRUE;
+            capabilities->graphics_queue_family_index = queue_family_property_index;
         }
-        if (found_present_queue_family == VK_FALSE)
+        if (present_support == VK_TRUE && capabilities->present_queue_family == VK_FALSE)
         {
-            VK_CHECK_RESULT(
-                vkGetPhysicalDeviceSurfaceSupportKHR(
-                    graphics->physical_device,
-                    queue_family_property_index,
-                    graphics->surface,
-                    &found_present_queue_family))
+            capabilities->present_queue_family = VK_TRUE;
+            capabilities->present_queue_family_index = queue_family_property_index;
+        }
+    }
+    if (capabilities->graphics_queue_family == VK_TRUE)
+    {
+        capabilities->timestamp_valid_bits =
+            (queue_family_properties + capabilities->graphics_queue_family_index)->timestampValidBits;
+    }
+    CUBE_END_FUNCTION
+}
+
+// one enumeration answers every optional extension
+int graphics_probe_extensions(VkPhysicalDevice physical_device, cube_device_capabilities *capabilities)
+{
+    CUBE_BEGIN_FUNCTION
+    uint32_t extension_count;
+    uint32_t extension_index;
+    VkExtensionProperties *extensions;
+    const char *extension_name;
+
+    VK_CHECK_RESULT(
+        vkEnumerateDeviceExtensionProperties(
+            physical_device,
+            NULL,
+            &extension_count,
+            NULL))
+    extensions = CUBE_CALLOC(extension_count, sizeof(VkExtensionProperties));
+    CUBE_ASSERT(extensions != NULL, "failed to allocate device extensions")
+    VK_CHECK_RESULT(
+        vkEnumerateDeviceExtensionProperties(
+            physical_device,
+            NULL,
+            &extension_count,
+            extensions))
+
+    for (extension_index = 0; extension_index < extension_count; extension_index++)
+    {
+        extension_name = (extensions + extension_index)->extensionName;
+        if (SDL_strcmp(extension_name, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0)
+        {
+            capabilities->swapchain_extension = VK_TRUE;
+        }
+        else if (SDL_strcmp(extension_name, VK_KHR_PRESENT_ID_EXTENSION_NAME) == 0)
+        {
+            capabilities->present_id_extension = VK_TRUE;
+        }
+        else if (SDL_strcmp(extension_name, VK_KHR_PRESENT_WAIT_EXTENSION_NAME) == 0)
+        {
+            capabilities->present_wait_extension = VK_TRUE;
+        }
+        else if (SDL_strcmp(extension_name, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0)
+        {
+            capabilities->calibrated_timestamps_extension = VK_TRUE;
         }
     }
-    CUBE_ASSERT(found_graphics_queue_family == VK_TRUE, "failed to find graphics queue family");
-    CUBE_ASSERT(found_present_queue_family == VK_TRUE, "failed to find present queue family");
     CUBE_END_FUNCTION
 }
 
+void graphics_probe_features2(
+    cube_graphics *graphics,
+    VkPhysicalDevice physical_device,
+    cube_device_capabilities *capabilities)
+{
+    VkPhysicalDeviceVulkan13Features vulkan13_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+    };
+    VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+    };
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptor_indexing_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+    };
+    VkPhysicalDeviceDescriptorIndexingProperties descriptor_indexing_properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES,
+    };
+    VkPhysicalDeviceProperties2 properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &descriptor_indexing_properties,
+    };
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+    };
+    VkPhysicalDevicePresentIdFeaturesKHR present_id_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+        .pNext = &present_wait_features,
+    };
+    VkPhysicalDeviceFeatures2 features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+    };
+
+    // the feature query needs 1.1 on both the instance and the device
+    capabilities->present_wait = VK_FALSE;
+    capabilities->dynamic_rendering = VK_FALSE;
+    capabilities->synchronization2 = VK_FALSE;
+    capabilities->timeline_semaphore = VK_FALSE;
+    capabilities->descriptor_indexing = VK_FALSE;
+    capabilities->max_bindless_buffers = 0;
+    capabilities->max_bindless_images = 0;
+    if (graphics->api_version < VK_API_VERSION_1_1 || capabilities->api_version < VK_API_VERSION_1_1)
+    {
+        return;
+    }
+    if (capabilities->present_id_extension == VK_TRUE && capabilities->present_wait_extension == VK_TRUE)
+    {
+        present_wait_features.pNext = features.pNext;
+        features.pNext = &present_id_features;
+    }
+    // core 1.2 and 1.3 features, usable only when the instance asked for that version too
+    if (graphics->api_version >= VK_API_VERSION_1_2 && capabilities->api_version >= VK_API_VERSION_1_2)
+    {
+        timeline_semaphore_features.pNext = features.pNext;
+        features.pNext = &timeline_semaphore_features;
+        descriptor_indexing_features.pNext = features.pNext;
+        features.pNext = &descriptor_indexing_features;
+    }
+    if (graphics->api_version >= VK_API_VERSION_1_3 && capabilities->api_version >= VK_API_VERSION_1_3)
+    {
+        vulkan13_features.pNext = features.pNext;
+        features.pNext = &vulkan13_features;
+    }
+
+    vkGetPhysicalDeviceFeatures2(physical_device, &features);
+    capabilities->present_wait = (present_id_features.presentId == VK_TRUE &&
+                                  present_wait_features.presentWait == VK_TRUE)
+                                     ? VK_TRUE
+                                     : VK_FALSE;
+    capabilities->dynamic_rendering = vulkan13_features.dynamicRendering;
+    capabilities->synchronization2 = vulkan13_features.synchronization2;
+    capabilities->timeline_semaphore = timeline_semaphore_features.timelineSemaphore;
+
+    // the bindless set needs runtime arrays that are partially bound and written after binding
+    capabilities->descriptor_indexing = (descriptor_indexing_features.runtimeDescriptorArray == VK_TRUE &&
+                                         descriptor_indexing_features.descriptorBindingPartiallyBound == VK_TRUE &&
+                                         descriptor_indexing_features.descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE &&
+                                         descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE &&
+                                         descriptor_indexing_features.shaderSampledImageArrayNonUniformIndexing == VK_TRUE)
+                                            ? VK_TRUE
+                                            : VK_FALSE;
+    if (capabilities->descriptor_indexing == VK_TRUE)
+    {
+        vkGetPhysicalDeviceProperties2(physical_device, &properties);
+        capabilities->max_bindless_buffers = SDL_min(
+            descriptor_indexing_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+            descriptor_indexing_properties.maxDescriptorSetUpdateAfterBindStorageBuffers);
+        capabilities->max_bindless_images = SDL_min(
+            descriptor_indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            descriptor_indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages);
+    }
+}
+
+#ifdef CUBE_PROFILE
+// the trace lines the gpu track up with the host clock the performance counter reads
+int graphics_probe_calibration(
+    cube_graphics *graphics,
+    VkPhysicalDevice physical_device,
+    cube_device_capabilities *capabilities)
+{
+    CUBE_BEGIN_FUNCTION
+    PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT get_time_domains;
+    uint32_t time_domain_count;
+    uint32_t time_domain_index;
+    VkTimeDomainEXT *time_domains;
+    VkBool32 device_domain;
+    VkBool32 host_domain;
+#ifdef _WIN32
+    const VkTimeDomainEXT host_time_domain = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+    const VkTimeDomainEXT host_time_domain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_EXT;
+#endif
+
+    capabilities->calibrated_timestamps = VK_FALSE;
+    get_time_domains = (PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)vkGetInstanceProcAddr(
+        graphics->instance,
+        "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT");
+    if (capabilities->calibrated_timestamps_extension == VK_FALSE || get_time_domains == NULL)
+    {
+        goto done;
+    }
+
+    VK_CHECK_RESULT(get_time_domains(physical_device, &time_domain_count, NULL))
+    time_domains = CUBE_CALLOC(time_domain_count, sizeof(VkTimeDomainEXT));
+    CUBE_ASSERT(time_domains != NULL, "failed to allocate time domains")
+    VK_CHECK_RESULT(get_time_domains(physical_device, &time_domain_count, time_domains))
+    device_domain = VK_FALSE;
+    host_domain = VK_FALSE;
+    for (time_domain_index = 0; time_domain_index < time_domain_count; time_domain_index++)
+    {
+        device_domain |= (*(time_domains + time_domain_index) == VK_TIME_DOMAIN_DEVICE_EXT);
+        host_domain |= (*(time_domains + time_domain_index) == host_time_domain);
+    }
+    capabilities->calibrated_timestamps = (device_domain && host_domain) ? VK_TRUE : VK_FALSE;
+    CUBE_END_FUNCTION
+}
+#endif
+
+// zero means unusable; the device type dominates, then optional features, then memory
+uint64_t graphics_score_physical_device(const cube_device_capabilities *capabilities)
+{
+    uint64_t type_score;
+    uint64_t feature_score;
+    uint64_t memory_score;
+
+    if (capabilities->graphics_queue_family == VK_FALSE ||
+        capabilities->present_queue_family == VK_FALSE ||
+        capabilities->swapchain_extension == VK_FALSE)
+    {
+        return 0;
+    }
+
+    switch (capabilities->type)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        type_score = 4;
+        break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        type_score = 3;
+        break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        type_score = 2;
+        break;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+        type_score = 1;
+        break;
+    default:
+        type_score = 0;
+        break;
+    }
+    feature_score = (capabilities->graphics_queue_family_index == capabilities->present_queue_family_index) +
+                    (capabilities->multi_draw_indirect == VK_TRUE) +
+                    (capabilities->draw_indirect_first_instance == VK_TRUE) +
+                    (capabilities->sampler_anisotropy == VK_TRUE) +
+                    (capabilities->present_wait == VK_TRUE) +
+                    (capabilities->dynamic_rendering == VK_TRUE && capabilities->synchronization2 == VK_TRUE) +
+                    (capabilities->timeline_semaphore == VK_TRUE) +
+                    (capabilities->descriptor_indexing == VK_TRUE) +
+                    (capabilities->api_version >= VK_API_VERSION_1_1);
+    memory_score = SDL_min(capabilities->device_local_memory >> 20, ((uint64_t)1 << 48) - 1);
+    return ((type_score << 56) | (feature_score << 48) | memory_score) + 1;
+}
+
+const char *graphics_device_type_name(VkPhysicalDeviceType type)
+{
+    switch (type)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        return "discrete";
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        return "integrated";
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        return "virtual";
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+        return "cpu";
+    default:
+        return "other";
+    }
+}
+
+void graphics_print_capabilities(const cube_device_capabilities *capabilities)
+{
+    printf(
+        "using %s (%s), vulkan %u.%u.%u, %llu MiB device local\n",
+        capabilities->name,
+        graphics_device_type_name(capabilities->type),
+        VK_API_VERSION_MAJOR(capabilities->api_version),
+        VK_API_VERSION_MINOR(capabilities->api_version),
+        VK_API_VERSION_PATCH(capabilities->api_version),
+        (unsigned long long)(capabilities->device_local_memory >> 20));
+    printf(
+        "  queue families %u, graphics %u, present %u, timestamp bits %u\n",
+        capabilities->queue_family_count,
+        capabilities->graphics_queue_family_index,
+        capabilities->present_queue_family_index,
+        capabilities->timestamp_valid_bits);
+    printf(
+        "  multi draw indirect %s, first instance %s, anisotropy %s (%.0fx), bc textures %s, present wait %s, calibrated timestamps %s\n",
+        capabilities->multi_draw_indirect ? "yes" : "no",
+        capabilities->draw_indirect_first_instance ? "yes" : "no",
+        capabilities->sampler_anisotropy ? "yes" : "no",
+        capabilities->max_sampler_anisotropy,
+        capabilities->texture_compression_bc ? "yes" : "no",
+        capabilities->present_wait ? "yes" : "no",
+        capabilities->calibrated_timestamps ? "yes" : "no");
+    printf(
+        "  dynamic rendering %s, synchronization2 %s, timeline semaphores %s, descriptor indexing %s (%u buffers, %u images)\n",
+        capabilities->dynamic_rendering ? "yes" : "no",
+        capabilities->synchronization2 ? "yes" : "no",
+        capabilities->timeline_semaphore ? "yes" : "no",
+        capabilities->descriptor_indexing ? "yes" : "no",
+        capabilities->max_bindless_buffers,
+        capabilities->max_bindless_images);
+}
+
 int graphics_create_logical_device(cube_graphics *graphics)
 {
     CUBE_BEGIN_FUNCTION
-    const char *const device_extensions[] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    const char *device_extensions[4];
+    uint32_t device_extension_count;
+    const char *dynamic_rendering_variable;
+    const char *bindless_variable;
+    VkPhysicalDeviceVulkan13Features vulkan13_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+        .dynamicRendering = VK_TRUE,
+        .synchronization2 = VK_TRUE,
+    };
+    VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+        .timelineSemaphore = VK_TRUE,
+    };
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptor_indexing_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+        .runtimeDescriptorArray = VK_TRUE,
+        .descriptorBindingPartiallyBound = VK_TRUE,
+        .descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE,
+        .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+        .shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
+    };
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+        .presentWait = VK_TRUE,
+    };
+    VkPhysicalDevicePresentIdFeaturesKHR present_id_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+        .pNext = &present_wait_features,
+        .presentId = VK_TRUE,
+    };
     const float queue_priorities[] = {1.0};
     const uint32_t unique_queue_count = (graphics->graphics_queue_family_index != graphics->present_queue_family_index) ? 2 : 1;
-    const VkPhysicalDeviceFeatures device_features = {.samplerAnisotropy = VK_TRUE};
+    VkPhysicalDeviceFeatures device_features = {
+        .samplerAnisotropy = graphics->capabilities.sampler_anisotropy,
+        .textureCompressionBC = graphics->capabilities.texture_compression_bc,
+        .multiDrawIndirect = graphics->capabilities.multi_draw_indirect,
+        .drawIndirectFirstInstance = graphics->capabilities.draw_indirect_first_instance,
+    };
     VkDeviceQueueCreateInfo queue_create_infos[] = {
         {
             .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
@@ -106,14 +587,58 @@ int graphics_create_logical_device(cube_graphics *graphics)
             .queueCount = 1,
         },
     };
-    const VkDeviceCreateInfo device_create_info = {
+    VkDeviceCreateInfo device_create_info = {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
         .queueCreateInfoCount = unique_queue_count,
         .pQueueCreateInfos = &queue_create_infos[0],
-        .enabledExtensionCount = sizeof(device_extensions) / sizeof(device_extensions[0]),
         .ppEnabledExtensionNames = &device_extensions[0],
         .pEnabledFeatures = &device_features,
     };
+
+    device_extensions[0] = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+    device_extension_count = 1;
+    if (graphics->capabilities.present_wait == VK_TRUE)
+    {
+        device_extensions[device_extension_count++] = VK_KHR_PRESENT_ID_EXTENSION_NAME;
+        device_extensions[device_extension_count++] = VK_KHR_PRESENT_WAIT_EXTENSION_NAME;
+        device_create_info.pNext = &present_id_features;
+    }
+    if (graphics->capabilities.calibrated_timestamps == VK_TRUE)
+    {
+        device_extensions[device_extension_count++] = VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME;
+    }
+    device_create_info.enabledExtensionCount = device_extension_count;
+
+    // the render pass path stays for older drivers, and for comparison with CUBE_DYNAMIC_RENDERING=0
+    dynamic_rendering_variable = SDL_getenv(CUBE_DYNAMIC_RENDERING_VARIABLE);
+    graphics->dynamic_rendering = (graphics->capabilities.dynamic_rendering == VK_TRUE &&
+                                   graphics->capabilities.synchronization2 == VK_TRUE &&
+                                   (dynamic_rendering_variable == NULL || SDL_atoi(dynamic_rendering_variable) != 0))
+                                      ? VK_TRUE
+                                      : VK_FALSE;
+    if (graphics->dynamic_rendering == VK_TRUE)
+    {
+        vulkan13_features.pNext = (void *)device_create_info.pNext;
+        device_create_info.pNext = &vulkan13_features;
+    }
+    if (graphics->capabilities.timeline_semaphore == VK_TRUE)
+    {
+        timeline_semaphore_features.pNext = (void *)device_create_info.pNext;
+        device_create_info.pNext = &timeline_semaphore_features;
+    }
+
+    // the per-frame sets stay for comparison with CUBE_BINDLESS=0
+    bindless_variable = SDL_getenv(CUBE_BINDLESS_VARIABLE);
+    graphics->descriptor_indexing = (graphics->capabilities.descriptor_indexing == VK_TRUE &&
+                                     (bindless_variable == NULL || SDL_atoi(bindless_variable) != 0))
+                                        ? VK_TRUE
+                                        : VK_FALSE;
+    if (graphics->descriptor_indexing == VK_TRUE)
+    {
+        descriptor_indexing_features.pNext = (void *)device_create_info.pNext;
+        device_create_info.pNext = &descriptor_indexing_features;
+    }
+
     VK_CHECK_RESULT(
         vkCreateDevice(
             graphics->physical_device,
@@ -140,7 +665,7 @@ int graphics_create_allocator(cube_graphics *graphics)
         .instance = graphics->instance,
         .physicalDevice = graphics->physical_device,
         .device = graphics->logical_device,
-        .vulkanApiVersion = VK_MAKE_API_VERSION(0, 1, 0, 3),
+        .vulkanApiVersion = SDL_min(graphics->api_version, graphics->capabilities.api_version),
     };
     VK_CHECK_RESULT(
         vmaCreateAllocator(
@@ -1,5 +1,9 @@
 #include "cube.h"
 
+#define CUBE_HEADLESS_VARIABLE "CUBE_HEADLESS"
+#define CUBE_HEADLESS_WIDTH 1280
+#define CUBE_HEADLESS_HEIGHT 720
+
 static int graphics_create_window(cube_graphics *graphics);
 static int graphics_create_instance(cube_graphics *graphics);
 static int graphics_create_surface(cube_graphics *graphics);
@@ -17,13 +21,33 @@ void graphics_destroy_display(cube_graphics *graphics)
 {
     vkDestroySurfaceKHR(graphics->instance, graphics->surface, NULL);
     vkDestroyInstance(graphics->instance, NULL);
-    SDL_DestroyWindow(graphics->window);
+    if (graphics->window != NULL)
+    {
+        SDL_DestroyWindow(graphics->window);
+    }
 }
 
 int graphics_create_window(cube_graphics *graphics)
 {
     CUBE_BEGIN_FUNCTION
     SDL_DisplayMode display_mode;
+    const char *headless_variable;
+    char *separator;
+
+    // CUBE_HEADLESS=WIDTHxHEIGHT renders to a headless surface with no window, for tests and capture
+    headless_variable = SDL_getenv(CUBE_HEADLESS_VARIABLE);
+    if (headless_variable != NULL)
+    {
+        graphics->window = NULL;
+        graphics->display_size.width = (uint32_t)SDL_strtoul(headless_variable, &separator, 10);
+        graphics->display_size.height = (*separator == 'x') ? (uint32_t)SDL_strtoul(separator + 1, NULL, 10) : 0;
+        if (graphics->display_size.width == 0 || graphics->display_size.height == 0)
+        {
+            graphics->display_size.width = CUBE_HEADLESS_WIDTH;
+            graphics->display_size.height = CUBE_HEADLESS_HEIGHT;
+        }
+        goto done;
+    }
 
     CUBE_ASSERT(
         SDL_GetCurrentDisplayMode(
@@ -51,7 +75,13 @@ int graphics_create_instance(cube_graphics *graphics)
     const char *instance_layers[] = {
         "VK_LAYER_KHRONOS_validation",
     };
-    const VkApplicationInfo application_info = {
+    const char *headless_extensions[] = {
+        VK_KHR_SURFACE_EXTENSION_NAME,
+        VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME,
+    };
+    PFN_vkEnumerateInstanceVersion enumerate_instance_version;
+    uint32_t instance_version;
+    VkApplicationInfo application_info = {
         .apiVersion = VK_MAKE_API_VERSION(0, 1, 0, 3),
     };
     VkInstanceCreateInfo instance_create_info = {
@@ -63,6 +93,34 @@ int graphics_create_instance(cube_graphics *graphics)
 #endif
     };
 
+    // 1.1 brings vkGetPhysicalDeviceFeatures2 for the optional feature probes,
+    // 1.2 timeline semaphores and 1.3 dynamic rendering
+    graphics->api_version = application_info.apiVersion;
+    enumerate_instance_version = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(
+        VK_NULL_HANDLE,
+        "vkEnumerateInstanceVersion");
+    if (enumerate_instance_version != NULL &&
+        enumerate_instance_version(&instance_version) == VK_SUCCESS &&
+        instance_version >= VK_API_VERSION_1_1)
+    {
+        graphics->api_version = (instance_version >= VK_API_VERSION_1_3)   ? VK_API_VERSION_1_3
+                                : (instance_version >= VK_API_VERSION_1_2) ? VK_API_VERSION_1_2
+                                                                           : VK_API_VERSION_1_1;
+    }
+    application_info.apiVersion = graphics->api_version;
+
+    if (graphics->window == NULL)
+    {
+        instance_create_info.enabledExtensionCount = sizeof(headless_extensions) / sizeof(headless_extensions[0]);
+        instance_create_info.ppEnabledExtensionNames = &headless_extensions[0];
+        VK_CHECK_RESULT(
+            vkCreateInstance(
+                &instance_create_info,
+                NULL,
+                &graphics->instance))
+        goto done;
+    }
+
     CUBE_ASSERT(
         SDL_Vulkan_GetInstanceExtensions(
             graphics->window,
@@ -96,6 +154,25 @@ int graphics_create_instance(cube_graphics *graphics)
 int graphics_create_surface(cube_graphics *graphics)
 {
     CUBE_BEGIN_FUNCTION
+    const VkHeadlessSurfaceCreateInfoEXT headless_surface_create_info = {
+        .sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT,
+    };
+    PFN_vkCreateHeadlessSurfaceEXT create_headless_surface;
+
+    if (graphics->window == NULL)
+    {
+        create_headless_surface = (PFN_vkCreateHeadlessSurfaceEXT)vkGetInstanceProcAddr(
+            graphics->instance,
+            "vkCreateHeadlessSurfaceEXT");
+        CUBE_ASSERT(create_headless_surface != NULL, "headless surfaces are not supported")
+        VK_CHECK_RESULT(
+            create_headless_surface(
+                graphics->instance,
+                &headless_surface_create_info,
+                NULL,
+                &graphics->surface))
+        goto done;
+    }
     CUBE_ASSERT(
         SDL_Vulkan_CreateSurface(
             graphics->window,
@@ -0,0 +1,222 @@
+#include "cube.h"
+
+#define CUBE_DRAW_KEY_PIPELINE_SHIFT 56
+#define CUBE_DRAW_KEY_DESCRIPTOR_SHIFT 44
+#define CUBE_DRAW_KEY_MESH_SHIFT 32
+#define CUBE_DRAW_RADIX_BITS 8
+#define CUBE_DRAW_RADIX_SIZE (1 << CUBE_DRAW_RADIX_BITS)
+
+// sized for every instance, a frame never adds more draws than that
+int graphics_create_draw_list(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_draw_list *list;
+
+    graphics->draw_list = calloc(1, sizeof(cube_draw_list));
+    CUBE_ASSERT(graphics->draw_list != NULL, "failed to allocate draw list")
+    list = graphics->draw_list;
+    list->capacity = graphics->instance_count;
+    list->items = calloc(list->capacity, sizeof(VkDrawIndexedIndirectCommand));
+    list->keys = calloc(list->capacity, sizeof(uint64_t));
+    list->values = calloc(list->capacity, sizeof(uint32_t));
+    list->scratch_keys = calloc(list->capacity, sizeof(uint64_t));
+    list->scratch_values = calloc(list->capacity, sizeof(uint32_t));
+    list->commands = calloc(list->capacity, sizeof(VkDrawIndexedIndirectCommand));
+    list->batches = calloc(list->capacity, sizeof(cube_draw_batch));
+    list->mask = calloc((list->capacity + 63) / 64, sizeof(uint64_t));
+    CUBE_ASSERT(
+        list->items != NULL && list->keys != NULL && list->values != NULL &&
+            list->scratch_keys != NULL && list->scratch_values != NULL &&
+            list->commands != NULL && list->batches != NULL && list->mask != NULL,
+        "failed to allocate draw list arrays")
+    CUBE_END_FUNCTION
+}
+
+// pipeline in the top byte, then descriptor and mesh, so each state's draws go front to back
+uint64_t graphics_draw_list_key(uint32_t pipeline, uint32_t descriptor, uint32_t mesh, float depth)
+{
+    uint32_t depth_bits;
+
+    // non-negative floats order the same as their bits
+    depth = SDL_max(depth, 0.0f);
+    SDL_memcpy(&depth_bits, &depth, sizeof(depth_bits));
+    return ((uint64_t)(pipeline & 0xff) << CUBE_DRAW_KEY_PIPELINE_SHIFT) |
+           ((uint64_t)(descriptor & 0xfff) << CUBE_DRAW_KEY_DESCRIPTOR_SHIFT) |
+           ((uint64_t)(mesh & 0xfff) << CUBE_DRAW_KEY_MESH_SHIFT) |
+           depth_bits;
+}
+
+void graphics_draw_list_reset(cube_draw_list *list)
+{
+    list->item_count = 0;
+    list->command_count = 0;
+    list->batch_count = 0;
+}
+
+// culling hands instances over in bvh leaf order, marking them rewrites the list in ascending order
+void graphics_draw_list_order(cube_draw_list *list, uint32_t *instances, uint32_t count)
+{
+    uint32_t word_count;
+    uint32_t word_index;
+    uint32_t bit;
+    uint32_t index;
+    uint64_t word;
+
+    word_count = (list->capacity + 63) / 64;
+    SDL_memset(list->mask, 0, word_count * sizeof(uint64_t));
+    for (index = 0; index < count; index++)
+    {
+        *(list->mask + *(instances + index) / 64) |= 1ull << (*(instances + index) % 64);
+    }
+    index = 0;
+    for (word_index = 0; word_index < word_count; word_index++)
+    {
+        word = *(list->mask + word_index);
+        for (bit = 0; word != 0; bit++, word >>= 1)
+        {
+            if ((word & 1) != 0)
+            {
+                *(instances + index++) = word_index * 64 + bit;
+            }
+        }
+    }
+}
+
+// a draw continuing the previous instance run with the same state extends it, keyed on the nearer depth
+void graphics_draw_list_add(cube_draw_list *list, uint64_t key, const VkDrawIndexedIndirectCommand *command)
+{
+    VkDrawIndexedIndirectCommand *item;
+
+    if (list->item_count > 0)
+    {
+        item = list->items + list->item_count - 1;
+        if ((*(list->keys + list->item_count - 1) & CUBE_DRAW_KEY_STATE_MASK) == (key & CUBE_DRAW_KEY_STATE_MASK) &&
+            item->indexCount == command->indexCount &&
+            item->firstIndex == command->firstIndex &&
+            item->vertexOffset == command->vertexOffset &&
+            item->firstInstance + item->instanceCount == command->firstInstance)
+        {
+            item->instanceCount += command->instanceCount;
+            *(list->keys + list->item_count - 1) = SDL_min(*(list->keys + list->item_count - 1), key);
+            return;
+        }
+    }
+    *(list->items + list->item_count) = *command;
+    *(list->keys + list->item_count) = key;
+    *(list->values + list->item_count) = list->item_count;
+    list->item_count++;
+}
+
+// least significant byte first, a byte every key shares costs one counting pass and no scatter
+void graphics_draw_list_sort(cube_draw_list *list)
+{
+    uint32_t counts[CUBE_DRAW_RADIX_SIZE];
+    uint64_t *swap_keys;
+    uint32_t *swap_values;
+    uint32_t shift;
+    uint32_t index;
+    uint32_t bucket;
+    uint32_t offset;
+    uint32_t count;
+
+    if (list->item_count < 2)
+    {
+        return;
+    }
+    for (shift = 0; shift < 64; shift += CUBE_DRAW_RADIX_BITS)
+    {
+        SDL_memset(&counts[0], 0, sizeof(counts));
+        for (index = 0; index < list->item_count; index++)
+        {
+            counts[(*(list->keys + index) >> shift) & (CUBE_DRAW_RADIX_SIZE - 1)]++;
+        }
+        if (counts[(*list->keys >> shift) & (CUBE_DRAW_RADIX_SIZE - 1)] == list->item_count)
+        {
+            continue;
+        }
+        offset = 0;
+        for (bucket = 0; bucket < CUBE_DRAW_RADIX_SIZE; bucket++)
+        {
+            count = counts[bucket];
+            counts[bucket] = offset;
+            offset += count;
+        }
+        for (index = 0; index < list->item_count; index++)
+        {
+            bucket = (*(list->keys + index) >> shift) & (CUBE_DRAW_RADIX_SIZE - 1);
+            *(list->scratch_keys + counts[bucket]) = *(list->keys + index);
+            *(list->scratch_values + counts[bucket]) = *(list->values + index);
+            counts[bucket]++;
+        }
+        swap_keys = list->keys;
+        list->keys = list->scratch_keys;
+        list->scratch_keys = swap_keys;
+        swap_values = list->values;
+        list->values = list->scratch_values;
+        list->scratch_values = swap_values;
+    }
+}
+
+// merged on the host copy, the mapping is write combined and only written once, the caller flushes it
+void graphics_draw_list_build(cube_draw_list *list, void *mapping)
+{
+    const VkDrawIndexedIndirectCommand *item;
+    VkDrawIndexedIndirectCommand *command;
+    cube_draw_batch *batch;
+    uint64_t state;
+    uint32_t index;
+
+    list->command_count = 0;
+    list->batch_count = 0;
+    batch = NULL;
+    for (index = 0; index < list->item_count; index++)
+    {
+        item = list->items + *(list->values + index);
+        state = *(list->keys + index) & CUBE_DRAW_KEY_STATE_MASK;
+        if (batch == NULL || batch->state != state)
+        {
+            batch = list->batches + list->batch_count++;
+            batch->state = state;
+            batch->first_command = list->command_count;
+            batch->command_count = 0;
+        }
+
+        // neighbours in the sort that continue an instance run become one command
+        if (batch->command_count > 0)
+        {
+            command = list->commands + list->command_count - 1;
+            if (command->indexCount == item->indexCount &&
+                command->firstIndex == item->firstIndex &&
+                command->vertexOffset == item->vertexOffset &&
+                command->firstInstance + command->instanceCount == item->firstInstance)
+            {
+                command->instanceCount += item->instanceCount;
+                continue;
+            }
+        }
+        *(list->commands + list->command_count++) = *item;
+        batch->command_count++;
+    }
+    SDL_memcpy(mapping, list->commands, list->command_count * sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void graphics_destroy_draw_list(cube_graphics *graphics)
+{
+    cube_draw_list *list;
+
+    list = graphics->draw_list;
+    if (list == NULL)
+    {
+        return;
+    }
+    free(list->items);
+    free(list->keys);
+    free(list->values);
+    free(list->scratch_keys);
+    free(list->scratch_values);
+    free(list->commands);
+    free(list->batches);
+    free(list->mask);
+    free(list);
+    graphics->draw_list = NULL;
+}
\ No newline at end of file
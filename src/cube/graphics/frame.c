@@ -1,14 +1,52 @@
 #include "cube.h"
 
+// a multiple of eight keeps every range on the vector kernels' aligned rows
+#define CUBE_UPDATE_GRAIN 1024
+
 static int graphics_create_descriptor_pool(cube_graphics *graphics);
 static int graphics_create_frame(cube_graphics *graphics, VkImage *image, uint32_t index, cube_frame *frame);
 static int graphics_create_initialize_object(cube_graphics *graphics, cube_frame *frame);
 static int graphics_create_descriptor_sets(cube_graphics *graphics);
 static int graphics_create_sync_objects(cube_graphics *graphics);
-static int graphics_render_update_object(cube_graphics *graphics, cube_frame *frame);
-static int graphics_render_prepare_frame(cube_graphics *graphics, cube_frame *frame);
+static int graphics_render_update_object(cube_graphics *graphics, cube_frame *frame, const cube_scene *scene);
+static void graphics_render_update_job(void *data, uint32_t begin, uint32_t end);
+static void graphics_render_view_projection(cube_frame *frame, cube_mat4 *view_projection);
+static void graphics_render_cull_objects(cube_graphics *graphics, const cube_mat4 *view_projection);
+static void graphics_render_build_draws(cube_graphics *graphics, cube_frame *frame, const cube_mat4 *view_projection);
+static void graphics_render_record_batches(cube_graphics *graphics, cube_frame *frame);
+static int graphics_render_prepare_frame(cube_frame *frame);
+static void graphics_render_begin_frame_pass(cube_graphics *graphics, cube_frame *frame, VkBool32 secondary);
+static void graphics_render_end_frame_pass(cube_graphics *graphics, cube_frame *frame);
 static void graphics_destroy_frame(cube_graphics *graphics, cube_frame *frame);
 
+// the acquired image's old contents are discarded, the semaphore wait covers color output
+static const VkImageMemoryBarrier2 graphics_acquire_color_barrier = {
+    .srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+    .srcAccessMask = VK_ACCESS_2_NONE,
+    .dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+    .dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+    .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    .newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+};
+// depth is cleared every frame, only last frame's depth tests must finish first
+static const VkImageMemoryBarrier2 graphics_acquire_depth_barrier = {
+    .srcStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+    .srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+    .dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+    .dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+    .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    .newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+};
+// the capture copy, when there is one, waits on color output after this
+static const VkImageMemoryBarrier2 graphics_present_color_barrier = {
+    .srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+    .srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+    .dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+    .dstAccessMask = VK_ACCESS_2_NONE,
+    .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+    .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+};
+
 int graphics_create_frame_pool(cube_graphics *graphics)
 {
     CUBE_BEGIN_FUNCTION
@@ -70,28 +108,25 @@ int graphics_create_sync_objects(cube_graphics *graphics)
     const VkSemaphoreCreateInfo semaphore_create_info = {
         .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
     };
-    const VkFenceCreateInfo fence_create_info = {
-        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-        .flags = VK_FENCE_CREATE_SIGNALED_BIT,
-    };
-    VK_CHECK_RESULT(
-        vkCreateSemaphore(
-            graphics->logical_device,
-            &semaphore_create_info,
-            NULL,
-            &graphics->frame_rendered))
+    uint32_t frame_index;
+
+    for (frame_index = 0; frame_index < graphics->frame_count; frame_index++)
+    {
+        VK_CHECK_RESULT(
+            vkCreateSemaphore(
+                graphics->logical_device,
+                &semaphore_create_info,
+                NULL,
+                &(graphics->frames + frame_index)->rendered))
+    }
+
+    // acquire waits for the previous frame's timeline value, so the submit waiting on this one is done
     VK_CHECK_RESULT(
         vkCreateSemaphore(
             graphics->logical_device,
             &semaphore_create_info,
             NULL,
             &graphics->frame_presented))
-    VK_CHECK_RESULT(
-        vkCreateFence(
-            graphics->logical_device,
-            &fence_create_info,
-            NULL,
-            &graphics->command_fence))
     CUBE_END_FUNCTION
 }
 
@@ -100,19 +135,12 @@ int graphics_render_acquire_frame(cube_graphics *graphics, cube_frame **frame)
     CUBE_BEGIN_FUNCTION
     uint32_t frame_index;
 
-    VK_CHECK_RESULT(
-        vkWaitForFences(
-            graphics->logical_device,
-            1,
-            &graphics->command_fence,
-            VK_TRUE,
-            UINT64_MAX))
-
-    VK_CHECK_RESULT(
-        vkResetFences(
-            graphics->logical_device,
-            1,
-            &graphics->command_fence))
+    // the previous frame retires here, its command buffer and attachments are free again
+    CUBE_ASSERT(
+        graphics_sync_wait(
+            graphics,
+            graphics->sync->frame) == CUBE_SUCCESS,
+        "failed to wait for previous frame")
 
     VK_CHECK_RESULT(
         vkAcquireNextImageKHR(
@@ -128,49 +156,406 @@ int graphics_render_acquire_frame(cube_graphics *graphics, cube_frame **frame)
     CUBE_END_FUNCTION
 }
 
-int graphics_render_draw_frame(cube_graphics *graphics, cube_frame *frame)
+int graphics_render_draw_frame(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    const cube_scene *scene)
 {
     CUBE_BEGIN_FUNCTION
+    cube_mat4 view_projection;
+
+    CUBE_PROFILE_BEGIN(update_zone)
+    if (graphics->animation == NULL && graphics->voxels == NULL)
+    {
+        CUBE_ASSERT(
+            graphics_render_update_object(graphics, frame, scene) == CUBE_SUCCESS,
+            "failed to update object")
+    }
+    CUBE_PROFILE_END(update_zone, "graphics_render_update_object")
+    graphics_render_view_projection(frame, &view_projection);
+    CUBE_PROFILE_BEGIN(cull_zone)
+    if (graphics->voxels == NULL)
+    {
+        graphics_render_cull_objects(graphics, &view_projection);
+    }
+    CUBE_PROFILE_END(cull_zone, "graphics_render_cull_objects")
+    CUBE_PROFILE_COUNTER("visible instances", graphics->visible_count)
     CUBE_ASSERT(
-        graphics_render_update_object(graphics, frame) == CUBE_SUCCESS,
-        "failed to update object")
-    CUBE_ASSERT(
-        graphics_render_prepare_frame(
-            graphics,
-            frame) == CUBE_SUCCESS,
+        graphics_render_prepare_frame(frame) == CUBE_SUCCESS,
         "failed to prepare frame")
-    VkDeviceSize vertex_buffer_offsets[] = {0};
-    vkCmdBindVertexBuffers(
+    graphics_render_timestamp_begin(graphics, frame);
+    CUBE_PROFILE_BEGIN(record_zone)
+    if (graphics->animation != NULL && graphics->voxels == NULL)
+    {
+        graphics_render_animate_frame(graphics, frame, scene);
+    }
+    if (graphics->voxels != NULL)
+    {
+        // the chunks are culled and drawn in place of the instances
+        graphics_render_begin_frame_pass(graphics, frame, VK_FALSE);
+        graphics_render_record_state(graphics, frame, frame->command_buffer);
+        graphics_render_voxel_draws(graphics, frame->command_buffer, &view_projection);
+        graphics_render_end_frame_pass(graphics, frame);
+    }
+    else if (graphics->occlusion != NULL)
+    {
+        graphics_render_occlusion_frame(graphics, frame, &view_projection);
+    }
+    else if (graphics->recorder != NULL)
+    {
+        graphics_render_begin_frame_pass(graphics, frame, VK_TRUE);
+        CUBE_ASSERT(
+            graphics_render_record_frame(
+                graphics,
+                frame) == CUBE_SUCCESS,
+            "failed to record frame")
+        graphics_render_end_frame_pass(graphics, frame);
+    }
+    else
+    {
+        CUBE_PROFILE_BEGIN(draw_list_zone)
+        graphics_render_build_draws(graphics, frame, &view_projection);
+        CUBE_PROFILE_END(draw_list_zone, "graphics_render_build_draws")
+        CUBE_PROFILE_COUNTER("draw batches", graphics->draw_list->batch_count)
+        graphics_render_begin_frame_pass(graphics, frame, VK_FALSE);
+        graphics_render_record_batches(graphics, frame);
+        graphics_render_end_frame_pass(graphics, frame);
+    }
+    CUBE_PROFILE_END(record_zone, "graphics_render_record_frame")
+    graphics_render_capture_frame(graphics, frame);
+    graphics_render_timestamp_end(graphics, frame);
+    VK_CHECK_RESULT(vkEndCommandBuffer(frame->command_buffer))
+    CUBE_END_FUNCTION
+}
+
+void graphics_render_begin_pass(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    VkRenderPass render_pass,
+    VkSubpassContents contents)
+{
+    const VkClearValue clear_values[] = {
+        {{0.0f, 0.0f, 0.0f, 1.0f}},
+        {1.0f, 0},
+    };
+    const VkRenderPassBeginInfo render_pass_begin_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+        .clearValueCount = sizeof(clear_values) / sizeof(clear_values[0]),
+        .pClearValues = &clear_values[0],
+        .framebuffer = frame->framebuffer,
+        .renderPass = render_pass,
+        .renderArea = {
+            .extent = graphics->display_size,
+            .offset = {0, 0},
+        },
+    };
+    vkCmdBeginRenderPass(
         frame->command_buffer,
+        &render_pass_begin_info,
+        contents);
+}
+
+void graphics_render_begin_rendering(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    VkAttachmentLoadOp load_op,
+    VkAttachmentStoreOp depth_store_op,
+    VkRenderingFlags flags)
+{
+    const VkRenderingAttachmentInfo color_attachment = {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .imageView = frame->image_view,
+        .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .loadOp = load_op,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .clearValue = {{{0.0f, 0.0f, 0.0f, 1.0f}}},
+    };
+    const VkRenderingAttachmentInfo depth_attachment = {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .imageView = graphics->depth_image_view,
+        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .loadOp = load_op,
+        .storeOp = depth_store_op,
+        .clearValue = {.depthStencil = {1.0f, 0}},
+    };
+    const VkRenderingInfo rendering_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+        .flags = flags,
+        .renderArea = {
+            .extent = graphics->display_size,
+            .offset = {0, 0},
+        },
+        .layerCount = 1,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &color_attachment,
+        .pDepthAttachment = &depth_attachment,
+    };
+    vkCmdBeginRendering(frame->command_buffer, &rendering_info);
+}
+
+// fills in the frame's images for either template, a NULL template is skipped
+void graphics_render_attachment_barrier(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    const VkImageMemoryBarrier2 *color_barrier,
+    const VkImageMemoryBarrier2 *depth_barrier)
+{
+    VkImageMemoryBarrier2 barriers[2];
+    uint32_t barrier_count;
+    uint32_t barrier_index;
+    VkDependencyInfo dependency_info = {
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .pImageMemoryBarriers = &barriers[0],
+    };
+
+    barrier_count = 0;
+    if (color_barrier != NULL)
+    {
+        barriers[barrier_count] = *color_barrier;
+        barriers[barrier_count].image = frame->image;
+        barriers[barrier_count].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier_count++;
+    }
+    if (depth_barrier != NULL)
+    {
+        barriers[barrier_count] = *depth_barrier;
+        barriers[barrier_count].image = graphics->depth_image;
+        // a combined format transitions both aspects together
+        barriers[barrier_count].subresourceRange.aspectMask =
+            (graphics->depth_stencil_support == VK_TRUE)
+                ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT
+                : VK_IMAGE_ASPECT_DEPTH_BIT;
+        barrier_count++;
+    }
+    for (barrier_index = 0; barrier_index < barrier_count; barrier_index++)
+    {
+        barriers[barrier_index].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+        barriers[barrier_index].pNext = NULL;
+        barriers[barrier_index].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[barrier_index].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[barrier_index].subresourceRange.baseMipLevel = 0;
+        barriers[barrier_index].subresourceRange.levelCount = 1;
+        barriers[barrier_index].subresourceRange.baseArrayLayer = 0;
+        barriers[barrier_index].subresourceRange.layerCount = 1;
+    }
+    dependency_info.imageMemoryBarrierCount = barrier_count;
+    vkCmdPipelineBarrier2(frame->command_buffer, &dependency_info);
+}
+
+void graphics_render_acquire_attachments(cube_graphics *graphics, cube_frame *frame)
+{
+    graphics_render_attachment_barrier(
+        graphics,
+        frame,
+        &graphics_acquire_color_barrier,
+        &graphics_acquire_depth_barrier);
+}
+
+void graphics_render_present_attachment(cube_graphics *graphics, cube_frame *frame)
+{
+    graphics_render_attachment_barrier(
+        graphics,
+        frame,
+        &graphics_present_color_barrier,
+        NULL);
+}
+
+void graphics_render_begin_frame_pass(cube_graphics *graphics, cube_frame *frame, VkBool32 secondary)
+{
+    if (graphics->dynamic_rendering == VK_TRUE)
+    {
+        graphics_render_acquire_attachments(graphics, frame);
+        graphics_render_begin_rendering(
+            graphics,
+            frame,
+            VK_ATTACHMENT_LOAD_OP_CLEAR,
+            VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            (secondary == VK_TRUE) ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0);
+        return;
+    }
+    graphics_render_begin_pass(
+        graphics,
+        frame,
+        graphics->render_pass,
+        (secondary == VK_TRUE) ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void graphics_render_end_frame_pass(cube_graphics *graphics, cube_frame *frame)
+{
+    if (graphics->dynamic_rendering == VK_TRUE)
+    {
+        vkCmdEndRendering(frame->command_buffer);
+        graphics_render_present_attachment(graphics, frame);
+        return;
+    }
+    vkCmdEndRenderPass(frame->command_buffer);
+}
+
+void graphics_render_record_state(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    VkCommandBuffer command_buffer)
+{
+    const VkDeviceSize vertex_buffer_offsets[] = {0, 0};
+    const VkBuffer vertex_buffers[] = {
+        graphics->object->vertex_buffer,
+        (graphics->animation != NULL) ? graphics->animation->matrix_buffer : frame->instance_buffer,
+    };
+    const VkViewport viewport = {
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = (float)graphics->display_size.width,
+        .height = (float)graphics->display_size.height,
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+    const VkRect2D scissor = {
+        .offset = {0, 0},
+        .extent = graphics->display_size,
+    };
+    vkCmdBindPipeline(
+        command_buffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        graphics->graphics_pipeline);
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+    vkCmdBindVertexBuffers(
+        command_buffer,
         0,
-        1,
-        &graphics->object->vertex_buffer,
+        sizeof(vertex_buffers) / sizeof(vertex_buffers[0]),
+        &vertex_buffers[0],
         &vertex_buffer_offsets[0]);
     vkCmdBindIndexBuffer(
-        frame->command_buffer,
+        command_buffer,
         graphics->object->index_buffer,
         0,
         VK_INDEX_TYPE_UINT32);
     vkCmdBindDescriptorSets(
-        frame->command_buffer,
+        command_buffer,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
         graphics->pipeline_layout,
         0, 1,
         &frame->descriptor_set,
         0, NULL);
-    vkCmdDrawIndexed(
-        frame->command_buffer,
-        graphics->object->index_count,
-        1, 0, 0, 0);
-    vkCmdEndRenderPass(frame->command_buffer);
-    VK_CHECK_RESULT(vkEndCommandBuffer(frame->command_buffer))
-    CUBE_END_FUNCTION
+    graphics_render_bind_bindless(graphics, command_buffer);
+}
+
+void graphics_render_record_draws(
+    cube_graphics *graphics,
+    VkCommandBuffer command_buffer,
+    uint32_t first_visible,
+    uint32_t visible_count)
+{
+    uint32_t visible_index;
+    for (visible_index = first_visible; visible_index < first_visible + visible_count; visible_index++)
+    {
+        vkCmdDrawIndexed(
+            command_buffer,
+            graphics->object->index_count,
+            1, 0, 0,
+            *(graphics->visible_instances + visible_index));
+    }
+}
+
+// instance runs keyed on their nearest view depth, sorted, and merged into one run per distinct state
+void graphics_render_build_draws(cube_graphics *graphics, cube_frame *frame, const cube_mat4 *view_projection)
+{
+    cube_draw_list *list;
+    cube_transforms *transforms;
+    VkDrawIndexedIndirectCommand command;
+    uint32_t visible_index;
+    uint32_t instance;
+    float depth;
+
+    list = graphics->draw_list;
+    transforms = graphics->transforms;
+    command.indexCount = graphics->object->index_count;
+    command.instanceCount = 1;
+    command.firstIndex = 0;
+    command.vertexOffset = 0;
+    graphics_draw_list_reset(list);
+    if (graphics->bvh != NULL)
+    {
+        graphics_draw_list_order(list, graphics->visible_instances, graphics->visible_count);
+    }
+    for (visible_index = 0; visible_index < graphics->visible_count; visible_index++)
+    {
+        instance = *(graphics->visible_instances + visible_index);
+
+        // clip space w is the distance along the view direction
+        depth = view_projection->m[0][3] * *(transforms->position_x + instance) +
+                view_projection->m[1][3] * *(transforms->position_y + instance) +
+                view_projection->m[2][3] * *(transforms->position_z + instance) +
+                view_projection->m[3][3];
+        command.firstInstance = instance;
+        graphics_draw_list_add(list, graphics_draw_list_key(0, 0, 0, depth), &command);
+    }
+    graphics_draw_list_sort(list);
+    graphics_draw_list_build(list, frame->draw_buffer_mapping);
+
+    // the draw buffer may not be coherent, only the written commands are flushed
+    vmaFlushAllocation(
+        graphics->allocator,
+        frame->draw_buffer_allocation,
+        0,
+        (VkDeviceSize)list->command_count * sizeof(VkDrawIndexedIndirectCommand));
+}
+
+// the scene has one pipeline, descriptor set and mesh, so every state binds the same objects
+void graphics_render_record_batches(cube_graphics *graphics, cube_frame *frame)
+{
+    cube_draw_list *list;
+    const cube_draw_batch *batch;
+    const VkDrawIndexedIndirectCommand *command;
+    uint32_t batch_index;
+    uint32_t command_index;
+
+    list = graphics->draw_list;
+    for (batch_index = 0; batch_index < list->batch_count; batch_index++)
+    {
+        batch = list->batches + batch_index;
+        graphics_render_record_state(graphics, frame, frame->command_buffer);
+        if (graphics->capabilities.draw_indirect_first_instance == VK_TRUE &&
+            graphics->capabilities.multi_draw_indirect == VK_TRUE)
+        {
+            vkCmdDrawIndexedIndirect(
+                frame->command_buffer,
+                frame->draw_buffer,
+                batch->first_command * sizeof(VkDrawIndexedIndirectCommand),
+                batch->command_count,
+                sizeof(VkDrawIndexedIndirectCommand));
+            continue;
+        }
+        for (command_index = batch->first_command; command_index < batch->first_command + batch->command_count; command_index++)
+        {
+            // drawCount is limited to one without multiDrawIndirect
+            if (graphics->capabilities.draw_indirect_first_instance == VK_TRUE)
+            {
+                vkCmdDrawIndexedIndirect(
+                    frame->command_buffer,
+                    frame->draw_buffer,
+                    command_index * sizeof(VkDrawIndexedIndirectCommand),
+                    1,
+                    sizeof(VkDrawIndexedIndirectCommand));
+                continue;
+            }
+            command = list->commands + command_index;
+            vkCmdDrawIndexed(
+                frame->command_buffer,
+                command->indexCount,
+                command->instanceCount,
+                command->firstIndex,
+                command->vertexOffset,
+                command->firstInstance);
+        }
+    }
 }
 
 int graphics_render_submit_frame(cube_graphics *graphics, cube_frame *frame)
 {
     CUBE_BEGIN_FUNCTION
-    const VkPipelineStageFlags wait_dest_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    // color output is where the first write to the acquired image waits
+    const VkPipelineStageFlags wait_dest_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
     const VkSubmitInfo frame_submit_info = {
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
         .waitSemaphoreCount = 1,
@@ -179,87 +564,125 @@ int graphics_render_submit_frame(cube_graphics *graphics, cube_frame *frame)
         .commandBufferCount = 1,
         .pCommandBuffers = &frame->command_buffer,
         .signalSemaphoreCount = 1,
-        .pSignalSemaphores = &graphics->frame_rendered,
+        .pSignalSemaphores = &frame->rendered,
+    };
+    uint64_t present_id;
+    const VkPresentIdKHR frame_present_id = {
+        .sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+        .swapchainCount = 1,
+        .pPresentIds = &present_id,
     };
-    const VkPresentInfoKHR frame_present_info = {
+    VkPresentInfoKHR frame_present_info = {
         .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
         .waitSemaphoreCount = 1,
-        .pWaitSemaphores = &graphics->frame_rendered,
+        .pWaitSemaphores = &frame->rendered,
         .swapchainCount = 1,
         .pSwapchains = &graphics->swapchain,
         .pImageIndices = &frame->index,
     };
-    VK_CHECK_RESULT(
-        vkQueueSubmit(
-            graphics->graphics_queue,
-            1,
+    CUBE_ASSERT(
+        graphics_sync_submit(
+            graphics,
             &frame_submit_info,
-            graphics->command_fence))
+            &graphics->sync->frame) == CUBE_SUCCESS,
+        "failed to submit frame")
+    present_id = graphics_render_next_present_id(graphics);
+    if (graphics->pacer->wait_for_present != NULL)
+    {
+        frame_present_info.pNext = &frame_present_id;
+    }
     VK_CHECK_RESULT(
         vkQueuePresentKHR(
             graphics->present_queue,
             &frame_present_info))
-    VK_CHECK_RESULT(
-        vkQueueWaitIdle(
-            graphics->present_queue))
     CUBE_END_FUNCTION
 }
 
-int graphics_render_update_object(cube_graphics *graphics, cube_frame *frame)
+int graphics_render_update_object(cube_graphics *graphics, cube_frame *frame, const cube_scene *scene)
 {
     CUBE_BEGIN_FUNCTION
-    clock_t now = clock();
-    int step = (int)(now - graphics->timestamp) / 10;
-    graphics->timestamp = now;
-    graphics->theta = (graphics->theta + step) % 360;
-    double angle = (float)graphics->theta * 3.14 / 180.0;
+    cube_update_task task;
+    // the scene may have advanced by several ticks since the last frame
+    float angle = scene->angle - graphics->scene_angle;
+    graphics->scene_angle = scene->angle;
+
+    CUBE_ASSERT(frame->instance_buffer_mapping != NULL, "invalid mapping")
+
+    // every instance spins about the z axis by the same delta each frame
+    task.transforms = graphics->transforms;
+    task.rotation[0] = 0.0f;
+    task.rotation[1] = 0.0f;
+    task.rotation[2] = sinf(angle / 2.0f);
+    task.rotation[3] = cosf(angle / 2.0f);
+    task.matrices = frame->instance_buffer_mapping;
+    application_jobs_parallel_for(
+        graphics->jobs,
+        graphics_render_update_job,
+        &task,
+        graphics->instance_count,
+        CUBE_UPDATE_GRAIN);
 
-    cube_ubo *ubo = frame->uniform_buffer_mapping;
-    CUBE_ASSERT(ubo != NULL, "invalid mapping")
+    CUBE_END_FUNCTION
+}
 
-    ubo->model[0][0] = (float)cos(angle);
-    ubo->model[0][1] = (float)sin(angle);
-    ubo->model[1][0] = -1.0f * (float)sin(angle);
-    ubo->model[1][1] = (float)cos(angle);
+// rotated and written out in one pass while the range is still in cache
+void graphics_render_update_job(void *data, uint32_t begin, uint32_t end)
+{
+    cube_update_task *task;
+
+    task = data;
+    graphics_transforms_rotate(
+        task->transforms,
+        begin,
+        end - begin,
+        task->rotation);
+    graphics_transforms_compute(
+        task->transforms,
+        begin,
+        end - begin,
+        task->matrices);
+}
 
-    CUBE_END_FUNCTION
+void graphics_render_view_projection(cube_frame *frame, cube_mat4 *view_projection)
+{
+    cube_ubo *ubo;
+    cube_mat4 model;
+    cube_mat4 view;
+    cube_mat4 projection;
+
+    ubo = frame->uniform_buffer_mapping;
+    SDL_memcpy(&model.m[0][0], &ubo->model[0][0], sizeof(model.m));
+    SDL_memcpy(&view.m[0][0], &ubo->view[0][0], sizeof(view.m));
+    SDL_memcpy(&projection.m[0][0], &ubo->projection[0][0], sizeof(projection.m));
+    graphics_mat4_multiply(&projection, &view, view_projection);
+    graphics_mat4_multiply(view_projection, &model, view_projection);
 }
 
-int graphics_render_prepare_frame(cube_graphics *graphics, cube_frame *frame)
+void graphics_render_cull_objects(cube_graphics *graphics, const cube_mat4 *view_projection)
+{
+    cube_frustum frustum;
+
+    // without a bvh the visible list keeps every instance
+    if (graphics->bvh == NULL)
+    {
+        return;
+    }
+
+    graphics_bvh_frustum(view_projection, &frustum);
+    graphics->visible_count = graphics_bvh_cull(
+        graphics->bvh,
+        &frustum,
+        graphics->visible_instances);
+}
+
+int graphics_render_prepare_frame(cube_frame *frame)
 {
     CUBE_BEGIN_FUNCTION
     const VkCommandBufferResetFlags reset_flags = 0;
-    const VkClearValue clear_values[] = {
-        {{0.0f, 0.0f, 0.0f, 1.0f}},
-        {1.0f, 0},
-    };
     const VkCommandBufferBeginInfo command_buffer_begin_info = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
         .flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT,
     };
-    const VkRenderPassBeginInfo render_pass_begin_info = {
-        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-        .clearValueCount = sizeof(clear_values) / sizeof(clear_values[0]),
-        .pClearValues = &clear_values[0],
-        .framebuffer = frame->framebuffer,
-        .renderPass = graphics->render_pass,
-        .renderArea = {
-            .extent = graphics->display_size,
-            .offset = {0, 0},
-        },
-    };
-    const VkViewport viewport = {
-        .x = 0.0f,
-        .y = 0.0f,
-        .width = (float)graphics->display_size.width,
-        .height = (float)graphics->display_size.height,
-        .minDepth = 0.0f,
-        .maxDepth = 1.0f,
-    };
-    const VkRect2D scissor = {
-        .offset = {0, 0},
-        .extent = graphics->display_size,
-    };
     VK_CHECK_RESULT(
         vkResetCommandBuffer(
             frame->command_buffer,
@@ -268,16 +691,6 @@ int graphics_render_prepare_frame(cube_graphics *graphics, cube_frame *frame)
         vkBeginCommandBuffer(
             frame->command_buffer,
             &command_buffer_begin_info))
-    vkCmdBeginRenderPass(
-        frame->command_buffer,
-        &render_pass_begin_info,
-        VK_SUBPASS_CONTENTS_INLINE);
-    vkCmdBindPipeline(
-        frame->command_buffer,
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        graphics->graphics_pipeline);
-    vkCmdSetViewport(frame->command_buffer, 0, 1, &viewport);
-    vkCmdSetScissor(frame->command_buffer, 0, 1, &scissor);
     CUBE_END_FUNCTION
 }
 
@@ -298,18 +711,10 @@ void graphics_destroy_frame_pool(cube_graphics *graphics)
     {
         vkDestroyDescriptorPool(graphics->logical_device, graphics->descriptor_pool, NULL);
     }
-    if (graphics->frame_rendered != VK_NULL_HANDLE)
-    {
-        vkDestroySemaphore(graphics->logical_device, graphics->frame_rendered, NULL);
-    }
     if (graphics->frame_presented != VK_NULL_HANDLE)
     {
         vkDestroySemaphore(graphics->logical_device, graphics->frame_presented, NULL);
     }
-    if (graphics->command_fence != VK_NULL_HANDLE)
-    {
-        vkDestroyFence(graphics->logical_device, graphics->command_fence, NULL);
-    }
 }
 
 static int graphics_create_frame(cube_graphics *graphics, VkImage *images, uint32_t index, cube_frame *frame)
@@ -340,12 +745,37 @@ static int graphics_create_frame(cube_graphics *graphics, VkImage *images, uint3
         .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
     };
+    const VkBufferCreateInfo instance_buffer_create_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = (VkDeviceSize)graphics->instance_count * sizeof(float[4][4]),
+        .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    const VkBufferCreateInfo draw_buffer_create_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = (VkDeviceSize)graphics->instance_count * sizeof(VkDrawIndexedIndirectCommand),
+        .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
     const VmaAllocationCreateInfo host_allocation_create_info = {
         .usage = VMA_MEMORY_USAGE_CPU_ONLY,
         .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
     };
+    // the matrices are written every frame without a flush
+    const VmaAllocationCreateInfo instance_allocation_create_info = {
+        .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .requiredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+    };
+    const VmaAllocationCreateInfo draw_allocation_create_info = {
+        .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+    };
     VmaAllocationInfo uniform_buffer_allocation_info;
+    VmaAllocationInfo instance_buffer_allocation_info;
+    VmaAllocationInfo draw_buffer_allocation_info;
     frame->index = index;
+    frame->image = *(images + index);
 
     VK_CHECK_RESULT(
         vkCreateImageView(
@@ -366,12 +796,16 @@ static int graphics_create_frame(cube_graphics *graphics, VkImage *images, uint3
         .height = graphics->display_size.height,
         .layers = 1,
     };
-    VK_CHECK_RESULT(
-        vkCreateFramebuffer(
-            graphics->logical_device,
-            &framebuffer_create_info,
-            NULL,
-            &frame->framebuffer))
+    // dynamic rendering binds the views directly
+    if (graphics->dynamic_rendering == VK_FALSE)
+    {
+        VK_CHECK_RESULT(
+            vkCreateFramebuffer(
+                graphics->logical_device,
+                &framebuffer_create_info,
+                NULL,
+                &frame->framebuffer))
+    }
     VK_CHECK_RESULT(
         vkAllocateCommandBuffers(
             graphics->logical_device,
@@ -386,6 +820,30 @@ static int graphics_create_frame(cube_graphics *graphics, VkImage *images, uint3
             &frame->uniform_buffer_allocation,
             &uniform_buffer_allocation_info))
     frame->uniform_buffer_mapping = uniform_buffer_allocation_info.pMappedData;
+    VK_CHECK_RESULT(
+        vmaCreateBuffer(
+            graphics->allocator,
+            &draw_buffer_create_info,
+            &draw_allocation_create_info,
+            &frame->draw_buffer,
+            &frame->draw_buffer_allocation,
+            &draw_buffer_allocation_info))
+    frame->draw_buffer_mapping = draw_buffer_allocation_info.pMappedData;
+
+    // animated matrices never come from the host
+    if (graphics->animation != NULL)
+    {
+        goto done;
+    }
+    VK_CHECK_RESULT(
+        vmaCreateBuffer(
+            graphics->allocator,
+            &instance_buffer_create_info,
+            &instance_allocation_create_info,
+            &frame->instance_buffer,
+            &frame->instance_buffer_allocation,
+            &instance_buffer_allocation_info))
+    frame->instance_buffer_mapping = instance_buffer_allocation_info.pMappedData;
     CUBE_END_FUNCTION
 }
 
@@ -463,40 +921,46 @@ int graphics_create_descriptor_sets(cube_graphics *graphics)
 int graphics_create_initialize_object(cube_graphics *graphics, cube_frame *frame)
 {
     CUBE_BEGIN_FUNCTION
-    const float model_matrix[4][4] = {
+    float model_matrix[4][4] = {
         {1.0f, 0.0f, 0.0f, 0.0f},
         {0.0f, 1.0f, 0.0f, 0.0f},
         {0.0f, 0.0f, 1.0f, 0.0f},
         {0.0f, 0.0f, 0.0f, 1.0f},
     };
-    const float view_matrix[4][4] = {
-        {0.707107f, 0.408248f, 0.57735f, 0},
-        {-0.707107f, 0.408248f, 0.57735f, 0},
-        {0, -0.816497f, 0.57735f, 0},
-        {0, 0, -3.4641f, 1.0f},
-    };
+    float model_axis[3] = {0.0f, 0.0f, 1.0f};
+    float eye[3] = {2.0f, 2.0f, 2.0f};
+    float center[3] = {0.0f, 0.0f, 0.0f};
+    float up[3] = {0.0f, 0.0f, -1.0f};
     const float fov = 3.14f / 4.0f;
     const float aspect = (float)graphics->display_size.width / (float)graphics->display_size.height;
     const float znear = 0.1f;
     const float zfar = 10.0f;
-    const float range = tanf(fov / 2.0f) * znear;
-    const float left = -range * aspect;
-    const float right = range * aspect;
-    const float bottom = -range;
-    const float top = range;
-    const float projection_matrix[4][4] = {
-        {(2.0f * znear) / (right - left), 0.0f, 0.0f, 0.0f},
-        {0.0f, (2.0f * znear) / (top - bottom), 0.0f, 0.0f},
-        {0.0f, 0.0f, -1.0f * (zfar + znear) / (zfar - znear), -1.0f},
-        {0.0f, 0.0f, -1.0f * (2.0f * zfar * znear) / (zfar - znear), 0.0f},
-    };
 
     cube_ubo *updated_ubo = frame->uniform_buffer_mapping;
     CUBE_ASSERT(updated_ubo != NULL, "invalid mapping")
 
-    SDL_memcpy(&updated_ubo->model[0][0], &model_matrix[0][0], sizeof(model_matrix));
-    SDL_memcpy(&updated_ubo->view[0][0], &view_matrix[0][0], sizeof(view_matrix));
-    SDL_memcpy(&updated_ubo->projection[0][0], &projection_matrix[0][0], sizeof(projection_matrix));
+    CUBE_ASSERT(
+        graphics_util_rotate(
+            model_matrix,
+            0.0f,
+            model_axis,
+            updated_ubo) == CUBE_SUCCESS,
+        "failed to set model matrix")
+    CUBE_ASSERT(
+        graphics_util_look_at(
+            eye,
+            center,
+            up,
+            updated_ubo) == CUBE_SUCCESS,
+        "failed to set view matrix")
+    CUBE_ASSERT(
+        graphics_util_perspective(
+            fov,
+            aspect,
+            znear,
+            zfar,
+            updated_ubo) == CUBE_SUCCESS,
+        "failed to set projection matrix")
     CUBE_END_FUNCTION
 }
 
@@ -508,6 +972,14 @@ void graphics_destroy_frame(cube_graphics *graphics, cube_frame *frame)
         {
             vmaDestroyBuffer(graphics->allocator, frame->uniform_buffer, frame->uniform_buffer_allocation);
         }
+        if (frame->instance_buffer != VK_NULL_HANDLE)
+        {
+            vmaDestroyBuffer(graphics->allocator, frame->instance_buffer, frame->instance_buffer_allocation);
+        }
+        if (frame->draw_buffer != VK_NULL_HANDLE)
+        {
+            vmaDestroyBuffer(graphics->allocator, frame->draw_buffer, frame->draw_buffer_allocation);
+        }
         if (frame->framebuffer != VK_NULL_HANDLE)
         {
             vkDestroyFramebuffer(graphics->logical_device, frame->framebuffer, NULL);
@@ -516,5 +988,9 @@ void graphics_destroy_frame(cube_graphics *graphics, cube_frame *frame)
         {
             vkDestroyImageView(graphics->logical_device, frame->image_view, NULL);
         }
+        if (frame->rendered != VK_NULL_HANDLE)
+        {
+            vkDestroySemaphore(graphics->logical_device, frame->rendered, NULL);
+        }
     }
 }
\ No newline at end of file
@@ -2,47 +2,121 @@
 
 int graphics_create(
     cube_graphics **graphics,
-    const char *resource_directory)
+    cube_jobs *jobs,
+    cube_resources *resources)
 {
     CUBE_BEGIN_FUNCTION
+    uint32_t resource_index;
+
     CUBE_ASSERT(graphics != NULL, "NULL graphics handle")
+    CUBE_PROFILE_BEGIN(create_zone)
 
     *graphics = calloc(1, sizeof(cube_graphics));
     CUBE_ASSERT(*graphics != NULL, "failed to allocate graphics")
+    (*graphics)->jobs = jobs;
+    (*graphics)->resources = resources;
 
-    SDL_asprintf(&(*graphics)->shader_directory, "%s%s%s", resource_directory, PATH_SEPARATOR, "shaders");
-    CUBE_PUSH((*graphics)->shader_directory);
+    // shader files are read by the job workers while the instance and device come up
+    for (resource_index = resources->type_first[CUBE_RESOURCE_SHADER];
+         resource_index < resources->type_first[CUBE_RESOURCE_SHADER] + resources->type_count[CUBE_RESOURCE_SHADER];
+         resource_index++)
+    {
+        CUBE_ASSERT(
+            application_resources_load(
+                resources,
+                resource_index,
+                NULL,
+                NULL) == CUBE_SUCCESS,
+            "failed to queue shader")
+    }
 
+    CUBE_PROFILE_BEGIN(display_zone)
     CUBE_ASSERT(graphics_create_display(*graphics) == CUBE_SUCCESS, "failed to create display")
+    CUBE_PROFILE_END(display_zone, "graphics_create_display")
+    CUBE_PROFILE_BEGIN(device_zone)
     CUBE_ASSERT(graphics_create_device(*graphics) == CUBE_SUCCESS, "failed to create device")
+    CUBE_ASSERT(graphics_create_sync(*graphics) == CUBE_SUCCESS, "failed to create sync")
+    CUBE_PROFILE_END(device_zone, "graphics_create_device")
+    CUBE_PROFILE_BEGIN(scene_zone)
     CUBE_ASSERT(graphics_create_object(*graphics) == CUBE_SUCCESS, "failed to create object")
+    CUBE_ASSERT(graphics_create_transforms(*graphics) == CUBE_SUCCESS, "failed to create transforms")
+    CUBE_ASSERT(graphics_create_bvh(*graphics) == CUBE_SUCCESS, "failed to create bvh")
+    CUBE_PROFILE_END(scene_zone, "graphics_create_scene")
+    CUBE_PROFILE_BEGIN(pipeline_zone)
     CUBE_ASSERT(graphics_create_images(*graphics) == CUBE_SUCCESS, "failed to create images")
+    CUBE_ASSERT(graphics_create_bindless(*graphics) == CUBE_SUCCESS, "failed to create bindless")
+    CUBE_ASSERT(graphics_create_textures(*graphics) == CUBE_SUCCESS, "failed to create textures")
     CUBE_ASSERT(graphics_create_pipeline(*graphics) == CUBE_SUCCESS, "failed to create pipeline")
+    CUBE_PROFILE_END(pipeline_zone, "graphics_create_pipeline")
+    CUBE_PROFILE_BEGIN(frame_zone)
+    CUBE_ASSERT(graphics_create_animation(*graphics) == CUBE_SUCCESS, "failed to create animation")
     CUBE_ASSERT(graphics_create_frame_pool(*graphics) == CUBE_SUCCESS, "failed to create frame pool")
+    CUBE_ASSERT(graphics_create_draw_list(*graphics) == CUBE_SUCCESS, "failed to create draw list")
+    CUBE_ASSERT(graphics_create_recorder(*graphics) == CUBE_SUCCESS, "failed to create recorder")
+    CUBE_ASSERT(graphics_create_occlusion(*graphics) == CUBE_SUCCESS, "failed to create occlusion")
+    CUBE_ASSERT(graphics_create_pacer(*graphics) == CUBE_SUCCESS, "failed to create pacer")
+    CUBE_ASSERT(graphics_create_timestamps(*graphics) == CUBE_SUCCESS, "failed to create timestamps")
+    CUBE_ASSERT(graphics_create_capture(*graphics) == CUBE_SUCCESS, "failed to create capture")
+    CUBE_ASSERT(graphics_create_voxels(*graphics) == CUBE_SUCCESS, "failed to create voxels")
+    CUBE_PROFILE_END(frame_zone, "graphics_create_frames")
+
+    // every module is created, the spir-v is not needed again
+    for (resource_index = resources->type_first[CUBE_RESOURCE_SHADER];
+         resource_index < resources->type_first[CUBE_RESOURCE_SHADER] + resources->type_count[CUBE_RESOURCE_SHADER];
+         resource_index++)
+    {
+        application_resources_release(resources, resource_index);
+    }
+    CUBE_ASSERT(graphics_create_reload(*graphics) == CUBE_SUCCESS, "failed to create shader reload")
+    CUBE_PROFILE_END(create_zone, "graphics_create")
     CUBE_END_FUNCTION
 }
 
-int graphics_render(cube_graphics *graphics)
+int graphics_render(cube_graphics *graphics, const cube_scene *scene)
 {
     CUBE_BEGIN_FUNCTION
     cube_frame *frame;
 
+    CUBE_PROFILE_BEGIN(pace_zone)
+    graphics_render_pace_frame(graphics);
+    CUBE_PROFILE_END(pace_zone, "graphics_render_pace_frame")
+    CUBE_PROFILE_BEGIN(reload_zone)
+    graphics_render_reload_frame(graphics);
+    CUBE_PROFILE_END(reload_zone, "graphics_render_reload_frame")
+
+    CUBE_PROFILE_BEGIN(acquire_zone)
     CUBE_ASSERT(
         graphics_render_acquire_frame(
             graphics, &frame) == CUBE_SUCCESS,
         "failed to acquire frame")
+    CUBE_PROFILE_END(acquire_zone, "graphics_render_acquire_frame")
+    graphics_render_sync_collect(graphics);
+    graphics_render_timestamp_collect(graphics);
+    graphics_render_capture_collect(graphics);
+    CUBE_ASSERT(
+        graphics_render_voxel_frame(graphics) == CUBE_SUCCESS,
+        "failed to update voxels")
 
+    CUBE_PROFILE_BEGIN(draw_zone)
     CUBE_ASSERT(
         graphics_render_draw_frame(
             graphics,
-            frame) == CUBE_SUCCESS,
+            frame,
+            scene) == CUBE_SUCCESS,
         "failed to draw frame")
+    CUBE_PROFILE_END(draw_zone, "graphics_render_draw_frame")
 
+    CUBE_PROFILE_BEGIN(submit_zone)
     CUBE_ASSERT(
         graphics_render_submit_frame(
             graphics,
             frame) == CUBE_SUCCESS,
         "failed to submit frame")
+    CUBE_PROFILE_END(submit_zone, "graphics_render_submit_frame")
+
+    CUBE_PROFILE_BEGIN(paced_zone)
+    graphics_render_paced_frame(graphics);
+    CUBE_PROFILE_END(paced_zone, "graphics_render_paced_frame")
 
     CUBE_END_FUNCTION
 }
@@ -51,10 +125,28 @@ void graphics_destroy(cube_graphics *graphics)
 {
     if (graphics != NULL)
     {
+        if (graphics->logical_device != VK_NULL_HANDLE)
+        {
+            vkDeviceWaitIdle(graphics->logical_device);
+        }
+        graphics_destroy_reload(graphics);
+        graphics_destroy_voxels(graphics);
+        graphics_destroy_capture(graphics);
+        graphics_destroy_timestamps(graphics);
+        graphics_destroy_pacer(graphics);
+        graphics_destroy_occlusion(graphics);
+        graphics_destroy_recorder(graphics);
+        graphics_destroy_draw_list(graphics);
         graphics_destroy_frame_pool(graphics);
+        graphics_destroy_animation(graphics);
         graphics_destroy_images(graphics);
         graphics_destroy_pipeline(graphics);
+        graphics_destroy_textures(graphics);
+        graphics_destroy_bindless(graphics);
+        graphics_destroy_bvh(graphics);
+        graphics_destroy_transforms(graphics);
         graphics_destroy_object(graphics);
+        graphics_destroy_sync(graphics);
         graphics_destroy_device(graphics);
         graphics_destroy_display(graphics);
         free(graphics);
@@ -128,6 +128,12 @@ int graphics_create_swapchain(cube_graphics *graphics)
         .clipped = VK_TRUE,
     };
 
+    // lets capture copy the presented image out, where the surface allows it
+    if ((graphics->surface_capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) == VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+    {
+        swapchain_create_info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+
     if (graphics->graphics_queue_family_index != graphics->present_queue_family_index)
     {
         swapchain_create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
@@ -158,17 +164,23 @@ int graphics_create_depth_format(cube_graphics *graphics)
 
     graphics->depth_format = VK_FORMAT_UNDEFINED;
     graphics->depth_stencil_support = VK_FALSE;
+    graphics->depth_sampled_support = VK_FALSE;
     for (format_index = 0; format_index < format_count; format_index++)
     {
-        if (graphics->depth_format == VK_FORMAT_UNDEFINED)
+        if (graphics->depth_format == VK_FORMAT_UNDEFINED || graphics->depth_sampled_support == VK_FALSE)
         {
             vkGetPhysicalDeviceFormatProperties(
                 graphics->physical_device,
                 formats[format_index],
                 &format_properties);
-            if ((format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) == VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+            // prefer a format the occlusion pass can also sample
+            if ((format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) == VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT &&
+                (graphics->depth_format == VK_FORMAT_UNDEFINED ||
+                 (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
             {
                 graphics->depth_format = formats[format_index];
+                graphics->depth_sampled_support =
+                    (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
             }
         }
     }
@@ -189,7 +201,7 @@ int graphics_create_depth_image(cube_graphics *graphics)
 {
 
     CUBE_BEGIN_FUNCTION
-    const VkImageCreateInfo depth_image_create_info = {
+    VkImageCreateInfo depth_image_create_info = {
         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
         .imageType = VK_IMAGE_TYPE_2D,
         .format = graphics->depth_format,
@@ -209,6 +221,11 @@ int graphics_create_depth_image(cube_graphics *graphics)
     const VmaAllocationCreateInfo depth_image_allocation_create_info = {
         .usage = VMA_MEMORY_USAGE_GPU_ONLY,
     };
+    // the occlusion pass builds its depth pyramid from this image
+    if (graphics->depth_sampled_support == VK_TRUE)
+    {
+        depth_image_create_info.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+    }
     VK_CHECK_RESULT(
         vmaCreateImage(
             graphics->allocator,
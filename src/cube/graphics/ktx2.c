@@ -0,0 +1,159 @@
+#include "cube.h"
+
+#define CUBE_KTX2_HEADER_SIZE 80
+#define CUBE_KTX2_LEVEL_SIZE 24
+
+// the first entry is the rgba8 every texture is measured against
+static const cube_texture_format graphics_ktx2_formats[] = {
+    {VK_FORMAT_R8G8B8A8_UNORM, 1, 4},
+    {VK_FORMAT_R8G8B8A8_SRGB, 1, 4},
+    {VK_FORMAT_B8G8R8A8_UNORM, 1, 4},
+    {VK_FORMAT_B8G8R8A8_SRGB, 1, 4},
+    {VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 8},
+    {VK_FORMAT_BC1_RGB_SRGB_BLOCK, 4, 8},
+    {VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 8},
+    {VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 4, 8},
+    {VK_FORMAT_BC3_UNORM_BLOCK, 4, 16},
+    {VK_FORMAT_BC3_SRGB_BLOCK, 4, 16},
+    {VK_FORMAT_BC7_UNORM_BLOCK, 4, 16},
+    {VK_FORMAT_BC7_SRGB_BLOCK, 4, 16},
+};
+
+static const cube_texture_format *graphics_ktx2_find_format(VkFormat format);
+static VkDeviceSize graphics_ktx2_size(
+    const cube_texture_format *format,
+    uint32_t width,
+    uint32_t height,
+    uint32_t level_count);
+static uint32_t graphics_ktx2_uint32(const uint8_t *bytes);
+static uint64_t graphics_ktx2_uint64(const uint8_t *bytes);
+
+// a single 2d image without supercompression, every level checked against the file size
+int graphics_ktx2_parse(
+    const uint8_t *data,
+    size_t size,
+    VkBool32 block_compression,
+    uint32_t max_dimension,
+    cube_ktx2 *ktx2)
+{
+    CUBE_BEGIN_FUNCTION
+    const uint8_t identifier[] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    const uint8_t *level;
+    uint32_t level_index;
+    uint64_t level_length;
+
+    CUBE_ASSERT(
+        size >= CUBE_KTX2_HEADER_SIZE && SDL_memcmp(data, identifier, sizeof(identifier)) == 0,
+        "not a ktx2 file")
+    ktx2->format = graphics_ktx2_find_format((VkFormat)graphics_ktx2_uint32(data + 12));
+    CUBE_ASSERT(ktx2->format != NULL, "unsupported texture format")
+    CUBE_ASSERT(
+        ktx2->format->block_extent == 1 || block_compression == VK_TRUE,
+        "block compressed textures are not supported by the device")
+    ktx2->width = graphics_ktx2_uint32(data + 20);
+    ktx2->height = graphics_ktx2_uint32(data + 24);
+    CUBE_ASSERT(ktx2->width > 0 && ktx2->height > 0, "texture has no size")
+    CUBE_ASSERT(
+        ktx2->width <= max_dimension && ktx2->height <= max_dimension,
+        "texture is larger than the device allows")
+    CUBE_ASSERT(
+        graphics_ktx2_uint32(data + 28) == 0 &&
+            graphics_ktx2_uint32(data + 32) == 0 &&
+            graphics_ktx2_uint32(data + 36) == 1,
+        "only 2d textures without layers or faces are supported")
+    CUBE_ASSERT(graphics_ktx2_uint32(data + 44) == 0, "supercompressed textures are not supported")
+
+    // a level count of zero asks the loader to generate the chain
+    ktx2->level_count = graphics_ktx2_uint32(data + 40);
+    ktx2->generate_levels = (ktx2->level_count == 0 && ktx2->format->block_extent == 1) ? VK_TRUE : VK_FALSE;
+    ktx2->level_count = SDL_max(ktx2->level_count, 1);
+    CUBE_ASSERT(
+        ktx2->level_count <= graphics_ktx2_chain_length(ktx2->width, ktx2->height),
+        "texture has more levels than its size allows")
+    CUBE_ASSERT(ktx2->level_count <= CUBE_TEXTURE_LEVEL_CAPACITY, "texture has too many levels")
+    CUBE_ASSERT(
+        size >= CUBE_KTX2_HEADER_SIZE + (size_t)ktx2->level_count * CUBE_KTX2_LEVEL_SIZE,
+        "truncated texture level index")
+
+    for (level_index = 0; level_index < ktx2->level_count; level_index++)
+    {
+        level = data + CUBE_KTX2_HEADER_SIZE + level_index * CUBE_KTX2_LEVEL_SIZE;
+        ktx2->level_offsets[level_index] = graphics_ktx2_uint64(level);
+        level_length = graphics_ktx2_uint64(level + 8);
+        CUBE_ASSERT(
+            level_length == graphics_ktx2_size(
+                                ktx2->format,
+                                SDL_max(ktx2->width >> level_index, 1),
+                                SDL_max(ktx2->height >> level_index, 1),
+                                1) &&
+                ktx2->level_offsets[level_index] % ktx2->format->block_size == 0 &&
+                ktx2->level_offsets[level_index] <= size &&
+                level_length <= size - ktx2->level_offsets[level_index],
+            "invalid texture level")
+    }
+    CUBE_END_FUNCTION
+}
+
+const cube_texture_format *graphics_ktx2_find_format(VkFormat format)
+{
+    uint32_t format_index;
+
+    for (format_index = 0;
+         format_index < sizeof(graphics_ktx2_formats) / sizeof(graphics_ktx2_formats[0]);
+         format_index++)
+    {
+        if (graphics_ktx2_formats[format_index].format == format)
+        {
+            return graphics_ktx2_formats + format_index;
+        }
+    }
+    return NULL;
+}
+
+// bytes for the first level_count levels, partial blocks at the edges count whole
+VkDeviceSize graphics_ktx2_size(
+    const cube_texture_format *format,
+    uint32_t width,
+    uint32_t height,
+    uint32_t level_count)
+{
+    VkDeviceSize size;
+    uint32_t level_index;
+    uint32_t level_width;
+    uint32_t level_height;
+
+    size = 0;
+    for (level_index = 0; level_index < level_count; level_index++)
+    {
+        level_width = SDL_max(width >> level_index, 1);
+        level_height = SDL_max(height >> level_index, 1);
+        size += (VkDeviceSize)((level_width + format->block_extent - 1) / format->block_extent) *
+                ((level_height + format->block_extent - 1) / format->block_extent) *
+                format->block_size;
+    }
+    return size;
+}
+
+uint32_t graphics_ktx2_chain_length(uint32_t width, uint32_t height)
+{
+    uint32_t length;
+
+    for (length = 1; (SDL_max(width, height) >> length) > 0; length++)
+    {
+    }
+    return length;
+}
+
+// ktx2 is little endian throughout
+uint32_t graphics_ktx2_uint32(const uint8_t *bytes)
+{
+    return (uint32_t)*bytes |
+           ((uint32_t)*(bytes + 1) << 8) |
+           ((uint32_t)*(bytes + 2) << 16) |
+           ((uint32_t)*(bytes + 3) << 24);
+}
+
+uint64_t graphics_ktx2_uint64(const uint8_t *bytes)
+{
+    return (uint64_t)graphics_ktx2_uint32(bytes) | ((uint64_t)graphics_ktx2_uint32(bytes + 4) << 32);
+}
\ No newline at end of file
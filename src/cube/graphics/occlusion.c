@@ -0,0 +1,1026 @@
+#include "cube.h"
+
+#define CUBE_OCCLUSION_VARIABLE "CUBE_OCCLUSION"
+#define CUBE_OCCLUSION_CULL_GROUP_SIZE 64
+#define CUBE_OCCLUSION_REDUCE_GROUP_SIZE 8
+#define CUBE_OCCLUSION_PHASE_EARLY 0
+#define CUBE_OCCLUSION_PHASE_LATE 1
+
+static int graphics_create_occlusion_render_passes(cube_graphics *graphics);
+static int graphics_create_occlusion_render_pass(
+    cube_graphics *graphics,
+    VkAttachmentLoadOp load_op,
+    VkImageLayout color_initial_layout,
+    VkImageLayout color_final_layout,
+    VkImageLayout depth_initial_layout,
+    VkImageLayout depth_final_layout,
+    const VkSubpassDependency *dependencies,
+    uint32_t dependency_count,
+    VkRenderPass *render_pass);
+static int graphics_create_occlusion_pyramid(cube_graphics *graphics);
+static int graphics_create_occlusion_buffers(cube_graphics *graphics);
+static int graphics_create_occlusion_pipelines(cube_graphics *graphics);
+static int graphics_create_occlusion_pipeline(
+    cube_graphics *graphics,
+    const char *shader_file,
+    const VkDescriptorSetLayoutBinding *bindings,
+    uint32_t binding_count,
+    uint32_t constants_size,
+    VkDescriptorSetLayout *set_layout,
+    VkPipelineLayout *pipeline_layout,
+    VkPipeline *pipeline);
+static int graphics_create_occlusion_descriptor_sets(cube_graphics *graphics);
+static void graphics_render_occlusion_cull(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    cube_occlusion_constants *constants,
+    uint32_t phase);
+static void graphics_render_occlusion_pyramid(cube_graphics *graphics, cube_frame *frame);
+static void graphics_render_occlusion_draws(cube_graphics *graphics, cube_frame *frame, VkBuffer draw_buffer);
+static void graphics_render_occlusion_begin_phase(cube_graphics *graphics, cube_frame *frame, uint32_t phase);
+static void graphics_render_occlusion_end_phase(cube_graphics *graphics, cube_frame *frame, uint32_t phase);
+
+// the dynamic rendering equivalents of the early and late render pass dependencies
+static const VkImageMemoryBarrier2 graphics_occlusion_sample_depth_barrier = {
+    .srcStageMask = VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+    .srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+    .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+    .dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+    .oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+    .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+};
+static const VkImageMemoryBarrier2 graphics_occlusion_load_color_barrier = {
+    .srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+    .srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+    .dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+    .dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+    .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+    .newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+};
+static const VkImageMemoryBarrier2 graphics_occlusion_load_depth_barrier = {
+    .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+    .srcAccessMask = VK_ACCESS_2_NONE,
+    .dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+    .dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+    .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    .newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+};
+
+int graphics_create_occlusion(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    const char *occlusion_variable;
+
+    graphics->occlusion = NULL;
+
+    // without these the cpu culled draw path stays in use
+    occlusion_variable = SDL_getenv(CUBE_OCCLUSION_VARIABLE);
+    if ((occlusion_variable != NULL && SDL_atoi(occlusion_variable) == 0) ||
+        graphics->capabilities.draw_indirect_first_instance == VK_FALSE ||
+        graphics->depth_sampled_support == VK_FALSE)
+    {
+        goto done;
+    }
+    if (graphics_util_has_shader(graphics, "cull.spv") == VK_FALSE ||
+        graphics_util_has_shader(graphics, "reduce.spv") == VK_FALSE)
+    {
+        goto done;
+    }
+
+    graphics->occlusion = calloc(1, sizeof(cube_occlusion));
+    CUBE_ASSERT(graphics->occlusion != NULL, "failed to allocate occlusion")
+
+    if (graphics->dynamic_rendering == VK_FALSE)
+    {
+        CUBE_ASSERT(
+            graphics_create_occlusion_render_passes(graphics) == CUBE_SUCCESS,
+            "failed to create occlusion render passes")
+    }
+    CUBE_ASSERT(
+        graphics_create_occlusion_pyramid(graphics) == CUBE_SUCCESS,
+        "failed to create depth pyramid")
+    CUBE_ASSERT(
+        graphics_create_occlusion_buffers(graphics) == CUBE_SUCCESS,
+        "failed to create occlusion buffers")
+    CUBE_ASSERT(
+        graphics_create_occlusion_pipelines(graphics) == CUBE_SUCCESS,
+        "failed to create occlusion pipelines")
+    CUBE_ASSERT(
+        graphics_create_occlusion_descriptor_sets(graphics) == CUBE_SUCCESS,
+        "failed to create occlusion descriptor sets")
+    CUBE_END_FUNCTION
+}
+
+// two phases: redraw last frame's visible set, build the pyramid from that
+// depth, then draw whatever the pyramid shows was wrongly left out
+void graphics_render_occlusion_frame(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    const cube_mat4 *view_projection)
+{
+    cube_occlusion *occlusion;
+    cube_occlusion_constants constants;
+
+    occlusion = graphics->occlusion;
+    SDL_memcpy(
+        occlusion->candidate_mapping,
+        graphics->visible_instances,
+        graphics->visible_count * sizeof(uint32_t));
+    SDL_memcpy(&constants.view_projection[0][0], &view_projection->m[0][0], sizeof(constants.view_projection));
+    constants.pyramid_size[0] = (float)occlusion->pyramid_size.width;
+    constants.pyramid_size[1] = (float)occlusion->pyramid_size.height;
+    constants.candidate_count = graphics->visible_count;
+    constants.index_count = graphics->object->index_count;
+
+    graphics_render_occlusion_cull(graphics, frame, &constants, CUBE_OCCLUSION_PHASE_EARLY);
+    graphics_render_occlusion_begin_phase(graphics, frame, CUBE_OCCLUSION_PHASE_EARLY);
+    graphics_render_record_state(graphics, frame, frame->command_buffer);
+    graphics_render_occlusion_draws(graphics, frame, occlusion->early_draw_buffer);
+    graphics_render_occlusion_end_phase(graphics, frame, CUBE_OCCLUSION_PHASE_EARLY);
+
+    graphics_render_occlusion_pyramid(graphics, frame);
+
+    graphics_render_occlusion_cull(graphics, frame, &constants, CUBE_OCCLUSION_PHASE_LATE);
+    graphics_render_occlusion_begin_phase(graphics, frame, CUBE_OCCLUSION_PHASE_LATE);
+    graphics_render_record_state(graphics, frame, frame->command_buffer);
+    graphics_render_occlusion_draws(graphics, frame, occlusion->late_draw_buffer);
+    graphics_render_occlusion_end_phase(graphics, frame, CUBE_OCCLUSION_PHASE_LATE);
+}
+
+// the early phase clears and leaves depth for the pyramid, the late phase loads both
+void graphics_render_occlusion_begin_phase(cube_graphics *graphics, cube_frame *frame, uint32_t phase)
+{
+    if (graphics->dynamic_rendering == VK_FALSE)
+    {
+        graphics_render_begin_pass(
+            graphics,
+            frame,
+            (phase == CUBE_OCCLUSION_PHASE_EARLY) ? graphics->occlusion->early_render_pass : graphics->occlusion->late_render_pass,
+            VK_SUBPASS_CONTENTS_INLINE);
+        return;
+    }
+    if (phase == CUBE_OCCLUSION_PHASE_EARLY)
+    {
+        graphics_render_acquire_attachments(graphics, frame);
+    }
+    else
+    {
+        graphics_render_attachment_barrier(
+            graphics,
+            frame,
+            &graphics_occlusion_load_color_barrier,
+            &graphics_occlusion_load_depth_barrier);
+    }
+    graphics_render_begin_rendering(
+        graphics,
+        frame,
+        (phase == CUBE_OCCLUSION_PHASE_EARLY) ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD,
+        VK_ATTACHMENT_STORE_OP_STORE,
+        0);
+}
+
+void graphics_render_occlusion_end_phase(cube_graphics *graphics, cube_frame *frame, uint32_t phase)
+{
+    if (graphics->dynamic_rendering == VK_FALSE)
+    {
+        vkCmdEndRenderPass(frame->command_buffer);
+        return;
+    }
+    vkCmdEndRendering(frame->command_buffer);
+    if (phase == CUBE_OCCLUSION_PHASE_EARLY)
+    {
+        graphics_render_attachment_barrier(graphics, frame, NULL, &graphics_occlusion_sample_depth_barrier);
+    }
+    else
+    {
+        graphics_render_present_attachment(graphics, frame);
+    }
+}
+
+void graphics_destroy_occlusion(cube_graphics *graphics)
+{
+    cube_occlusion *occlusion;
+    uint32_t level;
+
+    occlusion = graphics->occlusion;
+    if (occlusion == NULL)
+    {
+        return;
+    }
+    if (occlusion->descriptor_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(graphics->logical_device, occlusion->descriptor_pool, NULL);
+    }
+    free(occlusion->reduce_sets);
+    if (occlusion->cull_pipeline != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(graphics->logical_device, occlusion->cull_pipeline, NULL);
+    }
+    if (occlusion->reduce_pipeline != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(graphics->logical_device, occlusion->reduce_pipeline, NULL);
+    }
+    if (occlusion->cull_pipeline_layout != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineLayout(graphics->logical_device, occlusion->cull_pipeline_layout, NULL);
+    }
+    if (occlusion->reduce_pipeline_layout != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineLayout(graphics->logical_device, occlusion->reduce_pipeline_layout, NULL);
+    }
+    if (occlusion->cull_set_layout != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorSetLayout(graphics->logical_device, occlusion->cull_set_layout, NULL);
+    }
+    if (occlusion->reduce_set_layout != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorSetLayout(graphics->logical_device, occlusion->reduce_set_layout, NULL);
+    }
+    if (occlusion->bounds_buffer != VK_NULL_HANDLE)
+    {
+        vmaDestroyBuffer(graphics->allocator, occlusion->bounds_buffer, occlusion->bounds_allocation);
+    }
+    if (occlusion->candidate_buffer != VK_NULL_HANDLE)
+    {
+        vmaDestroyBuffer(graphics->allocator, occlusion->candidate_buffer, occlusion->candidate_allocation);
+    }
+    if (occlusion->visibility_buffer != VK_NULL_HANDLE)
+    {
+        vmaDestroyBuffer(graphics->allocator, occlusion->visibility_buffer, occlusion->visibility_allocation);
+    }
+    if (occlusion->early_draw_buffer != VK_NULL_HANDLE)
+    {
+        vmaDestroyBuffer(graphics->allocator, occlusion->early_draw_buffer, occlusion->early_draw_allocation);
+    }
+    if (occlusion->late_draw_buffer != VK_NULL_HANDLE)
+    {
+        vmaDestroyBuffer(graphics->allocator, occlusion->late_draw_buffer, occlusion->late_draw_allocation);
+    }
+    if (occlusion->pyramid_level_views != NULL)
+    {
+        for (level = 0; level < occlusion->pyramid_levels; level++)
+        {
+            if (*(occlusion->pyramid_level_views + level) != VK_NULL_HANDLE)
+            {
+                vkDestroyImageView(graphics->logical_device, *(occlusion->pyramid_level_views + level), NULL);
+            }
+        }
+        free(occlusion->pyramid_level_views);
+    }
+    if (occlusion->pyramid_view != VK_NULL_HANDLE)
+    {
+        vkDestroyImageView(graphics->logical_device, occlusion->pyramid_view, NULL);
+    }
+    if (occlusion->pyramid != VK_NULL_HANDLE)
+    {
+        vmaDestroyImage(graphics->allocator, occlusion->pyramid, occlusion->pyramid_allocation);
+    }
+    if (occlusion->depth_view != VK_NULL_HANDLE)
+    {
+        vkDestroyImageView(graphics->logical_device, occlusion->depth_view, NULL);
+    }
+    if (occlusion->sampler != VK_NULL_HANDLE)
+    {
+        vkDestroySampler(graphics->logical_device, occlusion->sampler, NULL);
+    }
+    if (occlusion->early_render_pass != VK_NULL_HANDLE)
+    {
+        vkDestroyRenderPass(graphics->logical_device, occlusion->early_render_pass, NULL);
+    }
+    if (occlusion->late_render_pass != VK_NULL_HANDLE)
+    {
+        vkDestroyRenderPass(graphics->logical_device, occlusion->late_render_pass, NULL);
+    }
+    free(occlusion);
+    graphics->occlusion = NULL;
+}
+
+int graphics_create_occlusion_render_passes(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    const VkSubpassDependency early_dependencies[] = {
+        {
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = 0,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            .srcAccessMask = 0,
+            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT,
+        },
+        // the pyramid reduction samples the depth written here
+        {
+            .srcSubpass = 0,
+            .dstSubpass = VK_SUBPASS_EXTERNAL,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT,
+            .dependencyFlags = 0,
+        },
+    };
+    const VkSubpassDependency late_dependencies[] = {
+        {
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = 0,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dependencyFlags = 0,
+        },
+    };
+    CUBE_ASSERT(
+        graphics_create_occlusion_render_pass(
+            graphics,
+            VK_ATTACHMENT_LOAD_OP_CLEAR,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            &early_dependencies[0],
+            sizeof(early_dependencies) / sizeof(early_dependencies[0]),
+            &graphics->occlusion->early_render_pass) == CUBE_SUCCESS,
+        "failed to create early render pass")
+    CUBE_ASSERT(
+        graphics_create_occlusion_render_pass(
+            graphics,
+            VK_ATTACHMENT_LOAD_OP_LOAD,
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            &late_dependencies[0],
+            sizeof(late_dependencies) / sizeof(late_dependencies[0]),
+            &graphics->occlusion->late_render_pass) == CUBE_SUCCESS,
+        "failed to create late render pass")
+    CUBE_END_FUNCTION
+}
+
+// same attachments as the main render pass, so its pipeline and framebuffers stay compatible
+int graphics_create_occlusion_render_pass(
+    cube_graphics *graphics,
+    VkAttachmentLoadOp load_op,
+    VkImageLayout color_initial_layout,
+    VkImageLayout color_final_layout,
+    VkImageLayout depth_initial_layout,
+    VkImageLayout depth_final_layout,
+    const VkSubpassDependency *dependencies,
+    uint32_t dependency_count,
+    VkRenderPass *render_pass)
+{
+    CUBE_BEGIN_FUNCTION
+    const VkAttachmentDescription attachments[] = {
+        {
+            .format = graphics->surface_format.format,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = load_op,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = color_initial_layout,
+            .finalLayout = color_final_layout,
+        },
+        {
+            .format = graphics->depth_format,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = load_op,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = depth_initial_layout,
+            .finalLayout = depth_final_layout,
+        },
+    };
+    const VkAttachmentReference color_reference = {
+        .attachment = 0,
+        .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+    };
+    const VkAttachmentReference depth_reference = {
+        .attachment = 1,
+        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+    };
+    const VkSubpassDescription subpass_description = {
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &color_reference,
+        .pDepthStencilAttachment = &depth_reference,
+    };
+    const VkRenderPassCreateInfo render_pass_create_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+        .attachmentCount = sizeof(attachments) / sizeof(attachments[0]),
+        .pAttachments = &attachments[0],
+        .subpassCount = 1,
+        .pSubpasses = &subpass_description,
+        .dependencyCount = dependency_count,
+        .pDependencies = dependencies,
+    };
+    VK_CHECK_RESULT(
+        vkCreateRenderPass(
+            graphics->logical_device,
+            &render_pass_create_info,
+            NULL,
+            render_pass))
+    CUBE_END_FUNCTION
+}
+
+int graphics_create_occlusion_pyramid(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_occlusion *occlusion;
+    uint32_t level;
+    const VkSamplerCreateInfo sampler_create_info = {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_NEAREST,
+        .minFilter = VK_FILTER_NEAREST,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .minLod = 0.0f,
+        .maxLod = VK_LOD_CLAMP_NONE,
+    };
+    const VkImageViewCreateInfo depth_view_create_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = graphics->depth_image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = graphics->depth_format,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    };
+    VkImageCreateInfo pyramid_create_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = VK_FORMAT_R32_SFLOAT,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    const VmaAllocationCreateInfo pyramid_allocation_create_info = {
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+    };
+    VkImageViewCreateInfo pyramid_view_create_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = VK_FORMAT_R32_SFLOAT,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    };
+
+    occlusion = graphics->occlusion;
+    VK_CHECK_RESULT(
+        vkCreateSampler(
+            graphics->logical_device,
+            &sampler_create_info,
+            NULL,
+            &occlusion->sampler))
+    VK_CHECK_RESULT(
+        vkCreateImageView(
+            graphics->logical_device,
+            &depth_view_create_info,
+            NULL,
+            &occlusion->depth_view))
+
+    // power of two levels keep every reduction step an exact halving
+    occlusion->pyramid_size.width = 1;
+    while (occlusion->pyramid_size.width * 2 <= graphics->display_size.width)
+    {
+        occlusion->pyramid_size.width *= 2;
+    }
+    occlusion->pyramid_size.height = 1;
+    while (occlusion->pyramid_size.height * 2 <= graphics->display_size.height)
+    {
+        occlusion->pyramid_size.height *= 2;
+    }
+    occlusion->pyramid_levels = 1;
+    while ((SDL_max(occlusion->pyramid_size.width, occlusion->pyramid_size.height) >> occlusion->pyramid_levels) > 0)
+    {
+        occlusion->pyramid_levels++;
+    }
+
+    pyramid_create_info.extent.width = occlusion->pyramid_size.width;
+    pyramid_create_info.extent.height = occlusion->pyramid_size.height;
+    pyramid_create_info.extent.depth = 1;
+    pyramid_create_info.mipLevels = occlusion->pyramid_levels;
+    VK_CHECK_RESULT(
+        vmaCreateImage(
+            graphics->allocator,
+            &pyramid_create_info,
+            &pyramid_allocation_create_info,
+            &occlusion->pyramid,
+            &occlusion->pyramid_allocation,
+            NULL))
+
+    pyramid_view_create_info.image = occlusion->pyramid;
+    pyramid_view_create_info.subresourceRange.baseMipLevel = 0;
+    pyramid_view_create_info.subresourceRange.levelCount = occlusion->pyramid_levels;
+    VK_CHECK_RESULT(
+        vkCreateImageView(
+            graphics->logical_device,
+            &pyramid_view_create_info,
+            NULL,
+            &occlusion->pyramid_view))
+
+    occlusion->pyramid_level_views = calloc(occlusion->pyramid_levels, sizeof(VkImageView));
+    CUBE_ASSERT(occlusion->pyramid_level_views != NULL, "failed to allocate pyramid views")
+    for (level = 0; level < occlusion->pyramid_levels; level++)
+    {
+        pyramid_view_create_info.subresourceRange.baseMipLevel = level;
+        pyramid_view_create_info.subresourceRange.levelCount = 1;
+        VK_CHECK_RESULT(
+            vkCreateImageView(
+                graphics->logical_device,
+                &pyramid_view_create_info,
+                NULL,
+                occlusion->pyramid_level_views + level))
+    }
+    CUBE_END_FUNCTION
+}
+
+int graphics_create_occlusion_buffers(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_occlusion *occlusion;
+    float(*bounds)[4];
+    uint32_t *visibility;
+    uint32_t index;
+    const VkBufferCreateInfo candidate_buffer_create_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = graphics->instance_count * sizeof(uint32_t),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    const VkBufferCreateInfo draw_buffer_create_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = graphics->instance_count * sizeof(VkDrawIndexedIndirectCommand),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    // the candidates are written every frame without a flush
+    const VmaAllocationCreateInfo candidate_allocation_create_info = {
+        .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .requiredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+    };
+    const VmaAllocationCreateInfo draw_allocation_create_info = {
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+    };
+    VmaAllocationInfo candidate_allocation_info;
+
+    occlusion = graphics->occlusion;
+    bounds = CUBE_CALLOC(graphics->instance_count, sizeof(float[4]));
+    CUBE_ASSERT(bounds != NULL, "failed to allocate instance bounds")
+    for (index = 0; index < graphics->instance_count; index++)
+    {
+        graphics_transforms_sphere(graphics->transforms, index, *(bounds + index));
+    }
+    CUBE_ASSERT(
+        graphics_util_upload_buffer(
+            graphics,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            bounds,
+            graphics->instance_count * sizeof(float[4]),
+            &occlusion->bounds_buffer,
+            &occlusion->bounds_allocation) == CUBE_SUCCESS,
+        "failed to upload instance bounds")
+
+    // nothing counts as visible before the first frame
+    visibility = CUBE_CALLOC(graphics->instance_count, sizeof(uint32_t));
+    CUBE_ASSERT(visibility != NULL, "failed to allocate visibility")
+    CUBE_ASSERT(
+        graphics_util_upload_buffer(
+            graphics,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            visibility,
+            graphics->instance_count * sizeof(uint32_t),
+            &occlusion->visibility_buffer,
+            &occlusion->visibility_allocation) == CUBE_SUCCESS,
+        "failed to upload visibility")
+
+    VK_CHECK_RESULT(
+        vmaCreateBuffer(
+            graphics->allocator,
+            &candidate_buffer_create_info,
+            &candidate_allocation_create_info,
+            &occlusion->candidate_buffer,
+            &occlusion->candidate_allocation,
+            &candidate_allocation_info))
+    occlusion->candidate_mapping = candidate_allocation_info.pMappedData;
+    VK_CHECK_RESULT(
+        vmaCreateBuffer(
+            graphics->allocator,
+            &draw_buffer_create_info,
+            &draw_allocation_create_info,
+            &occlusion->early_draw_buffer,
+            &occlusion->early_draw_allocation,
+            NULL))
+    VK_CHECK_RESULT(
+        vmaCreateBuffer(
+            graphics->allocator,
+            &draw_buffer_create_info,
+            &draw_allocation_create_info,
+            &occlusion->late_draw_buffer,
+            &occlusion->late_draw_allocation,
+            NULL))
+    CUBE_END_FUNCTION
+}
+
+int graphics_create_occlusion_pipelines(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    const VkDescriptorSetLayoutBinding cull_bindings[] = {
+        {.binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
+        {.binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
+        {.binding = 2, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
+        {.binding = 3, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
+        {.binding = 4, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
+        {.binding = 5, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
+    };
+    const VkDescriptorSetLayoutBinding reduce_bindings[] = {
+        {.binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
+        {.binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
+    };
+    CUBE_ASSERT(
+        graphics_create_occlusion_pipeline(
+            graphics,
+            "cull.spv",
+            &cull_bindings[0],
+            sizeof(cull_bindings) / sizeof(cull_bindings[0]),
+            sizeof(cube_occlusion_constants),
+            &graphics->occlusion->cull_set_layout,
+            &graphics->occlusion->cull_pipeline_layout,
+            &graphics->occlusion->cull_pipeline) == CUBE_SUCCESS,
+        "failed to create cull pipeline")
+    CUBE_ASSERT(
+        graphics_create_occlusion_pipeline(
+            graphics,
+            "reduce.spv",
+            &reduce_bindings[0],
+            sizeof(reduce_bindings) / sizeof(reduce_bindings[0]),
+            sizeof(cube_reduce_constants),
+            &graphics->occlusion->reduce_set_layout,
+            &graphics->occlusion->reduce_pipeline_layout,
+            &graphics->occlusion->reduce_pipeline) == CUBE_SUCCESS,
+        "failed to create reduce pipeline")
+    CUBE_END_FUNCTION
+}
+
+int graphics_create_occlusion_pipeline(
+    cube_graphics *graphics,
+    const char *shader_file,
+    const VkDescriptorSetLayoutBinding *bindings,
+    uint32_t binding_count,
+    uint32_t constants_size,
+    VkDescriptorSetLayout *set_layout,
+    VkPipelineLayout *pipeline_layout,
+    VkPipeline *pipeline)
+{
+    CUBE_BEGIN_FUNCTION
+    VkShaderModule shader;
+    const VkDescriptorSetLayoutCreateInfo set_layout_create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = binding_count,
+        .pBindings = bindings,
+    };
+    const VkPushConstantRange push_constant_range = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = constants_size,
+    };
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &push_constant_range,
+    };
+    VkComputePipelineCreateInfo pipeline_create_info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pName = "main",
+        },
+    };
+
+    CUBE_ASSERT(
+        graphics_util_load_shader(
+            graphics,
+            shader_file,
+            &shader) == CUBE_SUCCESS,
+        "failed to load compute shader")
+    VK_CHECK_RESULT(
+        vkCreateDescriptorSetLayout(
+            graphics->logical_device,
+            &set_layout_create_info,
+            NULL,
+            set_layout))
+    pipeline_layout_create_info.pSetLayouts = set_layout;
+    VK_CHECK_RESULT(
+        vkCreatePipelineLayout(
+            graphics->logical_device,
+            &pipeline_layout_create_info,
+            NULL,
+            pipeline_layout))
+    pipeline_create_info.stage.module = shader;
+    pipeline_create_info.layout = *pipeline_layout;
+    vk_result = vkCreateComputePipelines(
+        graphics->logical_device,
+        graphics->pipeline_cache,
+        1,
+        &pipeline_create_info,
+        NULL,
+        pipeline);
+    vkDestroyShaderModule(graphics->logical_device, shader, NULL);
+    CUBE_ASSERT(vk_result == VK_SUCCESS, "failed to create compute pipeline")
+    CUBE_END_FUNCTION
+}
+
+int graphics_create_occlusion_descriptor_sets(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_occlusion *occlusion;
+    VkDescriptorSetLayout *set_layouts;
+    uint32_t level;
+    const VkDescriptorPoolSize pool_sizes[] = {
+        {.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 5},
+        {.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = graphics->occlusion->pyramid_levels + 1},
+        {.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .descriptorCount = graphics->occlusion->pyramid_levels},
+    };
+    const VkDescriptorPoolCreateInfo pool_create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = graphics->occlusion->pyramid_levels + 1,
+        .poolSizeCount = sizeof(pool_sizes) / sizeof(pool_sizes[0]),
+        .pPoolSizes = &pool_sizes[0],
+    };
+    VkDescriptorSetAllocateInfo set_allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+    };
+    VkDescriptorBufferInfo buffer_infos[5];
+    VkDescriptorImageInfo image_infos[2];
+    VkWriteDescriptorSet writes[6];
+    uint32_t write_index;
+
+    occlusion = graphics->occlusion;
+    VK_CHECK_RESULT(
+        vkCreateDescriptorPool(
+            graphics->logical_device,
+            &pool_create_info,
+            NULL,
+            &occlusion->descriptor_pool))
+
+    set_allocate_info.descriptorPool = occlusion->descriptor_pool;
+    set_allocate_info.descriptorSetCount = 1;
+    set_allocate_info.pSetLayouts = &occlusion->cull_set_layout;
+    VK_CHECK_RESULT(
+        vkAllocateDescriptorSets(
+            graphics->logical_device,
+            &set_allocate_info,
+            &occlusion->cull_set))
+
+    buffer_infos[0] = (VkDescriptorBufferInfo){occlusion->bounds_buffer, 0, VK_WHOLE_SIZE};
+    buffer_infos[1] = (VkDescriptorBufferInfo){occlusion->candidate_buffer, 0, VK_WHOLE_SIZE};
+    buffer_infos[2] = (VkDescriptorBufferInfo){occlusion->visibility_buffer, 0, VK_WHOLE_SIZE};
+    buffer_infos[3] = (VkDescriptorBufferInfo){occlusion->early_draw_buffer, 0, VK_WHOLE_SIZE};
+    buffer_infos[4] = (VkDescriptorBufferInfo){occlusion->late_draw_buffer, 0, VK_WHOLE_SIZE};
+    for (write_index = 0; write_index < 5; write_index++)
+    {
+        writes[write_index] = (VkWriteDescriptorSet){
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = occlusion->cull_set,
+            .dstBinding = write_index,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &buffer_infos[write_index],
+        };
+    }
+    image_infos[0] = (VkDescriptorImageInfo){occlusion->sampler, occlusion->pyramid_view, VK_IMAGE_LAYOUT_GENERAL};
+    writes[5] = (VkWriteDescriptorSet){
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = occlusion->cull_set,
+        .dstBinding = 5,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImageInfo = &image_infos[0],
+    };
+    vkUpdateDescriptorSets(graphics->logical_device, 6, &writes[0], 0, NULL);
+
+    // level n reads level n - 1, level 0 reads the depth attachment
+    occlusion->reduce_sets = calloc(occlusion->pyramid_levels, sizeof(VkDescriptorSet));
+    CUBE_ASSERT(occlusion->reduce_sets != NULL, "failed to allocate reduce sets")
+    set_layouts = CUBE_CALLOC(occlusion->pyramid_levels, sizeof(VkDescriptorSetLayout));
+    CUBE_ASSERT(set_layouts != NULL, "failed to allocate reduce set layouts")
+    for (level = 0; level < occlusion->pyramid_levels; level++)
+    {
+        *(set_layouts + level) = occlusion->reduce_set_layout;
+    }
+    set_allocate_info.descriptorSetCount = occlusion->pyramid_levels;
+    set_allocate_info.pSetLayouts = set_layouts;
+    VK_CHECK_RESULT(
+        vkAllocateDescriptorSets(
+            graphics->logical_device,
+            &set_allocate_info,
+            occlusion->reduce_sets))
+    for (level = 0; level < occlusion->pyramid_levels; level++)
+    {
+        image_infos[0] = (level == 0)
+                             ? (VkDescriptorImageInfo){occlusion->sampler, occlusion->depth_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL}
+                             : (VkDescriptorImageInfo){occlusion->sampler, *(occlusion->pyramid_level_views + level - 1), VK_IMAGE_LAYOUT_GENERAL};
+        image_infos[1] = (VkDescriptorImageInfo){VK_NULL_HANDLE, *(occlusion->pyramid_level_views + level), VK_IMAGE_LAYOUT_GENERAL};
+        writes[0] = (VkWriteDescriptorSet){
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = *(occlusion->reduce_sets + level),
+            .dstBinding = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo = &image_infos[0],
+        };
+        writes[1] = (VkWriteDescriptorSet){
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = *(occlusion->reduce_sets + level),
+            .dstBinding = 1,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .pImageInfo = &image_infos[1],
+        };
+        vkUpdateDescriptorSets(graphics->logical_device, 2, &writes[0], 0, NULL);
+    }
+    CUBE_END_FUNCTION
+}
+
+void graphics_render_occlusion_cull(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    cube_occlusion_constants *constants,
+    uint32_t phase)
+{
+    cube_occlusion *occlusion;
+    const VkMemoryBarrier before_barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+    };
+    const VkMemoryBarrier after_barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+    };
+
+    occlusion = graphics->occlusion;
+    constants->phase = phase;
+    vkCmdPipelineBarrier(
+        frame->command_buffer,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &before_barrier,
+        0, NULL,
+        0, NULL);
+    vkCmdBindPipeline(
+        frame->command_buffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        occlusion->cull_pipeline);
+    vkCmdBindDescriptorSets(
+        frame->command_buffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        occlusion->cull_pipeline_layout,
+        0, 1,
+        &occlusion->cull_set,
+        0, NULL);
+    vkCmdPushConstants(
+        frame->command_buffer,
+        occlusion->cull_pipeline_layout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(cube_occlusion_constants),
+        constants);
+    vkCmdDispatch(
+        frame->command_buffer,
+        (constants->candidate_count + CUBE_OCCLUSION_CULL_GROUP_SIZE - 1) / CUBE_OCCLUSION_CULL_GROUP_SIZE,
+        1, 1);
+    vkCmdPipelineBarrier(
+        frame->command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        0,
+        1, &after_barrier,
+        0, NULL,
+        0, NULL);
+}
+
+void graphics_render_occlusion_pyramid(cube_graphics *graphics, cube_frame *frame)
+{
+    cube_occlusion *occlusion;
+    cube_reduce_constants constants;
+    uint32_t level;
+    VkImageMemoryBarrier pyramid_barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    };
+
+    occlusion = graphics->occlusion;
+    pyramid_barrier.image = occlusion->pyramid;
+
+    // last frame's contents are rebuilt entirely
+    pyramid_barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    pyramid_barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    pyramid_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    pyramid_barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    pyramid_barrier.subresourceRange.baseMipLevel = 0;
+    pyramid_barrier.subresourceRange.levelCount = occlusion->pyramid_levels;
+    vkCmdPipelineBarrier(
+        frame->command_buffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0, NULL,
+        0, NULL,
+        1, &pyramid_barrier);
+
+    vkCmdBindPipeline(
+        frame->command_buffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        occlusion->reduce_pipeline);
+    pyramid_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    pyramid_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    pyramid_barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    pyramid_barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    pyramid_barrier.subresourceRange.levelCount = 1;
+    for (level = 0; level < occlusion->pyramid_levels; level++)
+    {
+        constants.source_size[0] = (level == 0) ? graphics->display_size.width : SDL_max(occlusion->pyramid_size.width >> (level - 1), 1);
+        constants.source_size[1] = (level == 0) ? graphics->display_size.height : SDL_max(occlusion->pyramid_size.height >> (level - 1), 1);
+        constants.target_size[0] = SDL_max(occlusion->pyramid_size.width >> level, 1);
+        constants.target_size[1] = SDL_max(occlusion->pyramid_size.height >> level, 1);
+        vkCmdBindDescriptorSets(
+            frame->command_buffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            occlusion->reduce_pipeline_layout,
+            0, 1,
+            occlusion->reduce_sets + level,
+            0, NULL);
+        vkCmdPushConstants(
+            frame->command_buffer,
+            occlusion->reduce_pipeline_layout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(cube_reduce_constants),
+            &constants);
+        vkCmdDispatch(
+            frame->command_buffer,
+            (constants.target_size[0] + CUBE_OCCLUSION_REDUCE_GROUP_SIZE - 1) / CUBE_OCCLUSION_REDUCE_GROUP_SIZE,
+            (constants.target_size[1] + CUBE_OCCLUSION_REDUCE_GROUP_SIZE - 1) / CUBE_OCCLUSION_REDUCE_GROUP_SIZE,
+            1);
+        pyramid_barrier.subresourceRange.baseMipLevel = level;
+        vkCmdPipelineBarrier(
+            frame->command_buffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, NULL,
+            0, NULL,
+            1, &pyramid_barrier);
+    }
+}
+
+void graphics_render_occlusion_draws(cube_graphics *graphics, cube_frame *frame, VkBuffer draw_buffer)
+{
+    uint32_t draw_index;
+
+    if (graphics->capabilities.multi_draw_indirect == VK_TRUE)
+    {
+        vkCmdDrawIndexedIndirect(
+            frame->command_buffer,
+            draw_buffer,
+            0,
+            graphics->visible_count,
+            sizeof(VkDrawIndexedIndirectCommand));
+        return;
+    }
+    // drawCount is limited to one without multiDrawIndirect
+    for (draw_index = 0; draw_index < graphics->visible_count; draw_index++)
+    {
+        vkCmdDrawIndexedIndirect(
+            frame->command_buffer,
+            draw_buffer,
+            draw_index * sizeof(VkDrawIndexedIndirectCommand),
+            1,
+            sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "cube.h"
+
+#define CUBE_PACER_TARGET_FPS_VARIABLE "CUBE_TARGET_FPS"
+#define CUBE_PACER_DEFAULT_FPS 60
+#define CUBE_PACER_CALIBRATION_SAMPLES 8
+#define CUBE_PACER_MARGIN_MICROSECONDS 500
+#define CUBE_PACER_PRESENT_TIMEOUT 100000000ULL
+
+static void graphics_pacer_calibrate(cube_pacer *pacer);
+static void graphics_pacer_sleep_until(cube_pacer *pacer, Uint64 target);
+
+int graphics_create_pacer(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    const char *target_variable;
+    int target_fps;
+
+    graphics->pacer = calloc(1, sizeof(cube_pacer));
+    CUBE_ASSERT(graphics->pacer != NULL, "failed to allocate pacer")
+
+    target_variable = SDL_getenv(CUBE_PACER_TARGET_FPS_VARIABLE);
+    target_fps = (target_variable != NULL) ? SDL_atoi(target_variable) : CUBE_PACER_DEFAULT_FPS;
+
+    graphics->pacer->frequency = SDL_GetPerformanceFrequency();
+    // zero leaves the rate to the presentation engine
+    graphics->pacer->interval = (target_fps > 0) ? graphics->pacer->frequency / (Uint64)target_fps : 0;
+    if (graphics->capabilities.present_wait == VK_TRUE)
+    {
+        graphics->pacer->wait_for_present = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(
+            graphics->logical_device,
+            "vkWaitForPresentKHR");
+    }
+    graphics_pacer_calibrate(graphics->pacer);
+    graphics->pacer->deadline = SDL_GetPerformanceCounter() + graphics->pacer->interval;
+    CUBE_END_FUNCTION
+}
+
+// called before acquire: keep at most one frame queued, then start as late as the deadline allows
+void graphics_render_pace_frame(cube_graphics *graphics)
+{
+    cube_pacer *pacer;
+    Uint64 margin;
+    Uint64 lead;
+    VkResult result;
+
+    pacer = graphics->pacer;
+    if (pacer->wait_for_present != NULL && pacer->present_id > 0)
+    {
+        result = pacer->wait_for_present(
+            graphics->logical_device,
+            graphics->swapchain,
+            pacer->present_id,
+            CUBE_PACER_PRESENT_TIMEOUT);
+        // a hidden or minimized window may never present, the timeout then keeps the old deadline
+        if (result == VK_SUCCESS)
+        {
+            // the previous frame just reached the display, the next is due one interval later
+            pacer->deadline = SDL_GetPerformanceCounter() + pacer->interval;
+        }
+    }
+    if (pacer->interval > 0)
+    {
+        margin = (pacer->frequency * CUBE_PACER_MARGIN_MICROSECONDS) / 1000000;
+        lead = pacer->work_estimate + margin;
+        if (pacer->deadline > lead)
+        {
+            graphics_pacer_sleep_until(pacer, pacer->deadline - lead);
+        }
+    }
+    pacer->frame_start = SDL_GetPerformanceCounter();
+}
+
+uint64_t graphics_render_next_present_id(cube_graphics *graphics)
+{
+    return ++graphics->pacer->present_id;
+}
+
+// called once the present is queued
+void graphics_render_paced_frame(cube_graphics *graphics)
+{
+    cube_pacer *pacer;
+    Uint64 now;
+    Uint64 work;
+
+    pacer = graphics->pacer;
+    now = SDL_GetPerformanceCounter();
+    work = now - pacer->frame_start;
+
+    // grow at once on a slow frame, shrink slowly so one fast frame does not cause a miss
+    if (work > pacer->work_estimate)
+    {
+        pacer->work_estimate = work;
+    }
+    else
+    {
+        pacer->work_estimate -= (pacer->work_estimate - work) / 16;
+    }
+
+    pacer->deadline += pacer->interval;
+    if (pacer->deadline < now)
+    {
+        pacer->deadline = now + pacer->interval;
+    }
+}
+
+void graphics_destroy_pacer(cube_graphics *graphics)
+{
+    free(graphics->pacer);
+    graphics->pacer = NULL;
+}
+
+void graphics_pacer_calibrate(cube_pacer *pacer)
+{
+    Uint64 requested;
+    Uint64 before;
+    Uint64 elapsed;
+    uint32_t sample;
+
+    requested = pacer->frequency / 1000;
+    pacer->sleep_slack = 0;
+    for (sample = 0; sample < CUBE_PACER_CALIBRATION_SAMPLES; sample++)
+    {
+        before = SDL_GetPerformanceCounter();
+        SDL_Delay(1);
+        elapsed = SDL_GetPerformanceCounter() - before;
+        if (elapsed > requested)
+        {
+            pacer->sleep_slack = SDL_max(pacer->sleep_slack, elapsed - requested);
+        }
+    }
+}
+
+// sleep the bulk of the wait away, spin only across the scheduler's measured oversleep
+void graphics_pacer_sleep_until(cube_pacer *pacer, Uint64 target)
+{
+    Uint64 now;
+    Uint64 millisecond;
+    Uint64 requested;
+    Uint64 elapsed;
+
+    millisecond = pacer->frequency / 1000;
+    now = SDL_GetPerformanceCounter();
+    while (now < target && target - now > pacer->sleep_slack + millisecond)
+    {
+        requested = ((target - now - pacer->sleep_slack) / millisecond) * millisecond;
+        SDL_Delay((Uint32)(requested / millisecond));
+        elapsed = SDL_GetPerformanceCounter() - now;
+        // a single bad wake up should not make every later frame spin
+        pacer->sleep_slack -= pacer->sleep_slack / 32;
+        if (elapsed > requested)
+        {
+            pacer->sleep_slack = SDL_max(pacer->sleep_slack, elapsed - requested);
+        }
+        now += elapsed;
+    }
+    while (now < target)
+    {
+#if defined(CUBE_SSE2)
+        _mm_pause();
+#endif
+        now = SDL_GetPerformanceCounter();
+    }
+}
\ No newline at end of file
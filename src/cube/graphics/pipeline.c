@@ -6,9 +6,13 @@ static int graphics_create_graphics_pipeline(cube_graphics *graphics);
 int graphics_create_pipeline(cube_graphics *graphics)
 {
     CUBE_BEGIN_FUNCTION
-    CUBE_ASSERT(
-        graphics_create_render_pass(graphics) == CUBE_SUCCESS,
-        "failed to create render pass")
+    // dynamic rendering names its attachments per pass instead
+    if (graphics->dynamic_rendering == VK_FALSE)
+    {
+        CUBE_ASSERT(
+            graphics_create_render_pass(graphics) == CUBE_SUCCESS,
+            "failed to create render pass")
+    }
     CUBE_ASSERT(
         graphics_create_graphics_pipeline(graphics) == CUBE_SUCCESS,
         "failed to create render pass")
@@ -29,6 +33,10 @@ void graphics_destroy_pipeline(cube_graphics *graphics)
     {
         vkDestroyRenderPass(graphics->logical_device, graphics->render_pass, NULL);
     }
+    if (graphics->pipeline_cache != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineCache(graphics->logical_device, graphics->pipeline_cache, NULL);
+    }
 }
 
 int graphics_create_render_pass(cube_graphics *graphics)
@@ -105,13 +113,116 @@ int graphics_create_render_pass(cube_graphics *graphics)
 int graphics_create_graphics_pipeline(cube_graphics *graphics)
 {
     CUBE_BEGIN_FUNCTION
+    const VkPipelineCacheCreateInfo pipeline_cache_create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+    };
     VkShaderModule vertex_shader;
     VkShaderModule fragment_shader;
-
-    VkVertexInputBindingDescription vertex_input_binding_descritpion = {
+    VkDescriptorSetLayoutBinding descriptor_set_layout_binding = {
         .binding = 0,
-        .stride = sizeof(cube_vertex),
-        .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+    };
+    VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = 1,
+        .pBindings = &descriptor_set_layout_binding,
+    };
+    const VkPushConstantRange push_constant_range = {
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        .offset = 0,
+        .size = sizeof(cube_bindless_constants),
+    };
+    VkDescriptorSetLayout set_layouts[2];
+    VkPipelineLayoutCreateInfo pipeline_layout_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 0,
+        .setLayoutCount = 1,
+        .pSetLayouts = &set_layouts[0],
+    };
+    const char *vertex_shader_file;
+    const char *fragment_shader_file;
+
+    VK_CHECK_RESULT(
+        vkCreatePipelineCache(
+            graphics->logical_device,
+            &pipeline_cache_create_info,
+            NULL,
+            &graphics->pipeline_cache))
+
+    VK_CHECK_RESULT(
+        vkCreateDescriptorSetLayout(
+            graphics->logical_device,
+            &descriptor_set_layout_create_info,
+            NULL,
+            &graphics->descriptor_set_layout))
+
+    // the bindless set follows the per-frame set, its slots arrive as push constants
+    set_layouts[0] = graphics->descriptor_set_layout;
+    vertex_shader_file = "vert.spv";
+    fragment_shader_file = "frag.spv";
+    if (graphics->bindless != NULL)
+    {
+        set_layouts[1] = graphics->bindless->descriptor_set_layout;
+        pipeline_layout_info.setLayoutCount = 2;
+        pipeline_layout_info.pushConstantRangeCount = 1;
+        pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+        vertex_shader_file = "bindless_vert.spv";
+        fragment_shader_file = "bindless_frag.spv";
+    }
+
+    VK_CHECK_RESULT(
+        vkCreatePipelineLayout(
+            graphics->logical_device,
+            &pipeline_layout_info,
+            NULL,
+            &graphics->pipeline_layout))
+
+    CUBE_ASSERT(
+        graphics_util_load_shader(
+            graphics, vertex_shader_file,
+            &vertex_shader) == CUBE_SUCCESS,
+        "failed to load vertex shader")
+
+    if (graphics_util_load_shader(
+            graphics, fragment_shader_file,
+            &fragment_shader) != CUBE_SUCCESS)
+    {
+        vkDestroyShaderModule(graphics->logical_device, vertex_shader, NULL);
+        CUBE_ASSERT(SDL_FALSE, "failed to load fragment shader")
+    }
+
+    cube_result = graphics_build_graphics_pipeline(
+        graphics,
+        vertex_shader,
+        fragment_shader,
+        &graphics->graphics_pipeline);
+    vkDestroyShaderModule(graphics->logical_device, fragment_shader, NULL);
+    vkDestroyShaderModule(graphics->logical_device, vertex_shader, NULL);
+    CUBE_ASSERT(cube_result == CUBE_SUCCESS, "failed to build graphics pipeline")
+    CUBE_END_FUNCTION
+}
+
+// safe off the render thread: reads only the layout, render pass or formats, and cache
+int graphics_build_graphics_pipeline(
+    cube_graphics *graphics,
+    VkShaderModule vertex_shader,
+    VkShaderModule fragment_shader,
+    VkPipeline *pipeline)
+{
+    CUBE_BEGIN_FUNCTION
+    VkVertexInputBindingDescription vertex_input_binding_descritpions[] = {
+        {
+            .binding = 0,
+            .stride = sizeof(cube_vertex),
+            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+        },
+        {
+            .binding = 1,
+            .stride = sizeof(float[4][4]),
+            .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE,
+        },
     };
     VkVertexInputAttributeDescription vertex_input_attribute_descritpions[] = {
         {
@@ -126,12 +237,37 @@ int graphics_create_graphics_pipeline(cube_graphics *graphics)
             .format = VK_FORMAT_R32G32B32_SFLOAT,
             .offset = offsetof(cube_vertex, color),
         },
+        // per instance model matrix, one column per location
+        {
+            .binding = 1,
+            .location = 2,
+            .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+            .offset = 0 * sizeof(float[4]),
+        },
+        {
+            .binding = 1,
+            .location = 3,
+            .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+            .offset = 1 * sizeof(float[4]),
+        },
+        {
+            .binding = 1,
+            .location = 4,
+            .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+            .offset = 2 * sizeof(float[4]),
+        },
+        {
+            .binding = 1,
+            .location = 5,
+            .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+            .offset = 3 * sizeof(float[4]),
+        },
     };
     VkPipelineVertexInputStateCreateInfo vertex_input_info = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .vertexBindingDescriptionCount = 1,
-        .pVertexBindingDescriptions = &vertex_input_binding_descritpion,
-        .vertexAttributeDescriptionCount = 2,
+        .vertexBindingDescriptionCount = sizeof(vertex_input_binding_descritpions) / sizeof(vertex_input_binding_descritpions[0]),
+        .pVertexBindingDescriptions = &vertex_input_binding_descritpions[0],
+        .vertexAttributeDescriptionCount = sizeof(vertex_input_attribute_descritpions) / sizeof(vertex_input_attribute_descritpions[0]),
         .pVertexAttributeDescriptions = &vertex_input_attribute_descritpions[0],
     };
     VkPipelineShaderStageCreateInfo shader_stages[] = {
@@ -139,12 +275,14 @@ int graphics_create_graphics_pipeline(cube_graphics *graphics)
         {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
             .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = vertex_shader,
             .pName = "main",
         },
         // fragment shader
         {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
             .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = fragment_shader,
             .pName = "main",
         },
     };
@@ -202,25 +340,16 @@ int graphics_create_graphics_pipeline(cube_graphics *graphics)
         .dynamicStateCount = 2,
         .pDynamicStates = &dynamic_states[0],
     };
-    VkDescriptorSetLayoutBinding descriptor_set_layout_binding = {
-        .binding = 0,
-        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-        .descriptorCount = 1,
-        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
-    };
-    VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = {
-        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-        .bindingCount = 1,
-        .pBindings = &descriptor_set_layout_binding,
-    };
-    VkPipelineLayoutCreateInfo pipeline_layout_info = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .setLayoutCount = 0,
-        .setLayoutCount = 1,
-        .pSetLayouts = &graphics->descriptor_set_layout,
+    const VkPipelineRenderingCreateInfo rendering_create_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &graphics->surface_format.format,
+        .depthAttachmentFormat = graphics->depth_format,
+        .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
     };
     VkGraphicsPipelineCreateInfo pipeline_create_info = {
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = (graphics->dynamic_rendering == VK_TRUE) ? &rendering_create_info : NULL,
         .stageCount = 2,
         .pStages = &shader_stages[0],
         .pVertexInputState = &vertex_input_info,
@@ -231,53 +360,19 @@ int graphics_create_graphics_pipeline(cube_graphics *graphics)
         .pDepthStencilState = &depth_stencil_state_create_info,
         .pColorBlendState = &color_blend_state_info,
         .pDynamicState = &dynamic_state_info,
+        .layout = graphics->pipeline_layout,
         .renderPass = graphics->render_pass,
         .subpass = 0,
         .basePipelineHandle = VK_NULL_HANDLE,
     };
 
-    CUBE_ASSERT(
-        graphics_util_load_shader(
-            graphics, "vert.spv",
-            &vertex_shader) == CUBE_SUCCESS,
-        "failed to load vertex shader")
-
-    shader_stages[0].module = vertex_shader;
-
-    CUBE_ASSERT(
-        graphics_util_load_shader(
-            graphics, "frag.spv",
-            &fragment_shader) == CUBE_SUCCESS,
-        "failed to load fragment shader")
-
-    shader_stages[1].module = fragment_shader;
-
-    VK_CHECK_RESULT(
-        vkCreateDescriptorSetLayout(
-            graphics->logical_device,
-            &descriptor_set_layout_create_info,
-            NULL,
-            &graphics->descriptor_set_layout))
-
-    VK_CHECK_RESULT(
-        vkCreatePipelineLayout(
-            graphics->logical_device,
-            &pipeline_layout_info,
-            NULL,
-            &graphics->pipeline_layout))
-
-    pipeline_create_info.layout = graphics->pipeline_layout;
-
     VK_CHECK_RESULT(
         vkCreateGraphicsPipelines(
             graphics->logical_device,
-            VK_NULL_HANDLE,
+            graphics->pipeline_cache,
             1,
             &pipeline_create_info,
             NULL,
-            &graphics->graphics_pipeline))
-
-    vkDestroyShaderModule(graphics->logical_device, fragment_shader, NULL);
-    vkDestroyShaderModule(graphics->logical_device, vertex_shader, NULL);
+            pipeline))
     CUBE_END_FUNCTION
 }
\ No newline at end of file
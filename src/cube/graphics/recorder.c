@@ -0,0 +1,224 @@
+#include "cube.h"
+
+#define CUBE_RECORDER_THREADS_VARIABLE "CUBE_RECORDER_THREADS"
+
+static int graphics_create_recorder_slice(cube_graphics *graphics, cube_recorder_slice *slice);
+static void graphics_render_record_job(void *data, uint32_t begin, uint32_t end);
+static int graphics_render_record_slice(cube_recorder *recorder, cube_recorder_slice *slice);
+static void graphics_destroy_recorder_slice(cube_graphics *graphics, cube_recorder_slice *slice);
+
+int graphics_create_recorder(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    const char *thread_variable;
+    uint32_t slice_count;
+    uint32_t slice_index;
+
+    graphics->recorder = NULL;
+
+    // the variable now sets how many secondary buffers a frame is split into,
+    // the job workers record them
+    thread_variable = SDL_getenv(CUBE_RECORDER_THREADS_VARIABLE);
+    slice_count = (thread_variable != NULL) ? (uint32_t)SDL_atoi(thread_variable) : 0;
+    slice_count = SDL_min(slice_count, graphics->jobs->worker_count + 1);
+
+    // no slices requested, record inline on the calling thread
+    if (slice_count == 0)
+    {
+        goto done;
+    }
+
+    graphics->recorder = calloc(1, sizeof(cube_recorder));
+    CUBE_ASSERT(graphics->recorder != NULL, "failed to allocate recorder")
+    graphics->recorder->graphics = graphics;
+
+    graphics->recorder->slices = calloc(slice_count, sizeof(cube_recorder_slice));
+    CUBE_ASSERT(graphics->recorder->slices != NULL, "failed to allocate recorder slices")
+
+    graphics->recorder->command_buffers = calloc(slice_count, sizeof(VkCommandBuffer));
+    CUBE_ASSERT(graphics->recorder->command_buffers != NULL, "failed to allocate recorder command buffers")
+
+    SDL_AtomicSet(&graphics->recorder->failures, 0);
+
+    for (slice_index = 0; slice_index < slice_count; slice_index++)
+    {
+        graphics->recorder->slice_count = slice_index + 1;
+        CUBE_ASSERT(
+            graphics_create_recorder_slice(
+                graphics,
+                graphics->recorder->slices + slice_index) == CUBE_SUCCESS,
+            "failed to create recorder slice")
+    }
+    CUBE_END_FUNCTION
+}
+
+int graphics_render_record_frame(cube_graphics *graphics, cube_frame *frame)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_recorder *recorder;
+    cube_recorder_slice *slice;
+    uint32_t slice_index;
+    uint32_t slice_begin;
+    uint32_t slice_end;
+
+    recorder = graphics->recorder;
+    recorder->frame = frame;
+    SDL_AtomicSet(&recorder->failures, 0);
+
+    for (slice_index = 0; slice_index < recorder->slice_count; slice_index++)
+    {
+        slice = recorder->slices + slice_index;
+        slice_begin = (uint32_t)(((uint64_t)graphics->visible_count * slice_index) / recorder->slice_count);
+        slice_end = (uint32_t)(((uint64_t)graphics->visible_count * (slice_index + 1)) / recorder->slice_count);
+        slice->first_visible = slice_begin;
+        slice->visible_count = slice_end - slice_begin;
+    }
+
+    // the render thread records a slice of its own while the workers take the rest
+    application_jobs_parallel_for(
+        graphics->jobs,
+        graphics_render_record_job,
+        recorder,
+        recorder->slice_count,
+        1);
+
+    CUBE_ASSERT(
+        SDL_AtomicGet(&recorder->failures) == 0,
+        "failed to record secondary command buffers")
+
+    for (slice_index = 0; slice_index < recorder->slice_count; slice_index++)
+    {
+        *(recorder->command_buffers + slice_index) = *((recorder->slices + slice_index)->command_buffers + frame->index);
+    }
+
+    vkCmdExecuteCommands(
+        frame->command_buffer,
+        recorder->slice_count,
+        recorder->command_buffers);
+    CUBE_END_FUNCTION
+}
+
+void graphics_destroy_recorder(cube_graphics *graphics)
+{
+    cube_recorder *recorder;
+    uint32_t slice_index;
+
+    recorder = graphics->recorder;
+    if (recorder != NULL)
+    {
+        for (slice_index = 0; slice_index < recorder->slice_count; slice_index++)
+        {
+            graphics_destroy_recorder_slice(graphics, recorder->slices + slice_index);
+        }
+        free(recorder->command_buffers);
+        free(recorder->slices);
+        free(recorder);
+        graphics->recorder = NULL;
+    }
+}
+
+int graphics_create_recorder_slice(cube_graphics *graphics, cube_recorder_slice *slice)
+{
+    CUBE_BEGIN_FUNCTION
+    const VkCommandPoolCreateInfo command_pool_create_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = graphics->graphics_queue_family_index,
+    };
+    VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+        .commandBufferCount = graphics->frame_count,
+    };
+
+    // each slice owns its pool, only one job at a time ever records into it
+    VK_CHECK_RESULT(
+        vkCreateCommandPool(
+            graphics->logical_device,
+            &command_pool_create_info,
+            NULL,
+            &slice->command_pool))
+
+    slice->command_buffers = calloc(graphics->frame_count, sizeof(VkCommandBuffer));
+    CUBE_ASSERT(slice->command_buffers != NULL, "failed to allocate slice command buffers")
+
+    command_buffer_allocate_info.commandPool = slice->command_pool;
+    VK_CHECK_RESULT(
+        vkAllocateCommandBuffers(
+            graphics->logical_device,
+            &command_buffer_allocate_info,
+            slice->command_buffers))
+    CUBE_END_FUNCTION
+}
+
+void graphics_render_record_job(void *data, uint32_t begin, uint32_t end)
+{
+    cube_recorder *recorder;
+    uint32_t slice_index;
+
+    recorder = data;
+    for (slice_index = begin; slice_index < end; slice_index++)
+    {
+        if (graphics_render_record_slice(recorder, recorder->slices + slice_index) != CUBE_SUCCESS)
+        {
+            SDL_AtomicAdd(&recorder->failures, 1);
+        }
+    }
+}
+
+int graphics_render_record_slice(cube_recorder *recorder, cube_recorder_slice *slice)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_graphics *graphics;
+    VkCommandBuffer command_buffer;
+    // under dynamic rendering the secondaries inherit attachment formats instead of a render pass
+    const VkCommandBufferInheritanceRenderingInfo inheritance_rendering_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &recorder->graphics->surface_format.format,
+        .depthAttachmentFormat = recorder->graphics->depth_format,
+        .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+    };
+    const VkCommandBufferInheritanceInfo command_buffer_inheritance_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = (recorder->graphics->dynamic_rendering == VK_TRUE) ? &inheritance_rendering_info : NULL,
+        .renderPass = (recorder->graphics->dynamic_rendering == VK_TRUE) ? VK_NULL_HANDLE : recorder->graphics->render_pass,
+        .subpass = 0,
+        .framebuffer = (recorder->graphics->dynamic_rendering == VK_TRUE) ? VK_NULL_HANDLE : recorder->frame->framebuffer,
+    };
+    const VkCommandBufferBeginInfo command_buffer_begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = &command_buffer_inheritance_info,
+    };
+
+    graphics = recorder->graphics;
+    command_buffer = *(slice->command_buffers + recorder->frame->index);
+
+    VK_CHECK_RESULT(
+        vkResetCommandBuffer(
+            command_buffer,
+            0))
+    VK_CHECK_RESULT(
+        vkBeginCommandBuffer(
+            command_buffer,
+            &command_buffer_begin_info))
+    graphics_render_record_state(graphics, recorder->frame, command_buffer);
+    graphics_render_record_draws(
+        graphics,
+        command_buffer,
+        slice->first_visible,
+        slice->visible_count);
+    VK_CHECK_RESULT(vkEndCommandBuffer(command_buffer))
+    CUBE_END_FUNCTION
+}
+
+void graphics_destroy_recorder_slice(cube_graphics *graphics, cube_recorder_slice *slice)
+{
+    if (slice->command_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(graphics->logical_device, slice->command_pool, NULL);
+    }
+    free(slice->command_buffers);
+}
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "cube.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#define CUBE_RELOAD_VARIABLE "CUBE_SHADER_RELOAD"
+#define CUBE_RELOAD_POLL_MILLISECONDS 100
+#define CUBE_RELOAD_SETTLE_MILLISECONDS 50
+
+// the bindless pipeline reads its own pair
+static const char *const graphics_reload_shaders[2][2] = {
+    {"vert.spv", "frag.spv"},
+    {"bindless_vert.spv", "bindless_frag.spv"},
+};
+
+#ifdef __linux__
+static int graphics_reload_thread(void *data);
+static SDL_bool graphics_reload_changed(cube_graphics *graphics);
+static int graphics_reload_build(cube_graphics *graphics);
+#endif
+
+// development only: off unless CUBE_SHADER_RELOAD is set, and only where inotify exists
+int graphics_create_reload(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    const char *reload_variable;
+#ifdef __linux__
+    const cube_resource *resource;
+    uint32_t resource_index;
+    char *separator;
+#endif
+
+    reload_variable = SDL_getenv(CUBE_RELOAD_VARIABLE);
+    if (reload_variable == NULL || SDL_atoi(reload_variable) == 0)
+    {
+        goto done;
+    }
+#ifdef __linux__
+    graphics->reload = calloc(1, sizeof(cube_reload));
+    CUBE_ASSERT(graphics->reload != NULL, "failed to allocate reload")
+    graphics->reload->watch = -1;
+
+    // watch the directory rather than the files, compilers replace them
+    CUBE_ASSERT(
+        application_resources_find(
+            graphics->resources,
+            CUBE_RESOURCE_SHADER,
+            graphics_reload_shaders[graphics->bindless != NULL][0],
+            &resource_index) == CUBE_SUCCESS,
+        "failed to find reloaded shader")
+    resource = graphics->resources->resources + resource_index;
+    graphics->reload->directory = SDL_strdup(resource->path);
+    CUBE_ASSERT(graphics->reload->directory != NULL, "failed to allocate reload directory")
+    separator = SDL_strrchr(graphics->reload->directory, *PATH_SEPARATOR);
+    CUBE_ASSERT(separator != NULL, "invalid shader path")
+    *separator = '\0';
+
+    graphics->reload->watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    CUBE_ASSERT(graphics->reload->watch >= 0, strerror(errno))
+    CUBE_ASSERT(
+        inotify_add_watch(
+            graphics->reload->watch,
+            graphics->reload->directory,
+            IN_CLOSE_WRITE | IN_MOVED_TO) >= 0,
+        strerror(errno))
+
+    SDL_AtomicSet(&graphics->reload->running, 1);
+    graphics->reload->thread = SDL_CreateThread(graphics_reload_thread, "cube_reload", graphics);
+    CUBE_ASSERT(graphics->reload->thread != NULL, SDL_GetError())
+#endif
+    CUBE_END_FUNCTION
+}
+
+// called on the render thread before acquire, the only place graphics_pipeline changes
+void graphics_render_reload_frame(cube_graphics *graphics)
+{
+    cube_reload *reload;
+    VkPipeline pipeline;
+
+    reload = graphics->reload;
+    if (reload == NULL)
+    {
+        return;
+    }
+    pipeline = SDL_AtomicSetPtr(&reload->pending, NULL);
+    if (pipeline == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    // frames already submitted still bind the old pipeline, it goes once the timeline passes them
+    if (graphics_sync_defer_pipeline(graphics, graphics->graphics_pipeline) == CUBE_SUCCESS)
+    {
+        graphics->graphics_pipeline = pipeline;
+    }
+    else if (!SDL_AtomicCASPtr(&reload->pending, NULL, pipeline))
+    {
+        vkDestroyPipeline(graphics->logical_device, pipeline, NULL);
+    }
+}
+
+// after vkDeviceWaitIdle, nothing pending is in use
+void graphics_destroy_reload(cube_graphics *graphics)
+{
+    cube_reload *reload;
+    VkPipeline pipeline;
+
+    reload = graphics->reload;
+    if (reload == NULL)
+    {
+        return;
+    }
+    if (reload->thread != NULL)
+    {
+        SDL_AtomicSet(&reload->running, 0);
+        SDL_WaitThread(reload->thread, NULL);
+    }
+#ifdef __linux__
+    if (reload->watch >= 0)
+    {
+        close(reload->watch);
+    }
+#endif
+    pipeline = SDL_AtomicSetPtr(&reload->pending, NULL);
+    if (pipeline != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(graphics->logical_device, pipeline, NULL);
+    }
+    SDL_free(reload->directory);
+    free(reload);
+    graphics->reload = NULL;
+}
+
+#ifdef __linux__
+int graphics_reload_thread(void *data)
+{
+    cube_graphics *graphics;
+    struct pollfd watch_poll;
+
+    graphics = data;
+    CUBE_PROFILE_THREAD("shader reload")
+    watch_poll.fd = graphics->reload->watch;
+    watch_poll.events = POLLIN;
+    while (SDL_AtomicGet(&graphics->reload->running) != 0)
+    {
+        if (poll(&watch_poll, 1, CUBE_RELOAD_POLL_MILLISECONDS) <= 0 ||
+            !graphics_reload_changed(graphics))
+        {
+            continue;
+        }
+
+        // let the other stage finish writing, then take every event since as one change
+        SDL_Delay(CUBE_RELOAD_SETTLE_MILLISECONDS);
+        graphics_reload_changed(graphics);
+        // a failed build reports through its assert and keeps the running pipeline
+        graphics_reload_build(graphics);
+    }
+    return 0;
+}
+
+// drains the watch and reports whether a reloaded shader was among the events
+SDL_bool graphics_reload_changed(cube_graphics *graphics)
+{
+    CUBE_ALIGN(8) char events[4096];
+    const struct inotify_event *event;
+    const char *const *shaders;
+    ssize_t length;
+    ssize_t offset;
+    uint32_t shader_index;
+    SDL_bool changed;
+
+    shaders = graphics_reload_shaders[graphics->bindless != NULL];
+    changed = SDL_FALSE;
+    while ((length = read(graphics->reload->watch, events, sizeof(events))) > 0)
+    {
+        for (offset = 0; offset < length; offset += (ssize_t)(sizeof(struct inotify_event) + event->len))
+        {
+            event = (const struct inotify_event *)(events + offset);
+            for (shader_index = 0;
+                 event->len > 0 && shader_index < sizeof(graphics_reload_shaders[0]) / sizeof(*graphics_reload_shaders[0]);
+                 shader_index++)
+            {
+                if (SDL_strcmp(event->name, shaders[shader_index]) == 0)
+                {
+                    changed = SDL_TRUE;
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+// a shader that fails to load or link leaves the running pipeline in place
+int graphics_reload_build(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    VkShaderModule vertex_shader;
+    VkShaderModule fragment_shader;
+    VkPipeline pipeline;
+    const char *const *shaders;
+    uint32_t resource_indices[2];
+    uint32_t shader_index;
+
+    shaders = graphics_reload_shaders[graphics->bindless != NULL];
+    for (shader_index = 0; shader_index < 2; shader_index++)
+    {
+        CUBE_ASSERT(
+            application_resources_find(
+                graphics->resources,
+                CUBE_RESOURCE_SHADER,
+                shaders[shader_index],
+                resource_indices + shader_index) == CUBE_SUCCESS,
+            "failed to find reloaded shader")
+        application_resources_release(graphics->resources, *(resource_indices + shader_index));
+    }
+
+    CUBE_ASSERT(
+        graphics_util_load_shader(
+            graphics,
+            shaders[0],
+            &vertex_shader) == CUBE_SUCCESS,
+        "failed to reload vertex shader")
+    if (graphics_util_load_shader(
+            graphics,
+            shaders[1],
+            &fragment_shader) != CUBE_SUCCESS)
+    {
+        vkDestroyShaderModule(graphics->logical_device, vertex_shader, NULL);
+        CUBE_ASSERT(SDL_FALSE, "failed to reload fragment shader")
+    }
+
+    // compiled here, through the cache, so the render thread only swaps a handle
+    cube_result = graphics_build_graphics_pipeline(graphics, vertex_shader, fragment_shader, &pipeline);
+    vkDestroyShaderModule(graphics->logical_device, fragment_shader, NULL);
+    vkDestroyShaderModule(graphics->logical_device, vertex_shader, NULL);
+    for (shader_index = 0; shader_index < 2; shader_index++)
+    {
+        application_resources_release(graphics->resources, *(resource_indices + shader_index));
+    }
+    CUBE_ASSERT(cube_result == CUBE_SUCCESS, "failed to rebuild graphics pipeline")
+
+    // a build the render thread never picked up was never bound
+    pipeline = SDL_AtomicSetPtr(&graphics->reload->pending, pipeline);
+    if (pipeline != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(graphics->logical_device, pipeline, NULL);
+    }
+    CUBE_END_FUNCTION
+}
+#endif
\ No newline at end of file
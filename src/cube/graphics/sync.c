@@ -0,0 +1,336 @@
+#include "cube.h"
+
+static int graphics_sync_submit_locked(
+    cube_graphics *graphics,
+    const VkSubmitInfo *submit_info,
+    uint64_t *value);
+static int graphics_sync_defer(cube_graphics *graphics, const cube_deletion *deletion);
+static void graphics_sync_destroy_deletion(cube_graphics *graphics, const cube_deletion *deletion);
+
+int graphics_create_sync(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    const VkSemaphoreTypeCreateInfo semaphore_type_create_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    const VkSemaphoreCreateInfo semaphore_create_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &semaphore_type_create_info,
+    };
+    const VkFenceCreateInfo fence_create_info = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+    };
+    uint32_t fence_index;
+
+    graphics->sync = calloc(1, sizeof(cube_sync));
+    CUBE_ASSERT(graphics->sync != NULL, "failed to allocate sync")
+    graphics->sync->mutex = SDL_CreateMutex();
+    CUBE_ASSERT(graphics->sync->mutex != NULL, SDL_GetError())
+
+    if (graphics->capabilities.timeline_semaphore == VK_TRUE)
+    {
+        VK_CHECK_RESULT(
+            vkCreateSemaphore(
+                graphics->logical_device,
+                &semaphore_create_info,
+                NULL,
+                &graphics->sync->timeline))
+    }
+    else
+    {
+        for (fence_index = 0; fence_index < CUBE_SYNC_FENCE_CAPACITY; fence_index++)
+        {
+            VK_CHECK_RESULT(
+                vkCreateFence(
+                    graphics->logical_device,
+                    &fence_create_info,
+                    NULL,
+                    graphics->sync->fences + fence_index))
+        }
+    }
+    CUBE_END_FUNCTION
+}
+
+// every graphics queue submission goes through here and signals the next value
+int graphics_sync_submit(cube_graphics *graphics, const VkSubmitInfo *submit_info, uint64_t *value)
+{
+    int result;
+
+    // the queue and the counter advance together
+    SDL_LockMutex(graphics->sync->mutex);
+    result = graphics_sync_submit_locked(graphics, submit_info, value);
+    SDL_UnlockMutex(graphics->sync->mutex);
+    return result;
+}
+
+int graphics_sync_submit_locked(cube_graphics *graphics, const VkSubmitInfo *submit_info, uint64_t *value)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_sync *sync;
+    VkSubmitInfo timeline_submit_info;
+    VkSemaphore signal_semaphores[CUBE_SYNC_SIGNAL_CAPACITY];
+    uint64_t signal_values[CUBE_SYNC_SIGNAL_CAPACITY];
+    VkTimelineSemaphoreSubmitInfo timeline_semaphore_submit_info = {
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+    };
+    uint32_t signal_index;
+    VkFence fence;
+
+    sync = graphics->sync;
+    CUBE_ASSERT(
+        submit_info->signalSemaphoreCount < CUBE_SYNC_SIGNAL_CAPACITY,
+        "too many signal semaphores")
+    timeline_submit_info = *submit_info;
+    fence = VK_NULL_HANDLE;
+    if (sync->timeline != VK_NULL_HANDLE)
+    {
+        // binary semaphores ignore their value, the timeline is appended last
+        for (signal_index = 0; signal_index < submit_info->signalSemaphoreCount; signal_index++)
+        {
+            signal_semaphores[signal_index] = *(submit_info->pSignalSemaphores + signal_index);
+            signal_values[signal_index] = 0;
+        }
+        signal_semaphores[signal_index] = sync->timeline;
+        signal_values[signal_index] = sync->submitted + 1;
+        timeline_semaphore_submit_info.pNext = submit_info->pNext;
+        timeline_semaphore_submit_info.signalSemaphoreValueCount = signal_index + 1;
+        timeline_semaphore_submit_info.pSignalSemaphoreValues = &signal_values[0];
+        timeline_submit_info.pNext = &timeline_semaphore_submit_info;
+        timeline_submit_info.signalSemaphoreCount = signal_index + 1;
+        timeline_submit_info.pSignalSemaphores = &signal_semaphores[0];
+    }
+    else
+    {
+        // the fence comes back around once its value is a full ring behind
+        if (sync->submitted + 1 > CUBE_SYNC_FENCE_CAPACITY)
+        {
+            CUBE_ASSERT(
+                graphics_sync_wait(
+                    graphics,
+                    sync->submitted + 1 - CUBE_SYNC_FENCE_CAPACITY) == CUBE_SUCCESS,
+                "failed to wait for fence")
+        }
+        fence = sync->fences[(sync->submitted + 1) % CUBE_SYNC_FENCE_CAPACITY];
+        VK_CHECK_RESULT(
+            vkResetFences(
+                graphics->logical_device,
+                1,
+                &fence))
+    }
+
+    VK_CHECK_RESULT(
+        vkQueueSubmit(
+            graphics->graphics_queue,
+            1,
+            &timeline_submit_info,
+            fence))
+    sync->submitted++;
+    if (value != NULL)
+    {
+        *value = sync->submitted;
+    }
+    CUBE_END_FUNCTION
+}
+
+int graphics_sync_wait(cube_graphics *graphics, uint64_t value)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_sync *sync;
+    const VkSemaphoreWaitInfo semaphore_wait_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores = &graphics->sync->timeline,
+        .pValues = &value,
+    };
+
+    sync = graphics->sync;
+    if (value <= sync->completed)
+    {
+        goto done;
+    }
+    CUBE_ASSERT(value <= sync->submitted, "waiting on a value never submitted")
+    if (sync->timeline != VK_NULL_HANDLE)
+    {
+        VK_CHECK_RESULT(
+            vkWaitSemaphores(
+                graphics->logical_device,
+                &semaphore_wait_info,
+                UINT64_MAX))
+    }
+    else
+    {
+        // a fence signals after every earlier submission to the queue, so one wait covers them
+        VK_CHECK_RESULT(
+            vkWaitForFences(
+                graphics->logical_device,
+                1,
+                sync->fences + value % CUBE_SYNC_FENCE_CAPACITY,
+                VK_TRUE,
+                UINT64_MAX))
+    }
+    sync->completed = SDL_max(sync->completed, value);
+    CUBE_END_FUNCTION
+}
+
+// polls without blocking, the fences past the first unsignaled one are not looked at
+uint64_t graphics_sync_completed(cube_graphics *graphics)
+{
+    cube_sync *sync;
+    uint64_t value;
+
+    sync = graphics->sync;
+    if (sync->timeline != VK_NULL_HANDLE)
+    {
+        if (vkGetSemaphoreCounterValue(graphics->logical_device, sync->timeline, &value) == VK_SUCCESS)
+        {
+            sync->completed = SDL_max(sync->completed, value);
+        }
+        return sync->completed;
+    }
+    while (sync->completed < sync->submitted &&
+           vkGetFenceStatus(
+               graphics->logical_device,
+               sync->fences[(sync->completed + 1) % CUBE_SYNC_FENCE_CAPACITY]) == VK_SUCCESS)
+    {
+        sync->completed++;
+    }
+    return sync->completed;
+}
+
+// deferred objects are destroyed once everything submitted so far has completed
+int graphics_sync_defer_buffer(cube_graphics *graphics, VkBuffer buffer, VmaAllocation allocation)
+{
+    cube_deletion deletion = {
+        .type = CUBE_DELETION_BUFFER,
+        .buffer = buffer,
+        .allocation = allocation,
+    };
+    return graphics_sync_defer(graphics, &deletion);
+}
+
+int graphics_sync_defer_pipeline(cube_graphics *graphics, VkPipeline pipeline)
+{
+    cube_deletion deletion = {
+        .type = CUBE_DELETION_PIPELINE,
+        .pipeline = pipeline,
+    };
+    return graphics_sync_defer(graphics, &deletion);
+}
+
+int graphics_sync_defer_command_buffer(cube_graphics *graphics, VkCommandBuffer command_buffer)
+{
+    cube_deletion deletion = {
+        .type = CUBE_DELETION_COMMAND_BUFFER,
+        .command_buffer = command_buffer,
+    };
+    return graphics_sync_defer(graphics, &deletion);
+}
+
+// called on the render thread after acquire, never blocks on the gpu
+void graphics_render_sync_collect(cube_graphics *graphics)
+{
+    cube_sync *sync;
+    uint64_t completed;
+    uint32_t deletion_index;
+
+    sync = graphics->sync;
+    SDL_LockMutex(sync->mutex);
+    completed = graphics_sync_completed(graphics);
+    deletion_index = 0;
+    while (deletion_index < sync->deletion_count)
+    {
+        if ((sync->deletions + deletion_index)->value <= completed)
+        {
+            graphics_sync_destroy_deletion(graphics, sync->deletions + deletion_index);
+            *(sync->deletions + deletion_index) = *(sync->deletions + --sync->deletion_count);
+        }
+        else
+        {
+            deletion_index++;
+        }
+    }
+    SDL_UnlockMutex(sync->mutex);
+}
+
+// after vkDeviceWaitIdle, every deferred object is free to go
+void graphics_destroy_sync(cube_graphics *graphics)
+{
+    cube_sync *sync;
+    uint32_t deletion_index;
+    uint32_t fence_index;
+
+    sync = graphics->sync;
+    if (sync == NULL)
+    {
+        return;
+    }
+    for (deletion_index = 0; deletion_index < sync->deletion_count; deletion_index++)
+    {
+        graphics_sync_destroy_deletion(graphics, sync->deletions + deletion_index);
+    }
+    free(sync->deletions);
+    if (sync->timeline != VK_NULL_HANDLE)
+    {
+        vkDestroySemaphore(graphics->logical_device, sync->timeline, NULL);
+    }
+    for (fence_index = 0; fence_index < CUBE_SYNC_FENCE_CAPACITY; fence_index++)
+    {
+        if (sync->fences[fence_index] != VK_NULL_HANDLE)
+        {
+            vkDestroyFence(graphics->logical_device, sync->fences[fence_index], NULL);
+        }
+    }
+    if (sync->mutex != NULL)
+    {
+        SDL_DestroyMutex(sync->mutex);
+    }
+    free(sync);
+    graphics->sync = NULL;
+}
+
+int graphics_sync_defer(cube_graphics *graphics, const cube_deletion *deletion)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_sync *sync;
+    cube_deletion *grown;
+
+    sync = graphics->sync;
+    SDL_LockMutex(sync->mutex);
+
+    // doubled whenever the count reaches a power of two
+    if ((sync->deletion_count & (sync->deletion_count - 1)) == 0)
+    {
+        grown = realloc(
+            sync->deletions,
+            (size_t)SDL_max(sync->deletion_count * 2, 16) * sizeof(cube_deletion));
+        if (grown == NULL)
+        {
+            SDL_UnlockMutex(sync->mutex);
+            CUBE_ASSERT(SDL_FALSE, "failed to grow deletion queue")
+        }
+        sync->deletions = grown;
+    }
+    *(sync->deletions + sync->deletion_count) = *deletion;
+    (sync->deletions + sync->deletion_count)->value = sync->submitted;
+    sync->deletion_count++;
+    SDL_UnlockMutex(sync->mutex);
+    CUBE_END_FUNCTION
+}
+
+void graphics_sync_destroy_deletion(cube_graphics *graphics, const cube_deletion *deletion)
+{
+    switch (deletion->type)
+    {
+    case CUBE_DELETION_BUFFER:
+        vmaDestroyBuffer(graphics->allocator, deletion->buffer, deletion->allocation);
+        break;
+    case CUBE_DELETION_PIPELINE:
+        vkDestroyPipeline(graphics->logical_device, deletion->pipeline, NULL);
+        break;
+    case CUBE_DELETION_COMMAND_BUFFER:
+        vkFreeCommandBuffers(graphics->logical_device, graphics->command_pool, 1, &deletion->command_buffer);
+        break;
+    }
+}
\ No newline at end of file
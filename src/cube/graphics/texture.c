@@ -0,0 +1,538 @@
+#include "cube.h"
+
+static int graphics_create_texture(
+    cube_graphics *graphics,
+    const cube_resource *resource,
+    cube_texture *texture);
+static int graphics_texture_record(
+    cube_graphics *graphics,
+    const cube_texture *texture,
+    const cube_ktx2 *ktx2,
+    VkBuffer staging_buffer,
+    VkCommandBuffer *command_buffer);
+
+// every .ktx2 in the resources becomes a material, the instances take them in turn
+int graphics_create_textures(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_resources *resources;
+    cube_textures *textures;
+    cube_texture *texture;
+    cube_sampler_key sampler_key = {
+        .filter = VK_FILTER_LINEAR,
+        .mipmap_mode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+        .address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+    };
+    cube_material material = {
+        .color = {1.0f, 1.0f, 1.0f, 1.0f},
+    };
+    uint32_t *materials;
+    uint32_t material_count;
+    uint32_t texture_count;
+    uint32_t texture_index;
+    uint32_t resource_index;
+    uint32_t instance_index;
+
+    resources = graphics->resources;
+    texture_count = resources->type_count[CUBE_RESOURCE_TEXTURE];
+    if (texture_count == 0)
+    {
+        goto done;
+    }
+    // textures are only sampled through bindless descriptors
+    if (graphics->bindless == NULL)
+    {
+        goto done;
+    }
+
+    // the job workers read the later files while the earlier ones upload
+    for (texture_index = 0; texture_index < texture_count; texture_index++)
+    {
+        CUBE_ASSERT(
+            application_resources_load(
+                resources,
+                resources->type_first[CUBE_RESOURCE_TEXTURE] + texture_index,
+                NULL,
+                NULL) == CUBE_SUCCESS,
+            "failed to queue texture")
+    }
+
+    graphics->textures = calloc(1, sizeof(cube_textures));
+    CUBE_ASSERT(graphics->textures != NULL, "failed to allocate textures")
+    textures = graphics->textures;
+    textures->textures = calloc(texture_count, sizeof(cube_texture));
+    CUBE_ASSERT(textures->textures != NULL, "failed to allocate texture array")
+    textures->texture_count = texture_count;
+    materials = CUBE_CALLOC(texture_count, sizeof(uint32_t));
+    CUBE_ASSERT(materials != NULL, "failed to allocate texture materials")
+
+    sampler_key.anisotropy = graphics->capabilities.sampler_anisotropy;
+    CUBE_ASSERT(
+        graphics_textures_sampler(
+            graphics,
+            &sampler_key,
+            &material.sampler) == CUBE_SUCCESS,
+        "failed to create texture sampler")
+
+    material_count = 0;
+    for (texture_index = 0; texture_index < texture_count; texture_index++)
+    {
+        texture = textures->textures + texture_index;
+        texture->index = CUBE_BINDLESS_NONE;
+        texture->material = CUBE_BINDLESS_NONE;
+        resource_index = resources->type_first[CUBE_RESOURCE_TEXTURE] + texture_index;
+
+        // a bad file only loses its own texture, the failed assert names it
+        if (application_resources_wait(resources, resource_index) != CUBE_SUCCESS ||
+            graphics_create_texture(graphics, resources->resources + resource_index, texture) != CUBE_SUCCESS)
+        {
+            application_resources_release(resources, resource_index);
+            continue;
+        }
+        application_resources_release(resources, resource_index);
+
+        material.texture = texture->index;
+        CUBE_ASSERT(
+            graphics_bindless_add_material(
+                graphics,
+                &material,
+                &texture->material) == CUBE_SUCCESS,
+            "failed to add texture material")
+        *(materials + material_count++) = texture->material;
+    }
+    if (material_count == 0)
+    {
+        goto done;
+    }
+
+    for (instance_index = 0; instance_index < graphics->instance_count; instance_index++)
+    {
+        graphics_bindless_set_instance_material(
+            graphics,
+            instance_index,
+            *(materials + instance_index % material_count));
+    }
+    CUBE_END_FUNCTION
+}
+
+// the cache is never larger than the bindless sampler array, so a linear search is the lookup
+int graphics_textures_sampler(cube_graphics *graphics, const cube_sampler_key *key, uint32_t *index)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_textures *textures;
+    cube_sampler *sampler;
+    VkSamplerCreateInfo sampler_create_info = {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = key->filter,
+        .minFilter = key->filter,
+        .mipmapMode = key->mipmap_mode,
+        .addressModeU = key->address_mode,
+        .addressModeV = key->address_mode,
+        .addressModeW = key->address_mode,
+        .anisotropyEnable = key->anisotropy,
+        .maxAnisotropy = 1.0f,
+        .minLod = 0.0f,
+        .maxLod = VK_LOD_CLAMP_NONE,
+        .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK,
+    };
+    uint32_t sampler_index;
+
+    textures = graphics->textures;
+    for (sampler_index = 0; sampler_index < textures->sampler_count; sampler_index++)
+    {
+        sampler = textures->samplers + sampler_index;
+        if (sampler->key.filter == key->filter &&
+            sampler->key.mipmap_mode == key->mipmap_mode &&
+            sampler->key.address_mode == key->address_mode &&
+            sampler->key.anisotropy == key->anisotropy)
+        {
+            *index = sampler->index;
+            goto done;
+        }
+    }
+
+    CUBE_ASSERT(
+        key->anisotropy == VK_FALSE || graphics->capabilities.sampler_anisotropy == VK_TRUE,
+        "sampler anisotropy is not supported")
+    CUBE_ASSERT(textures->sampler_count < CUBE_BINDLESS_SAMPLER_CAPACITY, "texture samplers are full")
+    if (key->anisotropy == VK_TRUE)
+    {
+        sampler_create_info.maxAnisotropy = graphics->capabilities.max_sampler_anisotropy;
+    }
+    sampler = textures->samplers + textures->sampler_count;
+    VK_CHECK_RESULT(
+        vkCreateSampler(
+            graphics->logical_device,
+            &sampler_create_info,
+            NULL,
+            &sampler->sampler))
+    cube_result = graphics_bindless_add_sampler(graphics, sampler->sampler, &sampler->index);
+    if (cube_result != CUBE_SUCCESS)
+    {
+        vkDestroySampler(graphics->logical_device, sampler->sampler, NULL);
+        sampler->sampler = VK_NULL_HANDLE;
+    }
+    CUBE_ASSERT(cube_result == CUBE_SUCCESS, "failed to bind sampler")
+    sampler->key = *key;
+    textures->sampler_count++;
+    *index = sampler->index;
+    CUBE_END_FUNCTION
+}
+
+// after vkDeviceWaitIdle, before the bindless set the views are written into
+void graphics_destroy_textures(cube_graphics *graphics)
+{
+    cube_textures *textures;
+    cube_texture *texture;
+    uint32_t texture_index;
+    uint32_t sampler_index;
+
+    textures = graphics->textures;
+    if (textures == NULL)
+    {
+        return;
+    }
+    for (texture_index = 0; texture_index < textures->texture_count; texture_index++)
+    {
+        texture = textures->textures + texture_index;
+        if (texture->image_view != VK_NULL_HANDLE)
+        {
+            vkDestroyImageView(graphics->logical_device, texture->image_view, NULL);
+        }
+        if (texture->image != VK_NULL_HANDLE)
+        {
+            vmaDestroyImage(graphics->allocator, texture->image, texture->allocation);
+        }
+    }
+    free(textures->textures);
+    for (sampler_index = 0; sampler_index < textures->sampler_count; sampler_index++)
+    {
+        vkDestroySampler(graphics->logical_device, textures->samplers[sampler_index].sampler, NULL);
+    }
+    free(textures);
+    graphics->textures = NULL;
+}
+
+// the image and view stay with the texture even on failure, they are destroyed with the rest
+int graphics_create_texture(
+    cube_graphics *graphics,
+    const cube_resource *resource,
+    cube_texture *texture)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_ktx2 ktx2;
+    VkFormatProperties format_properties;
+    const VkFormatFeatureFlags blit_features =
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+        VK_FORMAT_FEATURE_BLIT_DST_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    VkImageCreateInfo image_create_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .extent = {
+            .depth = 1,
+        },
+        .arrayLayers = 1,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    const VmaAllocationCreateInfo image_allocation_create_info = {
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+    };
+    VkImageViewCreateInfo image_view_create_info = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+            .baseMipLevel = 0,
+        },
+    };
+    const VkBufferCreateInfo staging_buffer_create_info = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = resource->size,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    const VmaAllocationCreateInfo staging_allocation_create_info = {
+        .usage = VMA_MEMORY_USAGE_CPU_ONLY,
+        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+    };
+    VkBuffer staging_buffer;
+    VmaAllocation staging_buffer_allocation;
+    VmaAllocationInfo staging_allocation_info;
+    VkCommandBuffer command_buffer;
+    const VkSubmitInfo submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &command_buffer,
+    };
+
+    CUBE_ASSERT(
+        graphics_ktx2_parse(
+            resource->data,
+            resource->size,
+            graphics->capabilities.texture_compression_bc,
+            graphics->capabilities.max_image_dimension_2d,
+            &ktx2) == CUBE_SUCCESS,
+        resource->path)
+    CUBE_ASSERT(
+        graphics->bindless->image_count < graphics->bindless->image_capacity,
+        "bindless images are full")
+    texture->format = ktx2.format->format;
+    texture->width = ktx2.width;
+    texture->height = ktx2.height;
+    texture->level_count = ktx2.level_count;
+
+    // block compressed files carry their own levels, the blit chain only filters plain texels
+    if (ktx2.generate_levels == VK_TRUE)
+    {
+        vkGetPhysicalDeviceFormatProperties(graphics->physical_device, texture->format, &format_properties);
+        if ((format_properties.optimalTilingFeatures & blit_features) == blit_features)
+        {
+            texture->level_count = graphics_ktx2_chain_length(texture->width, texture->height);
+            image_create_info.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+    }
+
+    image_create_info.format = texture->format;
+    image_create_info.extent.width = texture->width;
+    image_create_info.extent.height = texture->height;
+    image_create_info.mipLevels = texture->level_count;
+    VK_CHECK_RESULT(
+        vmaCreateImage(
+            graphics->allocator,
+            &image_create_info,
+            &image_allocation_create_info,
+            &texture->image,
+            &texture->allocation,
+            NULL))
+    image_view_create_info.image = texture->image;
+    image_view_create_info.format = texture->format;
+    image_view_create_info.subresourceRange.levelCount = texture->level_count;
+    VK_CHECK_RESULT(
+        vkCreateImageView(
+            graphics->logical_device,
+            &image_view_create_info,
+            NULL,
+            &texture->image_view))
+
+    // the whole file is staged so the level offsets from its index stay valid
+    VK_CHECK_RESULT(
+        vmaCreateBuffer(
+            graphics->allocator,
+            &staging_buffer_create_info,
+            &staging_allocation_create_info,
+            &staging_buffer,
+            &staging_buffer_allocation,
+            &staging_allocation_info))
+    SDL_memcpy(staging_allocation_info.pMappedData, resource->data, resource->size);
+
+    command_buffer = VK_NULL_HANDLE;
+    cube_result = graphics_texture_record(graphics, texture, &ktx2, staging_buffer, &command_buffer);
+    if (cube_result == CUBE_SUCCESS)
+    {
+        cube_result = graphics_sync_submit(graphics, &submit_info, NULL);
+    }
+    if (cube_result != CUBE_SUCCESS)
+    {
+        // nothing reached the queue, so nothing waits on these
+        if (command_buffer != VK_NULL_HANDLE)
+        {
+            vkFreeCommandBuffers(graphics->logical_device, graphics->command_pool, 1, &command_buffer);
+        }
+        vmaDestroyBuffer(graphics->allocator, staging_buffer, staging_buffer_allocation);
+    }
+    CUBE_ASSERT(cube_result == CUBE_SUCCESS, "failed to submit texture upload")
+    CUBE_ASSERT(
+        graphics_sync_defer_buffer(
+            graphics,
+            staging_buffer,
+            staging_buffer_allocation) == CUBE_SUCCESS,
+        "failed to defer texture staging buffer")
+    CUBE_ASSERT(
+        graphics_sync_defer_command_buffer(
+            graphics,
+            command_buffer) == CUBE_SUCCESS,
+        "failed to defer texture command buffer")
+
+    // the slot is only reached through a material, which the caller adds after this
+    CUBE_ASSERT(
+        graphics_bindless_add_image(
+            graphics,
+            texture->image_view,
+            &texture->index) == CUBE_SUCCESS,
+        "failed to bind texture")
+    CUBE_END_FUNCTION
+}
+
+// copies the supplied levels, then blits each generated level from the one above it
+int graphics_texture_record(
+    cube_graphics *graphics,
+    const cube_texture *texture,
+    const cube_ktx2 *ktx2,
+    VkBuffer staging_buffer,
+    VkCommandBuffer *command_buffer)
+{
+    CUBE_BEGIN_FUNCTION
+    const VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+        .commandPool = graphics->command_pool,
+    };
+    const VkCommandBufferBeginInfo command_buffer_begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    VkImageMemoryBarrier image_barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = texture->image,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    };
+    VkBufferImageCopy copy_regions[CUBE_TEXTURE_LEVEL_CAPACITY];
+    VkImageBlit image_blit = {
+        .srcSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+        .dstSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    };
+    uint32_t level_index;
+    VkBool32 generated;
+
+    VK_CHECK_RESULT(
+        vkAllocateCommandBuffers(
+            graphics->logical_device,
+            &command_buffer_allocate_info,
+            command_buffer))
+    VK_CHECK_RESULT(
+        vkBeginCommandBuffer(
+            *command_buffer,
+            &command_buffer_begin_info))
+
+    image_barrier.srcAccessMask = 0;
+    image_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    image_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    image_barrier.subresourceRange.baseMipLevel = 0;
+    image_barrier.subresourceRange.levelCount = texture->level_count;
+    vkCmdPipelineBarrier(
+        *command_buffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, NULL,
+        0, NULL,
+        1, &image_barrier);
+
+    for (level_index = 0; level_index < ktx2->level_count; level_index++)
+    {
+        copy_regions[level_index] = (VkBufferImageCopy){
+            .bufferOffset = ktx2->level_offsets[level_index],
+            .imageSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = level_index,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+            .imageExtent = {
+                .width = SDL_max(texture->width >> level_index, 1),
+                .height = SDL_max(texture->height >> level_index, 1),
+                .depth = 1,
+            },
+        };
+    }
+    vkCmdCopyBufferToImage(
+        *command_buffer,
+        staging_buffer,
+        texture->image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        ktx2->level_count,
+        &copy_regions[0]);
+
+    // each source level is read once, so it goes straight on to the shaders afterwards
+    generated = (texture->level_count > ktx2->level_count) ? VK_TRUE : VK_FALSE;
+    image_barrier.subresourceRange.levelCount = 1;
+    for (level_index = 1; generated == VK_TRUE && level_index < texture->level_count; level_index++)
+    {
+        image_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        image_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        image_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        image_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        image_barrier.subresourceRange.baseMipLevel = level_index - 1;
+        vkCmdPipelineBarrier(
+            *command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, NULL,
+            0, NULL,
+            1, &image_barrier);
+
+        image_blit.srcSubresource.mipLevel = level_index - 1;
+        image_blit.srcOffsets[1].x = (int32_t)SDL_max(texture->width >> (level_index - 1), 1);
+        image_blit.srcOffsets[1].y = (int32_t)SDL_max(texture->height >> (level_index - 1), 1);
+        image_blit.srcOffsets[1].z = 1;
+        image_blit.dstSubresource.mipLevel = level_index;
+        image_blit.dstOffsets[1].x = (int32_t)SDL_max(texture->width >> level_index, 1);
+        image_blit.dstOffsets[1].y = (int32_t)SDL_max(texture->height >> level_index, 1);
+        image_blit.dstOffsets[1].z = 1;
+        vkCmdBlitImage(
+            *command_buffer,
+            texture->image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            texture->image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &image_blit,
+            VK_FILTER_LINEAR);
+
+        image_barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        image_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        image_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        image_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(
+            *command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0,
+            0, NULL,
+            0, NULL,
+            1, &image_barrier);
+    }
+
+    // whatever was last written by a copy or blit is still a transfer destination
+    image_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    image_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    image_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    image_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    image_barrier.subresourceRange.baseMipLevel = (generated == VK_TRUE) ? texture->level_count - 1 : 0;
+    image_barrier.subresourceRange.levelCount = (generated == VK_TRUE) ? 1 : texture->level_count;
+    vkCmdPipelineBarrier(
+        *command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0,
+        0, NULL,
+        0, NULL,
+        1, &image_barrier);
+
+    VK_CHECK_RESULT(
+        vkEndCommandBuffer(*command_buffer))
+    CUBE_END_FUNCTION
+}
\ No newline at end of file
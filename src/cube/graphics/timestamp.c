@@ -0,0 +1,242 @@
+#include "cube.h"
+
+#ifdef CUBE_PROFILE
+
+#define CUBE_TIMESTAMP_NONE UINT32_MAX
+
+static int graphics_timestamps_calibrate(cube_graphics *graphics);
+static Uint64 graphics_timestamps_host(const cube_timestamps *timestamps, uint64_t device);
+
+int graphics_create_timestamps(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    uint32_t valid_bits;
+    VkQueryPoolCreateInfo query_pool_create_info = {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+    };
+
+    graphics->timestamps = NULL;
+
+    // a queue without timestamps leaves the gpu track empty
+    valid_bits = graphics->capabilities.timestamp_valid_bits;
+    if (valid_bits == 0)
+    {
+        goto done;
+    }
+
+    graphics->timestamps = calloc(1, sizeof(cube_timestamps));
+    CUBE_ASSERT(graphics->timestamps != NULL, "failed to allocate timestamps")
+    graphics->timestamps->period = graphics->capabilities.timestamp_period;
+    graphics->timestamps->valid_mask = (valid_bits >= 64) ? UINT64_MAX : ((uint64_t)1 << valid_bits) - 1;
+    graphics->timestamps->submitted = CUBE_TIMESTAMP_NONE;
+
+    query_pool_create_info.queryCount = graphics->frame_count * 2;
+    VK_CHECK_RESULT(
+        vkCreateQueryPool(
+            graphics->logical_device,
+            &query_pool_create_info,
+            NULL,
+            &graphics->timestamps->query_pool))
+
+    if (graphics->capabilities.calibrated_timestamps == VK_TRUE)
+    {
+        graphics->timestamps->get_calibrated_timestamps = (PFN_vkGetCalibratedTimestampsEXT)vkGetDeviceProcAddr(
+            graphics->logical_device,
+            "vkGetCalibratedTimestampsEXT");
+#ifdef _WIN32
+        graphics->timestamps->host_domain = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+        graphics->timestamps->host_domain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_EXT;
+#endif
+    }
+    CUBE_ASSERT(graphics_timestamps_calibrate(graphics) == CUBE_SUCCESS, "failed to calibrate timestamps")
+    CUBE_END_FUNCTION
+}
+
+// outside any render pass, right after the command buffer begins
+void graphics_render_timestamp_begin(cube_graphics *graphics, cube_frame *frame)
+{
+    if (graphics->timestamps == NULL)
+    {
+        return;
+    }
+    vkCmdResetQueryPool(frame->command_buffer, graphics->timestamps->query_pool, frame->index * 2, 2);
+    vkCmdWriteTimestamp(
+        frame->command_buffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        graphics->timestamps->query_pool,
+        frame->index * 2);
+}
+
+void graphics_render_timestamp_end(cube_graphics *graphics, cube_frame *frame)
+{
+    if (graphics->timestamps == NULL)
+    {
+        return;
+    }
+    vkCmdWriteTimestamp(
+        frame->command_buffer,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        graphics->timestamps->query_pool,
+        frame->index * 2 + 1);
+    graphics->timestamps->submitted = frame->index;
+}
+
+// called after acquire has waited on the frame's timeline value, so the last submitted frame has finished
+void graphics_render_timestamp_collect(cube_graphics *graphics)
+{
+    cube_timestamps *timestamps;
+    uint64_t results[2];
+
+    timestamps = graphics->timestamps;
+    if (timestamps == NULL || timestamps->submitted == CUBE_TIMESTAMP_NONE)
+    {
+        return;
+    }
+    if (vkGetQueryPoolResults(
+            graphics->logical_device,
+            timestamps->query_pool,
+            timestamps->submitted * 2,
+            2,
+            sizeof(results),
+            &results[0],
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+    {
+        // the clocks drift apart over a long run, recalibrating is cheap when the extension is there
+        if (timestamps->get_calibrated_timestamps != NULL)
+        {
+            graphics_timestamps_calibrate(graphics);
+        }
+        application_profile_gpu_zone(
+            "frame",
+            graphics_timestamps_host(timestamps, results[0] & timestamps->valid_mask),
+            graphics_timestamps_host(timestamps, results[1] & timestamps->valid_mask));
+    }
+    timestamps->submitted = CUBE_TIMESTAMP_NONE;
+}
+
+void graphics_destroy_timestamps(cube_graphics *graphics)
+{
+    if (graphics->timestamps != NULL)
+    {
+        if (graphics->timestamps->query_pool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(graphics->logical_device, graphics->timestamps->query_pool, NULL);
+        }
+        free(graphics->timestamps);
+        graphics->timestamps = NULL;
+    }
+}
+
+// with the extension both clocks are sampled together, without it a timestamp is written
+// on an idle queue and paired with the middle of the host interval around it
+int graphics_timestamps_calibrate(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_timestamps *timestamps;
+    const VkCalibratedTimestampInfoEXT calibrated_timestamp_infos[] = {
+        {
+            .sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+            .timeDomain = VK_TIME_DOMAIN_DEVICE_EXT,
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+            .timeDomain = graphics->timestamps->host_domain,
+        },
+    };
+    const VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+        .commandPool = graphics->command_pool,
+    };
+    const VkCommandBufferBeginInfo command_buffer_begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    VkCommandBuffer command_buffer;
+    const VkSubmitInfo submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &command_buffer,
+    };
+    uint64_t calibrated[2];
+    uint64_t deviation;
+    uint64_t value;
+    Uint64 host_before;
+    Uint64 host_after;
+
+    timestamps = graphics->timestamps;
+    if (timestamps->get_calibrated_timestamps != NULL)
+    {
+        VK_CHECK_RESULT(
+            timestamps->get_calibrated_timestamps(
+                graphics->logical_device,
+                2,
+                &calibrated_timestamp_infos[0],
+                &calibrated[0],
+                &deviation))
+        timestamps->device_base = calibrated[0] & timestamps->valid_mask;
+        timestamps->host_base = (Uint64)calibrated[1];
+        goto done;
+    }
+
+    VK_CHECK_RESULT(
+        vkAllocateCommandBuffers(
+            graphics->logical_device,
+            &command_buffer_allocate_info,
+            &command_buffer))
+    VK_CHECK_RESULT(
+        vkBeginCommandBuffer(
+            command_buffer,
+            &command_buffer_begin_info))
+    vkCmdResetQueryPool(command_buffer, timestamps->query_pool, 0, 1);
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestamps->query_pool, 0);
+    VK_CHECK_RESULT(vkEndCommandBuffer(command_buffer))
+
+    host_before = SDL_GetPerformanceCounter();
+    CUBE_ASSERT(
+        graphics_sync_submit(
+            graphics,
+            &submit_info,
+            &value) == CUBE_SUCCESS,
+        "failed to submit calibration")
+    CUBE_ASSERT(graphics_sync_wait(graphics, value) == CUBE_SUCCESS, "failed to wait for calibration")
+    host_after = SDL_GetPerformanceCounter();
+    vkFreeCommandBuffers(graphics->logical_device, graphics->command_pool, 1, &command_buffer);
+
+    VK_CHECK_RESULT(
+        vkGetQueryPoolResults(
+            graphics->logical_device,
+            timestamps->query_pool,
+            0,
+            1,
+            sizeof(calibrated[0]),
+            &calibrated[0],
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT))
+    timestamps->device_base = calibrated[0] & timestamps->valid_mask;
+    timestamps->host_base = host_before + (host_after - host_before) / 2;
+    CUBE_END_FUNCTION
+}
+
+// device ticks are period nanoseconds apart, the host domain is the one the performance counter reads
+Uint64 graphics_timestamps_host(const cube_timestamps *timestamps, uint64_t device)
+{
+    uint64_t difference;
+    Sint64 ticks;
+
+    // the device counter may wrap at fewer than 64 bits, a difference past half the range is negative
+    difference = (device - timestamps->device_base) & timestamps->valid_mask;
+    ticks = (Sint64)difference;
+    if (timestamps->valid_mask != UINT64_MAX && difference > timestamps->valid_mask / 2)
+    {
+        ticks -= (Sint64)timestamps->valid_mask + 1;
+    }
+    return timestamps->host_base +
+           (Uint64)(Sint64)((double)ticks * (double)timestamps->period * (double)SDL_GetPerformanceFrequency() / 1e9);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,605 @@
+#include "cube.h"
+
+#define CUBE_INSTANCE_COUNT_VARIABLE "CUBE_INSTANCE_COUNT"
+#define CUBE_TRANSFORM_LANES 8
+// the object mesh spans -0.5 to 0.5 on every axis
+#define CUBE_TRANSFORM_OBJECT_HALF_EXTENT 0.5f
+
+static int graphics_create_transform_arrays(cube_transforms *transforms, uint32_t count);
+static void graphics_create_transform_grid(cube_transforms *transforms);
+static void graphics_transforms_rotate_scalar(
+    cube_transforms *transforms,
+    uint32_t begin,
+    uint32_t end,
+    const float rotation[4]);
+static void graphics_transforms_compute_scalar(
+    const cube_transforms *transforms,
+    uint32_t begin,
+    uint32_t end,
+    float (*matrices)[4][4]);
+#if defined(CUBE_SSE2)
+static uint32_t graphics_transforms_rotate_sse2(
+    cube_transforms *transforms,
+    uint32_t begin,
+    uint32_t end,
+    const float rotation[4]);
+static uint32_t graphics_transforms_compute_sse2(
+    const cube_transforms *transforms,
+    uint32_t begin,
+    uint32_t end,
+    float (*matrices)[4][4]);
+#endif
+#if defined(CUBE_AVX2)
+static uint32_t graphics_transforms_rotate_avx2(
+    cube_transforms *transforms,
+    uint32_t begin,
+    uint32_t end,
+    const float rotation[4]);
+static uint32_t graphics_transforms_compute_avx2(
+    const cube_transforms *transforms,
+    uint32_t begin,
+    uint32_t end,
+    float (*matrices)[4][4]);
+#endif
+
+int graphics_create_transforms(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    const char *count_variable;
+    int requested_count;
+
+    count_variable = SDL_getenv(CUBE_INSTANCE_COUNT_VARIABLE);
+    requested_count = (count_variable != NULL) ? SDL_atoi(count_variable) : 1;
+    graphics->instance_count = (requested_count > 0) ? (uint32_t)requested_count : 1;
+
+    graphics->transforms = calloc(1, sizeof(cube_transforms));
+    CUBE_ASSERT(graphics->transforms != NULL, "failed to allocate transforms")
+
+    CUBE_ASSERT(
+        graphics_create_transform_arrays(
+            graphics->transforms,
+            graphics->instance_count) == CUBE_SUCCESS,
+        "failed to allocate transform arrays")
+
+    graphics_create_transform_grid(graphics->transforms);
+    CUBE_END_FUNCTION
+}
+
+void graphics_transforms_rotate(
+    cube_transforms *transforms,
+    uint32_t first,
+    uint32_t count,
+    const float rotation[4])
+{
+    uint32_t index;
+    uint32_t end;
+
+    index = first;
+    end = first + count;
+#if defined(CUBE_AVX2)
+    index = graphics_transforms_rotate_avx2(transforms, index, end, rotation);
+#endif
+#if defined(CUBE_SSE2)
+    index = graphics_transforms_rotate_sse2(transforms, index, end, rotation);
+#endif
+    graphics_transforms_rotate_scalar(transforms, index, end, rotation);
+}
+
+void graphics_transforms_compute(
+    const cube_transforms *transforms,
+    uint32_t first,
+    uint32_t count,
+    float (*matrices)[4][4])
+{
+    uint32_t index;
+    uint32_t end;
+
+    index = first;
+    end = first + count;
+    // the vector kernels use streaming stores, which need aligned rows
+    if (((uintptr_t)matrices & 31) == 0)
+    {
+#if defined(CUBE_AVX2)
+        index = graphics_transforms_compute_avx2(transforms, index, end, matrices);
+#endif
+#if defined(CUBE_SSE2)
+        index = graphics_transforms_compute_sse2(transforms, index, end, matrices);
+        _mm_sfence();
+#endif
+    }
+    graphics_transforms_compute_scalar(transforms, index, end, matrices);
+}
+
+// center and radius of a sphere enclosing the instance under any rotation
+void graphics_transforms_sphere(
+    const cube_transforms *transforms,
+    uint32_t index,
+    float sphere[4])
+{
+    float sx, sy, sz;
+
+    sx = *(transforms->scale_x + index);
+    sy = *(transforms->scale_y + index);
+    sz = *(transforms->scale_z + index);
+    sphere[0] = *(transforms->position_x + index);
+    sphere[1] = *(transforms->position_y + index);
+    sphere[2] = *(transforms->position_z + index);
+    sphere[3] = CUBE_TRANSFORM_OBJECT_HALF_EXTENT * sqrtf(sx * sx + sy * sy + sz * sz);
+}
+
+void graphics_destroy_transforms(cube_graphics *graphics)
+{
+    cube_transforms *transforms;
+
+    transforms = graphics->transforms;
+    if (transforms != NULL)
+    {
+        SDL_SIMDFree(transforms->position_x);
+        SDL_SIMDFree(transforms->position_y);
+        SDL_SIMDFree(transforms->position_z);
+        SDL_SIMDFree(transforms->rotation_x);
+        SDL_SIMDFree(transforms->rotation_y);
+        SDL_SIMDFree(transforms->rotation_z);
+        SDL_SIMDFree(transforms->rotation_w);
+        SDL_SIMDFree(transforms->scale_x);
+        SDL_SIMDFree(transforms->scale_y);
+        SDL_SIMDFree(transforms->scale_z);
+        free(transforms);
+        graphics->transforms = NULL;
+    }
+}
+
+int graphics_create_transform_arrays(cube_transforms *transforms, uint32_t count)
+{
+    CUBE_BEGIN_FUNCTION
+    float **arrays[] = {
+        &transforms->position_x,
+        &transforms->position_y,
+        &transforms->position_z,
+        &transforms->rotation_x,
+        &transforms->rotation_y,
+        &transforms->rotation_z,
+        &transforms->rotation_w,
+        &transforms->scale_x,
+        &transforms->scale_y,
+        &transforms->scale_z,
+    };
+    uint32_t array_index;
+
+    transforms->count = count;
+    transforms->capacity = (count + CUBE_TRANSFORM_LANES - 1) & ~(uint32_t)(CUBE_TRANSFORM_LANES - 1);
+    for (array_index = 0; array_index < sizeof(arrays) / sizeof(arrays[0]); array_index++)
+    {
+        *arrays[array_index] = SDL_SIMDAlloc(transforms->capacity * sizeof(float));
+        CUBE_ASSERT(*arrays[array_index] != NULL, "failed to allocate transform array")
+    }
+    CUBE_END_FUNCTION
+}
+
+void graphics_create_transform_grid(cube_transforms *transforms)
+{
+    uint32_t side;
+    uint32_t index;
+    float scale;
+
+    side = 1;
+    while ((uint64_t)side * side * side < transforms->count)
+    {
+        side++;
+    }
+    // the whole grid spans the unit cube the single object used to occupy
+    scale = 1.0f / (float)side;
+    for (index = 0; index < transforms->capacity; index++)
+    {
+        *(transforms->position_x + index) = (float)(2 * (int)(index % side) + 1 - (int)side) * scale;
+        *(transforms->position_y + index) = (float)(2 * (int)((index / side) % side) + 1 - (int)side) * scale;
+        *(transforms->position_z + index) = (float)(2 * (int)((index / side / side) % side) + 1 - (int)side) * scale;
+        *(transforms->rotation_x + index) = 0.0f;
+        *(transforms->rotation_y + index) = 0.0f;
+        *(transforms->rotation_z + index) = 0.0f;
+        *(transforms->rotation_w + index) = 1.0f;
+        *(transforms->scale_x + index) = scale;
+        *(transforms->scale_y + index) = scale;
+        *(transforms->scale_z + index) = scale;
+    }
+}
+
+void graphics_transforms_rotate_scalar(
+    cube_transforms *transforms,
+    uint32_t begin,
+    uint32_t end,
+    const float rotation[4])
+{
+    uint32_t index;
+    float x, y, z, w;
+    float rotated_x, rotated_y, rotated_z, rotated_w;
+    float inverse_length;
+
+    for (index = begin; index < end; index++)
+    {
+        x = *(transforms->rotation_x + index);
+        y = *(transforms->rotation_y + index);
+        z = *(transforms->rotation_z + index);
+        w = *(transforms->rotation_w + index);
+        rotated_x = rotation[3] * x + rotation[0] * w + rotation[1] * z - rotation[2] * y;
+        rotated_y = rotation[3] * y - rotation[0] * z + rotation[1] * w + rotation[2] * x;
+        rotated_z = rotation[3] * z + rotation[0] * y - rotation[1] * x + rotation[2] * w;
+        rotated_w = rotation[3] * w - rotation[0] * x - rotation[1] * y - rotation[2] * z;
+        inverse_length = 1.0f / sqrtf(
+                                    rotated_x * rotated_x +
+                                    rotated_y * rotated_y +
+                                    rotated_z * rotated_z +
+                                    rotated_w * rotated_w);
+        *(transforms->rotation_x + index) = rotated_x * inverse_length;
+        *(transforms->rotation_y + index) = rotated_y * inverse_length;
+        *(transforms->rotation_z + index) = rotated_z * inverse_length;
+        *(transforms->rotation_w + index) = rotated_w * inverse_length;
+    }
+}
+
+void graphics_transforms_compute_scalar(
+    const cube_transforms *transforms,
+    uint32_t begin,
+    uint32_t end,
+    float (*matrices)[4][4])
+{
+    uint32_t index;
+    float x, y, z, w;
+    float sx, sy, sz;
+    float(*matrix)[4];
+
+    for (index = begin; index < end; index++)
+    {
+        x = *(transforms->rotation_x + index);
+        y = *(transforms->rotation_y + index);
+        z = *(transforms->rotation_z + index);
+        w = *(transforms->rotation_w + index);
+        sx = *(transforms->scale_x + index);
+        sy = *(transforms->scale_y + index);
+        sz = *(transforms->scale_z + index);
+        matrix = *(matrices + index);
+
+        matrix[0][0] = (1.0f - 2.0f * (y * y + z * z)) * sx;
+        matrix[0][1] = 2.0f * (x * y + w * z) * sx;
+        matrix[0][2] = 2.0f * (x * z - w * y) * sx;
+        matrix[0][3] = 0.0f;
+        matrix[1][0] = 2.0f * (x * y - w * z) * sy;
+        matrix[1][1] = (1.0f - 2.0f * (x * x + z * z)) * sy;
+        matrix[1][2] = 2.0f * (y * z + w * x) * sy;
+        matrix[1][3] = 0.0f;
+        matrix[2][0] = 2.0f * (x * z + w * y) * sz;
+        matrix[2][1] = 2.0f * (y * z - w * x) * sz;
+        matrix[2][2] = (1.0f - 2.0f * (x * x + y * y)) * sz;
+        matrix[2][3] = 0.0f;
+        matrix[3][0] = *(transforms->position_x + index);
+        matrix[3][1] = *(transforms->position_y + index);
+        matrix[3][2] = *(transforms->position_z + index);
+        matrix[3][3] = 1.0f;
+    }
+}
+
+#if defined(CUBE_SSE2)
+uint32_t graphics_transforms_rotate_sse2(
+    cube_transforms *transforms,
+    uint32_t begin,
+    uint32_t end,
+    const float rotation[4])
+{
+    const __m128 rotation_x = _mm_set1_ps(rotation[0]);
+    const __m128 rotation_y = _mm_set1_ps(rotation[1]);
+    const __m128 rotation_z = _mm_set1_ps(rotation[2]);
+    const __m128 rotation_w = _mm_set1_ps(rotation[3]);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 three_halves = _mm_set1_ps(1.5f);
+    __m128 x, y, z, w;
+    __m128 rotated_x, rotated_y, rotated_z, rotated_w;
+    __m128 length, inverse_length;
+    uint32_t index;
+
+    for (index = begin; index + 4 <= end; index += 4)
+    {
+        x = _mm_loadu_ps(transforms->rotation_x + index);
+        y = _mm_loadu_ps(transforms->rotation_y + index);
+        z = _mm_loadu_ps(transforms->rotation_z + index);
+        w = _mm_loadu_ps(transforms->rotation_w + index);
+
+        rotated_x = _mm_sub_ps(
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(rotation_w, x), _mm_mul_ps(rotation_x, w)),
+                _mm_mul_ps(rotation_y, z)),
+            _mm_mul_ps(rotation_z, y));
+        rotated_y = _mm_add_ps(
+            _mm_add_ps(
+                _mm_sub_ps(_mm_mul_ps(rotation_w, y), _mm_mul_ps(rotation_x, z)),
+                _mm_mul_ps(rotation_y, w)),
+            _mm_mul_ps(rotation_z, x));
+        rotated_z = _mm_add_ps(
+            _mm_sub_ps(
+                _mm_add_ps(_mm_mul_ps(rotation_w, z), _mm_mul_ps(rotation_x, y)),
+                _mm_mul_ps(rotation_y, x)),
+            _mm_mul_ps(rotation_z, w));
+        rotated_w = _mm_sub_ps(
+            _mm_sub_ps(
+                _mm_sub_ps(_mm_mul_ps(rotation_w, w), _mm_mul_ps(rotation_x, x)),
+                _mm_mul_ps(rotation_y, y)),
+            _mm_mul_ps(rotation_z, z));
+
+        length = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(rotated_x, rotated_x), _mm_mul_ps(rotated_y, rotated_y)),
+            _mm_add_ps(_mm_mul_ps(rotated_z, rotated_z), _mm_mul_ps(rotated_w, rotated_w)));
+        // one newton step on the estimate keeps the drift below float epsilon
+        inverse_length = _mm_rsqrt_ps(length);
+        inverse_length = _mm_mul_ps(
+            inverse_length,
+            _mm_sub_ps(
+                three_halves,
+                _mm_mul_ps(_mm_mul_ps(half, length), _mm_mul_ps(inverse_length, inverse_length))));
+
+        _mm_storeu_ps(transforms->rotation_x + index, _mm_mul_ps(rotated_x, inverse_length));
+        _mm_storeu_ps(transforms->rotation_y + index, _mm_mul_ps(rotated_y, inverse_length));
+        _mm_storeu_ps(transforms->rotation_z + index, _mm_mul_ps(rotated_z, inverse_length));
+        _mm_storeu_ps(transforms->rotation_w + index, _mm_mul_ps(rotated_w, inverse_length));
+    }
+    return index;
+}
+
+uint32_t graphics_transforms_compute_sse2(
+    const cube_transforms *transforms,
+    uint32_t begin,
+    uint32_t end,
+    float (*matrices)[4][4])
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    __m128 x, y, z, w;
+    __m128 xx, yy, zz, xy, xz, yz, wx, wy, wz;
+    __m128 sx, sy, sz;
+    __m128 row_0, row_1, row_2, row_3;
+    uint32_t index;
+    uint32_t lane;
+
+    for (index = begin; index + 4 <= end; index += 4)
+    {
+        x = _mm_loadu_ps(transforms->rotation_x + index);
+        y = _mm_loadu_ps(transforms->rotation_y + index);
+        z = _mm_loadu_ps(transforms->rotation_z + index);
+        w = _mm_loadu_ps(transforms->rotation_w + index);
+        sx = _mm_loadu_ps(transforms->scale_x + index);
+        sy = _mm_loadu_ps(transforms->scale_y + index);
+        sz = _mm_loadu_ps(transforms->scale_z + index);
+
+        xx = _mm_mul_ps(x, x);
+        yy = _mm_mul_ps(y, y);
+        zz = _mm_mul_ps(z, z);
+        xy = _mm_mul_ps(x, y);
+        xz = _mm_mul_ps(x, z);
+        yz = _mm_mul_ps(y, z);
+        wx = _mm_mul_ps(w, x);
+        wy = _mm_mul_ps(w, y);
+        wz = _mm_mul_ps(w, z);
+
+        // each column is built across four instances, then transposed into place
+        row_0 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+        row_1 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+        row_2 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+        row_3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(row_0, row_1, row_2, row_3);
+        _mm_stream_ps(&matrices[index + 0][0][0], row_0);
+        _mm_stream_ps(&matrices[index + 1][0][0], row_1);
+        _mm_stream_ps(&matrices[index + 2][0][0], row_2);
+        _mm_stream_ps(&matrices[index + 3][0][0], row_3);
+
+        row_0 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+        row_1 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+        row_2 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+        row_3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(row_0, row_1, row_2, row_3);
+        _mm_stream_ps(&matrices[index + 0][1][0], row_0);
+        _mm_stream_ps(&matrices[index + 1][1][0], row_1);
+        _mm_stream_ps(&matrices[index + 2][1][0], row_2);
+        _mm_stream_ps(&matrices[index + 3][1][0], row_3);
+
+        row_0 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+        row_1 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+        row_2 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+        row_3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(row_0, row_1, row_2, row_3);
+        _mm_stream_ps(&matrices[index + 0][2][0], row_0);
+        _mm_stream_ps(&matrices[index + 1][2][0], row_1);
+        _mm_stream_ps(&matrices[index + 2][2][0], row_2);
+        _mm_stream_ps(&matrices[index + 3][2][0], row_3);
+
+        for (lane = 0; lane < 4; lane++)
+        {
+            _mm_stream_ps(
+                &matrices[index + lane][3][0],
+                _mm_setr_ps(
+                    *(transforms->position_x + index + lane),
+                    *(transforms->position_y + index + lane),
+                    *(transforms->position_z + index + lane),
+                    1.0f));
+        }
+    }
+    return index;
+}
+#endif
+
+#if defined(CUBE_AVX2)
+static void graphics_transforms_transpose_avx2(
+    __m256 row_0,
+    __m256 row_1,
+    __m256 row_2,
+    __m256 row_3,
+    __m256 next_row_0,
+    __m256 next_row_1,
+    __m256 next_row_2,
+    __m256 next_row_3,
+    __m256 low_lanes[4],
+    __m256 high_lanes[4])
+{
+    __m256 low_0, low_1, high_0, high_1;
+    __m256 columns[4];
+    __m256 next_columns[4];
+    uint32_t lane;
+
+    // 4x4 transpose inside each 128 bit half: lane n holds instance n and n + 4
+    low_0 = _mm256_unpacklo_ps(row_0, row_1);
+    high_0 = _mm256_unpackhi_ps(row_0, row_1);
+    low_1 = _mm256_unpacklo_ps(row_2, row_3);
+    high_1 = _mm256_unpackhi_ps(row_2, row_3);
+    columns[0] = _mm256_shuffle_ps(low_0, low_1, _MM_SHUFFLE(1, 0, 1, 0));
+    columns[1] = _mm256_shuffle_ps(low_0, low_1, _MM_SHUFFLE(3, 2, 3, 2));
+    columns[2] = _mm256_shuffle_ps(high_0, high_1, _MM_SHUFFLE(1, 0, 1, 0));
+    columns[3] = _mm256_shuffle_ps(high_0, high_1, _MM_SHUFFLE(3, 2, 3, 2));
+
+    low_0 = _mm256_unpacklo_ps(next_row_0, next_row_1);
+    high_0 = _mm256_unpackhi_ps(next_row_0, next_row_1);
+    low_1 = _mm256_unpacklo_ps(next_row_2, next_row_3);
+    high_1 = _mm256_unpackhi_ps(next_row_2, next_row_3);
+    next_columns[0] = _mm256_shuffle_ps(low_0, low_1, _MM_SHUFFLE(1, 0, 1, 0));
+    next_columns[1] = _mm256_shuffle_ps(low_0, low_1, _MM_SHUFFLE(3, 2, 3, 2));
+    next_columns[2] = _mm256_shuffle_ps(high_0, high_1, _MM_SHUFFLE(1, 0, 1, 0));
+    next_columns[3] = _mm256_shuffle_ps(high_0, high_1, _MM_SHUFFLE(3, 2, 3, 2));
+
+    // pair two adjacent matrix columns so each instance takes 32 byte stores
+    for (lane = 0; lane < 4; lane++)
+    {
+        low_lanes[lane] = _mm256_permute2f128_ps(columns[lane], next_columns[lane], 0x20);
+        high_lanes[lane] = _mm256_permute2f128_ps(columns[lane], next_columns[lane], 0x31);
+    }
+}
+
+uint32_t graphics_transforms_rotate_avx2(
+    cube_transforms *transforms,
+    uint32_t begin,
+    uint32_t end,
+    const float rotation[4])
+{
+    const __m256 rotation_x = _mm256_set1_ps(rotation[0]);
+    const __m256 rotation_y = _mm256_set1_ps(rotation[1]);
+    const __m256 rotation_z = _mm256_set1_ps(rotation[2]);
+    const __m256 rotation_w = _mm256_set1_ps(rotation[3]);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 three_halves = _mm256_set1_ps(1.5f);
+    __m256 x, y, z, w;
+    __m256 rotated_x, rotated_y, rotated_z, rotated_w;
+    __m256 length, inverse_length;
+    uint32_t index;
+
+    for (index = begin; index + 8 <= end; index += 8)
+    {
+        x = _mm256_loadu_ps(transforms->rotation_x + index);
+        y = _mm256_loadu_ps(transforms->rotation_y + index);
+        z = _mm256_loadu_ps(transforms->rotation_z + index);
+        w = _mm256_loadu_ps(transforms->rotation_w + index);
+
+        rotated_x = _mm256_fnmadd_ps(
+            rotation_z, y,
+            _mm256_fmadd_ps(rotation_y, z, _mm256_fmadd_ps(rotation_x, w, _mm256_mul_ps(rotation_w, x))));
+        rotated_y = _mm256_fmadd_ps(
+            rotation_z, x,
+            _mm256_fmadd_ps(rotation_y, w, _mm256_fnmadd_ps(rotation_x, z, _mm256_mul_ps(rotation_w, y))));
+        rotated_z = _mm256_fmadd_ps(
+            rotation_z, w,
+            _mm256_fnmadd_ps(rotation_y, x, _mm256_fmadd_ps(rotation_x, y, _mm256_mul_ps(rotation_w, z))));
+        rotated_w = _mm256_fnmadd_ps(
+            rotation_z, z,
+            _mm256_fnmadd_ps(rotation_y, y, _mm256_fnmadd_ps(rotation_x, x, _mm256_mul_ps(rotation_w, w))));
+
+        length = _mm256_fmadd_ps(
+            rotated_x, rotated_x,
+            _mm256_fmadd_ps(
+                rotated_y, rotated_y,
+                _mm256_fmadd_ps(rotated_z, rotated_z, _mm256_mul_ps(rotated_w, rotated_w))));
+        inverse_length = _mm256_rsqrt_ps(length);
+        inverse_length = _mm256_mul_ps(
+            inverse_length,
+            _mm256_fnmadd_ps(
+                _mm256_mul_ps(half, length),
+                _mm256_mul_ps(inverse_length, inverse_length),
+                three_halves));
+
+        _mm256_storeu_ps(transforms->rotation_x + index, _mm256_mul_ps(rotated_x, inverse_length));
+        _mm256_storeu_ps(transforms->rotation_y + index, _mm256_mul_ps(rotated_y, inverse_length));
+        _mm256_storeu_ps(transforms->rotation_z + index, _mm256_mul_ps(rotated_z, inverse_length));
+        _mm256_storeu_ps(transforms->rotation_w + index, _mm256_mul_ps(rotated_w, inverse_length));
+    }
+    return index;
+}
+
+
+uint32_t graphics_transforms_compute_avx2(
+    const cube_transforms *transforms,
+    uint32_t begin,
+    uint32_t end,
+    float (*matrices)[4][4])
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 x, y, z, w;
+    __m256 xx, yy, zz, xy, xz, yz, wx, wy, wz;
+    __m256 sx, sy, sz;
+    __m256 first_columns_low[4], first_columns_high[4];
+    __m256 last_columns_low[4], last_columns_high[4];
+    uint32_t index;
+    uint32_t lane;
+
+    for (index = begin; index + 8 <= end; index += 8)
+    {
+        x = _mm256_loadu_ps(transforms->rotation_x + index);
+        y = _mm256_loadu_ps(transforms->rotation_y + index);
+        z = _mm256_loadu_ps(transforms->rotation_z + index);
+        w = _mm256_loadu_ps(transforms->rotation_w + index);
+        sx = _mm256_loadu_ps(transforms->scale_x + index);
+        sy = _mm256_loadu_ps(transforms->scale_y + index);
+        sz = _mm256_loadu_ps(transforms->scale_z + index);
+
+        xx = _mm256_mul_ps(x, x);
+        yy = _mm256_mul_ps(y, y);
+        zz = _mm256_mul_ps(z, z);
+        xy = _mm256_mul_ps(x, y);
+        xz = _mm256_mul_ps(x, z);
+        yz = _mm256_mul_ps(y, z);
+        wx = _mm256_mul_ps(w, x);
+        wy = _mm256_mul_ps(w, y);
+        wz = _mm256_mul_ps(w, z);
+
+        graphics_transforms_transpose_avx2(
+            _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), sx),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx),
+            zero,
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+            _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), sy),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy),
+            zero,
+            &first_columns_low[0],
+            &first_columns_high[0]);
+        graphics_transforms_transpose_avx2(
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+            _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+            _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), sz),
+            zero,
+            _mm256_loadu_ps(transforms->position_x + index),
+            _mm256_loadu_ps(transforms->position_y + index),
+            _mm256_loadu_ps(transforms->position_z + index),
+            one,
+            &last_columns_low[0],
+            &last_columns_high[0]);
+
+        // write whole matrices in order so write combining sees full lines
+        for (lane = 0; lane < 4; lane++)
+        {
+            _mm256_stream_ps(&matrices[index + lane][0][0], first_columns_low[lane]);
+            _mm256_stream_ps(&matrices[index + lane][2][0], last_columns_low[lane]);
+        }
+        for (lane = 0; lane < 4; lane++)
+        {
+            _mm256_stream_ps(&matrices[index + lane + 4][0][0], first_columns_high[lane]);
+            _mm256_stream_ps(&matrices[index + lane + 4][2][0], last_columns_high[lane]);
+        }
+    }
+    return index;
+}
+#endif
\ No newline at end of file
@@ -6,6 +6,25 @@ static int graphics_util_copy_buffer(
     VkBuffer destination,
     VkDeviceSize size);
 
+// shaders past the baseline pair only exist when glslc was found at configure time
+VkBool32 graphics_util_has_shader(cube_graphics *graphics, const char *shader_file)
+{
+    const cube_resources *resources;
+    uint32_t resource_index;
+
+    resources = graphics->resources;
+    for (resource_index = resources->type_first[CUBE_RESOURCE_SHADER];
+         resource_index < resources->type_first[CUBE_RESOURCE_SHADER] + resources->type_count[CUBE_RESOURCE_SHADER];
+         resource_index++)
+    {
+        if (SDL_strcmp((resources->resources + resource_index)->file_name, shader_file) == 0)
+        {
+            return VK_TRUE;
+        }
+    }
+    return VK_FALSE;
+}
+
 int graphics_util_load_shader(
     cube_graphics *graphics,
     const char *shader_file,
@@ -15,20 +34,26 @@ int graphics_util_load_shader(
     VkShaderModuleCreateInfo shader_module_create_info = {
         .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
     };
-    char *shader_path;
+    const cube_resource *resource;
+    uint32_t resource_index;
+
     CUBE_ASSERT(
-        SDL_asprintf(
-            &shader_path,
-            "%s%s%s",
-            graphics->shader_directory,
-            PATH_SEPARATOR,
-            shader_file) >= 0,
-        "failed to allocate shader path")
-    CUBE_PUSH((void *)shader_path);
-
-    shader_module_create_info.pCode = SDL_LoadFile(shader_path, &shader_module_create_info.codeSize);
-    CUBE_ASSERT(shader_module_create_info.pCode != NULL, "failed to load shader code")
-    CUBE_PUSH((void *)shader_module_create_info.pCode);
+        application_resources_find(
+            graphics->resources,
+            CUBE_RESOURCE_SHADER,
+            shader_file,
+            &resource_index) == CUBE_SUCCESS,
+        "failed to find shader")
+    CUBE_ASSERT(
+        application_resources_wait(
+            graphics->resources,
+            resource_index) == CUBE_SUCCESS,
+        "failed to load shader code")
+
+    // the code stays with the resource, several pipelines share a module file
+    resource = graphics->resources->resources + resource_index;
+    shader_module_create_info.pCode = resource->data;
+    shader_module_create_info.codeSize = resource->size;
 
     VK_CHECK_RESULT(
         vkCreateShaderModule(
@@ -70,6 +95,7 @@ int graphics_util_upload_buffer(
     VkBuffer staging_buffer;
     VmaAllocation staging_buffer_allocation;
     VmaAllocationInfo staging_buffer_allocation_info;
+    CUBE_PROFILE_BEGIN(upload_zone)
 
     VK_CHECK_RESULT(
         vmaCreateBuffer(
@@ -99,7 +125,15 @@ int graphics_util_upload_buffer(
             size) == CUBE_SUCCESS,
         "failed to copy buffer")
 
-    vmaDestroyBuffer(graphics->allocator, staging_buffer, staging_buffer_allocation);
+    // the copy is still in flight, the staging buffer goes once the timeline passes it
+    CUBE_ASSERT(
+        graphics_sync_defer_buffer(
+            graphics,
+            staging_buffer,
+            staging_buffer_allocation) == CUBE_SUCCESS,
+        "failed to defer staging buffer")
+    CUBE_PROFILE_END(upload_zone, "graphics_util_upload_buffer")
+    CUBE_PROFILE_COUNTER("uploaded bytes", size)
 
     CUBE_END_FUNCTION
 }
@@ -124,6 +158,12 @@ int graphics_util_copy_buffer(
     const VkBufferCopy buffer_copy = {
         .size = size,
     };
+    // later submissions read the buffer without waiting for the copy on the host
+    const VkMemoryBarrier memory_barrier = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+    };
     VkCommandBuffer command_buffer;
     const VkSubmitInfo submit_info = {
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
@@ -142,19 +182,97 @@ int graphics_util_copy_buffer(
             command_buffer,
             &command_buffer_begin_info))
     vkCmdCopyBuffer(command_buffer, source, destination, 1, &buffer_copy);
+    vkCmdPipelineBarrier(
+        command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        0,
+        1, &memory_barrier,
+        0, NULL,
+        0, NULL);
 
     VK_CHECK_RESULT(
         vkEndCommandBuffer(command_buffer))
 
-    VK_CHECK_RESULT(
-        vkQueueSubmit(
-            graphics->graphics_queue,
-            1,
-            &submit_info, VK_NULL_HANDLE))
+    CUBE_ASSERT(
+        graphics_sync_submit(
+            graphics,
+            &submit_info,
+            NULL) == CUBE_SUCCESS,
+        "failed to submit copy")
+    CUBE_ASSERT(
+        graphics_sync_defer_command_buffer(
+            graphics,
+            command_buffer) == CUBE_SUCCESS,
+        "failed to defer copy command buffer")
 
-    VK_CHECK_RESULT(
-        vkQueueWaitIdle(
-            graphics->graphics_queue))
+    CUBE_END_FUNCTION
+}
 
+
+int graphics_util_rotate(
+    float model[4][4],
+    float angle,
+    float axis[3],
+    cube_ubo *ubo)
+{
+    CUBE_BEGIN_FUNCTION
+    const cube_vec3 rotation_axis = {
+        .x = axis[0],
+        .y = axis[1],
+        .z = axis[2],
+    };
+    cube_mat4 matrix;
+
+    CUBE_ASSERT(ubo != NULL, "invalid ubo")
+    SDL_memcpy(&matrix.m[0][0], &model[0][0], sizeof(matrix.m));
+    graphics_mat4_rotate(&matrix, angle, &rotation_axis, &matrix);
+    SDL_memcpy(&ubo->model[0][0], &matrix.m[0][0], sizeof(ubo->model));
     CUBE_END_FUNCTION
 }
+
+int graphics_util_look_at(
+    float eye[3],
+    float center[3],
+    float up[3],
+    cube_ubo *ubo)
+{
+    CUBE_BEGIN_FUNCTION
+    const cube_vec3 eye_position = {
+        .x = eye[0],
+        .y = eye[1],
+        .z = eye[2],
+    };
+    const cube_vec3 center_position = {
+        .x = center[0],
+        .y = center[1],
+        .z = center[2],
+    };
+    const cube_vec3 up_direction = {
+        .x = up[0],
+        .y = up[1],
+        .z = up[2],
+    };
+    cube_mat4 matrix;
+
+    CUBE_ASSERT(ubo != NULL, "invalid ubo")
+    graphics_mat4_look_at(&eye_position, &center_position, &up_direction, &matrix);
+    SDL_memcpy(&ubo->view[0][0], &matrix.m[0][0], sizeof(ubo->view));
+    CUBE_END_FUNCTION
+}
+
+int graphics_util_perspective(
+    float fov,
+    float aspect,
+    float znear,
+    float zfar,
+    cube_ubo *ubo)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_mat4 matrix;
+
+    CUBE_ASSERT(ubo != NULL, "invalid ubo")
+    graphics_mat4_perspective(fov, aspect, znear, zfar, &matrix);
+    SDL_memcpy(&ubo->projection[0][0], &matrix.m[0][0], sizeof(ubo->projection));
+    CUBE_END_FUNCTION
+}
\ No newline at end of file
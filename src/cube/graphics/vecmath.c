@@ -0,0 +1,446 @@
+#include "cube.h"
+
+#if defined(CUBE_SSE2)
+#define CUBE_SHUFFLE(A, B, X, Y, Z, W) _mm_shuffle_ps(A, B, _MM_SHUFFLE(W, Z, Y, X))
+#define CUBE_SWIZZLE(A, X, Y, Z, W) CUBE_SHUFFLE(A, A, X, Y, Z, W)
+
+static __m128 graphics_mat4_multiply_column_sse2(
+    __m128 column_0,
+    __m128 column_1,
+    __m128 column_2,
+    __m128 column_3,
+    __m128 column);
+static __m128 graphics_mat2_multiply_sse2(__m128 a, __m128 b);
+static __m128 graphics_mat2_adjugate_multiply_sse2(__m128 a, __m128 b);
+static __m128 graphics_mat2_multiply_adjugate_sse2(__m128 a, __m128 b);
+static int graphics_mat4_inverse_sse2(const cube_mat4 *matrix, cube_mat4 *out);
+#endif
+
+float graphics_vec3_dot(const cube_vec3 *a, const cube_vec3 *b)
+{
+    return a->x * b->x + a->y * b->y + a->z * b->z;
+}
+
+void graphics_vec3_cross(const cube_vec3 *a, const cube_vec3 *b, cube_vec3 *out)
+{
+    const cube_vec3 cross = {
+        .x = a->y * b->z - a->z * b->y,
+        .y = a->z * b->x - a->x * b->z,
+        .z = a->x * b->y - a->y * b->x,
+    };
+    *out = cross;
+}
+
+void graphics_vec3_normalize(const cube_vec3 *vector, cube_vec3 *out)
+{
+    float length;
+
+    length = sqrtf(graphics_vec3_dot(vector, vector));
+    if (length > 0.0f)
+    {
+        out->x = vector->x / length;
+        out->y = vector->y / length;
+        out->z = vector->z / length;
+    }
+    else
+    {
+        *out = *vector;
+    }
+    out->padding = 0.0f;
+}
+
+void graphics_mat4_transform_vec4(const cube_mat4 *matrix, const cube_vec4 *vector, cube_vec4 *out)
+{
+#if defined(CUBE_SSE2)
+    _mm_store_ps(
+        &out->x,
+        graphics_mat4_multiply_column_sse2(
+            _mm_load_ps(matrix->m[0]),
+            _mm_load_ps(matrix->m[1]),
+            _mm_load_ps(matrix->m[2]),
+            _mm_load_ps(matrix->m[3]),
+            _mm_load_ps(&vector->x)));
+#else
+    const cube_vec4 transformed = {
+        .x = matrix->m[0][0] * vector->x + matrix->m[1][0] * vector->y + matrix->m[2][0] * vector->z + matrix->m[3][0] * vector->w,
+        .y = matrix->m[0][1] * vector->x + matrix->m[1][1] * vector->y + matrix->m[2][1] * vector->z + matrix->m[3][1] * vector->w,
+        .z = matrix->m[0][2] * vector->x + matrix->m[1][2] * vector->y + matrix->m[2][2] * vector->z + matrix->m[3][2] * vector->w,
+        .w = matrix->m[0][3] * vector->x + matrix->m[1][3] * vector->y + matrix->m[2][3] * vector->z + matrix->m[3][3] * vector->w,
+    };
+    *out = transformed;
+#endif
+}
+
+void graphics_quat_from_axis_angle(const cube_vec3 *axis, float angle, cube_quat *out)
+{
+    cube_vec3 unit_axis;
+    float half_sine;
+
+    graphics_vec3_normalize(axis, &unit_axis);
+    half_sine = sinf(angle / 2.0f);
+    out->x = unit_axis.x * half_sine;
+    out->y = unit_axis.y * half_sine;
+    out->z = unit_axis.z * half_sine;
+    out->w = cosf(angle / 2.0f);
+}
+
+void graphics_quat_multiply(const cube_quat *a, const cube_quat *b, cube_quat *out)
+{
+    const cube_quat product = {
+        .x = a->w * b->x + a->x * b->w + a->y * b->z - a->z * b->y,
+        .y = a->w * b->y - a->x * b->z + a->y * b->w + a->z * b->x,
+        .z = a->w * b->z + a->x * b->y - a->y * b->x + a->z * b->w,
+        .w = a->w * b->w - a->x * b->x - a->y * b->y - a->z * b->z,
+    };
+    *out = product;
+}
+
+void graphics_mat4_identity(cube_mat4 *out)
+{
+    const cube_mat4 identity = {
+        .m = {
+            {1.0f, 0.0f, 0.0f, 0.0f},
+            {0.0f, 1.0f, 0.0f, 0.0f},
+            {0.0f, 0.0f, 1.0f, 0.0f},
+            {0.0f, 0.0f, 0.0f, 1.0f},
+        },
+    };
+    *out = identity;
+}
+
+void graphics_mat4_from_quat(const cube_quat *rotation, cube_mat4 *out)
+{
+    const float x = rotation->x;
+    const float y = rotation->y;
+    const float z = rotation->z;
+    const float w = rotation->w;
+    const cube_mat4 matrix = {
+        .m = {
+            {1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f},
+            {2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f},
+            {2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f},
+            {0.0f, 0.0f, 0.0f, 1.0f},
+        },
+    };
+    *out = matrix;
+}
+
+void graphics_mat4_rotate(
+    const cube_mat4 *matrix,
+    float angle,
+    const cube_vec3 *axis,
+    cube_mat4 *out)
+{
+    cube_quat rotation;
+    cube_mat4 rotation_matrix;
+
+    graphics_quat_from_axis_angle(axis, angle, &rotation);
+    graphics_mat4_from_quat(&rotation, &rotation_matrix);
+    graphics_mat4_multiply(matrix, &rotation_matrix, out);
+}
+
+void graphics_mat4_look_at(
+    const cube_vec3 *eye,
+    const cube_vec3 *center,
+    const cube_vec3 *up,
+    cube_mat4 *out)
+{
+    cube_vec3 forward = {
+        .x = center->x - eye->x,
+        .y = center->y - eye->y,
+        .z = center->z - eye->z,
+    };
+    cube_vec3 side;
+    cube_vec3 camera_up;
+
+    graphics_vec3_normalize(&forward, &forward);
+    graphics_vec3_cross(&forward, up, &side);
+    graphics_vec3_normalize(&side, &side);
+    graphics_vec3_cross(&side, &forward, &camera_up);
+
+    out->m[0][0] = side.x;
+    out->m[0][1] = camera_up.x;
+    out->m[0][2] = -forward.x;
+    out->m[0][3] = 0.0f;
+    out->m[1][0] = side.y;
+    out->m[1][1] = camera_up.y;
+    out->m[1][2] = -forward.y;
+    out->m[1][3] = 0.0f;
+    out->m[2][0] = side.z;
+    out->m[2][1] = camera_up.z;
+    out->m[2][2] = -forward.z;
+    out->m[2][3] = 0.0f;
+    out->m[3][0] = -graphics_vec3_dot(&side, eye);
+    out->m[3][1] = -graphics_vec3_dot(&camera_up, eye);
+    out->m[3][2] = graphics_vec3_dot(&forward, eye);
+    out->m[3][3] = 1.0f;
+}
+
+void graphics_mat4_perspective(
+    float fov,
+    float aspect,
+    float znear,
+    float zfar,
+    cube_mat4 *out)
+{
+    const float focal_length = 1.0f / tanf(fov / 2.0f);
+
+    SDL_memset(out, 0, sizeof(cube_mat4));
+    out->m[0][0] = focal_length / aspect;
+    out->m[1][1] = focal_length;
+    out->m[2][2] = -1.0f * (zfar + znear) / (zfar - znear);
+    out->m[2][3] = -1.0f;
+    out->m[3][2] = -1.0f * (2.0f * zfar * znear) / (zfar - znear);
+}
+
+void graphics_mat4_multiply(const cube_mat4 *a, const cube_mat4 *b, cube_mat4 *out)
+{
+#if defined(CUBE_SSE2)
+    const __m128 column_0 = _mm_load_ps(a->m[0]);
+    const __m128 column_1 = _mm_load_ps(a->m[1]);
+    const __m128 column_2 = _mm_load_ps(a->m[2]);
+    const __m128 column_3 = _mm_load_ps(a->m[3]);
+    uint32_t column;
+
+    // every column of a is in registers, so out may alias either input
+    for (column = 0; column < 4; column++)
+    {
+        _mm_store_ps(
+            out->m[column],
+            graphics_mat4_multiply_column_sse2(
+                column_0,
+                column_1,
+                column_2,
+                column_3,
+                _mm_load_ps(b->m[column])));
+    }
+#else
+    graphics_mat4_multiply_scalar(a, b, out);
+#endif
+}
+
+void graphics_mat4_multiply_scalar(const cube_mat4 *a, const cube_mat4 *b, cube_mat4 *out)
+{
+    cube_mat4 product;
+    uint32_t column;
+    uint32_t row;
+
+    for (column = 0; column < 4; column++)
+    {
+        for (row = 0; row < 4; row++)
+        {
+            product.m[column][row] =
+                a->m[0][row] * b->m[column][0] +
+                a->m[1][row] * b->m[column][1] +
+                a->m[2][row] * b->m[column][2] +
+                a->m[3][row] * b->m[column][3];
+        }
+    }
+    *out = product;
+}
+
+void graphics_mat4_multiply_batch(
+    const cube_mat4 *left,
+    const cube_mat4 *matrices,
+    uint32_t count,
+    cube_mat4 *out)
+{
+    uint32_t index;
+#if defined(CUBE_SSE2)
+    const __m128 column_0 = _mm_load_ps(left->m[0]);
+    const __m128 column_1 = _mm_load_ps(left->m[1]);
+    const __m128 column_2 = _mm_load_ps(left->m[2]);
+    const __m128 column_3 = _mm_load_ps(left->m[3]);
+    uint32_t column;
+
+    for (index = 0; index < count; index++)
+    {
+        for (column = 0; column < 4; column++)
+        {
+            _mm_store_ps(
+                (out + index)->m[column],
+                graphics_mat4_multiply_column_sse2(
+                    column_0,
+                    column_1,
+                    column_2,
+                    column_3,
+                    _mm_load_ps((matrices + index)->m[column])));
+        }
+    }
+#else
+    for (index = 0; index < count; index++)
+    {
+        graphics_mat4_multiply_scalar(left, matrices + index, out + index);
+    }
+#endif
+}
+
+int graphics_mat4_inverse(const cube_mat4 *matrix, cube_mat4 *out)
+{
+#if defined(CUBE_SSE2)
+    return graphics_mat4_inverse_sse2(matrix, out);
+#else
+    return graphics_mat4_inverse_scalar(matrix, out);
+#endif
+}
+
+int graphics_mat4_inverse_scalar(const cube_mat4 *matrix, cube_mat4 *out)
+{
+    const float *m = &matrix->m[0][0];
+    float inverse[16];
+    float determinant;
+    uint32_t index;
+
+    // cofactor expansion; transpose(M)^-1 = transpose(M^-1), so the column
+    // major storage can be treated as row major throughout
+    inverse[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+    inverse[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+    inverse[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+    inverse[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+    inverse[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+    inverse[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+    inverse[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+    inverse[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+    inverse[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+    inverse[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+    inverse[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+    inverse[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+    inverse[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+    inverse[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+    inverse[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+    inverse[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+    determinant = m[0] * inverse[0] + m[1] * inverse[4] + m[2] * inverse[8] + m[3] * inverse[12];
+    if (determinant == 0.0f)
+    {
+        return CUBE_FAILURE;
+    }
+    for (index = 0; index < 16; index++)
+    {
+        *(&out->m[0][0] + index) = inverse[index] / determinant;
+    }
+    return CUBE_SUCCESS;
+}
+
+int graphics_mat4_inverse_batch(
+    const cube_mat4 *matrices,
+    uint32_t count,
+    cube_mat4 *out)
+{
+    int result;
+    uint32_t index;
+
+    result = CUBE_SUCCESS;
+    for (index = 0; index < count; index++)
+    {
+        if (graphics_mat4_inverse(matrices + index, out + index) != CUBE_SUCCESS)
+        {
+            result = CUBE_FAILURE;
+        }
+    }
+    return result;
+}
+
+#if defined(CUBE_SSE2)
+__m128 graphics_mat4_multiply_column_sse2(
+    __m128 column_0,
+    __m128 column_1,
+    __m128 column_2,
+    __m128 column_3,
+    __m128 column)
+{
+    return _mm_add_ps(
+        _mm_add_ps(
+            _mm_mul_ps(column_0, CUBE_SWIZZLE(column, 0, 0, 0, 0)),
+            _mm_mul_ps(column_1, CUBE_SWIZZLE(column, 1, 1, 1, 1))),
+        _mm_add_ps(
+            _mm_mul_ps(column_2, CUBE_SWIZZLE(column, 2, 2, 2, 2)),
+            _mm_mul_ps(column_3, CUBE_SWIZZLE(column, 3, 3, 3, 3))));
+}
+
+// 2x2 blocks are packed as (m00, m01, m10, m11)
+__m128 graphics_mat2_multiply_sse2(__m128 a, __m128 b)
+{
+    return _mm_add_ps(
+        _mm_mul_ps(a, CUBE_SWIZZLE(b, 0, 3, 0, 3)),
+        _mm_mul_ps(CUBE_SWIZZLE(a, 1, 0, 3, 2), CUBE_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+__m128 graphics_mat2_adjugate_multiply_sse2(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(
+        _mm_mul_ps(CUBE_SWIZZLE(a, 3, 3, 0, 0), b),
+        _mm_mul_ps(CUBE_SWIZZLE(a, 1, 1, 2, 2), CUBE_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+__m128 graphics_mat2_multiply_adjugate_sse2(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(
+        _mm_mul_ps(a, CUBE_SWIZZLE(b, 3, 0, 3, 0)),
+        _mm_mul_ps(CUBE_SWIZZLE(a, 1, 0, 3, 2), CUBE_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+int graphics_mat4_inverse_sse2(const cube_mat4 *matrix, cube_mat4 *out)
+{
+    const __m128 column_0 = _mm_load_ps(matrix->m[0]);
+    const __m128 column_1 = _mm_load_ps(matrix->m[1]);
+    const __m128 column_2 = _mm_load_ps(matrix->m[2]);
+    const __m128 column_3 = _mm_load_ps(matrix->m[3]);
+    const __m128 adjugate_sign = _mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f);
+    __m128 a, b, c, d;
+    __m128 sub_determinants;
+    __m128 determinant_a, determinant_b, determinant_c, determinant_d;
+    __m128 d_c, a_b;
+    __m128 x, y, z, w;
+    __m128 determinant;
+    __m128 trace;
+    __m128 reciprocal;
+
+    // block inverse over the four 2x2 sub matrices | A B |
+    //                                                | C D |
+    a = _mm_movelh_ps(column_0, column_1);
+    b = _mm_movehl_ps(column_1, column_0);
+    c = _mm_movelh_ps(column_2, column_3);
+    d = _mm_movehl_ps(column_3, column_2);
+
+    sub_determinants = _mm_sub_ps(
+        _mm_mul_ps(CUBE_SHUFFLE(column_0, column_2, 0, 2, 0, 2), CUBE_SHUFFLE(column_1, column_3, 1, 3, 1, 3)),
+        _mm_mul_ps(CUBE_SHUFFLE(column_0, column_2, 1, 3, 1, 3), CUBE_SHUFFLE(column_1, column_3, 0, 2, 0, 2)));
+    determinant_a = CUBE_SWIZZLE(sub_determinants, 0, 0, 0, 0);
+    determinant_b = CUBE_SWIZZLE(sub_determinants, 1, 1, 1, 1);
+    determinant_c = CUBE_SWIZZLE(sub_determinants, 2, 2, 2, 2);
+    determinant_d = CUBE_SWIZZLE(sub_determinants, 3, 3, 3, 3);
+
+    d_c = graphics_mat2_adjugate_multiply_sse2(d, c);
+    a_b = graphics_mat2_adjugate_multiply_sse2(a, b);
+    x = _mm_sub_ps(_mm_mul_ps(determinant_d, a), graphics_mat2_multiply_sse2(b, d_c));
+    w = _mm_sub_ps(_mm_mul_ps(determinant_a, d), graphics_mat2_multiply_sse2(c, a_b));
+    y = _mm_sub_ps(_mm_mul_ps(determinant_b, c), graphics_mat2_multiply_adjugate_sse2(d, a_b));
+    z = _mm_sub_ps(_mm_mul_ps(determinant_c, b), graphics_mat2_multiply_adjugate_sse2(a, d_c));
+
+    trace = _mm_mul_ps(a_b, CUBE_SWIZZLE(d_c, 0, 2, 1, 3));
+    trace = _mm_add_ps(trace, CUBE_SWIZZLE(trace, 2, 3, 0, 1));
+    trace = _mm_add_ps(trace, CUBE_SWIZZLE(trace, 1, 0, 3, 2));
+    determinant = _mm_sub_ps(
+        _mm_add_ps(
+            _mm_mul_ps(determinant_a, determinant_d),
+            _mm_mul_ps(determinant_b, determinant_c)),
+        trace);
+    if (_mm_cvtss_f32(determinant) == 0.0f)
+    {
+        return CUBE_FAILURE;
+    }
+
+    reciprocal = _mm_div_ps(adjugate_sign, determinant);
+    x = _mm_mul_ps(x, reciprocal);
+    y = _mm_mul_ps(y, reciprocal);
+    z = _mm_mul_ps(z, reciprocal);
+    w = _mm_mul_ps(w, reciprocal);
+
+    _mm_store_ps(out->m[0], CUBE_SHUFFLE(x, y, 3, 1, 3, 1));
+    _mm_store_ps(out->m[1], CUBE_SHUFFLE(x, y, 2, 0, 2, 0));
+    _mm_store_ps(out->m[2], CUBE_SHUFFLE(z, w, 3, 1, 3, 1));
+    _mm_store_ps(out->m[3], CUBE_SHUFFLE(z, w, 2, 0, 2, 0));
+    return CUBE_SUCCESS;
+}
+#endif
\ No newline at end of file
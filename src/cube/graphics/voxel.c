@@ -0,0 +1,919 @@
+#include "cube.h"
+
+#define CUBE_VOXEL_VARIABLE "CUBE_VOXEL_CHUNKS"
+#define CUBE_VOXEL_CRATER_VARIABLE "CUBE_VOXEL_CRATER"
+#define CUBE_VOXEL_MAX_SIDE 16
+#define CUBE_VOXEL_PADDED_SIZE (CUBE_VOXEL_CHUNK_SIZE + 2)
+#define CUBE_VOXEL_PADDED_INDEX(X, Y, Z) \
+    (((Z) * CUBE_VOXEL_PADDED_SIZE + (Y)) * CUBE_VOXEL_PADDED_SIZE + (X))
+#define CUBE_VOXEL_INITIAL_QUADS 1024
+
+// quads are appended here by one meshing job and packed once the chunk is done
+typedef struct _cube_voxel_builder
+{
+    cube_vertex *vertices;
+    uint32_t *indices;
+    uint32_t quad_count;
+    uint32_t quad_capacity;
+} cube_voxel_builder;
+
+static int graphics_create_voxel_chunks(cube_graphics *graphics);
+static int graphics_voxels_crater(cube_graphics *graphics, uint32_t radius);
+static void graphics_voxel_generate_job(void *data, uint32_t begin, uint32_t end);
+static void graphics_voxel_mesh_job(void *data, uint32_t begin, uint32_t end);
+static int graphics_voxel_mesh_chunk(
+    const cube_voxels *voxels,
+    cube_voxel_chunk *chunk,
+    cube_voxel_builder *builder);
+static void graphics_voxel_fill(const cube_voxels *voxels, const cube_voxel_chunk *chunk, uint16_t *padded);
+static int graphics_voxel_emit(
+    cube_voxel_builder *builder,
+    uint32_t face,
+    uint32_t slice,
+    uint32_t u,
+    uint32_t v,
+    uint32_t width,
+    uint32_t height,
+    uint16_t block);
+static void graphics_voxels_remesh(cube_graphics *graphics);
+static int graphics_voxels_upload(cube_graphics *graphics);
+static int graphics_voxels_apply(cube_graphics *graphics);
+static uint32_t graphics_voxel_chunk_entry(const uint64_t *indices, uint32_t bits, uint32_t index);
+static void graphics_voxel_chunk_put(uint64_t *indices, uint32_t bits, uint32_t index, uint32_t entry);
+static uint16_t graphics_voxel_chunk_get(const cube_voxel_chunk *chunk, uint32_t index);
+static int graphics_voxel_chunk_set(cube_voxel_chunk *chunk, uint32_t index, uint16_t block);
+static int graphics_voxel_chunk_repack(cube_voxel_chunk *chunk, uint32_t bits);
+static SDL_bool graphics_voxel_chunk_visible(
+    const cube_frustum *frustum,
+    const float center[3],
+    float half_extent);
+
+static const float graphics_voxel_colors[CUBE_VOXEL_BLOCK_COUNT][3] = {
+    {0.0f, 0.0f, 0.0f},
+    {0.3f, 0.6f, 0.2f},
+    {0.5f, 0.35f, 0.2f},
+    {0.5f, 0.5f, 0.5f},
+    {0.95f, 0.95f, 0.95f},
+};
+
+// one per face, positive then negative along x, y and z, so neighbouring faces read apart
+static const float graphics_voxel_shades[6] = {
+    0.8f, 0.8f, 0.7f, 0.7f, 0.6f, 1.0f,
+};
+
+// positive faces wind one way and negative faces the other, both outward
+static const uint32_t graphics_voxel_quad_indices[2][6] = {
+    {0, 1, 2, 2, 3, 0},
+    {0, 3, 2, 2, 1, 0},
+};
+
+// the world replaces the instanced cubes when the variable names a side length in chunks
+int graphics_create_voxels(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    const char *voxel_variable;
+    const char *crater_variable;
+    cube_voxels *voxels;
+    int requested_side;
+    int requested_radius;
+
+    graphics->voxels = NULL;
+
+    voxel_variable = SDL_getenv(CUBE_VOXEL_VARIABLE);
+    requested_side = (voxel_variable != NULL) ? SDL_atoi(voxel_variable) : 0;
+    if (requested_side <= 0)
+    {
+        goto done;
+    }
+
+    graphics->voxels = calloc(1, sizeof(cube_voxels));
+    CUBE_ASSERT(graphics->voxels != NULL, "failed to allocate voxels")
+    voxels = graphics->voxels;
+    voxels->side = SDL_min((uint32_t)requested_side, CUBE_VOXEL_MAX_SIDE);
+    CUBE_ASSERT(
+        graphics_create_voxel_chunks(graphics) == CUBE_SUCCESS,
+        "failed to create voxel chunks")
+    application_jobs_parallel_for(
+        graphics->jobs,
+        graphics_voxel_generate_job,
+        voxels,
+        voxels->chunk_count,
+        1);
+    CUBE_ASSERT(SDL_AtomicGet(&voxels->failed) == 0, "failed to generate voxels")
+
+    // a scripted edit goes through the same queue as any other, before the first build so it is deterministic
+    crater_variable = SDL_getenv(CUBE_VOXEL_CRATER_VARIABLE);
+    requested_radius = (crater_variable != NULL) ? SDL_atoi(crater_variable) : 0;
+    if (requested_radius > 0)
+    {
+        CUBE_ASSERT(
+            graphics_voxels_crater(graphics, (uint32_t)requested_radius) == CUBE_SUCCESS,
+            "failed to queue voxel crater")
+        CUBE_ASSERT(
+            graphics_voxels_apply(graphics) == CUBE_SUCCESS,
+            "failed to apply voxel crater")
+    }
+
+    // the first build waits, later ones overlap rendering
+    graphics_voxels_remesh(graphics);
+    application_jobs_wait(graphics->jobs, &voxels->pending);
+    CUBE_ASSERT(
+        graphics_voxels_upload(graphics) == CUBE_SUCCESS,
+        "failed to upload voxel meshes")
+    CUBE_END_FUNCTION
+}
+
+// edits are queued and picked up by the next batch, the call never touches the chunks
+int graphics_voxels_set(cube_graphics *graphics, const uint32_t position[3], uint16_t block)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_voxels *voxels;
+    cube_voxel_edit *grown;
+    uint32_t world_size;
+
+    voxels = graphics->voxels;
+    CUBE_ASSERT(voxels != NULL, "no voxel world")
+    world_size = voxels->side * CUBE_VOXEL_CHUNK_SIZE;
+    CUBE_ASSERT(
+        position[0] < world_size && position[1] < world_size && position[2] < world_size,
+        "voxel outside the world")
+    CUBE_ASSERT(block < CUBE_VOXEL_BLOCK_COUNT, "unknown voxel block")
+    if (voxels->edit_count == voxels->edit_capacity)
+    {
+        grown = realloc(
+            voxels->edits,
+            (size_t)SDL_max(voxels->edit_capacity * 2, 64) * sizeof(cube_voxel_edit));
+        CUBE_ASSERT(grown != NULL, "failed to grow voxel edits")
+        voxels->edits = grown;
+        voxels->edit_capacity = SDL_max(voxels->edit_capacity * 2, 64);
+    }
+    (voxels->edits + voxels->edit_count)->position[0] = position[0];
+    (voxels->edits + voxels->edit_count)->position[1] = position[1];
+    (voxels->edits + voxels->edit_count)->position[2] = position[2];
+    (voxels->edits + voxels->edit_count)->block = block;
+    voxels->edit_count++;
+    CUBE_END_FUNCTION
+}
+
+// never waits on the workers: a finished batch is uploaded, then the queued edits start the next one
+int graphics_render_voxel_frame(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_voxels *voxels;
+
+    voxels = graphics->voxels;
+    if (voxels == NULL || SDL_AtomicGet(&voxels->pending.pending) != 0)
+    {
+        goto done;
+    }
+    CUBE_ASSERT(
+        graphics_voxels_upload(graphics) == CUBE_SUCCESS,
+        "failed to upload voxel meshes")
+    CUBE_ASSERT(
+        graphics_voxels_apply(graphics) == CUBE_SUCCESS,
+        "failed to apply voxel edits")
+    graphics_voxels_remesh(graphics);
+    CUBE_END_FUNCTION
+}
+
+// inside the frame pass after the shared state, one draw per chunk that meets the frustum
+void graphics_render_voxel_draws(
+    cube_graphics *graphics,
+    VkCommandBuffer command_buffer,
+    const cube_mat4 *view_projection)
+{
+    cube_voxels *voxels;
+    cube_voxel_chunk *chunk;
+    cube_frustum frustum;
+    VkBuffer buffers[2];
+    VkDeviceSize offsets[2];
+    float center[3];
+    float half_extent;
+    uint32_t chunk_index;
+    uint32_t axis;
+
+    voxels = graphics->voxels;
+    graphics_bvh_frustum(view_projection, &frustum);
+    half_extent = 0.5f / (float)voxels->side;
+    buffers[1] = voxels->matrix_buffer;
+    offsets[0] = 0;
+    for (chunk_index = 0; chunk_index < voxels->chunk_count; chunk_index++)
+    {
+        chunk = voxels->chunks + chunk_index;
+        if (chunk->index_count == 0)
+        {
+            continue;
+        }
+        for (axis = 0; axis < 3; axis++)
+        {
+            center[axis] = -0.5f + ((float)chunk->coordinates[axis] + 0.5f) / (float)voxels->side;
+        }
+        if (!graphics_voxel_chunk_visible(&frustum, center, half_extent))
+        {
+            continue;
+        }
+
+        // the chunk matrix rides the instance binding, so the shaders are unchanged
+        buffers[0] = chunk->buffer;
+        offsets[1] = chunk_index * sizeof(float[4][4]);
+        vkCmdBindVertexBuffers(command_buffer, 0, 2, &buffers[0], &offsets[0]);
+        vkCmdBindIndexBuffer(command_buffer, chunk->buffer, chunk->index_offset, VK_INDEX_TYPE_UINT32);
+        vkCmdDrawIndexed(command_buffer, chunk->index_count, 1, 0, 0, 0);
+    }
+}
+
+// after vkDeviceWaitIdle, a batch may still be meshing on the workers
+void graphics_destroy_voxels(cube_graphics *graphics)
+{
+    cube_voxels *voxels;
+    cube_voxel_chunk *chunk;
+    uint32_t chunk_index;
+
+    voxels = graphics->voxels;
+    if (voxels == NULL)
+    {
+        return;
+    }
+    application_jobs_wait(graphics->jobs, &voxels->pending);
+    for (chunk_index = 0; chunk_index < voxels->chunk_count; chunk_index++)
+    {
+        chunk = voxels->chunks + chunk_index;
+        free(chunk->palette);
+        free(chunk->indices);
+        free(chunk->mesh.data);
+        if (chunk->buffer != VK_NULL_HANDLE)
+        {
+            vmaDestroyBuffer(graphics->allocator, chunk->buffer, chunk->allocation);
+        }
+    }
+    if (voxels->matrix_buffer != VK_NULL_HANDLE)
+    {
+        vmaDestroyBuffer(graphics->allocator, voxels->matrix_buffer, voxels->matrix_allocation);
+    }
+    free(voxels->chunks);
+    free(voxels->batch);
+    free(voxels->edits);
+    free(voxels);
+    graphics->voxels = NULL;
+}
+
+// every chunk starts as air with a single palette entry and is dirty until its first mesh
+int graphics_create_voxel_chunks(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_voxels *voxels;
+    cube_voxel_chunk *chunk;
+    float (*matrices)[4][4];
+    float scale;
+    uint32_t chunk_index;
+    uint32_t axis;
+
+    voxels = graphics->voxels;
+    voxels->chunk_count = voxels->side * voxels->side * voxels->side;
+    voxels->chunks = calloc(voxels->chunk_count, sizeof(cube_voxel_chunk));
+    CUBE_ASSERT(voxels->chunks != NULL, "failed to allocate voxel chunks")
+    voxels->batch = calloc(voxels->chunk_count, sizeof(uint32_t));
+    CUBE_ASSERT(voxels->batch != NULL, "failed to allocate voxel batch")
+    matrices = CUBE_CALLOC(voxels->chunk_count, sizeof(float[4][4]));
+    CUBE_ASSERT(matrices != NULL, "failed to allocate chunk matrices")
+
+    // the whole world spans the unit cube the instances used to fill
+    scale = 1.0f / (float)(voxels->side * CUBE_VOXEL_CHUNK_SIZE);
+    for (chunk_index = 0; chunk_index < voxels->chunk_count; chunk_index++)
+    {
+        chunk = voxels->chunks + chunk_index;
+        chunk->coordinates[0] = chunk_index % voxels->side;
+        chunk->coordinates[1] = (chunk_index / voxels->side) % voxels->side;
+        chunk->coordinates[2] = chunk_index / voxels->side / voxels->side;
+        chunk->palette = malloc(4 * sizeof(uint16_t));
+        CUBE_ASSERT(chunk->palette != NULL, "failed to allocate voxel palette")
+        *chunk->palette = CUBE_VOXEL_AIR;
+        chunk->palette_count = 1;
+        chunk->palette_capacity = 4;
+        chunk->dirty = VK_TRUE;
+        for (axis = 0; axis < 3; axis++)
+        {
+            (*(matrices + chunk_index))[axis][axis] = scale;
+            (*(matrices + chunk_index))[3][axis] = -0.5f + (float)(chunk->coordinates[axis] * CUBE_VOXEL_CHUNK_SIZE) * scale;
+        }
+        (*(matrices + chunk_index))[3][3] = 1.0f;
+    }
+    CUBE_ASSERT(
+        graphics_util_upload_buffer(
+            graphics,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            matrices,
+            voxels->chunk_count * sizeof(float[4][4]),
+            &voxels->matrix_buffer,
+            &voxels->matrix_allocation) == CUBE_SUCCESS,
+        "failed to upload chunk matrices")
+    CUBE_END_FUNCTION
+}
+
+// a ball of air around the middle of the world at the mean surface height, across the chunk borders there
+int graphics_voxels_crater(cube_graphics *graphics, uint32_t radius)
+{
+    CUBE_BEGIN_FUNCTION
+    uint32_t world_size;
+    uint32_t center[3];
+    uint32_t minimum[3];
+    uint32_t maximum[3];
+    uint32_t position[3];
+    int64_t distance;
+    int64_t offset;
+    uint32_t axis;
+
+    world_size = graphics->voxels->side * CUBE_VOXEL_CHUNK_SIZE;
+    center[0] = world_size / 2;
+    center[1] = world_size / 2;
+    center[2] = world_size - world_size * 7 / 20;
+    for (axis = 0; axis < 3; axis++)
+    {
+        minimum[axis] = (center[axis] > radius) ? center[axis] - radius : 0;
+        maximum[axis] = SDL_min(center[axis] + radius, world_size - 1);
+    }
+    for (position[2] = minimum[2]; position[2] <= maximum[2]; position[2]++)
+    {
+        for (position[1] = minimum[1]; position[1] <= maximum[1]; position[1]++)
+        {
+            for (position[0] = minimum[0]; position[0] <= maximum[0]; position[0]++)
+            {
+                distance = 0;
+                for (axis = 0; axis < 3; axis++)
+                {
+                    offset = (int64_t)position[axis] - (int64_t)center[axis];
+                    distance += offset * offset;
+                }
+                if (distance > (int64_t)radius * radius)
+                {
+                    continue;
+                }
+                CUBE_ASSERT(
+                    graphics_voxels_set(graphics, position, CUBE_VOXEL_AIR) == CUBE_SUCCESS,
+                    "failed to queue voxel edit")
+            }
+        }
+    }
+    CUBE_END_FUNCTION
+}
+
+// rolling terrain over z, which points down in view: grass or snow on top, dirt, then stone
+void graphics_voxel_generate_job(void *data, uint32_t begin, uint32_t end)
+{
+    cube_voxels *voxels;
+    cube_voxel_chunk *chunk;
+    uint32_t chunk_index;
+    uint32_t world_size;
+    uint32_t local[3];
+    uint32_t world[3];
+    uint32_t surface;
+    uint16_t block;
+    float fraction_x;
+    float fraction_y;
+    float height;
+
+    voxels = data;
+    world_size = voxels->side * CUBE_VOXEL_CHUNK_SIZE;
+    for (chunk_index = begin; chunk_index < end; chunk_index++)
+    {
+        chunk = voxels->chunks + chunk_index;
+        for (local[1] = 0; local[1] < CUBE_VOXEL_CHUNK_SIZE; local[1]++)
+        {
+            for (local[0] = 0; local[0] < CUBE_VOXEL_CHUNK_SIZE; local[0]++)
+            {
+                world[0] = chunk->coordinates[0] * CUBE_VOXEL_CHUNK_SIZE + local[0];
+                world[1] = chunk->coordinates[1] * CUBE_VOXEL_CHUNK_SIZE + local[1];
+                fraction_x = (float)world[0] / (float)world_size;
+                fraction_y = (float)world[1] / (float)world_size;
+                height = (float)world_size * (
+                    0.35f +
+                    0.15f * sinf(fraction_x * 4.0f * 3.14159265f) * cosf(fraction_y * 3.0f * 3.14159265f) +
+                    0.05f * sinf((fraction_x + fraction_y) * 10.0f * 3.14159265f));
+                surface = world_size - (uint32_t)height;
+                for (local[2] = 0; local[2] < CUBE_VOXEL_CHUNK_SIZE; local[2]++)
+                {
+                    world[2] = chunk->coordinates[2] * CUBE_VOXEL_CHUNK_SIZE + local[2];
+                    if (world[2] < surface)
+                    {
+                        continue;
+                    }
+                    if (world[2] == surface)
+                    {
+                        block = (height > 0.5f * (float)world_size) ? CUBE_VOXEL_SNOW : CUBE_VOXEL_GRASS;
+                    }
+                    else
+                    {
+                        block = (world[2] < surface + 4) ? CUBE_VOXEL_DIRT : CUBE_VOXEL_STONE;
+                    }
+                    if (graphics_voxel_chunk_set(
+                            chunk,
+                            (local[2] * CUBE_VOXEL_CHUNK_SIZE + local[1]) * CUBE_VOXEL_CHUNK_SIZE + local[0],
+                            block) != CUBE_SUCCESS)
+                    {
+                        SDL_AtomicSet(&voxels->failed, 1);
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// a failed chunk keeps its old buffer and is retried with the next batch
+void graphics_voxel_mesh_job(void *data, uint32_t begin, uint32_t end)
+{
+    cube_voxels *voxels;
+    cube_voxel_chunk *chunk;
+    cube_voxel_builder builder;
+    uint32_t batch_index;
+
+    voxels = data;
+    builder.vertices = NULL;
+    builder.indices = NULL;
+    builder.quad_count = 0;
+    builder.quad_capacity = 0;
+    for (batch_index = begin; batch_index < end; batch_index++)
+    {
+        chunk = voxels->chunks + *(voxels->batch + batch_index);
+        SDL_memset(&chunk->mesh, 0, sizeof(cube_voxel_mesh));
+        builder.quad_count = 0;
+        if (graphics_voxel_mesh_chunk(voxels, chunk, &builder) != CUBE_SUCCESS)
+        {
+            free(chunk->mesh.data);
+            SDL_memset(&chunk->mesh, 0, sizeof(cube_voxel_mesh));
+            chunk->mesh.failed = VK_TRUE;
+        }
+    }
+    free(builder.vertices);
+    free(builder.indices);
+}
+
+// greedy meshing per face direction and slice, only faces against air are kept
+int graphics_voxel_mesh_chunk(
+    const cube_voxels *voxels,
+    cube_voxel_chunk *chunk,
+    cube_voxel_builder *builder)
+{
+    CUBE_BEGIN_FUNCTION
+    uint16_t *padded;
+    uint16_t *mask;
+    uint16_t block;
+    uint32_t cell[3];
+    int32_t step[3];
+    uint32_t face;
+    uint32_t axis;
+    uint32_t slice;
+    uint32_t u;
+    uint32_t v;
+    uint32_t width;
+    uint32_t height;
+    uint32_t column;
+    uint32_t row;
+    size_t vertex_size;
+    size_t index_size;
+
+    // nothing to mesh in an all air chunk
+    if (chunk->palette_count == 1 && *chunk->palette == CUBE_VOXEL_AIR)
+    {
+        goto done;
+    }
+
+    padded = CUBE_CALLOC(CUBE_VOXEL_PADDED_SIZE * CUBE_VOXEL_PADDED_SIZE * CUBE_VOXEL_PADDED_SIZE, sizeof(uint16_t));
+    CUBE_ASSERT(padded != NULL, "failed to allocate padded chunk")
+    mask = CUBE_CALLOC(CUBE_VOXEL_CHUNK_SIZE * CUBE_VOXEL_CHUNK_SIZE, sizeof(uint16_t));
+    CUBE_ASSERT(mask != NULL, "failed to allocate face mask")
+    graphics_voxel_fill(voxels, chunk, padded);
+
+    for (face = 0; face < 6; face++)
+    {
+        axis = face / 2;
+        step[0] = 0;
+        step[1] = 0;
+        step[2] = 0;
+        step[axis] = (face % 2 == 0) ? 1 : -1;
+        for (slice = 0; slice < CUBE_VOXEL_CHUNK_SIZE; slice++)
+        {
+            cell[axis] = slice;
+            for (v = 0; v < CUBE_VOXEL_CHUNK_SIZE; v++)
+            {
+                for (u = 0; u < CUBE_VOXEL_CHUNK_SIZE; u++)
+                {
+                    cell[(axis + 1) % 3] = u;
+                    cell[(axis + 2) % 3] = v;
+                    block = *(padded + CUBE_VOXEL_PADDED_INDEX(cell[0] + 1, cell[1] + 1, cell[2] + 1));
+                    if (*(padded + CUBE_VOXEL_PADDED_INDEX(
+                                       cell[0] + 1 + step[0],
+                                       cell[1] + 1 + step[1],
+                                       cell[2] + 1 + step[2])) != CUBE_VOXEL_AIR)
+                    {
+                        block = CUBE_VOXEL_AIR;
+                    }
+                    *(mask + v * CUBE_VOXEL_CHUNK_SIZE + u) = block;
+                }
+            }
+
+            // grow each face along u, then along v while whole rows match
+            for (v = 0; v < CUBE_VOXEL_CHUNK_SIZE; v++)
+            {
+                u = 0;
+                while (u < CUBE_VOXEL_CHUNK_SIZE)
+                {
+                    block = *(mask + v * CUBE_VOXEL_CHUNK_SIZE + u);
+                    if (block == CUBE_VOXEL_AIR)
+                    {
+                        u++;
+                        continue;
+                    }
+                    for (width = 1;
+                         u + width < CUBE_VOXEL_CHUNK_SIZE &&
+                         *(mask + v * CUBE_VOXEL_CHUNK_SIZE + u + width) == block;
+                         width++)
+                    {
+                    }
+                    for (height = 1; v + height < CUBE_VOXEL_CHUNK_SIZE; height++)
+                    {
+                        for (column = 0;
+                             column < width &&
+                             *(mask + (v + height) * CUBE_VOXEL_CHUNK_SIZE + u + column) == block;
+                             column++)
+                        {
+                        }
+                        if (column < width)
+                        {
+                            break;
+                        }
+                    }
+                    CUBE_ASSERT(
+                        graphics_voxel_emit(builder, face, slice, u, v, width, height, block) == CUBE_SUCCESS,
+                        "failed to emit voxel quad")
+                    for (row = 0; row < height; row++)
+                    {
+                        SDL_memset(
+                            mask + (v + row) * CUBE_VOXEL_CHUNK_SIZE + u,
+                            0,
+                            width * sizeof(uint16_t));
+                    }
+                    u += width;
+                }
+            }
+        }
+    }
+    if (builder->quad_count == 0)
+    {
+        goto done;
+    }
+
+    // packed so the render thread uploads a single block per chunk
+    vertex_size = (size_t)builder->quad_count * 4 * sizeof(cube_vertex);
+    index_size = (size_t)builder->quad_count * 6 * sizeof(uint32_t);
+    chunk->mesh.data = malloc(vertex_size + index_size);
+    CUBE_ASSERT(chunk->mesh.data != NULL, "failed to allocate chunk mesh")
+    memcpy(chunk->mesh.data, builder->vertices, vertex_size);
+    memcpy(chunk->mesh.data + vertex_size, builder->indices, index_size);
+    chunk->mesh.size = vertex_size + index_size;
+    chunk->mesh.index_offset = vertex_size;
+    chunk->mesh.index_count = builder->quad_count * 6;
+    CUBE_END_FUNCTION
+}
+
+// the chunk with a one voxel border of its face neighbours, outside the world is air
+void graphics_voxel_fill(const cube_voxels *voxels, const cube_voxel_chunk *chunk, uint16_t *padded)
+{
+    int32_t position[3];
+    int32_t local[3];
+    int32_t neighbor[3];
+    uint32_t outside;
+    uint32_t axis;
+    uint16_t block;
+
+    for (position[2] = -1; position[2] <= CUBE_VOXEL_CHUNK_SIZE; position[2]++)
+    {
+        for (position[1] = -1; position[1] <= CUBE_VOXEL_CHUNK_SIZE; position[1]++)
+        {
+            for (position[0] = -1; position[0] <= CUBE_VOXEL_CHUNK_SIZE; position[0]++)
+            {
+                outside = 0;
+                block = CUBE_VOXEL_AIR;
+                for (axis = 0; axis < 3; axis++)
+                {
+                    neighbor[axis] = (int32_t)chunk->coordinates[axis];
+                    local[axis] = position[axis];
+                    if (position[axis] < 0)
+                    {
+                        outside++;
+                        neighbor[axis]--;
+                        local[axis] += CUBE_VOXEL_CHUNK_SIZE;
+                    }
+                    else if (position[axis] >= CUBE_VOXEL_CHUNK_SIZE)
+                    {
+                        outside++;
+                        neighbor[axis]++;
+                        local[axis] -= CUBE_VOXEL_CHUNK_SIZE;
+                    }
+                }
+
+                // edges and corners are never looked at by face culling
+                if (outside <= 1 &&
+                    neighbor[0] >= 0 && neighbor[0] < (int32_t)voxels->side &&
+                    neighbor[1] >= 0 && neighbor[1] < (int32_t)voxels->side &&
+                    neighbor[2] >= 0 && neighbor[2] < (int32_t)voxels->side)
+                {
+                    block = graphics_voxel_chunk_get(
+                        voxels->chunks + (neighbor[2] * voxels->side + neighbor[1]) * voxels->side + neighbor[0],
+                        (local[2] * CUBE_VOXEL_CHUNK_SIZE + local[1]) * CUBE_VOXEL_CHUNK_SIZE + local[0]);
+                }
+                *(padded + CUBE_VOXEL_PADDED_INDEX(position[0] + 1, position[1] + 1, position[2] + 1)) = block;
+            }
+        }
+    }
+}
+
+int graphics_voxel_emit(
+    cube_voxel_builder *builder,
+    uint32_t face,
+    uint32_t slice,
+    uint32_t u,
+    uint32_t v,
+    uint32_t width,
+    uint32_t height,
+    uint16_t block)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_vertex *vertices;
+    uint32_t *indices;
+    uint32_t quad_capacity;
+    uint32_t axis;
+    uint32_t u_axis;
+    uint32_t v_axis;
+    uint32_t corner;
+    uint32_t first;
+    uint32_t index;
+    float shade;
+
+    if (builder->quad_count == builder->quad_capacity)
+    {
+        quad_capacity = SDL_max(builder->quad_capacity * 2, CUBE_VOXEL_INITIAL_QUADS);
+        vertices = realloc(builder->vertices, (size_t)quad_capacity * 4 * sizeof(cube_vertex));
+        CUBE_ASSERT(vertices != NULL, "failed to grow voxel vertices")
+        builder->vertices = vertices;
+        indices = realloc(builder->indices, (size_t)quad_capacity * 6 * sizeof(uint32_t));
+        CUBE_ASSERT(indices != NULL, "failed to grow voxel indices")
+        builder->indices = indices;
+        builder->quad_capacity = quad_capacity;
+    }
+
+    axis = face / 2;
+    u_axis = (axis + 1) % 3;
+    v_axis = (axis + 2) % 3;
+    shade = graphics_voxel_shades[face];
+    first = builder->quad_count * 4;
+    for (corner = 0; corner < 4; corner++)
+    {
+        vertices = builder->vertices + first + corner;
+        vertices->position[axis] = (float)(slice + ((face % 2 == 0) ? 1 : 0));
+        vertices->position[u_axis] = (float)(u + ((corner == 1 || corner == 2) ? width : 0));
+        vertices->position[v_axis] = (float)(v + ((corner >= 2) ? height : 0));
+        vertices->color[0] = graphics_voxel_colors[block][0] * shade;
+        vertices->color[1] = graphics_voxel_colors[block][1] * shade;
+        vertices->color[2] = graphics_voxel_colors[block][2] * shade;
+    }
+    for (index = 0; index < 6; index++)
+    {
+        *(builder->indices + builder->quad_count * 6 + index) = first + graphics_voxel_quad_indices[face % 2][index];
+    }
+    builder->quad_count++;
+    CUBE_END_FUNCTION
+}
+
+// dirty chunks go out one job each, the counter tells the render thread when all are back
+void graphics_voxels_remesh(cube_graphics *graphics)
+{
+    cube_voxels *voxels;
+    uint32_t chunk_index;
+    uint32_t batch_index;
+
+    voxels = graphics->voxels;
+    voxels->batch_count = 0;
+    for (chunk_index = 0; chunk_index < voxels->chunk_count; chunk_index++)
+    {
+        if ((voxels->chunks + chunk_index)->dirty == VK_TRUE)
+        {
+            (voxels->chunks + chunk_index)->dirty = VK_FALSE;
+            *(voxels->batch + voxels->batch_count++) = chunk_index;
+        }
+    }
+    for (batch_index = 0; batch_index < voxels->batch_count; batch_index++)
+    {
+        application_jobs_submit(
+            graphics->jobs,
+            graphics_voxel_mesh_job,
+            voxels,
+            batch_index,
+            batch_index + 1,
+            &voxels->pending);
+    }
+}
+
+// the buffers being replaced may still be read by the frame in flight
+int graphics_voxels_upload(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_voxels *voxels;
+    cube_voxel_chunk *chunk;
+    uint32_t batch_index;
+
+    voxels = graphics->voxels;
+    for (batch_index = 0; batch_index < voxels->batch_count; batch_index++)
+    {
+        chunk = voxels->chunks + *(voxels->batch + batch_index);
+        if (chunk->mesh.failed == VK_TRUE)
+        {
+            chunk->dirty = VK_TRUE;
+            continue;
+        }
+        if (chunk->buffer != VK_NULL_HANDLE)
+        {
+            CUBE_ASSERT(
+                graphics_sync_defer_buffer(graphics, chunk->buffer, chunk->allocation) == CUBE_SUCCESS,
+                "failed to defer chunk buffer")
+            chunk->buffer = VK_NULL_HANDLE;
+            chunk->allocation = NULL;
+            chunk->index_count = 0;
+        }
+        if (chunk->mesh.index_count == 0)
+        {
+            continue;
+        }
+        cube_result = graphics_util_upload_buffer(
+            graphics,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            chunk->mesh.data,
+            chunk->mesh.size,
+            &chunk->buffer,
+            &chunk->allocation);
+        free(chunk->mesh.data);
+        chunk->mesh.data = NULL;
+        CUBE_ASSERT(cube_result == CUBE_SUCCESS, "failed to upload chunk mesh")
+        chunk->index_offset = chunk->mesh.index_offset;
+        chunk->index_count = chunk->mesh.index_count;
+    }
+    voxels->batch_count = 0;
+    CUBE_END_FUNCTION
+}
+
+// an edit on a chunk border also changes which faces its neighbour shows
+int graphics_voxels_apply(cube_graphics *graphics)
+{
+    CUBE_BEGIN_FUNCTION
+    cube_voxels *voxels;
+    cube_voxel_edit *edit;
+    uint32_t edit_index;
+    uint32_t chunk_coordinates[3];
+    uint32_t local[3];
+    uint32_t chunk_index;
+    uint32_t axis;
+    uint32_t stride;
+
+    voxels = graphics->voxels;
+    for (edit_index = 0; edit_index < voxels->edit_count; edit_index++)
+    {
+        edit = voxels->edits + edit_index;
+        for (axis = 0; axis < 3; axis++)
+        {
+            chunk_coordinates[axis] = edit->position[axis] / CUBE_VOXEL_CHUNK_SIZE;
+            local[axis] = edit->position[axis] % CUBE_VOXEL_CHUNK_SIZE;
+        }
+        chunk_index = (chunk_coordinates[2] * voxels->side + chunk_coordinates[1]) * voxels->side + chunk_coordinates[0];
+        CUBE_ASSERT(
+            graphics_voxel_chunk_set(
+                voxels->chunks + chunk_index,
+                (local[2] * CUBE_VOXEL_CHUNK_SIZE + local[1]) * CUBE_VOXEL_CHUNK_SIZE + local[0],
+                edit->block) == CUBE_SUCCESS,
+            "failed to set voxel")
+        (voxels->chunks + chunk_index)->dirty = VK_TRUE;
+        stride = 1;
+        for (axis = 0; axis < 3; axis++)
+        {
+            if (local[axis] == 0 && chunk_coordinates[axis] > 0)
+            {
+                (voxels->chunks + chunk_index - stride)->dirty = VK_TRUE;
+            }
+            if (local[axis] == CUBE_VOXEL_CHUNK_SIZE - 1 && chunk_coordinates[axis] + 1 < voxels->side)
+            {
+                (voxels->chunks + chunk_index + stride)->dirty = VK_TRUE;
+            }
+            stride *= voxels->side;
+        }
+    }
+    voxels->edit_count = 0;
+    CUBE_END_FUNCTION
+}
+
+uint32_t graphics_voxel_chunk_entry(const uint64_t *indices, uint32_t bits, uint32_t index)
+{
+    uint32_t bit;
+
+    bit = index * bits;
+    return (uint32_t)((*(indices + bit / 64) >> (bit % 64)) & ((1ull << bits) - 1));
+}
+
+void graphics_voxel_chunk_put(uint64_t *indices, uint32_t bits, uint32_t index, uint32_t entry)
+{
+    uint32_t bit;
+    uint64_t mask;
+
+    bit = index * bits;
+    mask = ((1ull << bits) - 1) << (bit % 64);
+    *(indices + bit / 64) = (*(indices + bit / 64) & ~mask) | ((uint64_t)entry << (bit % 64));
+}
+
+uint16_t graphics_voxel_chunk_get(const cube_voxel_chunk *chunk, uint32_t index)
+{
+    if (chunk->bits == 0)
+    {
+        return *chunk->palette;
+    }
+    return *(chunk->palette + graphics_voxel_chunk_entry(chunk->indices, chunk->bits, index));
+}
+
+// the palette only grows, a block that disappears keeps its entry until the chunk is gone
+int graphics_voxel_chunk_set(cube_voxel_chunk *chunk, uint32_t index, uint16_t block)
+{
+    CUBE_BEGIN_FUNCTION
+    uint16_t *grown;
+    uint32_t entry;
+
+    for (entry = 0; entry < chunk->palette_count && *(chunk->palette + entry) != block; entry++)
+    {
+    }
+    if (entry == chunk->palette_count)
+    {
+        if (entry == chunk->palette_capacity)
+        {
+            grown = realloc(chunk->palette, (size_t)chunk->palette_capacity * 2 * sizeof(uint16_t));
+            CUBE_ASSERT(grown != NULL, "failed to grow voxel palette")
+            chunk->palette = grown;
+            chunk->palette_capacity *= 2;
+        }
+        if (entry >= (1u << chunk->bits))
+        {
+            CUBE_ASSERT(
+                graphics_voxel_chunk_repack(chunk, (chunk->bits == 0) ? 1 : chunk->bits * 2) == CUBE_SUCCESS,
+                "failed to repack voxel chunk")
+        }
+        *(chunk->palette + entry) = block;
+        chunk->palette_count++;
+    }
+    if (chunk->bits > 0)
+    {
+        graphics_voxel_chunk_put(chunk->indices, chunk->bits, index, entry);
+    }
+    CUBE_END_FUNCTION
+}
+
+// widths stay powers of two so no index straddles two words
+int graphics_voxel_chunk_repack(cube_voxel_chunk *chunk, uint32_t bits)
+{
+    CUBE_BEGIN_FUNCTION
+    uint64_t *indices;
+    uint32_t index;
+
+    indices = calloc(CUBE_VOXEL_CHUNK_VOLUME / 64 * bits, sizeof(uint64_t));
+    CUBE_ASSERT(indices != NULL, "failed to allocate voxel indices")
+
+    // without indices every voxel is entry zero, which calloc already wrote
+    if (chunk->bits > 0)
+    {
+        for (index = 0; index < CUBE_VOXEL_CHUNK_VOLUME; index++)
+        {
+            graphics_voxel_chunk_put(
+                indices,
+                bits,
+                index,
+                graphics_voxel_chunk_entry(chunk->indices, chunk->bits, index));
+        }
+    }
+    free(chunk->indices);
+    chunk->indices = indices;
+    chunk->bits = bits;
+    CUBE_END_FUNCTION
+}
+
+SDL_bool graphics_voxel_chunk_visible(
+    const cube_frustum *frustum,
+    const float center[3],
+    float half_extent)
+{
+    uint32_t plane;
+
+    for (plane = 0; plane < 6; plane++)
+    {
+        if (frustum->x[plane] * center[0] + frustum->y[plane] * center[1] + frustum->z[plane] * center[2] + frustum->w[plane] +
+                half_extent * (frustum->abs_x[plane] + frustum->abs_y[plane] + frustum->abs_z[plane]) <
+            0.0f)
+        {
+            return SDL_FALSE;
+        }
+    }
+    return SDL_TRUE;
+}
\ No newline at end of file
@@ -3,8 +3,10 @@
 int main(int argc, char **argv)
 {
     cube_application *application;
+    int result;
     
     application = NULL;
+    result = CUBE_FAILURE;
 
     if(argc > 1)
     {
@@ -19,6 +21,7 @@ int main(int argc, char **argv)
             puts("failed to run application");
             goto done;
         }
+        result = CUBE_SUCCESS;
     }
 
 done:
@@ -26,5 +29,5 @@ done:
     {
         application_destroy(application);
     }
-    return 0;
+    return result;
 }
\ No newline at end of file
@@ -2,12 +2,27 @@
 #define CUBE_APPLICATION_H
 
 #include "common.h"
+#include "audio/audio.h"
 #include "graphics/graphics.h"
+#include "application/input.h"
+#include "application/job.h"
+#include "application/profile.h"
+#include "application/render.h"
+#include "application/resource.h"
 
 typedef struct _cube_application
 {
     SDL_bool loop;
+    cube_jobs *jobs;
+    cube_resources *resources;
     cube_graphics *graphics;
+    cube_audio *audio;
+    cube_input *input;
+    cube_render *render;
+    cube_scene scene;
+    Uint64 start_counter;
+    Uint64 simulation_counter;
+    SDL_bool simulation_fixed;
 } cube_application;
 
 int application_create(cube_application **application, const char * resource_directory);
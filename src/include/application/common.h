@@ -41,6 +41,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <dirent.h>
 
 #include <vk_mem_alloc.h>
 
@@ -54,6 +55,24 @@
 #define CUBE_DEBUG
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CUBE_SSE2
+#endif
+
+#if defined(__AVX2__)
+#define CUBE_AVX2
+#endif
+
+#if defined(CUBE_SSE2) || defined(CUBE_AVX2)
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#define CUBE_ALIGN(N) __declspec(align(N))
+#else
+#define CUBE_ALIGN(N) __attribute__((aligned(N)))
+#endif
+
 typedef struct
 {
     void **blocks;
@@ -0,0 +1,53 @@
+#ifndef CUBE_APPLICATION_INPUT_H
+#define CUBE_APPLICATION_INPUT_H
+
+#include "common.h"
+
+#define CUBE_INPUT_EVENT_CAPACITY 256
+#define CUBE_INPUT_TRACE_CAPACITY 4096
+#define CUBE_INPUT_HISTOGRAM_BUCKETS 24
+
+typedef struct _cube_input_event
+{
+    Uint64 id;
+    Uint64 timestamp;
+    SDL_Event event;
+} cube_input_event;
+
+// a seqlock: odd while the main thread rewrites the entry, so the render thread can tell a torn read
+typedef struct _cube_input_trace
+{
+    SDL_atomic_t sequence;
+    Uint64 id;
+    Uint64 timestamp;
+} cube_input_trace;
+
+// events and traces are written by the main thread, the latency
+// statistics only by the render thread once a frame is presented
+typedef struct _cube_input
+{
+    Uint64 frequency;
+    Uint64 next_id;
+    uint32_t event_count;
+    cube_input_event events[CUBE_INPUT_EVENT_CAPACITY];
+    cube_input_trace traces[CUBE_INPUT_TRACE_CAPACITY];
+
+    Uint64 presented_id;
+    Uint64 sample_count;
+    Uint64 dropped_count;
+    Uint64 latency_sum;
+    Uint64 latency_max;
+    Uint64 histogram[CUBE_INPUT_HISTOGRAM_BUCKETS];
+} cube_input;
+
+int application_create_input(cube_input **input);
+
+uint32_t application_input_poll(cube_input *input, Sint32 timeout);
+
+void application_input_present(cube_input *input, Uint64 input_id, Uint64 present_counter);
+
+void application_input_report(const cube_input *input);
+
+void application_destroy_input(cube_input *input);
+
+#endif
\ No newline at end of file
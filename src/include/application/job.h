@@ -0,0 +1,80 @@
+#ifndef CUBE_APPLICATION_JOB_H
+#define CUBE_APPLICATION_JOB_H
+
+#include "common.h"
+
+#define CUBE_JOB_MAX_WORKERS 64
+#define CUBE_JOB_CAPACITY 4096
+#define CUBE_JOB_DEFAULT_WORKERS UINT32_MAX
+
+// every job covers the index range [begin, end) of its data
+typedef void (*cube_job_function)(void *data, uint32_t begin, uint32_t end);
+
+// pending drops to zero once every job submitted against the counter has run
+typedef struct _cube_job_counter
+{
+    SDL_atomic_t pending;
+} cube_job_counter;
+
+typedef struct _cube_job
+{
+    cube_job_function function;
+    void *data;
+    uint32_t begin;
+    uint32_t end;
+    cube_job_counter *counter;
+} cube_job;
+
+// chase-lev deque: the owner pushes and pops at the bottom, thieves take from the top,
+// a slot is only rewritten once top has moved past it
+typedef struct _cube_job_worker
+{
+    CUBE_ALIGN(64) SDL_atomic_t top;
+    CUBE_ALIGN(64) SDL_atomic_t bottom;
+    CUBE_ALIGN(64) cube_job slots[CUBE_JOB_CAPACITY];
+    uint32_t index;
+    uint32_t victim;
+    struct _cube_jobs *jobs;
+    SDL_Thread *thread;
+} cube_job_worker;
+
+// threads outside the pool submit through the locked injection ring
+typedef struct _cube_jobs
+{
+    uint32_t worker_count;
+    cube_job_worker *workers;
+    SDL_TLSID worker_key;
+    SDL_atomic_t running;
+    SDL_atomic_t sleeping;
+    SDL_sem *wake;
+    SDL_atomic_t injected;
+    SDL_mutex *injection_mutex;
+    uint32_t injection_head;
+    uint32_t injection_tail;
+    cube_job injection[CUBE_JOB_CAPACITY];
+} cube_jobs;
+
+int application_create_jobs(cube_jobs **jobs, uint32_t worker_count);
+
+void application_jobs_submit(
+    cube_jobs *jobs,
+    cube_job_function function,
+    void *data,
+    uint32_t begin,
+    uint32_t end,
+    cube_job_counter *counter);
+
+SDL_bool application_jobs_help(cube_jobs *jobs);
+
+void application_jobs_wait(cube_jobs *jobs, cube_job_counter *counter);
+
+void application_jobs_parallel_for(
+    cube_jobs *jobs,
+    cube_job_function function,
+    void *data,
+    uint32_t count,
+    uint32_t grain);
+
+void application_destroy_jobs(cube_jobs *jobs);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef CUBE_APPLICATION_PROFILE_H
+#define CUBE_APPLICATION_PROFILE_H
+
+#include "common.h"
+
+// built with CUBE_PROFILE defined, every macro below expands to nothing otherwise
+#ifdef CUBE_PROFILE
+
+#define CUBE_PROFILE_EVENT_CAPACITY 65536
+#define CUBE_PROFILE_MAX_THREADS 96
+
+typedef enum _cube_profile_kind
+{
+    CUBE_PROFILE_KIND_ZONE,
+    CUBE_PROFILE_KIND_COUNTER,
+    CUBE_PROFILE_KIND_GPU_ZONE,
+} cube_profile_kind;
+
+// zones keep their end in value, counters their sample
+typedef struct _cube_profile_event
+{
+    const char *name;
+    cube_profile_kind kind;
+    Uint64 start;
+    Sint64 value;
+} cube_profile_event;
+
+// written only by its own thread, count is published after each event so export never locks
+typedef struct _cube_profile_thread
+{
+    SDL_atomic_t count;
+    SDL_atomic_t dropped;
+    const char *name;
+    cube_profile_event events[CUBE_PROFILE_EVENT_CAPACITY];
+} cube_profile_thread;
+
+typedef struct _cube_profile
+{
+    SDL_TLSID thread_key;
+    SDL_mutex *mutex;
+    uint32_t thread_count;
+    cube_profile_thread *threads[CUBE_PROFILE_MAX_THREADS];
+    Uint64 origin;
+    Uint64 frequency;
+} cube_profile;
+
+int application_create_profile(void);
+
+void application_profile_thread(const char *name);
+
+void application_profile_zone(const char *name, Uint64 start);
+
+void application_profile_gpu_zone(const char *name, Uint64 start, Uint64 end);
+
+void application_profile_counter(const char *name, Sint64 value);
+
+void application_destroy_profile(void);
+
+// names must outlive the profile and are written unescaped, so pass plain string literals
+#define CUBE_PROFILE_BEGIN(ZONE) Uint64 ZONE = SDL_GetPerformanceCounter();
+#define CUBE_PROFILE_END(ZONE, NAME) application_profile_zone(NAME, ZONE);
+#define CUBE_PROFILE_COUNTER(NAME, VALUE) application_profile_counter(NAME, (Sint64)(VALUE));
+#define CUBE_PROFILE_THREAD(NAME) application_profile_thread(NAME);
+
+#else
+
+#define CUBE_PROFILE_BEGIN(ZONE)
+#define CUBE_PROFILE_END(ZONE, NAME)
+#define CUBE_PROFILE_COUNTER(NAME, VALUE)
+#define CUBE_PROFILE_THREAD(NAME)
+
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef CUBE_APPLICATION_RENDER_H
+#define CUBE_APPLICATION_RENDER_H
+
+#include "common.h"
+#include "graphics/types.h"
+#include "application/input.h"
+
+#define CUBE_RENDER_QUEUE_CAPACITY 64
+#define CUBE_RENDER_SCENE_SLOTS 3
+#define CUBE_RENDER_METRIC_CAPACITY 4096
+
+typedef enum _cube_render_command_type
+{
+    CUBE_RENDER_COMMAND_STOP,
+} cube_render_command_type;
+
+typedef struct _cube_render_command
+{
+    cube_render_command_type type;
+} cube_render_command;
+
+// single producer, single consumer ring; head and tail sit on separate cache lines
+typedef struct _cube_render_queue
+{
+    CUBE_ALIGN(64) SDL_atomic_t head;
+    CUBE_ALIGN(64) SDL_atomic_t tail;
+    CUBE_ALIGN(64) cube_render_command commands[CUBE_RENDER_QUEUE_CAPACITY];
+} cube_render_queue;
+
+// triple buffer, the shared slot index carries a fresh flag above the index bits
+typedef struct _cube_render_exchange
+{
+    cube_scene scenes[CUBE_RENDER_SCENE_SLOTS];
+    SDL_atomic_t shared;
+    int back;
+    int front;
+} cube_render_exchange;
+
+typedef struct _cube_render
+{
+    cube_graphics *graphics;
+    cube_input *input;
+    SDL_Thread *thread;
+    cube_render_queue queue;
+    cube_render_exchange exchange;
+    SDL_atomic_t failed;
+
+    // written by the render thread, read once it has been joined
+    Uint64 start_counter;
+    Uint64 frame_limit;
+    Uint64 frame_count;
+    Uint64 last_counter;
+    Uint64 startup;
+    Uint64 frame_times[CUBE_RENDER_METRIC_CAPACITY];
+} cube_render;
+
+int application_create_render(
+    cube_render **render,
+    cube_graphics *graphics,
+    cube_input *input,
+    const cube_scene *scene,
+    Uint64 start_counter);
+
+int application_render_push(cube_render *render, const cube_render_command *command);
+
+void application_render_publish(cube_render *render, const cube_scene *scene);
+
+SDL_bool application_render_failed(cube_render *render);
+
+void application_destroy_render(cube_render *render);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef CUBE_APPLICATION_RESOURCE_H
+#define CUBE_APPLICATION_RESOURCE_H
+
+#include "common.h"
+#include "job.h"
+
+typedef enum _cube_resource_type
+{
+    CUBE_RESOURCE_SHADER,
+    CUBE_RESOURCE_SOUND,
+    CUBE_RESOURCE_MESH,
+    CUBE_RESOURCE_TEXTURE,
+    CUBE_RESOURCE_OTHER,
+    CUBE_RESOURCE_TYPE_COUNT,
+} cube_resource_type;
+
+typedef enum _cube_resource_state
+{
+    CUBE_RESOURCE_UNLOADED,
+    CUBE_RESOURCE_QUEUED,
+    CUBE_RESOURCE_LOADED,
+    CUBE_RESOURCE_FAILED,
+} cube_resource_state;
+
+struct _cube_resources;
+
+// runs on a job worker once the file is in memory, a failure marks the resource failed
+typedef int (*cube_resource_callback)(struct _cube_resources *resources, uint32_t resource, void *userdata);
+
+// data is owned by the entry from load until release
+typedef struct _cube_resource
+{
+    char *path;
+    const char *file_name;
+    cube_resource_type type;
+    size_t file_size;
+    SDL_atomic_t state;
+    void *data;
+    size_t size;
+    cube_resource_callback callback;
+    void *userdata;
+} cube_resource;
+
+// the index is sorted by type then path and never changes after the scan,
+// each queued resource is one job and pending counts the ones not yet finished
+typedef struct _cube_resources
+{
+    char *directory;
+    uint32_t resource_count;
+    cube_resource *resources;
+    uint32_t type_first[CUBE_RESOURCE_TYPE_COUNT];
+    uint32_t type_count[CUBE_RESOURCE_TYPE_COUNT];
+    cube_jobs *jobs;
+    cube_job_counter pending;
+    SDL_atomic_t running;
+    SDL_mutex *mutex;
+    SDL_cond *completed;
+} cube_resources;
+
+int application_create_resources(
+    cube_resources **resources,
+    cube_jobs *jobs,
+    const char *directory);
+
+int application_resources_find(
+    const cube_resources *resources,
+    cube_resource_type type,
+    const char *file_name,
+    uint32_t *resource);
+
+int application_resources_load(
+    cube_resources *resources,
+    uint32_t resource,
+    cube_resource_callback callback,
+    void *userdata);
+
+int application_resources_wait(cube_resources *resources, uint32_t resource);
+
+void application_resources_release(cube_resources *resources, uint32_t resource);
+
+void application_destroy_resources(cube_resources *resources);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef CUBE_AUDIO_H
+#define CUBE_AUDIO_H
+
+#include "audio/types.h"
+#include "audio/mixer.h"
+#include "audio/stream.h"
+
+int audio_create(cube_audio **audio, cube_resources *resources);
+
+int audio_find_sound(const cube_audio *audio, const char *name, uint32_t *sound);
+
+int audio_play(cube_audio *audio, uint32_t sound, float gain, float pan);
+
+int audio_play_random(cube_audio *audio);
+
+void audio_destroy(cube_audio *audio);
+
+#endif
\ No newline at end of file
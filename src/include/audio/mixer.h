@@ -0,0 +1,39 @@
+#ifndef CUBE_AUDIO_MIXER_H
+#define CUBE_AUDIO_MIXER_H
+
+#include "audio/types.h"
+
+void audio_mix_stereo(
+    float *stream,
+    const float *source,
+    uint32_t frame_count,
+    const float gain[2]);
+
+void audio_mix_stereo_scalar(
+    float *stream,
+    const float *source,
+    uint32_t frame_count,
+    const float gain[2]);
+
+void audio_clamp(float *stream, uint32_t sample_count);
+
+int audio_create_resampler(cube_resampler *resampler, int source_rate, int target_rate);
+
+uint32_t audio_resample_length(const cube_resampler *resampler, uint32_t source_frame_count);
+
+int audio_resample(
+    const cube_resampler *resampler,
+    const float *source,
+    uint32_t source_frame_count,
+    float *target,
+    uint32_t target_frame_count);
+
+void audio_resample_frame(
+    const cube_resampler *resampler,
+    uint32_t phase,
+    const float *window,
+    float *target);
+
+void audio_destroy_resampler(cube_resampler *resampler);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef CUBE_AUDIO_STREAM_H
+#define CUBE_AUDIO_STREAM_H
+
+#include "audio/types.h"
+
+int audio_create_stream_sound(
+    cube_audio *audio,
+    const char *sound_path,
+    cube_sound *sound,
+    SDL_bool *streamed);
+
+int audio_create_streams(cube_audio *audio);
+
+SDL_bool audio_start_stream(cube_audio *audio, const cube_sound *sound, const float gain[2]);
+
+void audio_mix_streams(cube_audio *audio, float *stream, Uint32 frame_count);
+
+void audio_destroy_streams(cube_audio *audio);
+
+void audio_destroy_stream_sound(cube_sound *sound);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,118 @@
+#ifndef CUBE_AUDIO_TYPES_H
+#define CUBE_AUDIO_TYPES_H
+
+#include "application/common.h"
+#include "application/resource.h"
+
+#define CUBE_AUDIO_CHANNELS 2
+#define CUBE_AUDIO_VOICE_COUNT 64
+#define CUBE_AUDIO_TRIGGER_CAPACITY 256
+#define CUBE_AUDIO_RESAMPLER_TAPS 32
+#define CUBE_AUDIO_STREAM_COUNT 4
+#define CUBE_AUDIO_STREAM_CAPACITY 16384
+#define CUBE_AUDIO_STREAM_CHUNK 1024
+#define CUBE_AUDIO_STREAM_THRESHOLD (1 << 20)
+
+// rational up/down polyphase filter, each phase row holds its taps duplicated for left and right
+typedef struct _cube_resampler
+{
+    uint32_t up;
+    uint32_t down;
+    float *coefficients;
+} cube_resampler;
+
+typedef struct _cube_mapping
+{
+    void *data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE view;
+#endif
+} cube_mapping;
+
+// decoded once to interleaved stereo float at the device rate,
+// or left in a mapped file and decoded ahead of playback when streamed;
+// ready is set once a worker has finished decoding
+typedef struct _cube_sound
+{
+    char *name;
+    SDL_atomic_t ready;
+    float *samples;
+    Uint32 frame_count;
+    cube_mapping mapping;
+    const Uint8 *pcm;
+    Uint32 source_frame_count;
+    SDL_AudioFormat source_format;
+    Uint8 source_channels;
+    cube_resampler resampler;
+} cube_sound;
+
+typedef struct _cube_voice
+{
+    const cube_sound *sound;
+    Uint32 position;
+    float gain[2];
+} cube_voice;
+
+typedef enum _cube_stream_state
+{
+    CUBE_STREAM_IDLE,
+    CUBE_STREAM_STARTING,
+    CUBE_STREAM_PLAYING,
+    CUBE_STREAM_DRAINING,
+} cube_stream_state;
+
+// the ring is written by the stream thread only and read by the audio callback only,
+// each state transition belongs to exactly one of the two sides
+typedef struct _cube_stream
+{
+    CUBE_ALIGN(64) SDL_atomic_t read;
+    CUBE_ALIGN(64) SDL_atomic_t write;
+    CUBE_ALIGN(64) SDL_atomic_t state;
+    const cube_sound *sound;
+    Uint32 position;
+    float gain[2];
+    float *ring;
+    float *staging;
+    uint32_t staging_count;
+    Uint32 source_position;
+    Uint32 produced;
+    uint64_t window;
+    uint64_t base;
+    uint32_t phase;
+    size_t released;
+} cube_stream;
+
+typedef struct _cube_audio_trigger
+{
+    uint32_t sound;
+    float gain;
+    float pan;
+} cube_audio_trigger;
+
+// written by the main thread only, drained by the audio callback only
+typedef struct _cube_audio_queue
+{
+    CUBE_ALIGN(64) SDL_atomic_t head;
+    CUBE_ALIGN(64) SDL_atomic_t tail;
+    CUBE_ALIGN(64) cube_audio_trigger triggers[CUBE_AUDIO_TRIGGER_CAPACITY];
+} cube_audio_queue;
+
+typedef struct _cube_audio
+{
+    SDL_AudioDeviceID device_id;
+    SDL_AudioSpec spec;
+    cube_resources *resources;
+    uint32_t sound_count;
+    cube_sound *sounds;
+    cube_audio_queue queue;
+    cube_voice voices[CUBE_AUDIO_VOICE_COUNT];
+    cube_stream streams[CUBE_AUDIO_STREAM_COUNT];
+    SDL_Thread *stream_thread;
+    SDL_atomic_t streaming;
+    SDL_atomic_t dropped_triggers;
+    SDL_atomic_t stream_underruns;
+} cube_audio;
+
+#endif
\ No newline at end of file
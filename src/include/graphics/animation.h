@@ -0,0 +1,12 @@
+#ifndef CUBE_GRAPHICS_ANIMATION_H
+#define CUBE_GRAPHICS_ANIMATION_H
+
+#include "types.h"
+
+int graphics_create_animation(cube_graphics *graphics);
+
+void graphics_render_animate_frame(cube_graphics *graphics, cube_frame *frame, const cube_scene *scene);
+
+void graphics_destroy_animation(cube_graphics *graphics);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef CUBE_GRAPHICS_BINDLESS_H
+#define CUBE_GRAPHICS_BINDLESS_H
+
+#include "types.h"
+
+int graphics_create_bindless(cube_graphics *graphics);
+
+int graphics_bindless_add_buffer(
+    cube_graphics *graphics,
+    VkBuffer buffer,
+    VkDeviceSize range,
+    uint32_t *index);
+
+int graphics_bindless_add_image(cube_graphics *graphics, VkImageView image_view, uint32_t *index);
+
+int graphics_bindless_add_sampler(cube_graphics *graphics, VkSampler sampler, uint32_t *index);
+
+int graphics_bindless_add_material(cube_graphics *graphics, const cube_material *material, uint32_t *index);
+
+void graphics_bindless_set_instance_material(cube_graphics *graphics, uint32_t instance, uint32_t material);
+
+void graphics_render_bind_bindless(cube_graphics *graphics, VkCommandBuffer command_buffer);
+
+void graphics_destroy_bindless(cube_graphics *graphics);
+
+#endif
\ No newline at end of file
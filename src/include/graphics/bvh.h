@@ -0,0 +1,21 @@
+#ifndef CUBE_GRAPHICS_BVH_H
+#define CUBE_GRAPHICS_BVH_H
+
+#include "types.h"
+
+#define CUBE_BVH_LEAF UINT32_MAX
+
+int graphics_create_bvh(cube_graphics *graphics);
+
+int graphics_bvh_build(cube_bvh *bvh, const cube_transforms *transforms);
+
+void graphics_bvh_frustum(const cube_mat4 *view_projection, cube_frustum *frustum);
+
+uint32_t graphics_bvh_cull(
+    const cube_bvh *bvh,
+    const cube_frustum *frustum,
+    uint32_t *visible);
+
+void graphics_destroy_bvh(cube_graphics *graphics);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,14 @@
+#ifndef CUBE_GRAPHICS_CAPTURE_H
+#define CUBE_GRAPHICS_CAPTURE_H
+
+#include "types.h"
+
+int graphics_create_capture(cube_graphics *graphics);
+
+void graphics_render_capture_frame(cube_graphics *graphics, cube_frame *frame);
+
+void graphics_render_capture_collect(cube_graphics *graphics);
+
+void graphics_destroy_capture(cube_graphics *graphics);
+
+#endif
\ No newline at end of file
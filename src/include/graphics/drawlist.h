@@ -0,0 +1,22 @@
+#ifndef CUBE_GRAPHICS_DRAWLIST_H
+#define CUBE_GRAPHICS_DRAWLIST_H
+
+#include "types.h"
+
+int graphics_create_draw_list(cube_graphics *graphics);
+
+uint64_t graphics_draw_list_key(uint32_t pipeline, uint32_t descriptor, uint32_t mesh, float depth);
+
+void graphics_draw_list_reset(cube_draw_list *list);
+
+void graphics_draw_list_order(cube_draw_list *list, uint32_t *instances, uint32_t count);
+
+void graphics_draw_list_add(cube_draw_list *list, uint64_t key, const VkDrawIndexedIndirectCommand *command);
+
+void graphics_draw_list_sort(cube_draw_list *list);
+
+void graphics_draw_list_build(cube_draw_list *list, void *mapping);
+
+void graphics_destroy_draw_list(cube_graphics *graphics);
+
+#endif
\ No newline at end of file
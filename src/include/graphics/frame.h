@@ -7,7 +7,44 @@ int graphics_create_frame_pool(cube_graphics *graphics);
 
 int graphics_render_acquire_frame(cube_graphics *graphics, cube_frame **frame);
 
-int graphics_render_draw_frame(cube_graphics *graphics, cube_frame *frame);
+int graphics_render_draw_frame(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    const cube_scene *scene);
+
+void graphics_render_begin_pass(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    VkRenderPass render_pass,
+    VkSubpassContents contents);
+
+void graphics_render_begin_rendering(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    VkAttachmentLoadOp load_op,
+    VkAttachmentStoreOp depth_store_op,
+    VkRenderingFlags flags);
+
+void graphics_render_attachment_barrier(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    const VkImageMemoryBarrier2 *color_barrier,
+    const VkImageMemoryBarrier2 *depth_barrier);
+
+void graphics_render_acquire_attachments(cube_graphics *graphics, cube_frame *frame);
+
+void graphics_render_present_attachment(cube_graphics *graphics, cube_frame *frame);
+
+void graphics_render_record_state(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    VkCommandBuffer command_buffer);
+
+void graphics_render_record_draws(
+    cube_graphics *graphics,
+    VkCommandBuffer command_buffer,
+    uint32_t first_visible,
+    uint32_t visible_count);
 
 int graphics_render_submit_frame(cube_graphics *graphics, cube_frame *frame);
 
@@ -2,18 +2,35 @@
 #define CUBE_GRAPHICS_H
 
 #include "graphics/display.h"
+#include "graphics/animation.h"
+#include "graphics/bindless.h"
+#include "graphics/bvh.h"
+#include "graphics/capture.h"
 #include "graphics/device.h"
+#include "graphics/drawlist.h"
 #include "graphics/frame.h"
 #include "graphics/image.h"
+#include "graphics/ktx2.h"
 #include "graphics/object.h"
+#include "graphics/occlusion.h"
+#include "graphics/pacer.h"
 #include "graphics/pipeline.h"
+#include "graphics/recorder.h"
+#include "graphics/reload.h"
+#include "graphics/sync.h"
+#include "graphics/texture.h"
+#include "graphics/timestamp.h"
+#include "graphics/transform.h"
 #include "graphics/util.h"
+#include "graphics/vecmath.h"
+#include "graphics/voxel.h"
 
 int graphics_create(
     cube_graphics **graphics, 
-    const char * resource_directory);
+    cube_jobs *jobs,
+    cube_resources *resources);
 
-int graphics_render(cube_graphics *graphics);
+int graphics_render(cube_graphics *graphics, const cube_scene *scene);
 
 void graphics_destroy(cube_graphics *graphics);
 
@@ -0,0 +1,15 @@
+#ifndef CUBE_GRAPHICS_KTX2_H
+#define CUBE_GRAPHICS_KTX2_H
+
+#include "types.h"
+
+int graphics_ktx2_parse(
+    const uint8_t *data,
+    size_t size,
+    VkBool32 block_compression,
+    uint32_t max_dimension,
+    cube_ktx2 *ktx2);
+
+uint32_t graphics_ktx2_chain_length(uint32_t width, uint32_t height);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef CUBE_GRAPHICS_OCCLUSION_H
+#define CUBE_GRAPHICS_OCCLUSION_H
+
+#include "types.h"
+
+int graphics_create_occlusion(cube_graphics *graphics);
+
+void graphics_render_occlusion_frame(
+    cube_graphics *graphics,
+    cube_frame *frame,
+    const cube_mat4 *view_projection);
+
+void graphics_destroy_occlusion(cube_graphics *graphics);
+
+#endif
\ No newline at end of file
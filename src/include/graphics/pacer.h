@@ -0,0 +1,16 @@
+#ifndef CUBE_GRAPHICS_PACER_H
+#define CUBE_GRAPHICS_PACER_H
+
+#include "types.h"
+
+int graphics_create_pacer(cube_graphics *graphics);
+
+void graphics_render_pace_frame(cube_graphics *graphics);
+
+uint64_t graphics_render_next_present_id(cube_graphics *graphics);
+
+void graphics_render_paced_frame(cube_graphics *graphics);
+
+void graphics_destroy_pacer(cube_graphics *graphics);
+
+#endif
\ No newline at end of file
@@ -5,6 +5,12 @@
 
 int graphics_create_pipeline(cube_graphics *graphics);
 
+int graphics_build_graphics_pipeline(
+    cube_graphics *graphics,
+    VkShaderModule vertex_shader,
+    VkShaderModule fragment_shader,
+    VkPipeline *pipeline);
+
 void graphics_destroy_pipeline(cube_graphics *graphics);
 
 #endif
\ No newline at end of file
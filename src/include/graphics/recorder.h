@@ -0,0 +1,12 @@
+#ifndef CUBE_GRAPHICS_RECORDER_H
+#define CUBE_GRAPHICS_RECORDER_H
+
+#include "types.h"
+
+int graphics_create_recorder(cube_graphics *graphics);
+
+int graphics_render_record_frame(cube_graphics *graphics, cube_frame *frame);
+
+void graphics_destroy_recorder(cube_graphics *graphics);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,12 @@
+#ifndef CUBE_GRAPHICS_RELOAD_H
+#define CUBE_GRAPHICS_RELOAD_H
+
+#include "types.h"
+
+int graphics_create_reload(cube_graphics *graphics);
+
+void graphics_render_reload_frame(cube_graphics *graphics);
+
+void graphics_destroy_reload(cube_graphics *graphics);
+
+#endif
\ No newline at end of file
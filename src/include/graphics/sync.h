@@ -0,0 +1,24 @@
+#ifndef CUBE_GRAPHICS_SYNC_H
+#define CUBE_GRAPHICS_SYNC_H
+
+#include "types.h"
+
+int graphics_create_sync(cube_graphics *graphics);
+
+int graphics_sync_submit(cube_graphics *graphics, const VkSubmitInfo *submit_info, uint64_t *value);
+
+int graphics_sync_wait(cube_graphics *graphics, uint64_t value);
+
+uint64_t graphics_sync_completed(cube_graphics *graphics);
+
+int graphics_sync_defer_buffer(cube_graphics *graphics, VkBuffer buffer, VmaAllocation allocation);
+
+int graphics_sync_defer_pipeline(cube_graphics *graphics, VkPipeline pipeline);
+
+int graphics_sync_defer_command_buffer(cube_graphics *graphics, VkCommandBuffer command_buffer);
+
+void graphics_render_sync_collect(cube_graphics *graphics);
+
+void graphics_destroy_sync(cube_graphics *graphics);
+
+#endif
\ No newline at end of file
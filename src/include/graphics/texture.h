@@ -0,0 +1,12 @@
+#ifndef CUBE_GRAPHICS_TEXTURE_H
+#define CUBE_GRAPHICS_TEXTURE_H
+
+#include "types.h"
+
+int graphics_create_textures(cube_graphics *graphics);
+
+int graphics_textures_sampler(cube_graphics *graphics, const cube_sampler_key *key, uint32_t *index);
+
+void graphics_destroy_textures(cube_graphics *graphics);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef CUBE_GRAPHICS_TIMESTAMP_H
+#define CUBE_GRAPHICS_TIMESTAMP_H
+
+#include "types.h"
+
+// gpu zones for the profile, gone with the rest of it when CUBE_PROFILE is not defined
+#ifdef CUBE_PROFILE
+
+int graphics_create_timestamps(cube_graphics *graphics);
+
+void graphics_render_timestamp_begin(cube_graphics *graphics, cube_frame *frame);
+
+void graphics_render_timestamp_end(cube_graphics *graphics, cube_frame *frame);
+
+void graphics_render_timestamp_collect(cube_graphics *graphics);
+
+void graphics_destroy_timestamps(cube_graphics *graphics);
+
+#else
+
+#define graphics_create_timestamps(GRAPHICS) CUBE_SUCCESS
+#define graphics_render_timestamp_begin(GRAPHICS, FRAME)
+#define graphics_render_timestamp_end(GRAPHICS, FRAME)
+#define graphics_render_timestamp_collect(GRAPHICS)
+#define graphics_destroy_timestamps(GRAPHICS)
+
+#endif
+
+#endif
\ No newline at end of file
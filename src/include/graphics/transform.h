@@ -0,0 +1,27 @@
+#ifndef CUBE_GRAPHICS_TRANSFORM_H
+#define CUBE_GRAPHICS_TRANSFORM_H
+
+#include "types.h"
+
+int graphics_create_transforms(cube_graphics *graphics);
+
+void graphics_transforms_rotate(
+    cube_transforms *transforms,
+    uint32_t first,
+    uint32_t count,
+    const float rotation[4]);
+
+void graphics_transforms_compute(
+    const cube_transforms *transforms,
+    uint32_t first,
+    uint32_t count,
+    float (*matrices)[4][4]);
+
+void graphics_transforms_sphere(
+    const cube_transforms *transforms,
+    uint32_t index,
+    float sphere[4]);
+
+void graphics_destroy_transforms(cube_graphics *graphics);
+
+#endif
\ No newline at end of file
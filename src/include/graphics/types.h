@@ -2,6 +2,22 @@
 #define CUBE_GRAPHICS_TYPES_H
 
 #include "application/common.h"
+#include "application/profile.h"
+#include "application/resource.h"
+
+#define CUBE_SYNC_FENCE_CAPACITY 8
+#define CUBE_SYNC_SIGNAL_CAPACITY 4
+#define CUBE_BVH_CULL_ROOTS 64
+#define CUBE_CAPTURE_SLOTS 4
+#define CUBE_BINDLESS_BUFFER_CAPACITY 1024
+#define CUBE_BINDLESS_IMAGE_CAPACITY 4096
+#define CUBE_BINDLESS_SAMPLER_CAPACITY 32
+#define CUBE_BINDLESS_MATERIAL_CAPACITY 4096
+#define CUBE_BINDLESS_NONE UINT32_MAX
+#define CUBE_TEXTURE_LEVEL_CAPACITY 16
+#define CUBE_VOXEL_CHUNK_SIZE 32
+#define CUBE_VOXEL_CHUNK_VOLUME (CUBE_VOXEL_CHUNK_SIZE * CUBE_VOXEL_CHUNK_SIZE * CUBE_VOXEL_CHUNK_SIZE)
+#define CUBE_DRAW_KEY_STATE_MASK 0xffffffff00000000ull
 
 typedef struct _cube_vertex
 {
@@ -9,6 +25,36 @@ typedef struct _cube_vertex
     float color[3];
 } cube_vertex;
 
+typedef struct CUBE_ALIGN(16) _cube_vec3
+{
+    float x;
+    float y;
+    float z;
+    float padding;
+} cube_vec3;
+
+typedef struct CUBE_ALIGN(16) _cube_vec4
+{
+    float x;
+    float y;
+    float z;
+    float w;
+} cube_vec4;
+
+typedef struct CUBE_ALIGN(16) _cube_quat
+{
+    float x;
+    float y;
+    float z;
+    float w;
+} cube_quat;
+
+// column major, m[column][row], matching the layout the shaders expect
+typedef struct CUBE_ALIGN(16) _cube_mat4
+{
+    float m[4][4];
+} cube_mat4;
+
 typedef struct _cube_object
 {
     VkBuffer vertex_buffer;
@@ -19,19 +65,507 @@ typedef struct _cube_object
     uint32_t index_count;
 } cube_object;
 
+typedef struct _cube_transforms
+{
+    uint32_t count;
+    uint32_t capacity;
+    float *position_x;
+    float *position_y;
+    float *position_z;
+    float *rotation_x;
+    float *rotation_y;
+    float *rotation_z;
+    float *rotation_w;
+    float *scale_x;
+    float *scale_y;
+    float *scale_z;
+} cube_transforms;
+
+typedef struct _cube_bvh_node
+{
+    float min[3];
+    uint32_t left;
+    float max[3];
+    uint32_t right;
+    uint32_t first;
+    uint32_t last;
+} cube_bvh_node;
+
+typedef struct _cube_bvh
+{
+    uint32_t object_count;
+    uint32_t node_count;
+    cube_bvh_node *nodes;
+    uint32_t *parents;
+    uint32_t *objects;
+    uint32_t *codes;
+    SDL_atomic_t *visits;
+    cube_jobs *jobs;
+    float scene_min[3];
+    float scene_max[3];
+} cube_bvh;
+
+typedef struct _cube_bvh_task
+{
+    cube_bvh *bvh;
+    const cube_transforms *transforms;
+    int phase;
+} cube_bvh_task;
+
+// six clip planes in structure of arrays form, padded to eight lanes
+typedef struct CUBE_ALIGN(16) _cube_frustum
+{
+    float x[8];
+    float y[8];
+    float z[8];
+    float w[8];
+    float abs_x[8];
+    float abs_y[8];
+    float abs_z[8];
+} cube_frustum;
+
+// each root writes its survivors at its own first leaf, the counts are compacted in root order
+typedef struct _cube_bvh_cull_task
+{
+    const cube_bvh *bvh;
+    const cube_frustum *frustum;
+    uint32_t *visible;
+    uint32_t root_count;
+    uint32_t roots[CUBE_BVH_CULL_ROOTS];
+    uint32_t counts[CUBE_BVH_CULL_ROOTS];
+} cube_bvh_cull_task;
+
+typedef struct _cube_occlusion_constants
+{
+    float view_projection[4][4];
+    float pyramid_size[2];
+    uint32_t phase;
+    uint32_t candidate_count;
+    uint32_t index_count;
+} cube_occlusion_constants;
+
+typedef struct _cube_reduce_constants
+{
+    uint32_t source_size[2];
+    uint32_t target_size[2];
+} cube_reduce_constants;
+
+typedef struct _cube_occlusion
+{
+    VkRenderPass early_render_pass;
+    VkRenderPass late_render_pass;
+    VkSampler sampler;
+    VkImageView depth_view;
+    VkImage pyramid;
+    VmaAllocation pyramid_allocation;
+    VkImageView pyramid_view;
+    VkImageView *pyramid_level_views;
+    uint32_t pyramid_levels;
+    VkExtent2D pyramid_size;
+    VkBuffer bounds_buffer;
+    VmaAllocation bounds_allocation;
+    VkBuffer candidate_buffer;
+    VmaAllocation candidate_allocation;
+    void *candidate_mapping;
+    VkBuffer visibility_buffer;
+    VmaAllocation visibility_allocation;
+    VkBuffer early_draw_buffer;
+    VmaAllocation early_draw_allocation;
+    VkBuffer late_draw_buffer;
+    VmaAllocation late_draw_allocation;
+    VkDescriptorSetLayout cull_set_layout;
+    VkDescriptorSetLayout reduce_set_layout;
+    VkPipelineLayout cull_pipeline_layout;
+    VkPipelineLayout reduce_pipeline_layout;
+    VkPipeline cull_pipeline;
+    VkPipeline reduce_pipeline;
+    VkDescriptorPool descriptor_pool;
+    VkDescriptorSet cull_set;
+    VkDescriptorSet *reduce_sets;
+} cube_occlusion;
+
+// std430 layout, the spin is about axis by phase plus angular_velocity times the scene angle
+typedef struct _cube_animation_state
+{
+    float position[3];
+    float angular_velocity;
+    float scale[3];
+    float phase;
+    float rotation[4];
+    float axis[4];
+} cube_animation_state;
+
+typedef struct _cube_animation_constants
+{
+    float angle;
+    uint32_t instance_count;
+} cube_animation_constants;
+
+// the matrices are written on the gpu each frame, so one buffer serves every frame
+typedef struct _cube_animation
+{
+    VkBuffer state_buffer;
+    VmaAllocation state_allocation;
+    VkBuffer matrix_buffer;
+    VmaAllocation matrix_allocation;
+    VkDescriptorSetLayout set_layout;
+    VkPipelineLayout pipeline_layout;
+    VkPipeline pipeline;
+    VkDescriptorPool descriptor_pool;
+    VkDescriptorSet descriptor_set;
+} cube_animation;
+
+typedef enum _cube_voxel_block
+{
+    CUBE_VOXEL_AIR,
+    CUBE_VOXEL_GRASS,
+    CUBE_VOXEL_DIRT,
+    CUBE_VOXEL_STONE,
+    CUBE_VOXEL_SNOW,
+    CUBE_VOXEL_BLOCK_COUNT,
+} cube_voxel_block;
+
+typedef struct _cube_voxel_edit
+{
+    uint32_t position[3];
+    uint16_t block;
+} cube_voxel_edit;
+
+// written by a meshing job, vertices then indices in one block ready for upload
+typedef struct _cube_voxel_mesh
+{
+    uint8_t *data;
+    size_t size;
+    VkDeviceSize index_offset;
+    uint32_t index_count;
+    VkBool32 failed;
+} cube_voxel_mesh;
+
+// indices into the palette are packed at a power of two width so none straddles a word,
+// a chunk with a single palette entry stores no indices at all
+typedef struct _cube_voxel_chunk
+{
+    uint16_t *palette;
+    uint32_t palette_count;
+    uint32_t palette_capacity;
+    uint32_t bits;
+    uint64_t *indices;
+    uint32_t coordinates[3];
+    VkBool32 dirty;
+    cube_voxel_mesh mesh;
+    VkBuffer buffer;
+    VmaAllocation allocation;
+    VkDeviceSize index_offset;
+    uint32_t index_count;
+} cube_voxel_chunk;
+
+// edits are applied between meshing batches, so the jobs never see the storage change
+typedef struct _cube_voxels
+{
+    uint32_t side;
+    uint32_t chunk_count;
+    cube_voxel_chunk *chunks;
+    VkBuffer matrix_buffer;
+    VmaAllocation matrix_allocation;
+    uint32_t *batch;
+    uint32_t batch_count;
+    cube_job_counter pending;
+    SDL_atomic_t failed;
+    cube_voxel_edit *edits;
+    uint32_t edit_count;
+    uint32_t edit_capacity;
+} cube_voxels;
+
+// a run of sorted draws sharing pipeline, descriptor and mesh, recorded as one indirect call
+typedef struct _cube_draw_batch
+{
+    uint64_t state;
+    uint32_t first_command;
+    uint32_t command_count;
+} cube_draw_batch;
+
+// keys and item indices are sorted together, the scratch arrays are the other half of each radix pass
+typedef struct _cube_draw_list
+{
+    uint32_t capacity;
+    uint32_t item_count;
+    VkDrawIndexedIndirectCommand *items;
+    uint64_t *keys;
+    uint32_t *values;
+    uint64_t *scratch_keys;
+    uint32_t *scratch_values;
+    VkDrawIndexedIndirectCommand *commands;
+    uint32_t command_count;
+    cube_draw_batch *batches;
+    uint32_t batch_count;
+    uint64_t *mask;
+} cube_draw_list;
+
 typedef struct _cube_frame
 {
     uint32_t index;
+    VkImage image;
     VkImageView image_view;
     VkFramebuffer framebuffer;
     VkCommandBuffer command_buffer;
     VkFence fence;
+    // one per image, it is only signaled again once the image is reacquired and so presented
+    VkSemaphore rendered;
     VkBuffer uniform_buffer;
     VmaAllocation uniform_buffer_allocation;
     void *uniform_buffer_mapping;
+    VkBuffer instance_buffer;
+    VmaAllocation instance_buffer_allocation;
+    void *instance_buffer_mapping;
+    VkBuffer draw_buffer;
+    VmaAllocation draw_buffer_allocation;
+    void *draw_buffer_mapping;
     VkDescriptorSet descriptor_set;
 } cube_frame;
 
+// a slice is one job, whichever thread runs it records into the slice's own pool
+typedef struct _cube_recorder_slice
+{
+    VkCommandPool command_pool;
+    VkCommandBuffer *command_buffers;
+    uint32_t first_visible;
+    uint32_t visible_count;
+} cube_recorder_slice;
+
+typedef struct _cube_recorder
+{
+    struct _cube_graphics *graphics;
+    cube_frame *frame;
+    uint32_t slice_count;
+    cube_recorder_slice *slices;
+    VkCommandBuffer *command_buffers;
+    SDL_atomic_t failures;
+} cube_recorder;
+
+// simulation state published by the main thread and consumed by the render thread
+typedef struct _cube_scene
+{
+    uint64_t tick;
+    uint64_t input_id;
+    float angle;
+} cube_scene;
+
+typedef struct _cube_pacer
+{
+    PFN_vkWaitForPresentKHR wait_for_present;
+    uint64_t present_id;
+    Uint64 frequency;
+    Uint64 interval;
+    Uint64 deadline;
+    Uint64 frame_start;
+    Uint64 work_estimate;
+    Uint64 sleep_slack;
+} cube_pacer;
+
+// the pending pipeline goes from the reload thread to the render thread through one atomic pointer,
+// the replaced pipeline goes to the sync deletion queue
+typedef struct _cube_reload
+{
+    SDL_Thread *thread;
+    SDL_atomic_t running;
+    void *pending;
+    int watch;
+    char *directory;
+} cube_reload;
+
+typedef enum _cube_deletion_type
+{
+    CUBE_DELETION_BUFFER,
+    CUBE_DELETION_PIPELINE,
+    CUBE_DELETION_COMMAND_BUFFER,
+} cube_deletion_type;
+
+// destroyed once the graphics queue timeline reaches value
+typedef struct _cube_deletion
+{
+    cube_deletion_type type;
+    uint64_t value;
+    VkBuffer buffer;
+    VmaAllocation allocation;
+    VkPipeline pipeline;
+    VkCommandBuffer command_buffer;
+} cube_deletion;
+
+// one monotonic counter for the graphics queue, every submission signals the next value;
+// without timeline semaphores a ring of fences stands in, one per value still in flight
+typedef struct _cube_sync
+{
+    SDL_mutex *mutex;
+    VkSemaphore timeline;
+    VkFence fences[CUBE_SYNC_FENCE_CAPACITY];
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t frame;
+    cube_deletion *deletions;
+    uint32_t deletion_count;
+} cube_sync;
+
+// std430 layout, read by the bindless shaders
+typedef struct _cube_material
+{
+    float color[4];
+    uint32_t texture;
+    uint32_t sampler;
+    uint32_t padding[2];
+} cube_material;
+
+// pushed once per command buffer, every draw finds its material through the instance index
+typedef struct _cube_bindless_constants
+{
+    uint32_t material_buffer;
+    uint32_t instance_buffer;
+} cube_bindless_constants;
+
+// one update-after-bind set for the whole renderer, a slot is handed out once and never moves
+typedef struct _cube_bindless
+{
+    VkDescriptorPool descriptor_pool;
+    VkDescriptorSetLayout descriptor_set_layout;
+    VkDescriptorSet descriptor_set;
+    uint32_t buffer_capacity;
+    uint32_t buffer_count;
+    uint32_t image_capacity;
+    uint32_t image_count;
+    uint32_t sampler_count;
+    VkBuffer material_buffer;
+    VmaAllocation material_buffer_allocation;
+    cube_material *materials;
+    uint32_t material_count;
+    VkBuffer instance_buffer;
+    VmaAllocation instance_buffer_allocation;
+    uint32_t *instance_materials;
+    cube_bindless_constants constants;
+} cube_bindless;
+
+typedef struct _cube_sampler_key
+{
+    VkFilter filter;
+    VkSamplerMipmapMode mipmap_mode;
+    VkSamplerAddressMode address_mode;
+    VkBool32 anisotropy;
+} cube_sampler_key;
+
+typedef struct _cube_sampler
+{
+    cube_sampler_key key;
+    VkSampler sampler;
+    uint32_t index;
+} cube_sampler;
+
+// block_extent is 1 for plain texels, 4 for the bc formats
+typedef struct _cube_texture_format
+{
+    VkFormat format;
+    uint32_t block_extent;
+    uint32_t block_size;
+} cube_texture_format;
+
+// the fields of a ktx2 file the upload needs, offsets point into the file bytes
+typedef struct _cube_ktx2
+{
+    const cube_texture_format *format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t level_count;
+    VkBool32 generate_levels;
+    uint64_t level_offsets[CUBE_TEXTURE_LEVEL_CAPACITY];
+} cube_ktx2;
+
+// index is the bindless image slot, material the material that samples it
+typedef struct _cube_texture
+{
+    VkImage image;
+    VmaAllocation allocation;
+    VkImageView image_view;
+    VkFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t level_count;
+    uint32_t index;
+    uint32_t material;
+} cube_texture;
+
+// textures are sampled through the bindless set only, samplers are shared by key
+typedef struct _cube_textures
+{
+    cube_texture *textures;
+    uint32_t texture_count;
+    cube_sampler samplers[CUBE_BINDLESS_SAMPLER_CAPACITY];
+    uint32_t sampler_count;
+} cube_textures;
+
+typedef enum _cube_capture_format
+{
+    CUBE_CAPTURE_FORMAT_PNG,
+    CUBE_CAPTURE_FORMAT_RAW,
+} cube_capture_format;
+
+// one png being written, idat is a single chunk of stored deflate blocks
+typedef struct _cube_capture_png
+{
+    FILE *file;
+    uint32_t crc;
+    uint32_t adler_low;
+    uint32_t adler_high;
+    uint32_t block_remaining;
+    uint64_t remaining;
+} cube_capture_png;
+
+// busy from the frame that records the copy until the writer has encoded it
+typedef struct _cube_capture_slot
+{
+    VkBuffer buffer;
+    VmaAllocation allocation;
+    void *mapping;
+    uint64_t frame;
+    SDL_atomic_t busy;
+} cube_capture_slot;
+
+// slots are recorded, handed over and written in the same round-robin order,
+// so the writer only follows handed with its own count
+typedef struct _cube_capture
+{
+    cube_capture_format format;
+    char *directory;
+    uint32_t width;
+    uint32_t height;
+    SDL_bool swizzle;
+    uint64_t frame;
+    uint64_t first;
+    uint64_t count;
+    uint64_t captured;
+    uint32_t record_index;
+    uint32_t recorded;
+    SDL_atomic_t handed;
+    SDL_atomic_t failed;
+    SDL_sem *ready;
+    SDL_Thread *thread;
+    FILE *stream;
+    uint8_t *row;
+    cube_capture_slot slots[CUBE_CAPTURE_SLOTS];
+} cube_capture;
+
+#ifdef CUBE_PROFILE
+// two queries per frame, read back once the timeline has passed the frame;
+// base pairs a device tick with the host counter at the same instant
+typedef struct _cube_timestamps
+{
+    VkQueryPool query_pool;
+    float period;
+    uint64_t valid_mask;
+    PFN_vkGetCalibratedTimestampsEXT get_calibrated_timestamps;
+    VkTimeDomainEXT host_domain;
+    uint64_t device_base;
+    Uint64 host_base;
+    uint32_t submitted;
+} cube_timestamps;
+#endif
+
 typedef struct _cube_ubo
 {
     float model[4][4];
@@ -39,16 +573,63 @@ typedef struct _cube_ubo
     float projection[4][4];
 } cube_ubo;
 
+typedef struct _cube_update_task
+{
+    cube_transforms *transforms;
+    float rotation[4];
+    float (*matrices)[4][4];
+} cube_update_task;
+
+// what the selected device offers, probed once so later stages only read flags
+typedef struct
+{
+    char name[VK_MAX_PHYSICAL_DEVICE_NAME_SIZE];
+    VkPhysicalDeviceType type;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t api_version;
+    uint32_t driver_version;
+    VkDeviceSize device_local_memory;
+    uint32_t queue_family_count;
+    uint32_t graphics_queue_family_index;
+    uint32_t present_queue_family_index;
+    uint32_t timestamp_valid_bits;
+    float timestamp_period;
+    float max_sampler_anisotropy;
+    uint32_t max_image_dimension_2d;
+    uint32_t max_bindless_buffers;
+    uint32_t max_bindless_images;
+    VkBool32 graphics_queue_family;
+    VkBool32 present_queue_family;
+    VkBool32 swapchain_extension;
+    VkBool32 present_id_extension;
+    VkBool32 present_wait_extension;
+    VkBool32 calibrated_timestamps_extension;
+    VkBool32 sampler_anisotropy;
+    VkBool32 texture_compression_bc;
+    VkBool32 multi_draw_indirect;
+    VkBool32 draw_indirect_first_instance;
+    VkBool32 present_wait;
+    VkBool32 calibrated_timestamps;
+    VkBool32 dynamic_rendering;
+    VkBool32 synchronization2;
+    VkBool32 timeline_semaphore;
+    VkBool32 descriptor_indexing;
+} cube_device_capabilities;
+
 typedef struct _cube_graphics
 {
-    char *shader_directory;
+    cube_jobs *jobs;
+    cube_resources *resources;
 
     SDL_Window *window;
     VkInstance instance;
+    uint32_t api_version;
     VkSurfaceKHR surface;
     VkExtent2D display_size;
 
     VkPhysicalDevice physical_device;
+    cube_device_capabilities capabilities;
     uint32_t graphics_queue_family_index;
     uint32_t present_queue_family_index;
     VkDevice logical_device;
@@ -56,21 +637,35 @@ typedef struct _cube_graphics
     VkQueue present_queue;
     VmaAllocator allocator;
     VkCommandPool command_pool;
+    cube_sync *sync;
 
     VkSurfaceCapabilitiesKHR surface_capabilities;
     VkSurfaceFormatKHR surface_format;
     VkRenderPass render_pass;
+    VkBool32 dynamic_rendering;
+    VkBool32 descriptor_indexing;
+    cube_bindless *bindless;
+    cube_textures *textures;
     VkDescriptorSetLayout descriptor_set_layout;
+    VkPipelineCache pipeline_cache;
     VkPipelineLayout pipeline_layout;
     VkPipeline graphics_pipeline;
  
     cube_object *object;
-    int theta;
-    clock_t timestamp;
+    uint32_t instance_count;
+    cube_transforms *transforms;
+    cube_bvh *bvh;
+    uint32_t *visible_instances;
+    uint32_t visible_count;
+    cube_draw_list *draw_list;
+    float scene_angle;
+    cube_animation *animation;
+    cube_voxels *voxels;
 
     VkSwapchainKHR swapchain;
     VkFormat depth_format;
     VkBool32 depth_stencil_support;
+    VkBool32 depth_sampled_support;
     VkImage depth_image;
     VmaAllocation depth_image_allocation;
     VkImageView depth_image_view;
@@ -79,9 +674,16 @@ typedef struct _cube_graphics
     VkDescriptorPool descriptor_pool;
     cube_frame *frames;
     VkDescriptorSet *descriptor_sets;
-    VkSemaphore frame_rendered;
     VkSemaphore frame_presented;
-    VkFence command_fence;
+
+    cube_recorder *recorder;
+    cube_occlusion *occlusion;
+    cube_pacer *pacer;
+    cube_reload *reload;
+    cube_capture *capture;
+#ifdef CUBE_PROFILE
+    cube_timestamps *timestamps;
+#endif
 } cube_graphics;
 
 #endif
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include "types.h"
 
+VkBool32 graphics_util_has_shader(cube_graphics *graphics, const char *shader_file);
+
 int graphics_util_load_shader(
     cube_graphics *graphics,
     const char *shader_file,
@@ -0,0 +1,60 @@
+#ifndef CUBE_GRAPHICS_VECMATH_H
+#define CUBE_GRAPHICS_VECMATH_H
+
+#include "types.h"
+
+float graphics_vec3_dot(const cube_vec3 *a, const cube_vec3 *b);
+
+void graphics_vec3_cross(const cube_vec3 *a, const cube_vec3 *b, cube_vec3 *out);
+
+void graphics_vec3_normalize(const cube_vec3 *vector, cube_vec3 *out);
+
+void graphics_mat4_transform_vec4(const cube_mat4 *matrix, const cube_vec4 *vector, cube_vec4 *out);
+
+void graphics_quat_from_axis_angle(const cube_vec3 *axis, float angle, cube_quat *out);
+
+void graphics_quat_multiply(const cube_quat *a, const cube_quat *b, cube_quat *out);
+
+void graphics_mat4_identity(cube_mat4 *out);
+
+void graphics_mat4_from_quat(const cube_quat *rotation, cube_mat4 *out);
+
+void graphics_mat4_rotate(
+    const cube_mat4 *matrix,
+    float angle,
+    const cube_vec3 *axis,
+    cube_mat4 *out);
+
+void graphics_mat4_look_at(
+    const cube_vec3 *eye,
+    const cube_vec3 *center,
+    const cube_vec3 *up,
+    cube_mat4 *out);
+
+void graphics_mat4_perspective(
+    float fov,
+    float aspect,
+    float znear,
+    float zfar,
+    cube_mat4 *out);
+
+void graphics_mat4_multiply(const cube_mat4 *a, const cube_mat4 *b, cube_mat4 *out);
+
+void graphics_mat4_multiply_scalar(const cube_mat4 *a, const cube_mat4 *b, cube_mat4 *out);
+
+void graphics_mat4_multiply_batch(
+    const cube_mat4 *left,
+    const cube_mat4 *matrices,
+    uint32_t count,
+    cube_mat4 *out);
+
+int graphics_mat4_inverse(const cube_mat4 *matrix, cube_mat4 *out);
+
+int graphics_mat4_inverse_scalar(const cube_mat4 *matrix, cube_mat4 *out);
+
+int graphics_mat4_inverse_batch(
+    const cube_mat4 *matrices,
+    uint32_t count,
+    cube_mat4 *out);
+
+#endif
\ No newline at end of file
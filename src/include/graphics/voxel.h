@@ -0,0 +1,19 @@
+#ifndef CUBE_GRAPHICS_VOXEL_H
+#define CUBE_GRAPHICS_VOXEL_H
+
+#include "types.h"
+
+int graphics_create_voxels(cube_graphics *graphics);
+
+int graphics_voxels_set(cube_graphics *graphics, const uint32_t position[3], uint16_t block);
+
+int graphics_render_voxel_frame(cube_graphics *graphics);
+
+void graphics_render_voxel_draws(
+    cube_graphics *graphics,
+    VkCommandBuffer command_buffer,
+    const cube_mat4 *view_projection);
+
+void graphics_destroy_voxels(cube_graphics *graphics);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+const uint NONE = 0xFFFFFFFFu;
+
+struct Material {
+    vec4 color;
+    uint texture;
+    uint sampler;
+    uint padding[2];
+};
+
+layout(set = 1, binding = 0) readonly buffer MaterialBuffer {
+    Material materials[];
+} materialBuffers[];
+
+layout(set = 1, binding = 1) uniform texture2D textures[];
+layout(set = 1, binding = 2) uniform sampler samplers[];
+
+layout(push_constant) uniform BindlessConstants {
+    uint materialBuffer;
+    uint instanceBuffer;
+} constants;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) flat in uint fragMaterial;
+layout(location = 2) in vec3 fragPosition;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    Material material = materialBuffers[constants.materialBuffer].materials[fragMaterial];
+    vec3 normal;
+    vec2 uv;
+
+    outColor = vec4(fragColor, 1.0) * material.color;
+    if (material.texture != NONE) {
+        // the cube has no texture coordinates, each face projects along its largest normal axis
+        normal = abs(cross(dFdx(fragPosition), dFdy(fragPosition)));
+        uv = (normal.x > normal.y && normal.x > normal.z) ? fragPosition.yz
+           : (normal.y > normal.z)                        ? fragPosition.xz
+                                                          : fragPosition.xy;
+        outColor *= texture(
+            sampler2D(textures[nonuniformEXT(material.texture)], samplers[nonuniformEXT(material.sampler)]),
+            uv + 0.5);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+// the material ids of every instance, indexed by gl_InstanceIndex
+layout(set = 1, binding = 0) readonly buffer InstanceBuffer {
+    uint materials[];
+} instanceBuffers[];
+
+layout(push_constant) uniform BindlessConstants {
+    uint materialBuffer;
+    uint instanceBuffer;
+} constants;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in mat4 inModel;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) flat out uint fragMaterial;
+layout(location = 2) out vec3 fragPosition;
+
+void main() {
+    gl_Position = ubo.proj * ubo.view * ubo.model * inModel * vec4(inPosition, 1.0);
+    fragColor = inColor;
+    fragMaterial = instanceBuffers[constants.instanceBuffer].materials[gl_InstanceIndex];
+    fragPosition = inPosition;
+}
\ No newline at end of file
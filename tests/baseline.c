@@ -0,0 +1,178 @@
+#include <cube.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define TEST_MKDIR(PATH) _mkdir(PATH)
+#else
+#include <sys/stat.h>
+#define TEST_MKDIR(PATH) mkdir(PATH, 0755)
+#endif
+
+#define TEST_UPDATE_VARIABLE "CUBE_UPDATE_BASELINES"
+#define TEST_METRIC_CAPACITY 32
+#define TEST_NAME_LENGTH 64
+
+typedef struct
+{
+    char name[TEST_NAME_LENGTH];
+    double value;
+} test_metric;
+
+static int test_copy(const char *source_path, const char *destination_path);
+static int test_make_parent(const char *path);
+static uint32_t test_read_metrics(FILE *file, test_metric *metrics);
+
+// every metric is a time in milliseconds, so only a rise beyond the threshold fails
+int main(int argc, char **argv)
+{
+    test_metric metrics[TEST_METRIC_CAPACITY];
+    test_metric baselines[TEST_METRIC_CAPACITY];
+    uint32_t metric_count;
+    uint32_t baseline_count;
+    uint32_t metric_index;
+    uint32_t baseline_index;
+    FILE *file;
+    const char *update_variable;
+    double threshold;
+    int result;
+
+    if (argc < 4)
+    {
+        puts("usage: cube_baseline <metrics> <baseline> <threshold>");
+        return CUBE_FAILURE;
+    }
+    threshold = SDL_atof(argv[3]);
+
+    update_variable = SDL_getenv(TEST_UPDATE_VARIABLE);
+    if (update_variable != NULL && SDL_atoi(update_variable) != 0)
+    {
+        result = test_copy(argv[1], argv[2]);
+        if (result == CUBE_SUCCESS)
+        {
+            printf("updated %s\n", argv[2]);
+        }
+        return result;
+    }
+
+    file = fopen(argv[2], "r");
+    if (file == NULL)
+    {
+        printf("no baseline at %s, run with " TEST_UPDATE_VARIABLE "=1 on the reference machine to record it\n", argv[2]);
+        return CUBE_FAILURE;
+    }
+    baseline_count = test_read_metrics(file, baselines);
+    fclose(file);
+    file = fopen(argv[1], "r");
+    if (file == NULL)
+    {
+        printf("no metrics at %s\n", argv[1]);
+        return CUBE_FAILURE;
+    }
+    metric_count = test_read_metrics(file, metrics);
+    fclose(file);
+
+    result = CUBE_SUCCESS;
+    for (baseline_index = 0; baseline_index < baseline_count; baseline_index++)
+    {
+        for (metric_index = 0;
+             metric_index < metric_count && SDL_strcmp(metrics[metric_index].name, baselines[baseline_index].name) != 0;
+             metric_index++)
+        {
+        }
+        if (metric_index == metric_count)
+        {
+            printf("%-16s missing\n", baselines[baseline_index].name);
+            result = CUBE_FAILURE;
+            continue;
+        }
+        printf(
+            "%-16s %10.3f ms, baseline %10.3f ms, %+6.1f%%\n",
+            baselines[baseline_index].name,
+            metrics[metric_index].value,
+            baselines[baseline_index].value,
+            (baselines[baseline_index].value > 0.0)
+                ? (metrics[metric_index].value / baselines[baseline_index].value - 1.0) * 100.0
+                : 0.0);
+        if (metrics[metric_index].value > baselines[baseline_index].value * (1.0 + threshold))
+        {
+            result = CUBE_FAILURE;
+        }
+    }
+    if (result != CUBE_SUCCESS)
+    {
+        printf("regressed by more than %.0f%%\n", threshold * 100.0);
+    }
+    return result;
+}
+
+int test_copy(const char *source_path, const char *destination_path)
+{
+    CUBE_BEGIN_FUNCTION
+    FILE *source;
+    FILE *destination;
+    char buffer[4096];
+    size_t length;
+    int write_error;
+
+    source = fopen(source_path, "rb");
+    CUBE_ASSERT(source != NULL, strerror(errno))
+    if (test_make_parent(destination_path) != CUBE_SUCCESS)
+    {
+        fclose(source);
+        CUBE_ASSERT(SDL_FALSE, strerror(errno))
+    }
+    destination = fopen(destination_path, "wb");
+    if (destination == NULL)
+    {
+        fclose(source);
+        CUBE_ASSERT(SDL_FALSE, strerror(errno))
+    }
+    while ((length = fread(buffer, 1, sizeof(buffer), source)) > 0)
+    {
+        fwrite(buffer, 1, length, destination);
+    }
+    fclose(source);
+    write_error = ferror(destination);
+    CUBE_ASSERT(fclose(destination) == 0 && write_error == 0, "failed to write baseline")
+    CUBE_END_FUNCTION
+}
+
+// the baselines directory is only created once something is recorded into it
+int test_make_parent(const char *path)
+{
+    CUBE_BEGIN_FUNCTION
+    char *directory;
+    char *separator;
+
+    directory = CUBE_CALLOC(SDL_strlen(path) + 1, 1);
+    CUBE_ASSERT(directory != NULL, "failed to allocate directory")
+    SDL_strlcpy(directory, path, SDL_strlen(path) + 1);
+    separator = SDL_strrchr(directory, '/');
+#ifdef _WIN32
+    if (SDL_strrchr(directory, '\\') > separator)
+    {
+        separator = SDL_strrchr(directory, '\\');
+    }
+#endif
+    if (separator == NULL || separator == directory)
+    {
+        goto done;
+    }
+    *separator = '\0';
+    CUBE_ASSERT(TEST_MKDIR(directory) == 0 || errno == EEXIST, strerror(errno))
+    CUBE_END_FUNCTION
+}
+
+// one name and value per line, as the render thread writes them
+uint32_t test_read_metrics(FILE *file, test_metric *metrics)
+{
+    uint32_t metric_count;
+
+    metric_count = 0;
+    while (metric_count < TEST_METRIC_CAPACITY &&
+           fscanf(file, "%63s %lf", metrics[metric_count].name, &metrics[metric_count].value) == 2)
+    {
+        metric_count++;
+    }
+    return metric_count;
+}
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include <cube.h>
+
+#define TEST_INSTANCE_COUNT 20000
+#define TEST_VIEW_COUNT 8
+#define TEST_SCENE_EXTENT 4.0f
+#define TEST_BORDER_EPSILON 1e-4f
+#define TEST_OUTSIDE 0
+#define TEST_BORDER 1
+#define TEST_VISIBLE 2
+
+static cube_graphics test_graphics;
+static cube_transforms test_transforms;
+static uint8_t test_visible[TEST_INSTANCE_COUNT];
+
+static int test_create_transforms(cube_transforms *transforms);
+static void test_destroy_transforms(cube_transforms *transforms);
+static int test_brute_force(const cube_frustum *frustum, uint32_t index);
+static int test_compare(const char *name, const cube_frustum *frustum, uint32_t visible_count);
+
+// the bvh walk, serial and split across workers, must keep exactly the instances a per instance test keeps
+int main(void)
+{
+    const cube_vec3 center = {0.0f, 0.0f, 0.0f, 0.0f};
+    const cube_vec3 up = {0.0f, 1.0f, 0.0f, 0.0f};
+    cube_vec3 eye;
+    cube_mat4 view;
+    cube_mat4 projection;
+    cube_mat4 view_projection;
+    cube_frustum frustum;
+    cube_jobs *jobs;
+    uint32_t worker_count;
+    uint32_t view_index;
+    uint32_t visible_count;
+    float angle;
+    char name[64];
+    int result;
+
+    if (test_create_transforms(&test_transforms) != CUBE_SUCCESS)
+    {
+        puts("failed to allocate transforms");
+        return CUBE_FAILURE;
+    }
+    result = CUBE_SUCCESS;
+    graphics_mat4_perspective(0.8f, 16.0f / 9.0f, 0.1f, 10.0f, &projection);
+    for (worker_count = 0; worker_count < 4; worker_count += 3)
+    {
+        if (application_create_jobs(&jobs, worker_count) != CUBE_SUCCESS)
+        {
+            puts("failed to create jobs");
+            result = CUBE_FAILURE;
+            break;
+        }
+        test_graphics.jobs = jobs;
+        test_graphics.transforms = &test_transforms;
+        test_graphics.instance_count = test_transforms.count;
+        if (graphics_create_bvh(&test_graphics) != CUBE_SUCCESS || test_graphics.bvh == NULL)
+        {
+            puts("failed to create bvh");
+            application_destroy_jobs(jobs);
+            result = CUBE_FAILURE;
+            break;
+        }
+
+        // views circle the scene from inside and outside it, so every test result occurs
+        for (view_index = 0; view_index < TEST_VIEW_COUNT; view_index++)
+        {
+            angle = (float)view_index * 2.0f * (float)M_PI / TEST_VIEW_COUNT;
+            eye.x = cosf(angle) * (1.0f + (float)(view_index % 3)) * TEST_SCENE_EXTENT * 0.5f;
+            eye.y = (float)(view_index % 2) * TEST_SCENE_EXTENT * 0.5f;
+            eye.z = sinf(angle) * (1.0f + (float)(view_index % 3)) * TEST_SCENE_EXTENT * 0.5f;
+            graphics_mat4_look_at(&eye, &center, &up, &view);
+            graphics_mat4_multiply(&projection, &view, &view_projection);
+            graphics_bvh_frustum(&view_projection, &frustum);
+            visible_count = graphics_bvh_cull(test_graphics.bvh, &frustum, test_graphics.visible_instances);
+            SDL_snprintf(name, sizeof(name), "view %u, %u workers", view_index, worker_count);
+            result |= test_compare(name, &frustum, visible_count);
+        }
+        graphics_destroy_bvh(&test_graphics);
+        application_destroy_jobs(jobs);
+    }
+    test_destroy_transforms(&test_transforms);
+    return result;
+}
+
+// scattered with a fixed seed and uneven scales, so the tree is not a regular grid
+int test_create_transforms(cube_transforms *transforms)
+{
+    float **arrays[] = {
+        &transforms->position_x,
+        &transforms->position_y,
+        &transforms->position_z,
+        &transforms->rotation_x,
+        &transforms->rotation_y,
+        &transforms->rotation_z,
+        &transforms->rotation_w,
+        &transforms->scale_x,
+        &transforms->scale_y,
+        &transforms->scale_z,
+    };
+    uint32_t array_index;
+    uint32_t index;
+    uint32_t seed;
+
+    transforms->count = TEST_INSTANCE_COUNT;
+    transforms->capacity = TEST_INSTANCE_COUNT;
+    for (array_index = 0; array_index < sizeof(arrays) / sizeof(arrays[0]); array_index++)
+    {
+        *arrays[array_index] = SDL_SIMDAlloc(TEST_INSTANCE_COUNT * sizeof(float));
+        if (*arrays[array_index] == NULL)
+        {
+            return CUBE_FAILURE;
+        }
+    }
+    seed = 1;
+    for (index = 0; index < TEST_INSTANCE_COUNT; index++)
+    {
+        for (array_index = 0; array_index < 3; array_index++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            *(*arrays[array_index] + index) = ((float)(seed >> 8) / (float)(1 << 24) - 0.5f) * TEST_SCENE_EXTENT;
+        }
+        *(transforms->rotation_x + index) = 0.0f;
+        *(transforms->rotation_y + index) = 0.0f;
+        *(transforms->rotation_z + index) = 0.0f;
+        *(transforms->rotation_w + index) = 1.0f;
+        seed = seed * 1664525u + 1013904223u;
+        *(transforms->scale_x + index) = 0.01f + 0.04f * (float)(seed >> 8) / (float)(1 << 24);
+        *(transforms->scale_y + index) = *(transforms->scale_x + index);
+        *(transforms->scale_z + index) = *(transforms->scale_x + index);
+    }
+    return CUBE_SUCCESS;
+}
+
+void test_destroy_transforms(cube_transforms *transforms)
+{
+    SDL_SIMDFree(transforms->position_x);
+    SDL_SIMDFree(transforms->position_y);
+    SDL_SIMDFree(transforms->position_z);
+    SDL_SIMDFree(transforms->rotation_x);
+    SDL_SIMDFree(transforms->rotation_y);
+    SDL_SIMDFree(transforms->rotation_z);
+    SDL_SIMDFree(transforms->rotation_w);
+    SDL_SIMDFree(transforms->scale_x);
+    SDL_SIMDFree(transforms->scale_y);
+    SDL_SIMDFree(transforms->scale_z);
+}
+
+// the same box around the bounding sphere the leaves use, outside once it is behind any plane,
+// a box within rounding of a plane may go either way
+int test_brute_force(const cube_frustum *frustum, uint32_t index)
+{
+    float sphere[4];
+    float distance;
+    float radius;
+    uint32_t plane;
+    int result;
+
+    graphics_transforms_sphere(&test_transforms, index, sphere);
+    result = TEST_VISIBLE;
+    for (plane = 0; plane < 6; plane++)
+    {
+        distance = frustum->x[plane] * sphere[0] + frustum->y[plane] * sphere[1] + frustum->z[plane] * sphere[2] + frustum->w[plane];
+        radius = (frustum->abs_x[plane] + frustum->abs_y[plane] + frustum->abs_z[plane]) * sphere[3];
+        if (distance + radius < -TEST_BORDER_EPSILON)
+        {
+            return TEST_OUTSIDE;
+        }
+        if (distance + radius < TEST_BORDER_EPSILON)
+        {
+            result = TEST_BORDER;
+        }
+    }
+    return result;
+}
+
+int test_compare(const char *name, const cube_frustum *frustum, uint32_t visible_count)
+{
+    uint32_t index;
+    uint32_t instance;
+    uint32_t expected_count;
+    uint32_t missing_count;
+    uint32_t extra_count;
+    int test;
+
+    SDL_memset(&test_visible[0], 0, sizeof(test_visible));
+    extra_count = 0;
+    for (index = 0; index < visible_count; index++)
+    {
+        instance = *(test_graphics.visible_instances + index);
+        if (instance >= TEST_INSTANCE_COUNT || test_visible[instance] != 0)
+        {
+            extra_count++;
+            continue;
+        }
+        test_visible[instance] = 1;
+    }
+    expected_count = 0;
+    missing_count = 0;
+    for (index = 0; index < TEST_INSTANCE_COUNT; index++)
+    {
+        test = test_brute_force(frustum, index);
+        if (test == TEST_VISIBLE)
+        {
+            expected_count++;
+            missing_count += (test_visible[index] == 0);
+        }
+        else if (test == TEST_OUTSIDE)
+        {
+            extra_count += (test_visible[index] != 0);
+        }
+    }
+    printf(
+        "%s: %u of %u visible, %u missing, %u extra\n",
+        name,
+        visible_count,
+        expected_count,
+        missing_count,
+        extra_count);
+    if (missing_count != 0 || extra_count != 0)
+    {
+        return CUBE_FAILURE;
+    }
+    return CUBE_SUCCESS;
+}
\ No newline at end of file
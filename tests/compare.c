@@ -0,0 +1,304 @@
+#include <cube.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define TEST_MKDIR(PATH) _mkdir(PATH)
+#else
+#include <sys/stat.h>
+#define TEST_MKDIR(PATH) mkdir(PATH, 0755)
+#endif
+
+#define TEST_UPDATE_VARIABLE "CUBE_UPDATE_GOLDENS"
+#define TEST_STORED_BLOCK_HEADER 5
+
+typedef struct
+{
+    uint32_t width;
+    uint32_t height;
+    uint8_t *pixels;
+} test_image;
+
+static int test_copy(const char *source_path, const char *destination_path);
+static int test_make_parent(const char *path);
+static int test_read_file(const char *path, uint8_t **data, size_t *size);
+static int test_read_png(const char *path, test_image *image);
+static uint32_t test_uint32(const uint8_t *bytes);
+
+// compares a captured png against its golden image, both written by the capture path
+int main(int argc, char **argv)
+{
+    test_image image;
+    test_image golden;
+    FILE *golden_file;
+    const char *update_variable;
+    uint32_t tolerance;
+    double fraction;
+    uint64_t pixel_index;
+    uint64_t pixel_count;
+    uint64_t differing_count;
+    uint32_t channel;
+    uint32_t difference;
+    uint32_t pixel_difference;
+    uint32_t max_difference;
+    int result;
+
+    if (argc < 5)
+    {
+        puts("usage: cube_compare <image> <golden> <channel tolerance> <differing fraction>");
+        return CUBE_FAILURE;
+    }
+    tolerance = (uint32_t)SDL_atoi(argv[3]);
+    fraction = SDL_atof(argv[4]);
+
+    // rendering changed on purpose, the new image becomes the golden
+    update_variable = SDL_getenv(TEST_UPDATE_VARIABLE);
+    if (update_variable != NULL && SDL_atoi(update_variable) != 0)
+    {
+        result = test_copy(argv[1], argv[2]);
+        if (result == CUBE_SUCCESS)
+        {
+            printf("updated %s\n", argv[2]);
+        }
+        return result;
+    }
+    // a missing golden fails, otherwise the comparison could never catch anything
+    golden_file = fopen(argv[2], "rb");
+    if (golden_file == NULL)
+    {
+        printf("no golden image at %s, run with " TEST_UPDATE_VARIABLE "=1 on the software driver to record it\n", argv[2]);
+        return CUBE_FAILURE;
+    }
+    fclose(golden_file);
+
+    image.pixels = NULL;
+    golden.pixels = NULL;
+    result = CUBE_FAILURE;
+    if (test_read_png(argv[1], &image) != CUBE_SUCCESS ||
+        test_read_png(argv[2], &golden) != CUBE_SUCCESS)
+    {
+        goto done;
+    }
+    if (image.width != golden.width || image.height != golden.height)
+    {
+        printf("image is %ux%u, golden is %ux%u\n", image.width, image.height, golden.width, golden.height);
+        goto done;
+    }
+
+    pixel_count = (uint64_t)image.width * image.height;
+    differing_count = 0;
+    max_difference = 0;
+    for (pixel_index = 0; pixel_index < pixel_count; pixel_index++)
+    {
+        pixel_difference = 0;
+        for (channel = 0; channel < 3; channel++)
+        {
+            difference = (uint32_t)abs(
+                (int)*(image.pixels + pixel_index * 3 + channel) -
+                (int)*(golden.pixels + pixel_index * 3 + channel));
+            pixel_difference = SDL_max(pixel_difference, difference);
+        }
+        max_difference = SDL_max(max_difference, pixel_difference);
+        if (pixel_difference > tolerance)
+        {
+            differing_count++;
+        }
+    }
+    printf(
+        "%llu of %llu pixels differ by more than %u, largest difference %u\n",
+        (unsigned long long)differing_count,
+        (unsigned long long)pixel_count,
+        tolerance,
+        max_difference);
+    if ((double)differing_count <= fraction * (double)pixel_count)
+    {
+        result = CUBE_SUCCESS;
+    }
+
+done:
+    free(image.pixels);
+    free(golden.pixels);
+    return result;
+}
+
+int test_copy(const char *source_path, const char *destination_path)
+{
+    CUBE_BEGIN_FUNCTION
+    FILE *source;
+    FILE *destination;
+    char buffer[4096];
+    size_t length;
+    int write_error;
+
+    source = fopen(source_path, "rb");
+    CUBE_ASSERT(source != NULL, strerror(errno))
+    if (test_make_parent(destination_path) != CUBE_SUCCESS)
+    {
+        fclose(source);
+        CUBE_ASSERT(SDL_FALSE, strerror(errno))
+    }
+    destination = fopen(destination_path, "wb");
+    if (destination == NULL)
+    {
+        fclose(source);
+        CUBE_ASSERT(SDL_FALSE, strerror(errno))
+    }
+    while ((length = fread(buffer, 1, sizeof(buffer), source)) > 0)
+    {
+        fwrite(buffer, 1, length, destination);
+    }
+    fclose(source);
+    write_error = ferror(destination);
+    CUBE_ASSERT(fclose(destination) == 0 && write_error == 0, "failed to write golden")
+    CUBE_END_FUNCTION
+}
+
+// the goldens directory is only created once something is recorded into it
+int test_make_parent(const char *path)
+{
+    CUBE_BEGIN_FUNCTION
+    char *directory;
+    char *separator;
+
+    directory = CUBE_CALLOC(SDL_strlen(path) + 1, 1);
+    CUBE_ASSERT(directory != NULL, "failed to allocate directory")
+    SDL_strlcpy(directory, path, SDL_strlen(path) + 1);
+    separator = SDL_strrchr(directory, '/');
+#ifdef _WIN32
+    if (SDL_strrchr(directory, '\\') > separator)
+    {
+        separator = SDL_strrchr(directory, '\\');
+    }
+#endif
+    if (separator == NULL || separator == directory)
+    {
+        goto done;
+    }
+    *separator = '\0';
+    CUBE_ASSERT(TEST_MKDIR(directory) == 0 || errno == EEXIST, strerror(errno))
+    CUBE_END_FUNCTION
+}
+
+int test_read_file(const char *path, uint8_t **data, size_t *size)
+{
+    CUBE_BEGIN_FUNCTION
+    FILE *file;
+    long length;
+
+    *data = NULL;
+    file = fopen(path, "rb");
+    CUBE_ASSERT(file != NULL, strerror(errno))
+    if (fseek(file, 0, SEEK_END) != 0 || (length = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0)
+    {
+        fclose(file);
+        CUBE_ASSERT(SDL_FALSE, "failed to size file")
+    }
+    *size = (size_t)length;
+    *data = malloc(*size + 1);
+    if (*data == NULL || fread(*data, 1, *size, file) != *size)
+    {
+        fclose(file);
+        free(*data);
+        *data = NULL;
+        CUBE_ASSERT(SDL_FALSE, "failed to read file")
+    }
+    fclose(file);
+    CUBE_END_FUNCTION
+}
+
+// only the subset the capture writer produces: 8 bit rgb, filter none, stored deflate blocks
+int test_read_png(const char *path, test_image *image)
+{
+    CUBE_BEGIN_FUNCTION
+    const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t *data;
+    size_t size;
+    size_t offset;
+    uint32_t chunk_length;
+    uint8_t *stream;
+    size_t stream_length;
+    size_t stream_offset;
+    size_t row_length;
+    size_t inflated_length;
+    size_t inflated_offset;
+    uint8_t *inflated;
+    uint32_t block_length;
+    SDL_bool final_block;
+    uint32_t row_index;
+
+    CUBE_ASSERT(test_read_file(path, &data, &size) == CUBE_SUCCESS, "failed to read png")
+    CUBE_PUSH(data);
+    CUBE_ASSERT(size > sizeof(signature) && SDL_memcmp(data, signature, sizeof(signature)) == 0, "not a png")
+
+    // gather every idat into one zlib stream
+    stream = CUBE_CALLOC(size, 1);
+    CUBE_ASSERT(stream != NULL, "failed to allocate png stream")
+    stream_length = 0;
+    image->width = 0;
+    image->height = 0;
+    for (offset = sizeof(signature); offset + 12 <= size; offset += 12 + chunk_length)
+    {
+        chunk_length = test_uint32(data + offset);
+        CUBE_ASSERT(chunk_length <= size - offset - 12, "truncated png chunk")
+        if (SDL_memcmp(data + offset + 4, "IHDR", 4) == 0)
+        {
+            CUBE_ASSERT(chunk_length == 13, "invalid png header")
+            image->width = test_uint32(data + offset + 8);
+            image->height = test_uint32(data + offset + 12);
+            CUBE_ASSERT(
+                *(data + offset + 16) == 8 && *(data + offset + 17) == 2 && *(data + offset + 20) == 0,
+                "png is not 8 bit rgb without interlace")
+        }
+        else if (SDL_memcmp(data + offset + 4, "IDAT", 4) == 0)
+        {
+            SDL_memcpy(stream + stream_length, data + offset + 8, chunk_length);
+            stream_length += chunk_length;
+        }
+    }
+    CUBE_ASSERT(image->width > 0 && image->height > 0, "png has no header")
+    CUBE_ASSERT(stream_length >= 2 && (*stream & 0x0F) == 8 && (*(stream + 1) & 0x20) == 0, "invalid zlib stream")
+
+    row_length = (size_t)image->width * 3 + 1;
+    inflated_length = row_length * image->height;
+    inflated = CUBE_CALLOC(inflated_length, 1);
+    CUBE_ASSERT(inflated != NULL, "failed to allocate png rows")
+    inflated_offset = 0;
+    stream_offset = 2;
+    final_block = SDL_FALSE;
+    while (final_block == SDL_FALSE)
+    {
+        CUBE_ASSERT(stream_offset + TEST_STORED_BLOCK_HEADER <= stream_length, "truncated deflate stream")
+        final_block = (*(stream + stream_offset) & 1) ? SDL_TRUE : SDL_FALSE;
+        CUBE_ASSERT(
+            (*(stream + stream_offset) & 6) == 0,
+            "compressed png, only goldens written by the capture path are supported")
+        block_length = (uint32_t)*(stream + stream_offset + 1) | ((uint32_t)*(stream + stream_offset + 2) << 8);
+        stream_offset += TEST_STORED_BLOCK_HEADER;
+        CUBE_ASSERT(
+            stream_offset + block_length <= stream_length && inflated_offset + block_length <= inflated_length,
+            "deflate block overruns image")
+        SDL_memcpy(inflated + inflated_offset, stream + stream_offset, block_length);
+        inflated_offset += block_length;
+        stream_offset += block_length;
+    }
+    CUBE_ASSERT(inflated_offset == inflated_length, "png is missing rows")
+
+    image->pixels = malloc(inflated_length - image->height);
+    CUBE_ASSERT(image->pixels != NULL, "failed to allocate pixels")
+    for (row_index = 0; row_index < image->height; row_index++)
+    {
+        CUBE_ASSERT(*(inflated + row_length * row_index) == 0, "png row uses a filter")
+        SDL_memcpy(
+            image->pixels + (row_length - 1) * row_index,
+            inflated + row_length * row_index + 1,
+            row_length - 1);
+    }
+    CUBE_END_FUNCTION
+}
+
+uint32_t test_uint32(const uint8_t *bytes)
+{
+    return ((uint32_t)*bytes << 24) |
+           ((uint32_t)*(bytes + 1) << 16) |
+           ((uint32_t)*(bytes + 2) << 8) |
+           (uint32_t)*(bytes + 3);
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include <cube.h>
+
+#define TEST_GRID_SIZE 16
+#define TEST_INSTANCE_COUNT (TEST_GRID_SIZE * TEST_GRID_SIZE * TEST_GRID_SIZE)
+
+static cube_graphics test_graphics;
+static uint32_t test_instances[TEST_INSTANCE_COUNT];
+static VkDrawIndexedIndirectCommand test_mapping[TEST_INSTANCE_COUNT];
+
+static void test_add_instances(cube_draw_list *list, const uint32_t *instances, uint32_t count);
+static int test_expect(const char *name, cube_draw_list *list, uint32_t command_count);
+
+// a grid of identical cubes shares one state, so each contiguous instance run must be one command
+int main(void)
+{
+    cube_draw_list *list;
+    uint32_t index;
+    uint32_t count;
+    int result;
+
+    test_graphics.instance_count = TEST_INSTANCE_COUNT;
+    if (graphics_create_draw_list(&test_graphics) != CUBE_SUCCESS)
+    {
+        return CUBE_FAILURE;
+    }
+    list = test_graphics.draw_list;
+    result = CUBE_SUCCESS;
+
+    for (index = 0; index < TEST_INSTANCE_COUNT; index++)
+    {
+        test_instances[index] = index;
+    }
+    test_add_instances(list, &test_instances[0], TEST_INSTANCE_COUNT);
+    result |= test_expect("grid", list, 1);
+
+    // bvh leaf order, reversed here, is put back in instance order first
+    for (index = 0; index < TEST_INSTANCE_COUNT; index++)
+    {
+        test_instances[index] = TEST_INSTANCE_COUNT - 1 - index;
+    }
+    graphics_draw_list_order(list, &test_instances[0], TEST_INSTANCE_COUNT);
+    test_add_instances(list, &test_instances[0], TEST_INSTANCE_COUNT);
+    result |= test_expect("reversed grid", list, 1);
+
+    // the far half of the grid is culled, the near half stays one run
+    count = 0;
+    for (index = TEST_INSTANCE_COUNT / 2; index-- > 0;)
+    {
+        test_instances[count++] = index;
+    }
+    graphics_draw_list_order(list, &test_instances[0], count);
+    test_add_instances(list, &test_instances[0], count);
+    result |= test_expect("half grid", list, 1);
+
+    count = 0;
+    for (index = 0; index < TEST_INSTANCE_COUNT; index += 2)
+    {
+        test_instances[count++] = index;
+    }
+    test_add_instances(list, &test_instances[0], count);
+    result |= test_expect("alternate instances", list, TEST_INSTANCE_COUNT / 2);
+
+    // two separate runs are ordered by their nearest cube
+    count = 0;
+    for (index = TEST_GRID_SIZE * TEST_GRID_SIZE * 12; index < TEST_INSTANCE_COUNT; index++)
+    {
+        test_instances[count++] = index;
+    }
+    for (index = 0; index < TEST_GRID_SIZE * TEST_GRID_SIZE * 4; index++)
+    {
+        test_instances[count++] = index;
+    }
+    test_add_instances(list, &test_instances[0], count);
+    result |= test_expect("separate runs", list, 2);
+    if (test_mapping[0].firstInstance != 0 || test_mapping[0].instanceCount != TEST_GRID_SIZE * TEST_GRID_SIZE * 4)
+    {
+        printf("separate runs: first command draws %u instances from %u\n",
+               test_mapping[0].instanceCount,
+               test_mapping[0].firstInstance);
+        result = CUBE_FAILURE;
+    }
+
+    graphics_destroy_draw_list(&test_graphics);
+    return result;
+}
+
+// the cubes are laid out in slices along z, and the camera looks down z from the first slice
+void test_add_instances(cube_draw_list *list, const uint32_t *instances, uint32_t count)
+{
+    VkDrawIndexedIndirectCommand command;
+    uint32_t index;
+    float depth;
+
+    command.indexCount = 36;
+    command.instanceCount = 1;
+    command.firstIndex = 0;
+    command.vertexOffset = 0;
+    graphics_draw_list_reset(list);
+    for (index = 0; index < count; index++)
+    {
+        depth = 1.0f + (float)(*(instances + index) / (TEST_GRID_SIZE * TEST_GRID_SIZE));
+        command.firstInstance = *(instances + index);
+        graphics_draw_list_add(list, graphics_draw_list_key(0, 0, 0, depth), &command);
+    }
+    graphics_draw_list_sort(list);
+    graphics_draw_list_build(list, &test_mapping[0]);
+}
+
+int test_expect(const char *name, cube_draw_list *list, uint32_t command_count)
+{
+    uint32_t index;
+    uint32_t instance_count;
+
+    instance_count = 0;
+    for (index = 0; index < list->command_count; index++)
+    {
+        instance_count += test_mapping[index].instanceCount;
+    }
+    printf(
+        "%s: %u commands in %u batches for %u instances\n",
+        name,
+        list->command_count,
+        list->batch_count,
+        instance_count);
+    if (list->command_count != command_count || list->batch_count != 1)
+    {
+        return CUBE_FAILURE;
+    }
+    return CUBE_SUCCESS;
+}
\ No newline at end of file
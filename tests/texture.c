@@ -0,0 +1,104 @@
+#include <cube.h>
+
+#define TEST_BC1_LEVEL_COUNT 5
+
+static int test_parse(
+    const char *directory,
+    const char *file_name,
+    size_t cut,
+    VkBool32 block_compression,
+    uint32_t max_dimension,
+    cube_ktx2 *ktx2);
+
+// the shipped textures must parse to the levels they were written with, and damaged copies must not
+int main(int argc, char **argv)
+{
+    // the bc1 levels are stored smallest first after the index and the format descriptor
+    const uint64_t bc1_offsets[TEST_BC1_LEVEL_COUNT] = {304, 272, 264, 256, 248};
+    cube_ktx2 ktx2;
+    uint32_t level_index;
+    int result;
+
+    if (argc != 2)
+    {
+        puts("usage: cube_test_texture <texture directory>");
+        return CUBE_FAILURE;
+    }
+    result = CUBE_SUCCESS;
+
+    // a plain texture without levels asks the loader for the full blit chain
+    if (test_parse(argv[1], "checker_rgba8.ktx2", 0, VK_FALSE, 4096, &ktx2) != CUBE_SUCCESS ||
+        ktx2.format->format != VK_FORMAT_R8G8B8A8_UNORM ||
+        ktx2.width != 16 ||
+        ktx2.height != 16 ||
+        ktx2.level_count != 1 ||
+        ktx2.generate_levels != VK_TRUE ||
+        ktx2.level_offsets[0] != 196 ||
+        graphics_ktx2_chain_length(ktx2.width, ktx2.height) != 5)
+    {
+        puts("checker_rgba8.ktx2: unexpected levels");
+        result = CUBE_FAILURE;
+    }
+
+    if (test_parse(argv[1], "tiles_bc1.ktx2", 0, VK_TRUE, 4096, &ktx2) != CUBE_SUCCESS ||
+        ktx2.format->format != VK_FORMAT_BC1_RGB_UNORM_BLOCK ||
+        ktx2.level_count != TEST_BC1_LEVEL_COUNT ||
+        ktx2.generate_levels != VK_FALSE)
+    {
+        puts("tiles_bc1.ktx2: unexpected levels");
+        result = CUBE_FAILURE;
+    }
+    else
+    {
+        for (level_index = 0; level_index < TEST_BC1_LEVEL_COUNT; level_index++)
+        {
+            if (ktx2.level_offsets[level_index] != bc1_offsets[level_index])
+            {
+                printf(
+                    "tiles_bc1.ktx2: level %u at %llu, expected %llu\n",
+                    level_index,
+                    (unsigned long long)ktx2.level_offsets[level_index],
+                    (unsigned long long)bc1_offsets[level_index]);
+                result = CUBE_FAILURE;
+            }
+        }
+    }
+
+    // a device without bc, a smaller size limit and a cut off last level are each rejected
+    if (test_parse(argv[1], "tiles_bc1.ktx2", 0, VK_FALSE, 4096, &ktx2) == CUBE_SUCCESS ||
+        test_parse(argv[1], "tiles_bc1.ktx2", 0, VK_TRUE, 8, &ktx2) == CUBE_SUCCESS ||
+        test_parse(argv[1], "tiles_bc1.ktx2", 1, VK_TRUE, 4096, &ktx2) == CUBE_SUCCESS ||
+        test_parse(argv[1], "checker_rgba8.ktx2", 1, VK_FALSE, 4096, &ktx2) == CUBE_SUCCESS)
+    {
+        puts("a damaged or unsupported texture was accepted");
+        result = CUBE_FAILURE;
+    }
+    return result;
+}
+
+// cut drops that many bytes from the end of the file before parsing
+int test_parse(
+    const char *directory,
+    const char *file_name,
+    size_t cut,
+    VkBool32 block_compression,
+    uint32_t max_dimension,
+    cube_ktx2 *ktx2)
+{
+    char path[512];
+    uint8_t *data;
+    size_t size;
+    int result;
+
+    SDL_snprintf(path, sizeof(path), "%s/%s", directory, file_name);
+    data = SDL_LoadFile(path, &size);
+    if (data == NULL || size < cut)
+    {
+        printf("failed to load %s\n", path);
+        SDL_free(data);
+        return CUBE_FAILURE;
+    }
+    result = graphics_ktx2_parse(data, size - cut, block_compression, max_dimension, ktx2);
+    SDL_free(data);
+    return result;
+}
\ No newline at end of file